@@ -0,0 +1,87 @@
+/**
+  ******************************************************************************
+  * @file    boot.h
+  * @brief   Boot stage and firmware update layout
+  *
+  *          The boot stage lives in the first flash pages, which an update
+  *          never rewrites. At reset, when an install record is present, it
+  *          copies the image staged by the fragmentation session over the
+  *          application, erases the record, and resets. A reset during the
+  *          copy starts the copy again. A copy which does not verify is
+  *          marked in the record page and after BOOT_INSTALL_MAX_ATTEMPTS the
+  *          record is erased, the update given up. It then starts the
+  *          application, whose vector table follows the boot stage, if its
+  *          stack pointer and reset handler are plausible.
+  *
+  *          Flash: boot stage | application | staging | install record |
+  *                 settings, see settings_store.h
+  *
+  *          An update file is a BootImageHeader_t followed by the application
+  *          image, see tools/fuota_image.py. It is staged as received: the
+  *          fragment of index n at n times the slot size, the fragment size
+  *          rounded up to the flash double word, so that each fragment is
+  *          programmed once.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __BOOT_H__
+#define __BOOT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define BOOT_IMAGE_MAGIC                            0x57465053U  /* "SPFW" */
+#define BOOT_RECORD_MAGIC                           0x4C54534EU  /* "NSTL" */
+#define BOOT_INSTALL_MAX_ATTEMPTS                   3U
+
+/* Exported types ------------------------------------------------------------*/
+/*!
+ * Header of an update file
+ */
+typedef struct
+{
+  uint32_t Magic;     /*!< BOOT_IMAGE_MAGIC */
+  uint32_t Size;      /*!< Size of the application image following the header */
+  uint32_t Crc;       /*!< CRC-32 of the application image */
+  uint32_t Version;
+} BootImageHeader_t;
+
+/*!
+ * Install record, programmed once the staged file is verified. The boot stage
+ * programs one double word after it per copy which failed to verify.
+ */
+typedef struct
+{
+  uint32_t Magic;     /*!< BOOT_RECORD_MAGIC */
+  uint32_t Size;      /*!< Size of the application image */
+  uint32_t Crc;       /*!< CRC-32 of the application image */
+  uint16_t FragSize;  /*!< Staged fragment size */
+  uint16_t SlotSize;  /*!< Staged fragment stride */
+} BootRecord_t;
+
+/* External variables --------------------------------------------------------*/
+/* Flash layout, from the linker script */
+extern uint8_t _app_start[];
+extern uint8_t _app_size[];
+extern uint8_t _staging_start[];
+extern uint8_t _staging_size[];
+extern uint8_t _boot_record[];
+
+/* Exported macros -----------------------------------------------------------*/
+#define BOOT_APP_START                              ((uint32_t)_app_start)
+#define BOOT_APP_SIZE                               ((uint32_t)_app_size)
+#define BOOT_STAGING_START                          ((uint32_t)_staging_start)
+#define BOOT_STAGING_SIZE                           ((uint32_t)_staging_size)
+#define BOOT_RECORD_START                           ((uint32_t)_boot_record)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOT_H__ */
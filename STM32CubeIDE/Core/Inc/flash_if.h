@@ -0,0 +1,50 @@
+/**
+  ******************************************************************************
+  * @file    flash_if.h
+  * @brief   Page erase and double word programming of the internal flash
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FLASH_IF_H__
+#define __FLASH_IF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define FLASH_IF_OK                                 0
+#define FLASH_IF_ERROR                              (-1)
+
+/*!
+ * Programming unit, written once between two erases
+ */
+#define FLASH_IF_DOUBLE_WORD                        8U
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+  * @brief Erases the pages covering an area
+  * @param address start of the area
+  * @param size size of the area
+  * @retval FLASH_IF_OK or FLASH_IF_ERROR
+  */
+int32_t FLASH_IF_Erase(uint32_t address, uint32_t size);
+
+/**
+  * @brief Programs erased double words. The last one is padded with 0xFF.
+  * @param address start, double word aligned
+  * @param data data
+  * @param size data size
+  * @retval FLASH_IF_OK or FLASH_IF_ERROR
+  */
+int32_t FLASH_IF_Write(uint32_t address, const uint8_t *data, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FLASH_IF_H__ */
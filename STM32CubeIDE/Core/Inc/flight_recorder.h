@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file    flight_recorder.h
+  * @brief   Crash-surviving event ring kept in the .noinit RAM
+  *
+  *          The ring is not cleared by the startup code, so the events of the
+  *          previous boot, up to a fault or a watchdog reset, can be read back
+  *          after the reset. Recording is lock-free and costs a few cycles:
+  *          an atomic index reservation, the RTC tick and three stores.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FLIGHT_RECORDER_H__
+#define __FLIGHT_RECORDER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Number of events kept, a power of two
+ */
+#define FLIGHT_RECORDER_SIZE                        256U
+
+/* Exported types ------------------------------------------------------------*/
+/*!
+ * Recorded events
+ */
+typedef enum
+{
+  FLIGHT_EVENT_BOOT,          /*!< Arg: RCC_CSR reset flags */
+  FLIGHT_EVENT_TX_START,      /*!< Arg: frame size */
+  FLIGHT_EVENT_TX_DONE,
+  FLIGHT_EVENT_TX_TIMEOUT,
+  FLIGHT_EVENT_RX_START,      /*!< Arg: receive slot */
+  FLIGHT_EVENT_RX_DONE,       /*!< Arg: frame size */
+  FLIGHT_EVENT_RX_TIMEOUT,
+  FLIGHT_EVENT_RX_ERROR,
+  FLIGHT_EVENT_JOIN_REQUEST,
+  FLIGHT_EVENT_JOIN_ACCEPT,
+  FLIGHT_EVENT_TASK,          /*!< Arg: sequencer task id */
+  FLIGHT_EVENT_STOP_ENTER,
+  FLIGHT_EVENT_STOP_EXIT,
+  FLIGHT_EVENT_FAULT_PC,      /*!< Arg: stacked PC */
+  FLIGHT_EVENT_FAULT_LR,      /*!< Arg: stacked LR */
+  FLIGHT_EVENT_FAULT_STATUS,  /*!< Arg: SCB_CFSR */
+  FLIGHT_EVENT_ERROR,         /*!< Arg: caller of Error_Handler, see FlightRecorder_Error */
+} FlightEvent_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+  * @brief Checks the ring left by the previous boot, clears it if it is not
+  *        valid, and records the BOOT event. Call once the RTC runs.
+  * @param none
+  * @retval none
+  */
+void FlightRecorder_Init(void);
+
+/**
+  * @brief Records an event. Lock-free, callable from any context.
+  * @param event event
+  * @param arg event argument
+  * @retval none
+  */
+void FlightRecorder_Record(FlightEvent_t event, uint32_t arg);
+
+/**
+  * @brief Records an unrecoverable error before a reset. Callable before
+  *        FlightRecorder_Init.
+  * @param caller address of the failing call
+  * @retval number of consecutive boots ended by an error, this one included
+  */
+uint32_t FlightRecorder_Error(uint32_t caller);
+
+/**
+  * @brief Returns the number of events recorded by the previous boot which
+  *        are still in the ring
+  * @param none
+  * @retval number of events, 0 after a power-on
+  */
+uint16_t FlightRecorder_PreviousCount(void);
+
+/**
+  * @brief Encodes the diagnostics uplink: the reset cause (RCC_CSR flags
+  *        >> 24), then the last events of the previous boot which fit, newest
+  *        first, as event u8 and argument u32 big endian. Usable as an uplink
+  *        encoder.
+  * @param buffer payload buffer
+  * @param maxSize payload size available
+  * @retval payload size
+  */
+uint8_t FlightRecorder_Summarize(uint8_t *buffer, uint8_t maxSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FLIGHT_RECORDER_H__ */
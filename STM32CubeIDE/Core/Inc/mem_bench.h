@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file    mem_bench.h
+  * @brief   On-target micro-benchmark of the UTIL_MEM routines
+  *
+  *          Counts the DWT cycles of UTIL_MEM_cpy_8, UTIL_MEM_cpyr_8 and
+  *          UTIL_MEM_set_8 against the byte loops they replaced, from 4 to
+  *          256 bytes, and logs them at boot. Built with -DUTIL_MEM_BENCH=ON,
+  *          tools/mem_bench.c is the host counterpart.
+  *
+  *          Record: size, alignment (0: aligned, 1: source + 1,
+  *          2: destination + 3), then old and new cycles per call for the
+  *          copy, the reverse copy and the fill.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MEM_BENCH_H__
+#define __MEM_BENCH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#ifndef UTIL_MEM_BENCH
+#define UTIL_MEM_BENCH                              0
+#endif /* UTIL_MEM_BENCH */
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+  * @brief Runs the benchmark and logs its records. Blocks for the whole run,
+  *        call once the timer and the trace run.
+  * @param none
+  * @retval none
+  */
+void MemBench_Run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEM_BENCH_H__ */
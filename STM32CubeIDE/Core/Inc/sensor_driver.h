@@ -0,0 +1,97 @@
+#ifndef _SENSOR_DRIVER_H_
+#define _SENSOR_DRIVER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <tuple>
+
+// Busy waits for a sensor to settle, the MCU stays awake
+inline void settle(uint32_t spins) {
+	for (volatile uint32_t t = 0; t < spins; t++) { }
+}
+
+// Sensor and actuator drivers, installed at compile time.
+//
+// A driver derives from sensor_driver<driver> and hides the defaults it
+// needs: init() once at boot, start() and complete() around a measurement,
+// get() for the last value, put() for its telemetry fields and apply() for
+// an actuator. The drivers of a driver_registry measure in one wake window:
+// all of them start, the longest settling time is waited once, then all of
+// them complete. Calls are resolved at compile time, no vtable, no heap.
+template <typename Derived>
+class sensor_driver {
+public:
+	// Busy loop iterations between start() and complete()
+	static constexpr uint32_t settle_spins = 0;
+
+	void start_measurement() { derived().start(); }
+	void on_complete() { derived().complete(); }
+	decltype(auto) value() const { return derived().get(); }
+
+	template <typename Stream>
+	void encode(Stream &stream) { derived().put(stream); }
+
+	template <typename Registry>
+	void actuate(Registry &registry) { derived().apply(registry); }
+
+	// Defaults, hidden by the driver
+	void init() { }
+	void start() { }
+	void complete() { }
+	template <typename Stream>
+	void put(Stream &) { }
+	template <typename Registry>
+	void apply(Registry &) { }
+
+protected:
+	constexpr sensor_driver() = default;
+
+private:
+	Derived &derived() { return static_cast<Derived &>(*this); }
+	const Derived &derived() const { return static_cast<const Derived &>(*this); }
+};
+
+// The installed drivers. Telemetry fields follow the order of the list.
+template <typename... Drivers>
+class driver_registry {
+public:
+	static constexpr uint32_t settle_spins = std::max({ uint32_t(0), Drivers::settle_spins... });
+
+	constexpr driver_registry() = default;
+
+	void init() {
+		(std::get<Drivers>(drivers).init(), ...);
+	}
+
+	// Measures all the sensors, then drives the actuators
+	void update() {
+		(std::get<Drivers>(drivers).start_measurement(), ...);
+		settle(settle_spins);
+		(std::get<Drivers>(drivers).on_complete(), ...);
+		(std::get<Drivers>(drivers).actuate(*this), ...);
+	}
+
+	// Measures a single sensor
+	template <typename Driver>
+	void measure() {
+		Driver &driver = get<Driver>();
+		driver.start_measurement();
+		settle(Driver::settle_spins);
+		driver.on_complete();
+	}
+
+	template <typename Stream>
+	void encode(Stream &stream) {
+		(std::get<Drivers>(drivers).encode(stream), ...);
+	}
+
+	template <typename Driver>
+	Driver &get() { return std::get<Driver>(drivers); }
+
+private:
+	std::tuple<Drivers...> drivers;
+};
+
+#endif  // #ifndef _SENSOR_DRIVER_H_
@@ -0,0 +1,55 @@
+/**
+  ******************************************************************************
+  * @file    settings_store.h
+  * @brief   Settings block kept in flash across resets and updates
+  *
+  *          The block is written alternately to two flash pages, each copy
+  *          with a sequence number and a CRC. A reset during a write leaves
+  *          the previous copy, which is then the newest valid one.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SETTINGS_STORE_H__
+#define __SETTINGS_STORE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Maximum size of the settings block
+ */
+#define SETTINGS_STORE_MAX_SIZE                     256U
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+  * @brief Reads the newest valid copy of the settings block. A block stored
+  *        by another layout version is copied up to the smaller of the two
+  *        sizes, the caller keeps its defaults for the rest.
+  * @param data settings, holding the defaults
+  * @param size settings size, at most SETTINGS_STORE_MAX_SIZE
+  * @param version layout version of the stored block, set if found
+  * @retval true if a valid copy was found
+  */
+bool SettingsStore_Load(void *data, uint16_t size, uint16_t *version);
+
+/**
+  * @brief Writes the settings block over the oldest copy
+  * @param data settings
+  * @param size settings size, at most SETTINGS_STORE_MAX_SIZE
+  * @param version layout version of the settings
+  * @retval true if written and read back
+  */
+bool SettingsStore_Save(const void *data, uint16_t size, uint16_t version);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SETTINGS_STORE_H__ */
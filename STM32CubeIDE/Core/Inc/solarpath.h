@@ -4,14 +4,22 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // #ifdef __cplusplus
 
-const uint8_t *encode_packet(uint8_t *len);
+void system_init();
+uint8_t encode_packet(uint8_t *buffer, uint8_t maxLen);
 void decode_packet(const uint8_t *packet, uint32_t len);
 void system_update();
+bool system_set_night(bool night, bool force);
+void system_clear_night();
+void system_set_auto_threshold(float volts);
+void system_set_averaging(uint8_t samples);
+float system_temperature();
+bool system_alarm();
 
 #ifdef __cplusplus
 }
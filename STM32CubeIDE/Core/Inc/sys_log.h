@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file    sys_log.h
+  * @brief   Tokenized binary log records sent through the advanced trace
+  *
+  *          The format strings stay out of the image: each one is placed in
+  *          the non-loaded .log_fmt section and its offset there is the
+  *          16-bit record id. A record only carries the id and the arguments
+  *          as varints, tools/log_decode.py rebuilds the text from the ELF.
+  *
+  *          Record: [0x00][payload size][id LSB][id MSB][argument varints]
+  *          Text sent with printf never contains 0x00, so both can share the
+  *          UART.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SYS_LOG_H__
+#define __SYS_LOG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Marker starting a record
+ */
+#define SYS_LOG_MARKER                              0x00
+
+/*!
+ * Maximum number of arguments of a record
+ */
+#define SYS_LOG_MAX_ARGS                            8
+
+/* Exported macros -----------------------------------------------------------*/
+/**
+  * @brief Logs a printf-like message. The arguments are converted to 32-bit
+  *        unsigned integers: %d, %i, %u, %x, %c and their l variants only, a
+  *        negative value costs 5 bytes.
+  */
+#define SYS_LOG(fmt, ...)                                                                   \
+  do {                                                                                      \
+    static const char _sysLogFmt[] __attribute__((section(".log_fmt"), used)) = fmt;       \
+    const uint32_t _sysLogArgs[] = { 0, ##__VA_ARGS__ };                                    \
+    SysLog_Write((uint16_t)(uintptr_t)_sysLogFmt, &_sysLogArgs[1],                          \
+                 (uint8_t)((sizeof(_sysLogArgs) / sizeof(_sysLogArgs[0])) - 1U));           \
+  } while (0)
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+  * @brief Queues a record in the trace FIFO. Never blocks, the record is
+  *        dropped if the FIFO is full.
+  * @param id format string offset in the .log_fmt section
+  * @param args arguments
+  * @param count number of arguments, at most SYS_LOG_MAX_ARGS
+  * @retval none
+  */
+void SysLog_Write(uint16_t id, const uint32_t *args, uint8_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYS_LOG_H__ */
@@ -34,7 +34,7 @@ extern "C" {
 #include "stm32_tiny_vsnprintf.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "flight_recorder.h"
 /* USER CODE END Includes */
 
 /* Exported types ------------------------------------------------------------*/
@@ -101,6 +101,11 @@ extern "C" {
   */
 #define UTIL_SEQ_EXIT_CRITICAL_SECTION( )    UTILS_EXIT_CRITICAL_SECTION()
 
+/**
+  * @brief macro called before a task is executed, records it in the flight recorder
+  */
+#define UTIL_SEQ_TASK_ENTRY( __task_idx__ )  FlightRecorder_Record(FLIGHT_EVENT_TASK, (__task_idx__))
+
 /**
   * @brief Memset utilities interface to application
   */
@@ -126,12 +131,12 @@ extern "C" {
   * trace\advanced
   * the define option
   *    UTIL_ADV_TRACE_CONDITIONNAL shall be defined if you want use conditional function
-  *    UTIL_ADV_TRACE_UNCHUNK_MODE shall be defined if you want use the unchunk mode
+  *    the FIFO is lock-free: its size shall be a power of two up to 2048, its
+  *    reservations never wrap
   *
   ******************************************************************************/
 
 #define UTIL_ADV_TRACE_CONDITIONNAL                                                      /*!< not used */
-#define UTIL_ADV_TRACE_UNCHUNK_MODE                                                      /*!< not used */
 #define UTIL_ADV_TRACE_DEBUG(...)                                                        /*!< not used */
 #define UTIL_ADV_TRACE_INIT_CRITICAL_SECTION( )    UTILS_INIT_CRITICAL_SECTION()         /*!< init the critical section in trace feature */
 #define UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION( )   UTILS_ENTER_CRITICAL_SECTION()        /*!< enter the critical section in trace feature */
@@ -44,7 +44,7 @@ typedef enum
   CFG_LPM_UART_TX_Id,
   CFG_LPM_TCXO_WA_Id,
   /* USER CODE BEGIN CFG_LPM_Id_t */
-
+  CFG_LPM_LED_Id,
   /* USER CODE END CFG_LPM_Id_t */
 } CFG_LPM_Id_t;
 
@@ -75,6 +75,12 @@ typedef enum
   CFG_SEQ_Task_LmHandlerProcess,
   CFG_SEQ_Task_JoinNetworkTimer,
   CFG_SEQ_Task_SendTxTimer,
+  CFG_SEQ_Task_UplinkDispatch,
+  CFG_SEQ_Task_Alarm,
+  CFG_SEQ_Task_Scene,
+  CFG_SEQ_Task_ActionSchedule,
+  CFG_SEQ_Task_SunEvent,
+  CFG_SEQ_Task_Downlink,
   /* USER CODE END CFG_SEQ_Task_Id_t */
   CFG_SEQ_Task_NBR
 } CFG_SEQ_Task_Id_t;
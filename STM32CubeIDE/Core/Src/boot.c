@@ -0,0 +1,260 @@
+/**
+  ******************************************************************************
+  * @file    boot.c
+  * @brief   Boot stage: installs a staged update, then starts the application
+  *
+  *          Everything here is linked into the boot pages and must not call
+  *          code outside of them: the application may be half erased.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include "stm32wlxx.h"
+#include "stm32wlxx_hal_flash.h"
+#include "boot.h"
+#include "flash_if.h"
+
+/* Private define ------------------------------------------------------------*/
+#define BOOT_CODE                                   __attribute__((section(".boot")))
+
+/* Failed install marks, one double word each after the record */
+#define BOOT_ATTEMPTS_START                         (BOOT_RECORD_START + sizeof(BootRecord_t))
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief Reader of the staged file, fragment by fragment
+  */
+typedef struct
+{
+  const BootRecord_t *Record;
+  const uint8_t *Next;   /*!< Next byte in the current slot */
+  uint32_t Left;         /*!< Bytes left in the current slot */
+  uint32_t Slot;
+} StagedReader_t;
+
+/* Private function prototypes -----------------------------------------------*/
+void Boot_Reset(void);
+void Boot_Fault(void);
+
+/* Private variables ---------------------------------------------------------*/
+extern uint32_t _estack;
+
+/**
+  * @brief Vector table of the boot stage, at the flash origin. Up to the
+  *        HardFault so that an NMI, e.g. on a flash ECC double error while
+  *        reading an interrupted page, resets instead of fetching code bytes
+  */
+__attribute__((section(".boot_vector"), used)) const uint32_t BootVector[4] =
+{
+  (uint32_t)&_estack,
+  (uint32_t)Boot_Reset,
+  (uint32_t)Boot_Fault,   /* NMI */
+  (uint32_t)Boot_Fault,   /* HardFault */
+};
+
+/* Private functions ---------------------------------------------------------*/
+BOOT_CODE static void StagedSeek(StagedReader_t *reader, uint32_t offset)
+{
+  const BootRecord_t *record = reader->Record;
+
+  reader->Slot = offset / record->FragSize;
+  reader->Left = record->FragSize - (offset % record->FragSize);
+  reader->Next = (const uint8_t *)(BOOT_STAGING_START + (reader->Slot * record->SlotSize) +
+                                   (offset % record->FragSize));
+}
+
+BOOT_CODE static uint8_t StagedRead(StagedReader_t *reader)
+{
+  if (reader->Left == 0U)
+  {
+    reader->Slot++;
+    reader->Left = reader->Record->FragSize;
+    reader->Next = (const uint8_t *)(BOOT_STAGING_START + (reader->Slot * reader->Record->SlotSize));
+  }
+  reader->Left--;
+  return *reader->Next++;
+}
+
+BOOT_CODE static bool IsRecordValid(const BootRecord_t *record)
+{
+  uint32_t fileSize;
+
+  if ((record->Magic != BOOT_RECORD_MAGIC) || (record->Size == 0U) || (record->Size > BOOT_APP_SIZE) ||
+      (record->FragSize == 0U) || (record->SlotSize < record->FragSize) ||
+      ((record->SlotSize % FLASH_IF_DOUBLE_WORD) != 0U))
+  {
+    return false;
+  }
+  fileSize = sizeof(BootImageHeader_t) + record->Size;
+  return (((fileSize + record->FragSize - 1U) / record->FragSize) * record->SlotSize) <= BOOT_STAGING_SIZE;
+}
+
+BOOT_CODE __attribute__((noreturn)) static void SystemReset(void)
+{
+  __DSB();
+  SCB->AIRCR = (0x5FAUL << SCB_AIRCR_VECTKEY_Pos) | (SCB->AIRCR & SCB_AIRCR_PRIGROUP_Msk) |
+               SCB_AIRCR_SYSRESETREQ_Msk;
+  __DSB();
+  for (;;)
+  {
+  }
+}
+
+BOOT_CODE static void FlashWait(void)
+{
+  while ((FLASH->SR & FLASH_SR_BSY) != 0U)
+  {
+  }
+}
+
+BOOT_CODE static void FlashErasePage(uint32_t address)
+{
+  FlashWait();
+  FLASH->SR = FLASH_FLAG_SR_ERRORS;
+  MODIFY_REG(FLASH->CR, FLASH_CR_PNB, ((address - FLASH_BASE) / FLASH_PAGE_SIZE) << FLASH_CR_PNB_Pos);
+  SET_BIT(FLASH->CR, FLASH_CR_PER);
+  SET_BIT(FLASH->CR, FLASH_CR_STRT);
+  FlashWait();
+  CLEAR_BIT(FLASH->CR, FLASH_CR_PER | FLASH_CR_PNB);
+}
+
+BOOT_CODE static void FlashProgram(uint32_t address, uint32_t low, uint32_t high)
+{
+  FlashWait();
+  FLASH->SR = FLASH_FLAG_SR_ERRORS;
+  SET_BIT(FLASH->CR, FLASH_CR_PG);
+  *(volatile uint32_t *)address = low;
+  __ISB();
+  *(volatile uint32_t *)(address + 4U) = high;
+  FlashWait();
+  FLASH->SR = FLASH_SR_EOP;
+  CLEAR_BIT(FLASH->CR, FLASH_CR_PG);
+}
+
+/**
+  * @brief Copies the staged image over the application
+  * @retval true if the application matches the staged image
+  */
+BOOT_CODE static bool Install(const BootRecord_t *record)
+{
+  StagedReader_t reader = { .Record = record };
+  uint32_t offset;
+
+  StagedSeek(&reader, sizeof(BootImageHeader_t));
+  for (offset = 0; offset < record->Size; offset += FLASH_IF_DOUBLE_WORD)
+  {
+    uint32_t word[2] = { UINT32_MAX, UINT32_MAX };
+
+    if ((offset % FLASH_PAGE_SIZE) == 0U)
+    {
+      FlashErasePage(BOOT_APP_START + offset);
+    }
+    for (uint32_t i = 0; (i < FLASH_IF_DOUBLE_WORD) && ((offset + i) < record->Size); i++)
+    {
+      uint32_t shift = (i % 4U) * 8U;
+
+      word[i / 4U] = (word[i / 4U] & ~(0xFFUL << shift)) | ((uint32_t)StagedRead(&reader) << shift);
+    }
+    FlashProgram(BOOT_APP_START + offset, word[0], word[1]);
+  }
+
+  StagedSeek(&reader, sizeof(BootImageHeader_t));
+  for (offset = 0; offset < record->Size; offset++)
+  {
+    if (*(const volatile uint8_t *)(BOOT_APP_START + offset) != StagedRead(&reader))
+    {
+      return false;
+    }
+  }
+
+  FlashErasePage(BOOT_RECORD_START);
+  return true;
+}
+
+/**
+  * @brief Counts the failed install marks in the record page
+  * @retval number of marks, at most BOOT_INSTALL_MAX_ATTEMPTS
+  */
+BOOT_CODE static uint32_t FailedAttempts(void)
+{
+  uint32_t attempts = 0;
+
+  while ((attempts < BOOT_INSTALL_MAX_ATTEMPTS) &&
+         (*(const volatile uint32_t *)(BOOT_ATTEMPTS_START + (attempts * FLASH_IF_DOUBLE_WORD)) != UINT32_MAX))
+  {
+    attempts++;
+  }
+  return attempts;
+}
+
+/**
+  * @brief Checks the vector table of the application: initial stack pointer
+  *        in RAM, reset handler in the application region and in Thumb state
+  */
+BOOT_CODE static bool IsAppValid(const uint32_t *vector)
+{
+  uint32_t stack = vector[0];
+  uint32_t reset = vector[1];
+
+  return (stack > SRAM1_BASE) && (stack <= (SRAM2_BASE + SRAM2_SIZE)) && ((stack % 8U) == 0U) &&
+         ((reset & 1U) != 0U) && (reset > BOOT_APP_START) && (reset < (BOOT_APP_START + BOOT_APP_SIZE));
+}
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief Reset handler of the boot stage
+  */
+BOOT_CODE __attribute__((noreturn)) void Boot_Reset(void)
+{
+  const BootRecord_t *record = (const BootRecord_t *)BOOT_RECORD_START;
+  const uint32_t *vector = (const uint32_t *)BOOT_APP_START;
+
+  if (IsRecordValid(record) == true)
+  {
+    if ((FLASH->CR & FLASH_CR_LOCK) != 0U)
+    {
+      FLASH->KEYR = FLASH_KEY1;
+      FLASH->KEYR = FLASH_KEY2;
+    }
+    /* A copy cut by a reset or a brown-out is retried without counting, only
+       a copy which completes and does not verify counts against the limit */
+    uint32_t attempts = FailedAttempts();
+    if (attempts < BOOT_INSTALL_MAX_ATTEMPTS)
+    {
+      if (Install(record) == false)
+      {
+        FlashProgram(BOOT_ATTEMPTS_START + (attempts * FLASH_IF_DOUBLE_WORD), 0U, 0U);
+      }
+      SystemReset();
+    }
+    /* The copy keeps failing, give the update up */
+    FlashErasePage(BOOT_RECORD_START);
+    SET_BIT(FLASH->CR, FLASH_CR_LOCK);
+  }
+
+  if (IsAppValid(vector) == false)
+  {
+    /* Nothing to start, an erased or corrupt application. Stays halted
+       rather than resetting in a loop, until reprogrammed */
+    for (;;)
+    {
+      __WFI();
+    }
+  }
+
+  SCB->VTOR = BOOT_APP_START;
+  __set_MSP(vector[0]);
+  ((void (*)(void))vector[1])();
+  for (;;)
+  {
+  }
+}
+
+/**
+  * @brief NMI and HardFault handler of the boot stage
+  */
+BOOT_CODE __attribute__((noreturn)) void Boot_Fault(void)
+{
+  SystemReset();
+}
@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file    flash_if.c
+  * @brief   Page erase and double word programming of the internal flash
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32wlxx_hal.h"
+#include "stm32_mem.h"
+#include "flash_if.h"
+
+/* Exported functions --------------------------------------------------------*/
+int32_t FLASH_IF_Erase(uint32_t address, uint32_t size)
+{
+  FLASH_EraseInitTypeDef erase;
+  uint32_t pageError;
+  int32_t status = FLASH_IF_OK;
+
+  if ((size == 0U) || (address < FLASH_BASE))
+  {
+    return FLASH_IF_ERROR;
+  }
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.Page = (address - FLASH_BASE) / FLASH_PAGE_SIZE;
+  erase.NbPages = ((address + size - 1U - FLASH_BASE) / FLASH_PAGE_SIZE) - erase.Page + 1U;
+
+  if (HAL_FLASH_Unlock() != HAL_OK)
+  {
+    return FLASH_IF_ERROR;
+  }
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_SR_ERRORS);
+  if (HAL_FLASHEx_Erase(&erase, &pageError) != HAL_OK)
+  {
+    status = FLASH_IF_ERROR;
+  }
+  HAL_FLASH_Lock();
+  return status;
+}
+
+int32_t FLASH_IF_Write(uint32_t address, const uint8_t *data, uint32_t size)
+{
+  uint64_t doubleWord;
+  int32_t status = FLASH_IF_OK;
+
+  if ((address % FLASH_IF_DOUBLE_WORD) != 0U)
+  {
+    return FLASH_IF_ERROR;
+  }
+  if (HAL_FLASH_Unlock() != HAL_OK)
+  {
+    return FLASH_IF_ERROR;
+  }
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_SR_ERRORS);
+  for (uint32_t offset = 0; (offset < size) && (status == FLASH_IF_OK); offset += FLASH_IF_DOUBLE_WORD)
+  {
+    uint32_t chunk = ((size - offset) < FLASH_IF_DOUBLE_WORD) ? (size - offset) : FLASH_IF_DOUBLE_WORD;
+
+    doubleWord = UINT64_MAX;
+    UTIL_MEM_cpy_8(&doubleWord, &data[offset], chunk);
+    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + offset, doubleWord) != HAL_OK)
+    {
+      status = FLASH_IF_ERROR;
+    }
+  }
+  HAL_FLASH_Lock();
+  return status;
+}
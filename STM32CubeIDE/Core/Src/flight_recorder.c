@@ -0,0 +1,204 @@
+/**
+  ******************************************************************************
+  * @file    flight_recorder.c
+  * @brief   Crash-surviving event ring kept in the .noinit RAM
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <string.h>
+#include "stm32wlxx.h"
+#include "stm32wlxx_ll_rcc.h"
+#include "stm32wlxx_ll_rtc.h"
+#include "flight_recorder.h"
+
+/* Private define ------------------------------------------------------------*/
+#define FLIGHT_RECORDER_MAGIC                       0x464C5452U
+
+/**
+  * @brief Entry tag: event in the high byte, low 24 bits of the index below
+  */
+#define FLIGHT_TAG_INDEX_MASK                       0x00FFFFFFU
+#define FLIGHT_TAG_EVENT_SHIFT                      24U
+
+/**
+  * @brief Size of an event in the diagnostics uplink
+  */
+#define FLIGHT_SUMMARY_EVENT_SIZE                   5U
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Time;   /*!< RTC ticks */
+  uint32_t Arg;
+  uint32_t Tag;    /*!< Written last, a torn entry does not match its index */
+} FlightEntry_t;
+
+typedef struct
+{
+  uint32_t Magic;
+  uint32_t MagicCheck;  /*!< ~Magic */
+  uint32_t Index;       /*!< Free-running index of the next entry */
+  uint32_t BootIndex;   /*!< Index of the first entry of the current boot */
+  uint32_t Boots;
+  uint32_t ErrorResets; /*!< Consecutive boots ended by FlightRecorder_Error */
+  FlightEntry_t Entries[FLIGHT_RECORDER_SIZE];
+} FlightRing_t;
+
+/* Private variables ---------------------------------------------------------*/
+static FlightRing_t Ring __attribute__((section(".noinit")));
+
+/* Previous boot entries still in the ring, and reset flags */
+static uint32_t PrevStart;
+static uint32_t PrevEnd;
+static uint8_t ResetCause;
+
+/* Private function prototypes -----------------------------------------------*/
+static bool IsRingValid(void);
+static void ClearRing(void);
+static bool IsValid(uint32_t index, const FlightEntry_t *entry);
+void FlightRecorder_Fault(const uint32_t *frame);
+
+/* Exported functions --------------------------------------------------------*/
+void FlightRecorder_Init(void)
+{
+  uint32_t flags = RCC->CSR;
+  const FlightEntry_t *last;
+
+  /* A brown-out or power-on reset leaves random RAM behind */
+  if (!IsRingValid() || ((flags & RCC_CSR_BORRSTF) != 0U))
+  {
+    ClearRing();
+  }
+
+  PrevEnd = Ring.Index;
+  PrevStart = Ring.BootIndex;
+  if ((PrevEnd - PrevStart) > FLIGHT_RECORDER_SIZE)
+  {
+    PrevStart = PrevEnd - FLIGHT_RECORDER_SIZE;
+  }
+  /* A chain of error resets ends with a boot which got here and ended otherwise */
+  last = &Ring.Entries[(PrevEnd - 1U) & (FLIGHT_RECORDER_SIZE - 1U)];
+  if ((PrevEnd == PrevStart) || !IsValid(PrevEnd - 1U, last) ||
+      ((last->Tag >> FLIGHT_TAG_EVENT_SHIFT) != FLIGHT_EVENT_ERROR))
+  {
+    Ring.ErrorResets = 0;
+  }
+  ResetCause = (uint8_t)(flags >> 24);
+  LL_RCC_ClearResetFlags();
+
+  Ring.BootIndex = Ring.Index;
+  Ring.Boots++;
+  FlightRecorder_Record(FLIGHT_EVENT_BOOT, flags);
+}
+
+void FlightRecorder_Record(FlightEvent_t event, uint32_t arg)
+{
+  volatile FlightEntry_t *entry;
+  uint32_t index;
+
+  do
+  {
+    index = __LDREXW(&Ring.Index);
+  } while (__STREXW(index + 1U, &Ring.Index) != 0U);
+
+  entry = &Ring.Entries[index & (FLIGHT_RECORDER_SIZE - 1U)];
+  entry->Time = UINT32_MAX - LL_RTC_TIME_GetSubSecond(RTC);
+  entry->Arg = arg;
+  entry->Tag = ((uint32_t)event << FLIGHT_TAG_EVENT_SHIFT) | (index & FLIGHT_TAG_INDEX_MASK);
+}
+
+uint32_t FlightRecorder_Error(uint32_t caller)
+{
+  /* May run before FlightRecorder_Init */
+  if (!IsRingValid())
+  {
+    ClearRing();
+  }
+  FlightRecorder_Record(FLIGHT_EVENT_ERROR, caller);
+  return ++Ring.ErrorResets;
+}
+
+uint16_t FlightRecorder_PreviousCount(void)
+{
+  return (uint16_t)(PrevEnd - PrevStart);
+}
+
+uint8_t FlightRecorder_Summarize(uint8_t *buffer, uint8_t maxSize)
+{
+  uint8_t size = 0;
+  uint32_t index = PrevEnd;
+
+  if (maxSize == 0)
+  {
+    return 0;
+  }
+  buffer[size++] = ResetCause;
+  while ((index != PrevStart) && ((size + FLIGHT_SUMMARY_EVENT_SIZE) <= maxSize))
+  {
+    const FlightEntry_t *entry = &Ring.Entries[--index & (FLIGHT_RECORDER_SIZE - 1U)];
+
+    /* Older entries are overwritten by the current boot */
+    if ((Ring.Index - index) > FLIGHT_RECORDER_SIZE)
+    {
+      break;
+    }
+    /* Torn by the reset */
+    if (!IsValid(index, entry))
+    {
+      continue;
+    }
+    buffer[size++] = (uint8_t)(entry->Tag >> FLIGHT_TAG_EVENT_SHIFT);
+    buffer[size++] = (uint8_t)(entry->Arg >> 24);
+    buffer[size++] = (uint8_t)(entry->Arg >> 16);
+    buffer[size++] = (uint8_t)(entry->Arg >> 8);
+    buffer[size++] = (uint8_t)entry->Arg;
+  }
+  return size;
+}
+
+/**
+  * @brief Hard fault: records the stacked PC and LR and the fault status,
+  *        then resets so that they are reported
+  */
+__attribute__((naked)) void HardFault_Handler(void)
+{
+  __asm volatile(
+    "tst lr, #4            \n"
+    "ite eq                \n"
+    "mrseq r0, msp         \n"
+    "mrsne r0, psp         \n"
+    "b FlightRecorder_Fault\n");
+}
+
+/* Private functions ---------------------------------------------------------*/
+static bool IsRingValid(void)
+{
+  return (Ring.Magic == FLIGHT_RECORDER_MAGIC) && (Ring.MagicCheck == ~FLIGHT_RECORDER_MAGIC) &&
+         ((Ring.Index - Ring.BootIndex) <= (UINT32_MAX / 2U));
+}
+
+static void ClearRing(void)
+{
+  memset(&Ring, 0, sizeof(Ring));
+  Ring.Magic = FLIGHT_RECORDER_MAGIC;
+  Ring.MagicCheck = ~FLIGHT_RECORDER_MAGIC;
+}
+
+static bool IsValid(uint32_t index, const FlightEntry_t *entry)
+{
+  return (entry->Tag & FLIGHT_TAG_INDEX_MASK) == (index & FLIGHT_TAG_INDEX_MASK);
+}
+
+/**
+  * @brief Second half of the hard fault handler
+  * @param frame exception stack frame: r0-r3, r12, lr, pc, xpsr
+  */
+__attribute__((used, noreturn)) void FlightRecorder_Fault(const uint32_t *frame)
+{
+  FlightRecorder_Record(FLIGHT_EVENT_FAULT_PC, frame[6]);
+  FlightRecorder_Record(FLIGHT_EVENT_FAULT_LR, frame[5]);
+  FlightRecorder_Record(FLIGHT_EVENT_FAULT_STATUS, SCB->CFSR);
+  NVIC_SystemReset();
+}
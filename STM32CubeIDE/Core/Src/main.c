@@ -25,6 +25,8 @@
 /* USER CODE BEGIN Includes */
 #include <stdio.h>
 #include "solarpath.h"
+#include "stm32_adv_trace.h"
+#include "flight_recorder.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -34,6 +36,11 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/**
+  * @brief Consecutive error resets before Error_Handler halts instead, so
+  *        that a persistent init failure does not loop
+  */
+#define ERROR_HANDLER_MAX_RESETS                    4U
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -58,6 +65,7 @@ SUBGHZ_HandleTypeDef hsubghz;
 UART_HandleTypeDef huart2;
 
 /* USER CODE BEGIN PV */
+DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE END PV */
 
@@ -75,9 +83,10 @@ static void MX_I2C2_Init(void);
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+/* Queued in the trace FIFO like the output of _write */
 int __io_putchar(int ch) {
 	uint8_t c = ch;
-	HAL_UART_Transmit(&huart2, &c, 1, 1000);
+	UTIL_ADV_TRACE_Send(&c, 1);
 	return 0;
 }
 
@@ -560,10 +569,21 @@ static void MX_GPIO_Init(void)
 void Error_Handler(void)
 {
   /* USER CODE BEGIN Error_Handler_Debug */
-  /* User can add his own implementation to report the HAL error return state */
+  /* Reported by the flight recorder after the reset */
+  if (FlightRecorder_Error((uint32_t)(uintptr_t)__builtin_return_address(0)) <= ERROR_HANDLER_MAX_RESETS)
+  {
+    NVIC_SystemReset();
+  }
+
+  /* Persistent: halt in Stop 2 until a power cycle or a reset from the pin */
   __disable_irq();
-  while (1)
+  for (uint32_t i = 0; i < (sizeof(NVIC->ICER) / sizeof(NVIC->ICER[0])); i++)
+  {
+    NVIC->ICER[i] = UINT32_MAX;
+  }
+  for (;;)
   {
+    HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
   }
   /* USER CODE END Error_Handler_Debug */
 }
@@ -0,0 +1,163 @@
+/**
+  ******************************************************************************
+  * @file    mem_bench.c
+  * @brief   On-target micro-benchmark of the UTIL_MEM routines
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mem_bench.h"
+
+#if (UTIL_MEM_BENCH == 1)
+#include "stm32wlxx.h"
+#include "stm32wlxx_hal.h"
+#include "stm32_mem.h"
+#include "sys_log.h"
+
+/* Private define ------------------------------------------------------------*/
+/**
+  * @brief Calls per measurement, the cycles are averaged over them
+  */
+#define MEM_BENCH_CALLS                             16U
+
+/**
+  * @brief Room for 256 bytes at the largest offset
+  */
+#define MEM_BENCH_BUFFER_SIZE                       (256U + 8U)
+
+/**
+  * @brief Time left to the trace to drain a record, in ms
+  */
+#define MEM_BENCH_LOG_DELAY                         5U
+
+/* Private typedef -----------------------------------------------------------*/
+typedef void (*MemBenchCopy_t)(void *dst, const void *src, uint16_t size);
+typedef void (*MemBenchFill_t)(void *dst, uint8_t value, uint16_t size);
+
+/* Private function prototypes -----------------------------------------------*/
+static void ByteCpy(void *dst, const void *src, uint16_t size);
+static void ByteCpyr(void *dst, const void *src, uint16_t size);
+static void ByteSet(void *dst, uint8_t value, uint16_t size);
+
+/* Private variables ---------------------------------------------------------*/
+/* Read through volatile pointers, so that no call is inlined or folded */
+static MemBenchCopy_t volatile const CopyOld = ByteCpy;
+static MemBenchCopy_t volatile const CopyNew = UTIL_MEM_cpy_8;
+static MemBenchCopy_t volatile const CopyrOld = ByteCpyr;
+static MemBenchCopy_t volatile const CopyrNew = UTIL_MEM_cpyr_8;
+static MemBenchFill_t volatile const FillOld = ByteSet;
+static MemBenchFill_t volatile const FillNew = UTIL_MEM_set_8;
+
+static const uint16_t Sizes[] = { 4, 8, 13, 16, 32, 51, 64, 115, 128, 222, 256 };
+
+/* Destination and source offsets from a word boundary */
+static const uint8_t DstOffsets[] = { 0, 0, 3 };
+static const uint8_t SrcOffsets[] = { 0, 1, 0 };
+
+static uint32_t Src[MEM_BENCH_BUFFER_SIZE / 4U];
+static uint32_t Dst[MEM_BENCH_BUFFER_SIZE / 4U];
+
+/* Private functions ---------------------------------------------------------*/
+/* The byte loops of STM32Cube, kept as loops rather than turned into libc calls */
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static void ByteCpy(void *dst, const void *src, uint16_t size)
+{
+  uint8_t *dst8 = (uint8_t *)dst;
+  const uint8_t *src8 = (const uint8_t *)src;
+
+  while (size--)
+  {
+    *dst8++ = *src8++;
+  }
+}
+
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static void ByteCpyr(void *dst, const void *src, uint16_t size)
+{
+  uint8_t *dst8 = (uint8_t *)dst + (size - 1);
+  const uint8_t *src8 = (const uint8_t *)src;
+
+  while (size--)
+  {
+    *dst8-- = *src8++;
+  }
+}
+
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+static void ByteSet(void *dst, uint8_t value, uint16_t size)
+{
+  uint8_t *dst8 = (uint8_t *)dst;
+
+  while (size--)
+  {
+    *dst8++ = value;
+  }
+}
+
+static uint32_t TimeCopy(MemBenchCopy_t volatile const *fn, uint8_t *dst, const uint8_t *src, uint16_t size)
+{
+  uint32_t start;
+  uint32_t cycles;
+
+  UTILS_ENTER_CRITICAL_SECTION();
+  start = DWT->CYCCNT;
+  for (uint32_t i = 0; i < MEM_BENCH_CALLS; i++)
+  {
+    (*fn)(dst, src, size);
+  }
+  cycles = DWT->CYCCNT - start;
+  UTILS_EXIT_CRITICAL_SECTION();
+  return cycles / MEM_BENCH_CALLS;
+}
+
+static uint32_t TimeFill(MemBenchFill_t volatile const *fn, uint8_t *dst, uint16_t size)
+{
+  uint32_t start;
+  uint32_t cycles;
+
+  UTILS_ENTER_CRITICAL_SECTION();
+  start = DWT->CYCCNT;
+  for (uint32_t i = 0; i < MEM_BENCH_CALLS; i++)
+  {
+    (*fn)(dst, (uint8_t)i, size);
+  }
+  cycles = DWT->CYCCNT - start;
+  UTILS_EXIT_CRITICAL_SECTION();
+  return cycles / MEM_BENCH_CALLS;
+}
+
+/* Exported functions --------------------------------------------------------*/
+void MemBench_Run(void)
+{
+  uint32_t demcr = CoreDebug->DEMCR;
+
+  CoreDebug->DEMCR = demcr | CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  for (uint32_t i = 0; i < sizeof(Src); i++)
+  {
+    ((uint8_t *)Src)[i] = (uint8_t)i;
+  }
+
+  for (uint32_t a = 0; a < sizeof(DstOffsets); a++)
+  {
+    uint8_t *dst = (uint8_t *)Dst + DstOffsets[a];
+    const uint8_t *src = (const uint8_t *)Src + SrcOffsets[a];
+
+    for (uint32_t i = 0; i < (sizeof(Sizes) / sizeof(Sizes[0])); i++)
+    {
+      uint16_t size = Sizes[i];
+
+      SYS_LOG("mem %u/%u: cpy %u>%u cpyr %u>%u set %u>%u\n", size, a,
+              TimeCopy(&CopyOld, dst, src, size), TimeCopy(&CopyNew, dst, src, size),
+              TimeCopy(&CopyrOld, dst, src, size), TimeCopy(&CopyrNew, dst, src, size),
+              TimeFill(&FillOld, dst, size), TimeFill(&FillNew, dst, size));
+      HAL_Delay(MEM_BENCH_LOG_DELAY);
+    }
+  }
+
+  DWT->CTRL &= ~DWT_CTRL_CYCCNTENA_Msk;
+  CoreDebug->DEMCR = demcr;
+}
+#endif /* UTIL_MEM_BENCH == 1 */
@@ -0,0 +1,126 @@
+/**
+  ******************************************************************************
+  * @file    settings_store.c
+  * @brief   Settings block kept in flash across resets and updates
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "stm32wlxx_hal.h"
+#include "stm32_mem.h"
+#include "flash_if.h"
+#include "settings_store.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SETTINGS_STORE_MAGIC                        0x54544553U  /* "SETT" */
+#define SETTINGS_STORE_BANKS                        2U
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief Copy of the block: header, data, then the CRC of both
+  */
+typedef struct
+{
+  uint32_t Magic;
+  uint32_t Sequence;   /*!< Incremented by each write */
+  uint16_t Version;    /*!< Layout version of the data */
+  uint16_t Size;       /*!< Data size */
+  uint8_t Data[SETTINGS_STORE_MAX_SIZE + sizeof(uint32_t)];
+} SettingsCopy_t;
+
+/* Private variables ---------------------------------------------------------*/
+extern CRC_HandleTypeDef hcrc;
+/* Flash layout, from the linker script */
+extern uint8_t _settings_start[];
+
+static SettingsCopy_t Copy;
+
+/* Private functions ---------------------------------------------------------*/
+static const SettingsCopy_t *Bank(uint32_t bank)
+{
+  return (const SettingsCopy_t *)((uint32_t)_settings_start + (bank * FLASH_PAGE_SIZE));
+}
+
+static uint32_t CopySize(uint16_t size)
+{
+  return offsetof(SettingsCopy_t, Data) + size;
+}
+
+static uint32_t CopyCrc(const SettingsCopy_t *copy, uint16_t size)
+{
+  return HAL_CRC_Calculate(&hcrc, (uint32_t *)copy, CopySize(size));
+}
+
+static bool IsValid(const SettingsCopy_t *copy)
+{
+  uint32_t crc;
+
+  if ((copy->Magic != SETTINGS_STORE_MAGIC) || (copy->Size > SETTINGS_STORE_MAX_SIZE))
+  {
+    return false;
+  }
+  UTIL_MEM_cpy_8(&crc, &copy->Data[copy->Size], sizeof(crc));
+  return CopyCrc(copy, copy->Size) == crc;
+}
+
+/**
+  * @brief Returns the bank of the newest valid copy
+  * @retval bank, SETTINGS_STORE_BANKS if none
+  */
+static uint32_t Newest(void)
+{
+  uint32_t newest = SETTINGS_STORE_BANKS;
+
+  for (uint32_t bank = 0; bank < SETTINGS_STORE_BANKS; bank++)
+  {
+    if (IsValid(Bank(bank)) &&
+        ((newest == SETTINGS_STORE_BANKS) || ((int32_t)(Bank(bank)->Sequence - Bank(newest)->Sequence) > 0)))
+    {
+      newest = bank;
+    }
+  }
+  return newest;
+}
+
+/* Exported functions --------------------------------------------------------*/
+bool SettingsStore_Load(void *data, uint16_t size, uint16_t *version)
+{
+  uint32_t newest = Newest();
+  const SettingsCopy_t *copy;
+
+  if ((newest == SETTINGS_STORE_BANKS) || (size > SETTINGS_STORE_MAX_SIZE))
+  {
+    return false;
+  }
+  copy = Bank(newest);
+  UTIL_MEM_cpy_8(data, copy->Data, (copy->Size < size) ? copy->Size : size);
+  *version = copy->Version;
+  return true;
+}
+
+bool SettingsStore_Save(const void *data, uint16_t size, uint16_t version)
+{
+  uint32_t newest = Newest();
+  uint32_t bank = (newest + 1U) % SETTINGS_STORE_BANKS;
+  uint32_t crc;
+
+  if (size > SETTINGS_STORE_MAX_SIZE)
+  {
+    return false;
+  }
+  Copy.Magic = SETTINGS_STORE_MAGIC;
+  Copy.Sequence = (newest == SETTINGS_STORE_BANKS) ? 0U : (Bank(newest)->Sequence + 1U);
+  Copy.Version = version;
+  Copy.Size = size;
+  UTIL_MEM_cpy_8(Copy.Data, data, size);
+  crc = CopyCrc(&Copy, size);
+  UTIL_MEM_cpy_8(&Copy.Data[size], &crc, sizeof(crc));
+
+  if ((FLASH_IF_Erase((uint32_t)Bank(bank), FLASH_PAGE_SIZE) != FLASH_IF_OK) ||
+      (FLASH_IF_Write((uint32_t)Bank(bank), (const uint8_t *)&Copy, CopySize(size) + sizeof(crc)) != FLASH_IF_OK))
+  {
+    return false;
+  }
+  return IsValid(Bank(bank));
+}
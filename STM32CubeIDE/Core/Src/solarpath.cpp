@@ -2,6 +2,9 @@
 
 #include "main.h"
 #include "app_lorawan.h"
+#include "sensor_driver.h"
+#include "stm32_lpm.h"
+#include "utilities_def.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -178,25 +181,18 @@ class InBitStream {
 class OutBitStream {
 
 public:
-	OutBitStream()
-	  : m_len(sizeof(m_buf)),
-		m_pos(0),
-		m_bitBuf(0),
-		m_bitPos(0) {
-	}
-
-	OutBitStream(const OutBitStream &from)
-	  : m_len(sizeof(m_buf)),
+	OutBitStream(uint8_t *_buf, size_t _len)
+	  : m_buf(_buf),
+		m_len(_len),
 		m_pos(0),
 		m_bitBuf(0),
-		m_bitPos(0) {
-		PutBytes(from.Buffer(), from.Length());
+		m_bitPos(8) {
 	}
 
-	~OutBitStream() {
-	}
+	OutBitStream(const OutBitStream &) = delete;
+	OutBitStream &operator=(const OutBitStream &) = delete;
 
-	void Reset() { m_pos = 0; m_len = 0; InitBits(); }
+	void Reset() { m_pos = 0; InitBits(); }
 
 	size_t Position() const { return m_pos; }
 	size_t Length() const { return m_len; }
@@ -207,7 +203,9 @@ public:
 	}
 
 	void PutUint8(uint8_t v) {
-		m_buf[m_pos++] = v;
+		if (m_pos < m_len) {
+			m_buf[m_pos++] = v;
+		}
 	}
 	void PutUint16(uint16_t v) {
 		PutUint8(uint8_t((v>>8)&0xFF));
@@ -281,20 +279,9 @@ public:
 		PutExpGolomb(uint32_t(v));
 	}
 
-	OutBitStream &operator=(const OutBitStream &from) {
-		if (&from == this) {
-			return *this;
-		}
-		m_bitBuf = 0;
-		m_bitPos = 0;
-		Reset();
-		PutBytes(from.Buffer(), from.Length());
-		return *this;
-	}
-
 private:
 
-	uint8_t m_buf[222]; // Max LoraWAN packet size
+	uint8_t *m_buf;
 
 	size_t m_len;
 	size_t m_pos;
@@ -303,78 +290,151 @@ private:
 	int32_t m_bitPos;
 };
 
-class leds {
+// Solar and battery voltages, averaged over the last samples
+class supply_voltages : public sensor_driver<supply_voltages> {
 public:
-	static constexpr float auto_threshold_voltage = 0.400f;
-	static constexpr size_t num_strips = 3;
-	static constexpr size_t num_leds = 3;
+	static constexpr size_t num_samples = 4;
+	static constexpr float system_voltage = 3.4f;
+	static constexpr float battery_divider = 2.2f;
+	// Battery test divider switched on before the conversions
+	static constexpr uint32_t settle_spins = 1000;
 
-	static leds &instance();
+	struct voltages {
+		float solar;
+		float battery;
+	};
 
-	void setrgb(size_t led, uint16_t r, uint16_t g, uint16_t b);
+	void init();
+	void start();
+	void complete();
+	const voltages &get() const { return _voltages; }
+	template <typename Stream>
+	void put(Stream &stream);
 
-	void setenabled(bool state) { enabled = state; }
-	void setauto(bool state) { automode = state; }
+	void setaveraging(size_t samples) { _averaging = (samples < 1) ? 1 : (samples > num_samples) ? num_samples : samples; }
 
-	bool on() const { return enabled;  }
+private:
+	struct averaged {
+		uint32_t samples[num_samples];
+		size_t index;
+	};
 
-	void update() { push(); }
+	uint32_t read_channel(uint32_t channel) const;
+	float average(averaged &ch, uint32_t sample) const;
 
-private:
+	voltages _voltages = {};
+	averaged _solar = {};
+	averaged _battery = {};
+	size_t _averaging = num_samples;
+};
 
-	void init();
-	void convert(size_t led, uint16_t r, uint16_t g, uint16_t b);
-	void push();
+void supply_voltages::init() {
+	for (uint32_t c = 0; c < 32; c++) {
+		start();
+		settle(settle_spins);
+		complete();
+	}
+}
 
-	bool enabled;
-	bool automode;
+uint32_t supply_voltages::read_channel(uint32_t channel) const {
 
-	static constexpr size_t buf_pad = 8;
-	static constexpr size_t buf_size = num_leds*3*16+buf_pad;
+    MX_ADC_Init();
 
-	uint16_t red[num_strips];
-	uint16_t grn[num_strips];
-	uint16_t blu[num_strips];
-	uint8_t  buf[num_strips][buf_size];
+    if (HAL_ADCEx_Calibration_Start(&hadc) != HAL_OK) {
+    	Error_Handler();
+    }
 
-};
+	ADC_ChannelConfTypeDef sConfig;
+	memset(&sConfig, 0, sizeof(sConfig));
 
-class i2c {
-public:
-	static i2c &instance();
+    sConfig.Channel = channel;
+    sConfig.Rank = ADC_REGULAR_RANK_1;
+    sConfig.SamplingTime = ADC_SAMPLINGTIME_COMMON_1;
 
-	void update();
+    HAL_ADC_ConfigChannel(&hadc, &sConfig);
 
-	float temperature() const { return _temperature_1 != 0 ? _temperature_1 :_temperature_0; }
-	float humidity() const { return _humidity; }
+    HAL_ADC_Start(&hadc);
 
-private:
-	float _temperature_0;
-	float _temperature_1;
-	float _humidity;
+	HAL_ADC_PollForConversion(&hadc,HAL_MAX_DELAY);
 
-	void init();
-};
+	uint32_t value = HAL_ADC_GetValue(&hadc);
+	HAL_ADC_Stop(&hadc);
 
+    HAL_ADC_DeInit(&hadc);
+
+	return value;
+}
 
-i2c &i2c::instance() {
-	static i2c i;
-	static bool init = false;
-	if (!init) {
-		init = true;
-		i.init();
+// Mean of the last _averaging samples
+float supply_voltages::average(averaged &ch, uint32_t sample) const {
+	ch.samples[ch.index++] = sample;
+	ch.index %= num_samples;
+	float output = 0.0f;
+	for (size_t c = 1; c <= _averaging; c++) {
+		output += float(ch.samples[(ch.index + num_samples - c) % num_samples]);
 	}
-	return i;
+	output *= 1.0f / float(_averaging);
+	return output * (1.0f / (4095.0f / system_voltage));
+}
+
+void supply_voltages::start() {
+	HAL_GPIO_WritePin(BAT_TEST_GPIO_Port, BAT_TEST_Pin, GPIO_PIN_SET);
+}
+
+__attribute__((optimize("Os")))
+void supply_voltages::complete() {
+	_voltages.solar = average(_solar, read_channel(ADC_CHANNEL_11));
+	HAL_GPIO_WritePin(BAT_TEST_GPIO_Port, BAT_TEST_Pin, GPIO_PIN_RESET);
+	_voltages.battery = average(_battery, read_channel(ADC_CHANNEL_3)) * battery_divider;
+}
+
+template <typename Stream>
+void supply_voltages::put(Stream &stream) {
+	uint32_t bt = std::max(int32_t(0), std::min( int32_t(0xF), int32_t(10.0f * (_voltages.battery - 2.7f))));
+	uint32_t sv = std::max(int32_t(0), std::min( int32_t(0xF), int32_t(20.0f * (_voltages.solar))));
+	stream.PutBits(bt, 4);
+	stream.PutBits(sv, 4);
 }
 
-void i2c::init() {
-	memset(this, 0, sizeof(i2c));
-	update();
+// AT30TS01 temperature and ENS210 temperature and humidity on I2C2
+class climate : public sensor_driver<climate> {
+public:
+	struct reading {
+		float temperature;
+		float humidity;
+	};
+
+	void init();
+	void complete();
+	const reading &get() const { return _reading; }
+	template <typename Stream>
+	void put(Stream &stream);
+
+private:
+	static constexpr uint8_t at30ts01_address = 0b00110000;
+	static constexpr uint8_t ens210_address = 0b10000110;
+
+	reading _reading = {};
+	float _temperature_0 = 0.0f;
+	float _temperature_1 = 0.0f;
+};
+
+void climate::init() {
+	if (HAL_I2C_IsDeviceReady(&hi2c2, ens210_address, 8, HAL_MAX_DELAY) == HAL_OK) {
+		uint8_t th_reset[] = { 0x10, 0x80 };
+		HAL_I2C_Master_Transmit(&hi2c2, ens210_address, th_reset, 2, HAL_MAX_DELAY);
+		HAL_Delay(2);
+		uint8_t th_normal[] = { 0x10, 0x00 };
+		HAL_I2C_Master_Transmit(&hi2c2, ens210_address, th_normal, 2, HAL_MAX_DELAY);
+		HAL_Delay(2);
+	}
+	complete();
 }
 
-void i2c::update() {
+// The ENS210 conversion started by the previous measurement is read, then
+// the next one is started
+void climate::complete() {
 
-	const uint8_t at30ts01_address = 0b00110000;
 	if (HAL_I2C_IsDeviceReady(&hi2c2, at30ts01_address, 8, HAL_MAX_DELAY) == HAL_OK) {
 		uint8_t temp_reg = 0x05;
 		uint8_t temp_value[2] = { 0, 0 };
@@ -383,19 +443,7 @@ void i2c::update() {
 		_temperature_0 = ( ( ( (temp_value[0] << 8) | (temp_value[1] << 0) ) & 0xFFF) ) / 16.0f ;
 	}
 
-	const uint8_t ens210_address = 0b10000110;
 	if (HAL_I2C_IsDeviceReady(&hi2c2, ens210_address, 8, HAL_MAX_DELAY) == HAL_OK) {
-		static bool reset = false;
-		if (!reset) {
-			reset = true;
-			uint8_t th_reset[] = { 0x10, 0x80 };
-			HAL_I2C_Master_Transmit(&hi2c2, ens210_address, th_reset, 2, HAL_MAX_DELAY);
-			HAL_Delay(2);
-			uint8_t th_normal[] = { 0x10, 0x00 };
-			HAL_I2C_Master_Transmit(&hi2c2, ens210_address, th_normal, 2, HAL_MAX_DELAY);
-			HAL_Delay(2);
-		}
-
 		uint8_t th_read = 0x30;
 		uint8_t th_data[6] = { 0, 0, 0, 0, 0, 0 };
 		HAL_I2C_Master_Transmit(&hi2c2, ens210_address, (uint8_t *)&th_read, sizeof(th_read), HAL_MAX_DELAY);
@@ -411,119 +459,100 @@ void i2c::update() {
 
 		uint32_t h_data = (h_val>>0 ) & 0xffff;
 		float H = (float)h_data/51200;
-		_humidity = H;
+		_reading.humidity = H;
 
 		uint8_t th_start_single[] = { 0x21, 0x00, 0x03 };
 		HAL_I2C_Master_Transmit(&hi2c2, ens210_address, (uint8_t *)&th_start_single, sizeof(th_start_single), HAL_MAX_DELAY);
 	}
-}
-
-class adc {
-public:
-	static constexpr size_t num_samples = 4;
-	static constexpr float system_voltage = 3.4f;
-	static constexpr float battery_divider = 2.2f;
 
-	static adc &instance();
+	_reading.temperature = _temperature_1 != 0 ? _temperature_1 : _temperature_0;
+}
 
-	float solar_voltage() const { return _solar; }
-	float battery_voltage() const { return _battery; }
+template <typename Stream>
+void climate::put(Stream &stream) {
+	uint32_t tp = std::max(int32_t(0), std::min( int32_t(0xFF), int32_t(4.0f * (_reading.temperature + 10.0f))));
+	uint32_t hm = std::max(int32_t(0), std::min( int32_t(0x3F), int32_t(63.0f * (_reading.humidity))));
+	stream.PutBits(tp, 8);
+	stream.PutBits(hm, 6);
+}
 
-	void update();
+// PGOOD of the solar charger
+class power_good : public sensor_driver<power_good> {
+public:
+	void complete() { _good = HAL_GPIO_ReadPin(PGOOD_GPIO_Port, PGOOD_Pin) == GPIO_PIN_SET; }
+	bool get() const { return _good; }
+	template <typename Stream>
+	void put(Stream &stream) { stream.PutBits(_good ? 1 : 0, 1); }
 
 private:
-	uint32_t read_channel(uint32_t channel) const;
+	bool _good = true;
+};
 
-	void init();
+class motion : public sensor_driver<motion> {
+public:
+	void complete() {
+		// TODO
+	}
+	bool get() const { return _active; }
+	// Reported once
+	template <typename Stream>
+	void put(Stream &stream) { stream.PutBits(isActiveAndClear() ? 1 : 0, 1); }
 
-	float _solar;
-	float _battery;
+private:
+	bool isActiveAndClear();
 
-	uint32_t _solar_samples[num_samples];
-	size_t _solar_samples_idx;
-	uint32_t _battery_samples[num_samples];
-	size_t _battery_samples_idx;
+	bool _active = false;
 };
 
-adc &adc::instance() {
-	static adc i;
-	static bool init = false;
-	if (!init) {
-		init = true;
-		i.init();
-	}
-	return i;
-}
-
-void adc::init() {
-	memset(this, 0, sizeof(adc));
-	for (uint32_t c = 0; c < 32; c++) {
-		update();
+bool motion::isActiveAndClear() {
+	if (_active) {
+		_active = false;
+		return true;
 	}
+	return false;
 }
 
-uint32_t adc::read_channel(uint32_t channel) const {
-
-    MX_ADC_Init();
-
-    if (HAL_ADCEx_Calibration_Start(&hadc) != HAL_OK) {
-    	Error_Handler();
-    }
+class leds : public sensor_driver<leds> {
+public:
+	static constexpr float default_auto_threshold_voltage = 0.400f;
+	static constexpr size_t num_strips = 3;
+	static constexpr size_t num_leds = 3;
 
-	ADC_ChannelConfTypeDef sConfig;
-	memset(&sConfig, 0, sizeof(sConfig));
+	void setrgb(size_t led, uint16_t r, uint16_t g, uint16_t b);
 
-    sConfig.Channel = channel;
-    sConfig.Rank = ADC_REGULAR_RANK_1;
-    sConfig.SamplingTime = ADC_SAMPLINGTIME_COMMON_1;
+	void setenabled(bool state) { enabled = state; }
+	void setauto(bool state) { automode = state; }
+	void setnight(bool state) { night = state; scheduled = true; }
+	void clearnight() { scheduled = false; }
+	void setthreshold(float volts) { threshold = volts; }
+	float autothreshold() const { return threshold; }
 
-    HAL_ADC_ConfigChannel(&hadc, &sConfig);
+	bool get() const { return enabled;  }
 
-    HAL_ADC_Start(&hadc);
+	// Pushes the LED state, the solar voltage drives the auto mode
+	template <typename Registry>
+	void apply(Registry &registry) { push(registry.template get<supply_voltages>().value().solar); }
 
-	HAL_ADC_PollForConversion(&hadc,HAL_MAX_DELAY);
+private:
 
-	uint32_t value = HAL_ADC_GetValue(&hadc);
-	HAL_ADC_Stop(&hadc);
+	void convert(size_t led, uint16_t r, uint16_t g, uint16_t b);
+	void push(float solar);
 
-    HAL_ADC_DeInit(&hadc);
+	bool enabled = false;
+	bool automode = false;
+	bool scheduled = false;
+	bool night = false;
+	float threshold = default_auto_threshold_voltage;
 
-	return value;
-}
+	static constexpr size_t buf_pad = 8;
+	static constexpr size_t buf_size = num_leds*3*16+buf_pad;
 
-__attribute__((optimize("Os")))
-void adc::update() {
-	HAL_GPIO_WritePin(BAT_TEST_GPIO_Port, BAT_TEST_Pin, GPIO_PIN_SET);
-	for (volatile uint32_t t = 0; t < 1000; t++) {}
-	auto process = [=] (uint32_t channel, uint32_t *samples, size_t &index, float &output) {
-		samples[index++] = read_channel(channel);
-		index %= num_samples;
-		output = 0.0f;
-		for (size_t c = 0; c < num_samples; c++) {
-			output += float(samples[c]);
-		}
-		output *= 1.0f / float(num_samples);
-		output *= 1.0f / (4095.0f / system_voltage);
-	};
-	process(ADC_CHANNEL_11, _solar_samples, _solar_samples_idx, _solar);
-	HAL_GPIO_WritePin(BAT_TEST_GPIO_Port, BAT_TEST_Pin, GPIO_PIN_RESET);
-	process(ADC_CHANNEL_3, _battery_samples, _battery_samples_idx, _battery);
-	_battery *= battery_divider;
-}
+	uint16_t red[num_strips] = {};
+	uint16_t grn[num_strips] = {};
+	uint16_t blu[num_strips] = {};
+	uint8_t  buf[num_strips][buf_size] = {};
 
-leds &leds::instance() {
-	static leds i;
-	static bool init = false;
-	if (!init) {
-		init = true;
-		i.init();
-	}
-	return i;
-}
-
-void leds::init() {
-	memset(this, 0, sizeof(leds));
-}
+};
 
 __attribute__((optimize("Os")))
 void leds::convert(size_t led, uint16_t r, uint16_t g, uint16_t b) {
@@ -560,29 +589,42 @@ void leds::setrgb(size_t led, uint16_t r, uint16_t g, uint16_t b) {
 }
 
 __attribute__((optimize("Os")))
-void leds::push() {
+void leds::push(float solar) {
 
+	// No Stop mode until the DMA transfer completes, see HAL_SPI_TxCpltCallback
 	auto on = [=] () mutable {
 		HAL_GPIO_WritePin(LOAD_ENABLE_GPIO_Port, LOAD_ENABLE_Pin, GPIO_PIN_SET);
-		HAL_SPI_Transmit_DMA(&hspi1, &buf[0][0], buf_size);
+		UTIL_LPM_SetStopMode((1 << CFG_LPM_LED_Id), UTIL_LPM_DISABLE);
+		if (HAL_SPI_Transmit_DMA(&hspi1, &buf[0][0], buf_size) != HAL_OK) {
+			UTIL_LPM_SetStopMode((1 << CFG_LPM_LED_Id), UTIL_LPM_ENABLE);
+		}
 	};
 
 	auto off = [=] () mutable {
 		HAL_GPIO_WritePin(LOAD_ENABLE_GPIO_Port, LOAD_ENABLE_Pin, GPIO_PIN_SET);
 		uint8_t ones[16]; memset(ones, 0xFF, sizeof(ones));
-		HAL_SPI_Transmit_DMA(&hspi1, &ones[0], sizeof(ones));
+		UTIL_LPM_SetStopMode((1 << CFG_LPM_LED_Id), UTIL_LPM_DISABLE);
+		if (HAL_SPI_Transmit_DMA(&hspi1, &ones[0], sizeof(ones)) != HAL_OK) {
+			UTIL_LPM_SetStopMode((1 << CFG_LPM_LED_Id), UTIL_LPM_ENABLE);
+		}
 		HAL_GPIO_WritePin(LOAD_ENABLE_GPIO_Port, LOAD_ENABLE_Pin, GPIO_PIN_RESET);
 	};
 
-	if (automode && enabled) {
+	if (automode && enabled && scheduled) {
+		if (night) {
+			on();
+		} else {
+			off();
+		}
+	} else if (automode && enabled) {
 		if (HAL_GPIO_ReadPin(LOAD_ENABLE_GPIO_Port, LOAD_ENABLE_Pin) == GPIO_PIN_SET) {
-			if (adc::instance().solar_voltage() < (auto_threshold_voltage - 0.050f)) {
+			if (solar < (threshold - 0.050f)) {
 				off();
 			} else {
 				on();
 			}
 		} else {
-			if (adc::instance().solar_voltage() > (auto_threshold_voltage + 0.050f)) {
+			if (solar > (threshold + 0.050f)) {
 				on();
 			} else {
 				off();
@@ -597,68 +639,36 @@ void leds::push() {
 	}
 }
 
-class motion {
-public:
-	static motion &instance();
-
-	void update();
-	bool isActiveAndClear();
-
-private:
-	bool _active;
-	void init();
-};
-
-
-motion &motion::instance() {
-	static motion i;
-	static bool init = false;
-	if (!init) {
-		init = true;
-		i.init();
+// End of an LED transfer, Stop mode allowed again
+extern "C" void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+	if (hspi == &hspi1) {
+		UTIL_LPM_SetStopMode((1 << CFG_LPM_LED_Id), UTIL_LPM_ENABLE);
 	}
-	return i;
 }
 
-void motion::init() {
-	memset(this, 0, sizeof(motion));
-	update();
+extern "C" void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+	if (hspi == &hspi1) {
+		UTIL_LPM_SetStopMode((1 << CFG_LPM_LED_Id), UTIL_LPM_ENABLE);
+	}
 }
 
-void motion::update() {
-	// TODO
-}
+// Installed drivers, in the order of their telemetry fields. Constant
+// initialized, the hardware is set up by system_init().
+static driver_registry<supply_voltages, climate, power_good, motion, leds> drivers;
 
-bool motion::isActiveAndClear() {
-	if (_active) {
-		_active = false;
-		return true;
-	}
-	return false;
+void system_init() {
+	drivers.init();
 }
 
 __attribute__((optimize("Os")))
-const uint8_t *encode_packet(uint8_t *len) {
-	static OutBitStream bitstream;
-
-	bitstream.Reset();
-	uint32_t bt = std::max(int32_t(0), std::min( int32_t(0xF), int32_t(10.0f * (adc::instance().battery_voltage() - 2.7f))));
-	uint32_t sv = std::max(int32_t(0), std::min( int32_t(0xF), int32_t(20.0f * (adc::instance().solar_voltage()))));
-	uint32_t tp = std::max(int32_t(0), std::min( int32_t(0xFF), int32_t(4.0f * (i2c::instance().temperature() + 10.0f))));
-	uint32_t hm = std::max(int32_t(0), std::min( int32_t(0x3F), int32_t(63.0f * (i2c::instance().humidity()))));
+uint8_t encode_packet(uint8_t *buffer, uint8_t maxLen) {
+	OutBitStream bitstream(buffer, maxLen);
 
-	bitstream.PutBits(bt, 4);
-	bitstream.PutBits(sv, 4);
-	bitstream.PutBits(tp, 8);
-	bitstream.PutBits(hm, 6);
-
-	bitstream.PutBits(HAL_GPIO_ReadPin(PGOOD_GPIO_Port, PGOOD_Pin) == GPIO_PIN_SET ? 1 : 0, 1);
-	bitstream.PutBits(motion::instance().isActiveAndClear() ? 1 : 0, 1);
+	drivers.encode(bitstream);
 
 	bitstream.FlushBits();
 
-	*len = uint8_t(bitstream.Position());
-	return bitstream.Buffer();
+	return uint8_t(bitstream.Position());
 }
 
 __attribute__((optimize("Os")))
@@ -669,9 +679,10 @@ void decode_packet(const uint8_t *packet, uint32_t len) {
 	}
 
 	InBitStream bitstream(packet, len);
+	leds &l = drivers.get<leds>();
 
-	leds::instance().setenabled(bitstream.GetBits(1));
-	leds::instance().setauto(bitstream.GetBits(1));
+	l.setenabled(bitstream.GetBits(1));
+	l.setauto(bitstream.GetBits(1));
 
 	auto expand = [=] () mutable {
 		uint16_t v = bitstream.GetBits(6);
@@ -679,15 +690,63 @@ void decode_packet(const uint8_t *packet, uint32_t len) {
 		return v;
 	};
 
-	leds::instance().setrgb(0,expand(),expand(),expand());
-	leds::instance().setrgb(1,expand(),expand(),expand());
-	leds::instance().setrgb(2,expand(),expand(),expand());
+	l.setrgb(0,expand(),expand(),expand());
+	l.setrgb(1,expand(),expand(),expand());
+	l.setrgb(2,expand(),expand(),expand());
 
 }
 
 __attribute__((optimize("Os")))
 void system_update() {
-	adc::instance().update();
-	i2c::instance().update();
-	leds::instance().update();
+	drivers.update();
+}
+
+bool system_set_night(bool night, bool force) {
+	leds &l = drivers.get<leds>();
+
+	// The solar voltage only confirms the scheduled transition
+	if (!force) {
+		drivers.measure<supply_voltages>();
+		float v = drivers.get<supply_voltages>().value().solar;
+		if (night && v > (l.autothreshold() + 0.050f)) {
+			return false;
+		}
+		if (!night && v < (l.autothreshold() - 0.050f)) {
+			return false;
+		}
+	}
+	l.setnight(night);
+	l.actuate(drivers);
+	return true;
+}
+
+void system_clear_night() {
+	drivers.get<leds>().clearnight();
+}
+
+void system_set_auto_threshold(float volts) {
+	drivers.get<leds>().setthreshold(volts);
+}
+
+void system_set_averaging(uint8_t samples) {
+	drivers.get<supply_voltages>().setaveraging(samples);
+}
+
+float system_temperature() {
+	return drivers.get<climate>().value().temperature;
+}
+
+bool system_alarm() {
+	static bool pgood = true;
+	bool alarm = drivers.get<motion>().value();
+
+	// Only the loss of PGOOD is an event, its return comes with the telemetry
+	drivers.measure<power_good>();
+	bool now = drivers.get<power_good>().value();
+	if (pgood && !now) {
+		alarm = true;
+	}
+	pgood = now;
+
+	return alarm;
 }
@@ -18,6 +18,7 @@
 #include "stm32_adv_trace.h"
 #include "stm32_adv_trace_if.h"
 /* USER CODE BEGIN include */
+#include "main.h"
 
 /* USER CODE END include */
 
@@ -54,12 +55,20 @@ const UTIL_ADV_TRACE_Driver_s UTIL_TraceDriver =
 /* USER CODE END Private_Macro */
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN Private_Variables */
+extern UART_HandleTypeDef huart2;
+
+/**
+ *  @brief  trace transfer complete callback
+ */
+static void (*TxCpltCallback)(void *) = NULL;
 
 /* USER CODE END Private_Variables */
 
 UTIL_ADV_TRACE_Status_t UART_Init(void (*cb)(void *))
 {
 /* USER CODE BEGIN UART_Init */
+  /* USART2 and its TX DMA are initialized by main */
+  TxCpltCallback = cb;
   return UTIL_ADV_TRACE_OK;
 /* USER CODE END UART_Init */
 }
@@ -81,11 +90,22 @@ UTIL_ADV_TRACE_Status_t UART_StartRx(void (*cb)(uint8_t *pdata, uint16_t size, u
 UTIL_ADV_TRACE_Status_t UART_TransmitDMA ( uint8_t *pdata, uint16_t size )
 {
 /* USER CODE BEGIN UART_DeInit */
+  if (HAL_UART_Transmit_DMA(&huart2, pdata, size) != HAL_OK)
+  {
+    return UTIL_ADV_TRACE_HW_ERROR;
+  }
   return UTIL_ADV_TRACE_OK;
 /* USER CODE END UART_DeInit */
 }
 
 /* USER CODE BEGIN Private_Functions */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if ((huart->Instance == USART2) && (TxCpltCallback != NULL))
+  {
+    TxCpltCallback(NULL);
+  }
+}
 
 /* USER CODE END Private_Functions */
 
@@ -23,6 +23,7 @@
 
 /* USER CODE BEGIN Includes */
 #include "main.h"
+#include "flight_recorder.h"
 /* USER CODE END Includes */
 
 /* External variables ---------------------------------------------------------*/
@@ -89,6 +90,7 @@ void PWR_ExitOffMode(void)
 void PWR_EnterStopMode(void)
 {
   /* USER CODE BEGIN EnterStopMode_1 */
+  FlightRecorder_Record(FLIGHT_EVENT_STOP_ENTER, 0);
   HAL_SuspendTick();
   LL_PWR_ClearFlag_C1STOP_C1STB();
   HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
@@ -99,6 +101,7 @@ void PWR_ExitStopMode(void)
 {
   /* USER CODE BEGIN ExitStopMode_1 */
   HAL_ResumeTick();
+  FlightRecorder_Record(FLIGHT_EVENT_STOP_EXIT, 0);
   /* USER CODE END ExitStopMode_1 */
 }
 
@@ -26,9 +26,12 @@
 #include "stm32_lpm.h"
 #include "utilities_def.h"
 #include "timer_if.h"
+#include "stm32_adv_trace.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "solarpath.h"
+#include "flight_recorder.h"
+#include "mem_bench.h"
 /* USER CODE END Includes */
 
 /* External variables ---------------------------------------------------------*/
@@ -80,11 +83,21 @@ void SystemApp_Init(void)
 
   UTIL_TIMER_Init();
 
+  /* Needs the RTC for its timestamps */
+  FlightRecorder_Init();
+
+  /* Logs and printf go out through the trace DMA */
+  UTIL_ADV_TRACE_Init();
+
   /*Init low power manager*/
   UTIL_LPM_Init();
   /* Disable Stand-by mode */
   UTIL_LPM_SetOffMode((1 << CFG_LPM_APPLI_Id), UTIL_LPM_ENABLE);
 
+#if (UTIL_MEM_BENCH == 1)
+  MemBench_Run();
+#endif /* UTIL_MEM_BENCH == 1 */
+
   /* USER CODE END SystemApp_Init_1 */
 }
 uint8_t GetBatteryLevel(void)
@@ -102,6 +115,7 @@ uint16_t GetTemperatureLevel(void)
   uint16_t temperatureLevel = 0;
 
   /* USER CODE BEGIN GetTemperatureLevel */
+  temperatureLevel = (uint16_t)(int16_t)system_temperature();
   /* USER CODE END GetTemperatureLevel */
   return temperatureLevel;
 }
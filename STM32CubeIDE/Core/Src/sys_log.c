@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * @file    sys_log.c
+  * @brief   Tokenized binary log records sent through the advanced trace
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32_adv_trace.h"
+#include "sys_log.h"
+
+/* Private define ------------------------------------------------------------*/
+/**
+  * @brief Record header: marker, payload size and id
+  */
+#define SYS_LOG_HEADER_SIZE                         4U
+
+/* Private functions ---------------------------------------------------------*/
+static uint8_t VarintSize(uint32_t value)
+{
+  uint8_t size = 1;
+
+  while (value >= 0x80U)
+  {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+/* Exported functions --------------------------------------------------------*/
+void SysLog_Write(uint16_t id, const uint32_t *args, uint8_t count)
+{
+  uint8_t *fifo;
+  uint8_t *record;
+  uint16_t fifoSize;
+  uint16_t pos;
+  uint16_t size = SYS_LOG_HEADER_SIZE;
+
+  if (count > SYS_LOG_MAX_ARGS)
+  {
+    count = SYS_LOG_MAX_ARGS;
+  }
+  for (uint8_t i = 0; i < count; i++)
+  {
+    size += VarintSize(args[i]);
+  }
+
+  /* Written in place, the reserved area does not wrap */
+  if (UTIL_ADV_TRACE_ZCSend_Allocation(size, &fifo, &fifoSize, &pos) != UTIL_ADV_TRACE_OK)
+  {
+    return;
+  }
+  record = &fifo[pos];
+  *record++ = SYS_LOG_MARKER;
+  *record++ = (uint8_t)(size - 2U);
+  *record++ = (uint8_t)id;
+  *record++ = (uint8_t)(id >> 8);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    uint32_t value = args[i];
+
+    while (value >= 0x80U)
+    {
+      *record++ = (uint8_t)(value | 0x80U);
+      value >>= 7;
+    }
+    *record++ = (uint8_t)value;
+  }
+  UTIL_ADV_TRACE_ZCSend_Finalize();
+}
@@ -30,6 +30,7 @@
 #include <time.h>
 #include <sys/time.h>
 #include <sys/times.h>
+#include "stm32_adv_trace.h"
 
 
 /* Variables */
@@ -80,12 +81,8 @@ return len;
 
 __attribute__((used)) int _write(int file, char *ptr, int len)
 {
-	int DataIdx;
-
-	for (DataIdx = 0; DataIdx < len; DataIdx++)
-	{
-		__io_putchar(*ptr++);
-	}
+	/* Queued for the trace DMA, dropped if the FIFO is full */
+	UTIL_ADV_TRACE_Send((const uint8_t *)ptr, (uint16_t)len);
 	return len;
 }
 
@@ -126,7 +126,8 @@
 /*!< Uncomment the following line if you need to relocate CPU1 CM4 and/or CPU2
      CM0+ vector table anywhere in Sram or Flash. Else vector table will be kept
      at address 0x00 which correspond to automatic remap of boot address selected */
-/* #define USER_VECT_TAB_ADDRESS */
+/* The application follows the boot stage, see boot.h */
+#define USER_VECT_TAB_ADDRESS
 #if defined(USER_VECT_TAB_ADDRESS)
 #ifdef CORE_CM0PLUS
  /*!< Uncomment this line for user vector table remap in Sram else user remap
@@ -155,7 +156,7 @@
 #else
 #define VECT_TAB_BASE_ADDRESS   FLASH_BASE      /*!< Vector Table base address field.
                                                      This value must be a multiple of 0x200. */
-#define VECT_TAB_OFFSET         0x00000000U     /*!< Vector Table base offset field.
+#define VECT_TAB_OFFSET         0x00001000U     /*!< Vector Table base offset field.
                                                      This value must be a multiple of 0x200. */
 #endif
 #endif
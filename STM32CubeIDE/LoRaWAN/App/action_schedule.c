@@ -0,0 +1,156 @@
+/**
+  ******************************************************************************
+  * @file    action_schedule.c
+  * @brief   Application actions scheduled at a GPS time
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "stm32_mem.h"
+#include "stm32_seq.h"
+#include "stm32_systime.h"
+#include "stm32_timer.h"
+#include "utilities_def.h"
+#include "action_schedule.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t GpsTime;                               /*!< Time at which the action is applied */
+  uint8_t Size;                                   /*!< Action size */
+  uint8_t Action[ACTION_SCHEDULE_MAX_ACTION];     /*!< Action */
+} ScheduledAction_t;
+
+/* Private define ------------------------------------------------------------*/
+/**
+  * @brief Longest timer delay in s, the timer is re-armed for what remains
+  */
+#define ACTION_SCHEDULE_MAX_DELAY                   86400U
+
+/* Private variables ---------------------------------------------------------*/
+static ScheduledAction_t Actions[ACTION_SCHEDULE_SIZE];
+static bool ActionUsed[ACTION_SCHEDULE_SIZE];
+static ActionScheduleApply_t Apply = NULL;
+static bool TimeSynced = false;
+static UTIL_TIMER_Object_t ActionTimer;
+
+/* Private functions ---------------------------------------------------------*/
+static void OnActionTimerEvent(void *context)
+{
+  UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_ActionSchedule), CFG_SEQ_Prio_0);
+}
+
+/**
+  * @brief Returns the due action with the earliest time, or the next one
+  * @param now current GPS time in s
+  * @param due set to true if the returned action is due
+  * @retval action index, ACTION_SCHEDULE_SIZE if none
+  */
+static uint8_t FindNext(uint32_t now, bool *due)
+{
+  uint8_t next = ACTION_SCHEDULE_SIZE;
+
+  for (uint8_t i = 0; i < ACTION_SCHEDULE_SIZE; i++)
+  {
+    if ((ActionUsed[i] == true) &&
+        ((next == ACTION_SCHEDULE_SIZE) || ((int32_t)(Actions[i].GpsTime - Actions[next].GpsTime) < 0)))
+    {
+      next = i;
+    }
+  }
+  *due = (next != ACTION_SCHEDULE_SIZE) && ((int32_t)(now - Actions[next].GpsTime) >= 0);
+  return next;
+}
+
+/* Exported functions --------------------------------------------------------*/
+void ActionSchedule_Init(ActionScheduleApply_t apply)
+{
+  UTIL_MEM_set_8(ActionUsed, 0, sizeof(ActionUsed));
+  Apply = apply;
+  UTIL_TIMER_Create(&ActionTimer, 0xFFFFFFFFU, UTIL_TIMER_ONESHOT, OnActionTimerEvent, NULL);
+}
+
+bool ActionSchedule_Add(uint32_t gpsTime, const uint8_t *action, uint8_t size)
+{
+  if ((action == NULL) || (size == 0) || (size > ACTION_SCHEDULE_MAX_ACTION))
+  {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < ACTION_SCHEDULE_SIZE; i++)
+  {
+    if (ActionUsed[i] == false)
+    {
+      Actions[i].GpsTime = gpsTime;
+      Actions[i].Size = size;
+      UTIL_MEM_cpy_8(Actions[i].Action, action, size);
+      ActionUsed[i] = true;
+      UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_ActionSchedule), CFG_SEQ_Prio_0);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ActionSchedule_Clear(void)
+{
+  UTIL_TIMER_Stop(&ActionTimer);
+  UTIL_MEM_set_8(ActionUsed, 0, sizeof(ActionUsed));
+}
+
+void ActionSchedule_OnTimeSync(void)
+{
+  TimeSynced = true;
+  /* The pending delays were computed from the previous time */
+  UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_ActionSchedule), CFG_SEQ_Prio_0);
+}
+
+bool ActionSchedule_IsTimeSynced(void)
+{
+  return TimeSynced;
+}
+
+uint32_t ActionSchedule_GetGpsTime(void)
+{
+  return SysTimeGet().Seconds - UNIX_GPS_EPOCH_OFFSET;
+}
+
+void ActionSchedule_Process(void)
+{
+  SysTime_t sysTime;
+  uint32_t now;
+  uint32_t delay;
+  uint8_t next;
+  bool due;
+
+  UTIL_TIMER_Stop(&ActionTimer);
+  if (TimeSynced == false)
+  {
+    return;
+  }
+
+  sysTime = SysTimeGet();
+  now = sysTime.Seconds - UNIX_GPS_EPOCH_OFFSET;
+  next = FindNext(now, &due);
+  while (due == true)
+  {
+    ActionUsed[next] = false;
+    if (Apply != NULL)
+    {
+      Apply(Actions[next].Action, Actions[next].Size);
+    }
+    next = FindNext(now, &due);
+  }
+
+  if (next != ACTION_SCHEDULE_SIZE)
+  {
+    delay = Actions[next].GpsTime - now;
+    if (delay > ACTION_SCHEDULE_MAX_DELAY)
+    {
+      delay = ACTION_SCHEDULE_MAX_DELAY;
+    }
+    /* Fires on the second boundary */
+    UTIL_TIMER_StartWithPeriod(&ActionTimer, (delay * 1000U) - sysTime.SubSeconds);
+  }
+}
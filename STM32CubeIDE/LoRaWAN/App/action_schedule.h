@@ -0,0 +1,94 @@
+/**
+  ******************************************************************************
+  * @file    action_schedule.h
+  * @brief   Application actions scheduled at a GPS time
+  ******************************************************************************
+  */
+#ifndef __ACTION_SCHEDULE_H__
+#define __ACTION_SCHEDULE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Number of actions the schedule holds
+ */
+#define ACTION_SCHEDULE_SIZE                        8
+
+/*!
+ * Maximum size of an action
+ */
+#define ACTION_SCHEDULE_MAX_ACTION                  8
+
+/* Exported types ------------------------------------------------------------*/
+/*!
+ * Applies an action
+ */
+typedef void (*ActionScheduleApply_t)(const uint8_t *action, uint8_t size);
+
+/* Exported functions ------------------------------------------------------- */
+/**
+  * @brief Empties the schedule
+  * @param apply called from the sequencer when an action is due
+  * @retval none
+  */
+void ActionSchedule_Init(ActionScheduleApply_t apply);
+
+/**
+  * @brief Schedules an action. An action already due is applied by the next
+  *        ActionSchedule_Process.
+  * @param gpsTime GPS time in s at which the action is applied
+  * @param action action, copied
+  * @param size action size, at most ACTION_SCHEDULE_MAX_ACTION
+  * @retval true if scheduled, false if the schedule is full
+  */
+bool ActionSchedule_Add(uint32_t gpsTime, const uint8_t *action, uint8_t size);
+
+/**
+  * @brief Removes all the actions
+  * @param none
+  * @retval none
+  */
+void ActionSchedule_Clear(void);
+
+/**
+  * @brief Tells the schedule the system time holds the network time. Until
+  *        then no action is applied.
+  * @param none
+  * @retval none
+  */
+void ActionSchedule_OnTimeSync(void);
+
+/**
+  * @brief Returns true once the system time has been synchronized
+  * @param none
+  * @retval synchronization status
+  */
+bool ActionSchedule_IsTimeSynced(void);
+
+/**
+  * @brief Returns the current GPS time
+  * @param none
+  * @retval GPS time in s
+  */
+uint32_t ActionSchedule_GetGpsTime(void);
+
+/**
+  * @brief Applies the due actions and arms the timer for the next one.
+  *        Runs as the CFG_SEQ_Task_ActionSchedule sequencer task.
+  * @param none
+  * @retval none
+  */
+void ActionSchedule_Process(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ACTION_SCHEDULE_H__ */
@@ -0,0 +1,113 @@
+/**
+  ******************************************************************************
+  * @file    downlink_router.c
+  * @brief   Dispatch of the application downlinks to handlers by port
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "stm32_mem.h"
+#include "stm32_seq.h"
+#include "utilities_def.h"
+#include "downlink_router.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  const DownlinkRoute_t *Route;                   /*!< Route of the downlink */
+  LmHandlerRxParams_t Params;                     /*!< Reception parameters */
+  uint8_t Size;                                   /*!< Payload size */
+  uint8_t Payload[DOWNLINK_ROUTER_MAX_DEFERRED];  /*!< Payload */
+} DeferredDownlink_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const DownlinkRoute_t *Routes = NULL;
+static uint8_t RouteCount = 0;
+/* Deferred downlinks in order of reception */
+static DeferredDownlink_t Deferred[DOWNLINK_ROUTER_QUEUE_SIZE];
+static uint8_t DeferredCount = 0;
+
+/* Private functions ---------------------------------------------------------*/
+static const DownlinkRoute_t *FindRoute(uint8_t port)
+{
+  for (uint8_t i = 0; i < RouteCount; i++)
+  {
+    if (Routes[i].Port == port)
+    {
+      return &Routes[i];
+    }
+  }
+  return NULL;
+}
+
+/* Exported functions --------------------------------------------------------*/
+bool DownlinkRouter_Init(const DownlinkRoute_t *routes, uint8_t count)
+{
+  Routes = routes;
+  RouteCount = count;
+  DeferredCount = 0;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if ((routes[i].Mode == DOWNLINK_DEFERRED) && (routes[i].MaxSize > DOWNLINK_ROUTER_MAX_DEFERRED))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DownlinkRouter_Dispatch(const LmHandlerAppData_t *appData, const LmHandlerRxParams_t *params)
+{
+  const DownlinkRoute_t *route;
+  uint8_t slot;
+
+  if ((appData == NULL) || (params == NULL))
+  {
+    return false;
+  }
+  route = FindRoute(appData->Port);
+  if ((route == NULL) || (appData->BufferSize < route->MinSize) || (appData->BufferSize > route->MaxSize))
+  {
+    return false;
+  }
+  if (route->Mode == DOWNLINK_INLINE)
+  {
+    route->Handler(appData->Buffer, appData->BufferSize, params);
+    return true;
+  }
+
+  for (slot = 0; (slot < DeferredCount) && (Deferred[slot].Route != route); slot++)
+  {
+  }
+  if (slot == DOWNLINK_ROUTER_QUEUE_SIZE)
+  {
+    return false;
+  }
+  if (slot == DeferredCount)
+  {
+    DeferredCount++;
+  }
+  Deferred[slot].Route = route;
+  Deferred[slot].Params = *params;
+  Deferred[slot].Size = appData->BufferSize;
+  UTIL_MEM_cpy_8(Deferred[slot].Payload, appData->Buffer, appData->BufferSize);
+  UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_Downlink), CFG_SEQ_Prio_0);
+  return true;
+}
+
+void DownlinkRouter_Process(void)
+{
+  while (DeferredCount > 0)
+  {
+    DeferredDownlink_t downlink = Deferred[0];
+
+    /* Removed first: the handler may send an uplink whose downlink is dispatched again */
+    DeferredCount--;
+    for (uint8_t i = 0; i < DeferredCount; i++)
+    {
+      Deferred[i] = Deferred[i + 1];
+    }
+    downlink.Route->Handler(downlink.Payload, downlink.Size, &downlink.Params);
+  }
+}
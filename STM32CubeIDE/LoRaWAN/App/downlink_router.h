@@ -0,0 +1,88 @@
+/**
+  ******************************************************************************
+  * @file    downlink_router.h
+  * @brief   Dispatch of the application downlinks to handlers by port
+  ******************************************************************************
+  */
+#ifndef __DOWNLINK_ROUTER_H__
+#define __DOWNLINK_ROUTER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "LmHandler.h"
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Number of deferred downlinks waiting for the sequencer
+ */
+#define DOWNLINK_ROUTER_QUEUE_SIZE                  4
+
+/*!
+ * Maximum payload size of a deferred route
+ */
+#define DOWNLINK_ROUTER_MAX_DEFERRED                32
+
+/* Exported types ------------------------------------------------------------*/
+/*!
+ * Handles a downlink payload. Inline handlers get the MAC buffer, valid for
+ * the call only. Deferred handlers get a copy, from the sequencer.
+ */
+typedef void (*DownlinkHandler_t)(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params);
+
+/*!
+ * Where a handler runs
+ */
+typedef enum
+{
+  DOWNLINK_INLINE,     /*!< In the MAC callback, for bookkeeping which must not wait */
+  DOWNLINK_DEFERRED,   /*!< From the sequencer, for hardware updates. A newer downlink
+                            replaces the pending one of the same route. */
+} DownlinkMode_t;
+
+/*!
+ * Route of a port
+ */
+typedef struct
+{
+  uint8_t Port;                    /*!< Application port */
+  uint8_t MinSize;                 /*!< Shorter payloads are dropped */
+  uint8_t MaxSize;                 /*!< Longer payloads are dropped, at most
+                                        DOWNLINK_ROUTER_MAX_DEFERRED when deferred */
+  DownlinkMode_t Mode;
+  DownlinkHandler_t Handler;
+} DownlinkRoute_t;
+
+/* Exported functions ------------------------------------------------------- */
+/**
+  * @brief Sets the route table and empties the deferred queue
+  * @param routes route table, kept, one route per port
+  * @param count number of routes
+  * @retval false if a deferred route accepts more than DOWNLINK_ROUTER_MAX_DEFERRED bytes
+  */
+bool DownlinkRouter_Init(const DownlinkRoute_t *routes, uint8_t count);
+
+/**
+  * @brief Runs or defers the handler of the downlink port
+  * @param appData downlink
+  * @param params reception parameters
+  * @retval false if the port has no route, the size is out of bounds or the queue is full
+  */
+bool DownlinkRouter_Dispatch(const LmHandlerAppData_t *appData, const LmHandlerRxParams_t *params);
+
+/**
+  * @brief Runs the deferred handlers, the CFG_SEQ_Task_Downlink task
+  * @param none
+  * @retval none
+  */
+void DownlinkRouter_Process(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DOWNLINK_ROUTER_H__ */
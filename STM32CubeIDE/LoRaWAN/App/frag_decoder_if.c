@@ -0,0 +1,212 @@
+/**
+  ******************************************************************************
+  * @file    frag_decoder_if.c
+  * @brief   Staging of the firmware update received by the fragmentation
+  *          package, see boot.h
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32wlxx_hal.h"
+#include "stm32_mem.h"
+#include "stm32_timer.h"
+#include "sys_log.h"
+#include "boot.h"
+#include "flash_if.h"
+#include "frag_decoder_if.h"
+
+/* Private define ------------------------------------------------------------*/
+/**
+  * @brief Bytes of the staged file read at once to compute the CRC
+  */
+#define FRAG_DECODER_IF_CRC_CHUNK                   64U
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t FragSize;
+static uint32_t SlotSize;
+/* Staging pages erased by the current session, erased as the first fragment
+   landing in them is written */
+static uint32_t ErasedPages[FRAG_DECODER_IF_MAX_PAGES / 32U];
+static UTIL_TIMER_Object_t ResetTimer;
+
+/* Private function prototypes -----------------------------------------------*/
+static int32_t FragDecoderPrepare(uint16_t fragNb, uint8_t fragSize);
+static int32_t FragDecoderWrite(uint32_t addr, uint8_t *data, uint32_t size);
+static int32_t FragDecoderRead(uint32_t addr, uint8_t *data, uint32_t size);
+static void OnFragDone(int32_t status, uint32_t size);
+
+/* Exported variables --------------------------------------------------------*/
+LmhpFragmentationParams_t FRAG_DECODER_IF_FragmentationParams =
+{
+  .DecoderCallbacks =
+  {
+    .FragDecoderPrepare = FragDecoderPrepare,
+    .FragDecoderWrite = FragDecoderWrite,
+    .FragDecoderRead = FragDecoderRead,
+  },
+  .OnProgress = NULL,
+  .OnDone = OnFragDone,
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief Returns the staging address of a file offset
+  * @param offset offset in the file
+  * @retval flash address
+  */
+static uint32_t StagedAddress(uint32_t offset)
+{
+  return BOOT_STAGING_START + ((offset / FragSize) * SlotSize) + (offset % FragSize);
+}
+
+/**
+  * @brief Copies a part of the staged file
+  * @param offset offset in the file
+  * @param data destination
+  * @param size number of bytes
+  */
+static void ReadStaged(uint32_t offset, uint8_t *data, uint32_t size)
+{
+  while (size > 0U)
+  {
+    uint32_t chunk = FragSize - (offset % FragSize);
+
+    if (chunk > size)
+    {
+      chunk = size;
+    }
+    UTIL_MEM_cpy_8(data, (const void *)StagedAddress(offset), chunk);
+    offset += chunk;
+    data += chunk;
+    size -= chunk;
+  }
+}
+
+/**
+  * @brief CRC-32 as computed by zlib, bitwise to spare the flash of a table
+  * @param crc CRC of the previous bytes, 0 for the first ones
+  * @param data bytes
+  * @param size number of bytes
+  * @retval CRC
+  */
+static uint32_t Crc32(uint32_t crc, const uint8_t *data, uint32_t size)
+{
+  crc = ~crc;
+  while (size-- > 0U)
+  {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8U; i++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1UL)));
+    }
+  }
+  return ~crc;
+}
+
+static void OnResetTimerEvent(void *context)
+{
+  NVIC_SystemReset();
+}
+
+static int32_t FragDecoderPrepare(uint16_t fragNb, uint8_t fragSize)
+{
+  uint32_t slotSize = ((uint32_t)fragSize + FLASH_IF_DOUBLE_WORD - 1U) & ~(FLASH_IF_DOUBLE_WORD - 1U);
+
+  if ((fragSize == 0U) || (((uint32_t)fragNb * slotSize) > BOOT_STAGING_SIZE) ||
+      ((BOOT_STAGING_SIZE / FLASH_PAGE_SIZE) > FRAG_DECODER_IF_MAX_PAGES))
+  {
+    return -1;
+  }
+  FragSize = fragSize;
+  SlotSize = slotSize;
+  UTIL_MEM_set_8(ErasedPages, 0, sizeof(ErasedPages));
+  return 0;
+}
+
+static int32_t FragDecoderWrite(uint32_t addr, uint8_t *data, uint32_t size)
+{
+  uint32_t address = StagedAddress(addr);
+  uint32_t first = (address - BOOT_STAGING_START) / FLASH_PAGE_SIZE;
+  uint32_t last = (address + SlotSize - 1U - BOOT_STAGING_START) / FLASH_PAGE_SIZE;
+
+  if ((FragSize == 0U) || ((addr % FragSize) != 0U) || (size > SlotSize) ||
+      ((address + SlotSize) > (BOOT_STAGING_START + BOOT_STAGING_SIZE)))
+  {
+    return -1;
+  }
+  for (uint32_t page = first; page <= last; page++)
+  {
+    if ((ErasedPages[page / 32U] & (1UL << (page % 32U))) == 0U)
+    {
+      if (FLASH_IF_Erase(BOOT_STAGING_START + (page * FLASH_PAGE_SIZE), FLASH_PAGE_SIZE) != FLASH_IF_OK)
+      {
+        return -1;
+      }
+      ErasedPages[page / 32U] |= 1UL << (page % 32U);
+    }
+  }
+  return (FLASH_IF_Write(address, data, size) == FLASH_IF_OK) ? 0 : -1;
+}
+
+static int32_t FragDecoderRead(uint32_t addr, uint8_t *data, uint32_t size)
+{
+  if ((FragSize == 0U) || ((addr % FragSize) != 0U) || (size > SlotSize))
+  {
+    return -1;
+  }
+  UTIL_MEM_cpy_8(data, (const void *)StagedAddress(addr), size);
+  return 0;
+}
+
+/**
+  * @brief Verifies the staged file and records it for the boot stage
+  * @param status session status
+  * @param size file size
+  */
+static void OnFragDone(int32_t status, uint32_t size)
+{
+  BootImageHeader_t header;
+  BootRecord_t record;
+  uint8_t chunk[FRAG_DECODER_IF_CRC_CHUNK];
+  uint32_t crc = 0;
+
+  if ((status != FRAG_SESSION_FINISHED) || (size < sizeof(header)))
+  {
+    SYS_LOG("FUOTA session failed\n");
+    return;
+  }
+  ReadStaged(0, (uint8_t *)&header, sizeof(header));
+  if ((header.Magic != BOOT_IMAGE_MAGIC) || (header.Size == 0U) || (header.Size > BOOT_APP_SIZE) ||
+      (header.Size > (size - sizeof(header))))
+  {
+    SYS_LOG("FUOTA image rejected\n");
+    return;
+  }
+  for (uint32_t offset = 0; offset < header.Size; offset += sizeof(chunk))
+  {
+    uint32_t n = ((header.Size - offset) < sizeof(chunk)) ? (header.Size - offset) : sizeof(chunk);
+
+    ReadStaged(sizeof(header) + offset, chunk, n);
+    crc = Crc32(crc, chunk, n);
+  }
+  if (crc != header.Crc)
+  {
+    SYS_LOG("FUOTA image CRC mismatch\n");
+    return;
+  }
+
+  record.Magic = BOOT_RECORD_MAGIC;
+  record.Size = header.Size;
+  record.Crc = header.Crc;
+  record.FragSize = FragSize;
+  record.SlotSize = (uint16_t)SlotSize;
+  if ((FLASH_IF_Erase(BOOT_RECORD_START, FLASH_PAGE_SIZE) != FLASH_IF_OK) ||
+      (FLASH_IF_Write(BOOT_RECORD_START, (const uint8_t *)&record, sizeof(record)) != FLASH_IF_OK))
+  {
+    SYS_LOG("FUOTA record write failed\n");
+    return;
+  }
+  SYS_LOG("FUOTA image %u staged, installing\n", header.Version);
+  UTIL_TIMER_Create(&ResetTimer, FRAG_DECODER_IF_RESET_DELAY, UTIL_TIMER_ONESHOT, OnResetTimerEvent, NULL);
+  UTIL_TIMER_Start(&ResetTimer);
+}
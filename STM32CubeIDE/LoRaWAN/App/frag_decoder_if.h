@@ -0,0 +1,40 @@
+/**
+  ******************************************************************************
+  * @file    frag_decoder_if.h
+  * @brief   Staging of the firmware update received by the fragmentation
+  *          package, see boot.h
+  ******************************************************************************
+  */
+#ifndef __FRAG_DECODER_IF_H__
+#define __FRAG_DECODER_IF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "LmhpFragmentation.h"
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Delay in ms between a verified update and the reset which installs it,
+ * leaves time for the last fragmentation answers
+ */
+#define FRAG_DECODER_IF_RESET_DELAY                 10000U
+
+/*!
+ * Maximum number of staging pages
+ */
+#define FRAG_DECODER_IF_MAX_PAGES                   64U
+
+/* External variables --------------------------------------------------------*/
+/*!
+ * Fragmentation package parameters, registered by the data distribution
+ */
+extern LmhpFragmentationParams_t FRAG_DECODER_IF_FragmentationParams;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRAG_DECODER_IF_H__ */
@@ -31,6 +31,18 @@
 #include "utilities_def.h"
 #include "lora_info.h"
 #include "solarpath.h"
+#include "uplink_queue.h"
+#include "uplink_fec.h"
+#include "utilities.h"
+#include "action_schedule.h"
+#include "downlink_router.h"
+#include "remote_config.h"
+#include "solar_position.h"
+#include "sys_log.h"
+#include "flight_recorder.h"
+#if defined( REGION_US915 )
+#include "RegionUS915.h"
+#endif /* REGION_US915 */
 /* USER CODE END Includes */
 
 /* External variables ---------------------------------------------------------*/
@@ -45,12 +57,22 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* Size of a scene, same encoding as the LORAWAN_USER_APP_PORT downlinks */
+#define SCENE_SIZE                                  7
+
+/* Longest downlinks of the deferred routes, copied into the router queue */
+#define USER_APP_MAX_SIZE                           DOWNLINK_ROUTER_MAX_DEFERRED
+#define CONFIG_MAX_SIZE                             DOWNLINK_ROUTER_MAX_DEFERRED
+
+_Static_assert(USER_APP_MAX_SIZE <= DOWNLINK_ROUTER_MAX_DEFERRED, "User app downlinks too long to be deferred");
+_Static_assert(CONFIG_MAX_SIZE <= DOWNLINK_ROUTER_MAX_DEFERRED, "Config downlinks too long to be deferred");
 
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
 /* USER CODE BEGIN PM */
-//#define DEBUG_MSG
+/* Tokenized, see sys_log.h */
+#define DEBUG_MSG
 /* USER CODE END PM */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -82,20 +104,83 @@ static void OnRxData(LmHandlerAppData_t *appData, LmHandlerRxParams_t *params);
  */
 static void OnMacProcessNotify(void);
 
-/* USER CODE BEGIN PFP */
+/**
+  * @brief  callback when the device class changed
+  * @param  deviceClass new class
+  * @retval none
+  */
+static void OnClassChange(DeviceClass_t deviceClass);
+
+/**
+  * @brief  callback when the class B beacon status changed
+  * @param  params beacon parameters
+  * @retval none
+  */
+static void OnBeaconStatusChange(LmHandlerBeaconParams_t *params);
+
+/**
+  * @brief  callback when the system time has been synchronized
+  * @param  none
+  * @retval none
+  */
+static void OnSysTimeUpdate(void);
 
-static LmHandlerAppData_t TxData = { LORAWAN_USER_APP_PORT, 0, 0 };
+/* USER CODE BEGIN PFP */
 
 static ActivationType_t ActivationType = LORAWAN_DEFAULT_ACTIVATION_TYPE;
 
 static UTIL_TIMER_Object_t JoinNetworkTimer = { 0 };
 static UTIL_TIMER_Object_t SendTxDataTimer = { 0 };
+static UTIL_TIMER_Object_t UplinkDispatchTimer = { 0 };
+static UTIL_TIMER_Object_t AlarmTimer = { 0 };
+static UTIL_TIMER_Object_t SceneTimer = { 0 };
+static UTIL_TIMER_Object_t SunTimer = { 0 };
+
+/* Position of the node in each multicast group, scales the scene delay */
+static uint16_t SceneSlot[LORAMAC_MAX_MC_CTX] = { 0 };
+static uint8_t PendingScene[SCENE_SIZE];
+
+/* Time of the last DeviceTimeReq and of the last DeviceTimeAns */
+static UTIL_TIMER_Time_t TimeSyncRequestTime = 0;
+static UTIL_TIMER_Time_t TimeSyncTime = 0;
+
+/* Telemetry period in s, see remote_config.h */
+static uint16_t TxInterval = APP_TX_DUTYCYCLE / 1000;
+/* Site position, see LORAWAN_SITE_LATITUDE */
+static int32_t SiteLatitude = LORAWAN_SITE_LATITUDE;
+static int32_t SiteLongitude = LORAWAN_SITE_LONGITUDE;
+/* Applied LED state and unconfirmed checks of the pending transition */
+static bool SunNight = false;
+static bool SunApplied = false;
+static uint8_t SunRetries = 0;
 
 static void OnJoinNetworkTimerEvent(void *context);
 static void OnSendTxDataTimerEvent(void *context);
+static void OnUplinkDispatchTimerEvent(void *context);
+static void OnAlarmTimerEvent(void *context);
+static void OnSceneTimerEvent(void *context);
+static void OnSunTimerEvent(void *context);
 
 static void JoinNetwork(void);
 static void SendTxData(void);
+static void DispatchUplinks(void);
+static void PollAlarm(void);
+#if LORAWAN_ALARM_FEC
+static bool PushFecAlarm(const uint8_t *payload, uint8_t size);
+static void PushFecParity(void);
+#endif
+static uint8_t ClassBPingPeriodicity(void);
+static void ApplyScene(void);
+static void OnClassRxData(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params);
+static void OnUserRxData(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params);
+static void OnSceneRxData(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params);
+static void ApplyScheduledAction(const uint8_t *action, uint8_t size);
+static void OnScheduleRxData(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params);
+static void ApplyConfig(const RemoteConfig_t *config);
+static void OnConfigRxData(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params);
+static void SyncTime(void);
+static bool SunState(uint32_t now, uint32_t *next);
+static void SunEvent(void);
 /* USER CODE END PFP */
 
 /* Private variables ---------------------------------------------------------*/
@@ -109,7 +194,10 @@ static LmHandlerCallbacks_t LmHandlerCallbacks =
   .OnMacProcess =              OnMacProcessNotify,
   .OnJoinRequest =             OnJoinRequest,
   .OnTxData =                  OnTxData,
-  .OnRxData =                  OnRxData
+  .OnRxData =                  OnRxData,
+  .OnClassChange =             OnClassChange,
+  .OnBeaconStatusChange =      OnBeaconStatusChange,
+  .OnSysTimeUpdate =           OnSysTimeUpdate
 };
 
 /* USER CODE BEGIN PV */
@@ -122,6 +210,16 @@ static LmHandlerParams_t LmHandlerParams =
   .PingPeriodicity =          LORAWAN_DEFAULT_PING_SLOT_PERIODICITY
 };
 
+/* Downlink handlers by port, the LED and sensor updates run from the sequencer */
+static const DownlinkRoute_t DownlinkRoutes[] =
+{
+  { LORAWAN_USER_APP_PORT,     0, USER_APP_MAX_SIZE,            DOWNLINK_DEFERRED, OnUserRxData },
+  { LORAWAN_SWITCH_CLASS_PORT, 1, 1,                            DOWNLINK_INLINE,   OnClassRxData },
+  { LORAWAN_SCENE_PORT,        3, 1 + SCENE_SIZE,               DOWNLINK_INLINE,   OnSceneRxData },
+  { LORAWAN_SCHEDULE_PORT,     1, UINT8_MAX,                    DOWNLINK_INLINE,   OnScheduleRxData },
+  { LORAWAN_CONFIG_PORT,       2, CONFIG_MAX_SIZE,              DOWNLINK_DEFERRED, OnConfigRxData },
+};
+
 /* USER CODE END PV */
 
 /* Exported functions ---------------------------------------------------------*/
@@ -145,6 +243,30 @@ void LoRaWAN_Init(void)
   UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_LmHandlerProcess), UTIL_SEQ_RFU, LmHandlerProcess);
   UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_JoinNetworkTimer), UTIL_SEQ_RFU, JoinNetwork);
   UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_SendTxTimer), UTIL_SEQ_RFU, SendTxData);
+  UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_UplinkDispatch), UTIL_SEQ_RFU, DispatchUplinks);
+  UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_Alarm), UTIL_SEQ_RFU, PollAlarm);
+  UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_Scene), UTIL_SEQ_RFU, ApplyScene);
+  UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_ActionSchedule), UTIL_SEQ_RFU, ActionSchedule_Process);
+  UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_SunEvent), UTIL_SEQ_RFU, SunEvent);
+  UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_Downlink), UTIL_SEQ_RFU, DownlinkRouter_Process);
+
+  /* Sensors and LEDs, before anything measures or drives them */
+  system_init();
+  UplinkQueue_Init();
+  ActionSchedule_Init(ApplyScheduledAction);
+  /* A deferred route longer than the router queue would overflow it */
+  if (!DownlinkRouter_Init(DownlinkRoutes, sizeof(DownlinkRoutes) / sizeof(DownlinkRoutes[0]))) {
+	  SYS_LOG("Downlink route too long to defer!\n");
+	  Error_Handler();
+  }
+
+  /* What led to the last reset, sent when nothing else is pending */
+  if (FlightRecorder_PreviousCount() > 0) {
+	  uint8_t diag[UPLINK_QUEUE_MAX_PAYLOAD];
+	  uint8_t diagSize = FlightRecorder_Summarize(diag, sizeof(diag));
+	  UplinkQueue_Push(UPLINK_CLASS_DIAGNOSTICS, LORAWAN_DIAG_PORT, LORAMAC_HANDLER_UNCONFIRMED_MSG,
+	                   diag, diagSize, FlightRecorder_Summarize, 0);
+  }
 
   LoraInfo_Init();
   /* USER CODE END LoRaWAN_Init_1 */
@@ -153,7 +275,14 @@ void LoRaWAN_Init(void)
   LmHandlerInit(&LmHandlerCallbacks);
 
   /* USER CODE BEGIN LoRaWAN_Init_Last */
+  LmHandlerParams.PingPeriodicity = ClassBPingPeriodicity();
   LmHandlerConfigure(&LmHandlerParams);
+  /* Random seeded by the MAC initialization */
+  UplinkFec_Init((uint8_t)randr(0, UINT8_MAX));
+
+#if defined( REGION_US915 )
+  RegionUS915SetPreferredSubBands(LORAWAN_US915_PREFERRED_SUB_BANDS);
+#endif /* REGION_US915 */
 
   MibRequestConfirm_t mibReq;
   memset(&mibReq, 0, sizeof(mibReq));
@@ -180,6 +309,24 @@ void LoRaWAN_Init(void)
   UTIL_TIMER_Create(&SendTxDataTimer, 0xFFFFFFFFU, UTIL_TIMER_PERIODIC, OnSendTxDataTimerEvent, NULL);
   UTIL_TIMER_SetPeriod(&SendTxDataTimer, APP_TX_DUTYCYCLE);
 
+  UTIL_TIMER_Create(&UplinkDispatchTimer, 0xFFFFFFFFU, UTIL_TIMER_ONESHOT, OnUplinkDispatchTimerEvent, NULL);
+  UTIL_TIMER_Create(&AlarmTimer, 0xFFFFFFFFU, UTIL_TIMER_PERIODIC, OnAlarmTimerEvent, NULL);
+  UTIL_TIMER_SetPeriod(&AlarmTimer, LORAWAN_ALARM_POLL_PERIOD);
+  UTIL_TIMER_Create(&SceneTimer, 0xFFFFFFFFU, UTIL_TIMER_ONESHOT, OnSceneTimerEvent, NULL);
+  UTIL_TIMER_Create(&SunTimer, 0xFFFFFFFFU, UTIL_TIMER_ONESHOT, OnSunTimerEvent, NULL);
+
+  /* Stored settings over the compile time ones, applied once the timers exist */
+  const RemoteConfig_t configDefaults = {
+	  .TxInterval = APP_TX_DUTYCYCLE / 1000,
+	  .AutoThreshold = LORAWAN_AUTO_THRESHOLD,
+	  .AdrEnable = (LORAWAN_ADR_STATE == LORAMAC_HANDLER_ADR_ON) ? 1 : 0,
+	  .TxDatarate = LORAWAN_DEFAULT_DATA_RATE,
+	  .Averaging = LORAWAN_SENSOR_AVERAGING,
+	  .SiteLatitude = LORAWAN_SITE_LATITUDE,
+	  .SiteLongitude = LORAWAN_SITE_LONGITUDE,
+  };
+  RemoteConfig_Init(&configDefaults, ApplyConfig);
+
   UTIL_LPM_Init();
   UTIL_LPM_SetOffMode((1 << CFG_LPM_APPLI_Id), UTIL_LPM_DISABLE);
   UTIL_LPM_SetStopMode((1 << CFG_LPM_APPLI_Id), UTIL_LPM_DISABLE);
@@ -196,75 +343,434 @@ static void OnJoinNetworkTimerEvent(void *context) {
 	UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_JoinNetworkTimer), CFG_SEQ_Prio_0);
 }
 
+static void OnUplinkDispatchTimerEvent(void *context) {
+	UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_UplinkDispatch), CFG_SEQ_Prio_0);
+}
+
+static void OnAlarmTimerEvent(void *context) {
+	UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_Alarm), CFG_SEQ_Prio_0);
+}
+
+static void OnSceneTimerEvent(void *context) {
+	UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_Scene), CFG_SEQ_Prio_0);
+}
+
+static void OnSunTimerEvent(void *context) {
+	UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_SunEvent), CFG_SEQ_Prio_0);
+}
+
 static void JoinNetwork() {
 #ifdef DEBUG_MSG
-	printf("Re-Attempt join!\n");
+	SYS_LOG("Re-Attempt join!\n");
 #endif  // #ifdef DEBUG_MSG
 	LmHandlerJoin(ActivationType);
 }
 
 static void SendTxData(void) {
-	TxData.Buffer = (uint8_t *)encode_packet(&TxData.BufferSize);
+	uint8_t payload[UPLINK_QUEUE_MAX_PAYLOAD];
+
+	uint8_t size = encode_packet(payload, sizeof(payload));
+	if (!UplinkQueue_Push(UPLINK_CLASS_TELEMETRY, LORAWAN_USER_APP_PORT, LORAWAN_DEFAULT_CONFIRMED_MSG_STATE,
+	                      payload, size, encode_packet, LORAWAN_TELEMETRY_LIFETIME)) {
+#ifdef DEBUG_MSG
+		SYS_LOG("SendTxData Queue full!\n");
+#endif // #ifdef DEBUG_MSG
+	}
+	system_update();
+
+	SyncTime();
+	DispatchUplinks();
+}
+
+/* Events go out with the current snapshot ahead of everything else, without waiting for the telemetry */
+static void PollAlarm(void) {
+	uint8_t payload[UPLINK_QUEUE_MAX_PAYLOAD];
+	bool queued;
+
+	if (!system_alarm()) {
+#if LORAWAN_ALARM_FEC
+		/* The alarms are over, close their window */
+		if (UplinkFec_Count() > 0) {
+			PushFecParity();
+			DispatchUplinks();
+		}
+#endif
+		return;
+	}
+
+	uint8_t size = encode_packet(payload, sizeof(payload));
+#if LORAWAN_ALARM_FEC
+	queued = PushFecAlarm(payload, size);
+#else
+	queued = UplinkQueue_Push(UPLINK_CLASS_ALARM, LORAWAN_USER_APP_PORT, LORAWAN_ALARM_CONFIRMED_MSG_STATE,
+	                          payload, size, NULL, LORAWAN_ALARM_LIFETIME);
+#endif
+	if (!queued) {
+#ifdef DEBUG_MSG
+		SYS_LOG("PollAlarm Queue full!\n");
+#endif // #ifdef DEBUG_MSG
+	}
+	DispatchUplinks();
+}
+
+#if LORAWAN_ALARM_FEC
+/* Sends the alarm as a data frame of the current erasure coded window */
+static bool PushFecAlarm(const uint8_t *payload, uint8_t size) {
+	uint8_t frame[UPLINK_QUEUE_MAX_PAYLOAD];
+	bool queued = false;
+
+	uint8_t frameSize = UplinkFec_EncodeData(payload, size, frame);
+	if (frameSize > 0) {
+		queued = UplinkQueue_Push(UPLINK_CLASS_ALARM, LORAWAN_FEC_PORT, LORAMAC_HANDLER_UNCONFIRMED_MSG,
+		                          frame, frameSize, NULL, LORAWAN_ALARM_LIFETIME);
+	}
+	if (UplinkFec_Count() == UPLINK_FEC_WINDOW_SIZE) {
+		PushFecParity();
+	}
+	return queued;
+}
+
+/* Queues the parity frames of the current window, behind its data frames */
+static void PushFecParity(void) {
+	uint8_t frame[UPLINK_QUEUE_MAX_PAYLOAD];
+
+	for (uint8_t i = 0; i < UPLINK_FEC_PARITY_COUNT; i++) {
+		uint8_t frameSize = UplinkFec_EncodeParity(i, frame);
+		if (!UplinkQueue_Push(UPLINK_CLASS_ALARM, LORAWAN_FEC_PORT, LORAMAC_HANDLER_UNCONFIRMED_MSG,
+		                      frame, frameSize, NULL, LORAWAN_ALARM_LIFETIME)) {
+#ifdef DEBUG_MSG
+			SYS_LOG("FEC parity dropped!\n");
+#endif // #ifdef DEBUG_MSG
+		}
+	}
+	UplinkFec_NextWindow();
+}
+#endif
+
+/* Requests the network time, sent with the next uplink */
+static void SyncTime(void) {
+	if (ActionSchedule_IsTimeSynced()) {
+		if (UTIL_TIMER_GetElapsedTime(TimeSyncTime) < LORAWAN_TIME_SYNC_PERIOD) {
+			return;
+		}
+	}
+	if ((TimeSyncRequestTime != 0) && (UTIL_TIMER_GetElapsedTime(TimeSyncRequestTime) < LORAWAN_TIME_SYNC_RETRY)) {
+		return;
+	}
+	if (LmHandlerDeviceTimeReq() == LORAMAC_HANDLER_SUCCESS) {
+		TimeSyncRequestTime = UTIL_TIMER_GetCurrentTime();
+	}
+}
+
+static void DispatchUplinks(void) {
+	uint8_t *buffer = NULL;
+	uint8_t maxSize = 0;
+	uint8_t size = 0;
 	UTIL_TIMER_Time_t nextTxIn = 0;
-	if (LORAMAC_HANDLER_SUCCESS == LmHandlerSend(&TxData, LORAWAN_DEFAULT_CONFIRMED_MSG_STATE, &nextTxIn, false)) {
+	UplinkMsg_t *msg;
+	UplinkMsg_t *heldBack;
+
+	if ((UplinkQueue_Count() == 0) || (LmHandlerJoinStatus() != LORAMAC_HANDLER_SET)) {
+		/* Dispatched again by OnJoinRequest */
+		return;
+	}
+
+	LmHandlerErrorStatus_t status = LmHandlerTxReserve(&buffer, &maxSize);
+	if ((status == LORAMAC_HANDLER_SUCCESS) && (maxSize == 0)) {
+		/* Pending MAC commands fill the frame, flush them with an empty one first */
+		status = LmHandlerTxCommit(LORAWAN_USER_APP_PORT, 0, LORAMAC_HANDLER_UNCONFIRMED_MSG, &nextTxIn, false);
+	} else if (status == LORAMAC_HANDLER_SUCCESS) {
+		msg = UplinkQueue_Peek(maxSize, &heldBack);
+		if (heldBack != NULL) {
+			/* Waits until ADR or fewer MAC commands leave more room, or until it expires */
+#ifdef DEBUG_MSG
+			SYS_LOG("Uplink port %u size %u over %u held back\n", heldBack->Port, heldBack->Size, maxSize);
+#endif // #ifdef DEBUG_MSG
+			if (msg == NULL) {
+				UTIL_TIMER_StartWithPeriod(&UplinkDispatchTimer, LORAWAN_UPLINK_BACKOFF_DELAY);
+			}
+		}
+		if (msg == NULL) {
+			return;
+		}
+		if (msg->Size <= maxSize) {
+			UTIL_MEM_cpy_8(buffer, msg->Payload, msg->Size);
+			size = msg->Size;
+		} else {
+			/* Re-encode for the current datarate */
+			size = msg->Encode(buffer, maxSize);
+			if (size == 0) {
+				UplinkQueue_Remove(msg);
+				UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_UplinkDispatch), CFG_SEQ_Prio_0);
+				return;
+			}
+		}
+		status = LmHandlerTxCommit(msg->Port, size, msg->MsgType, &nextTxIn, false);
+		if (status == LORAMAC_HANDLER_SUCCESS) {
+			UplinkQueue_Remove(msg);
+		}
+	}
+
+	if (LORAMAC_HANDLER_SUCCESS == status) {
+		/* Next one dispatched by OnTxData */
 #ifdef DEBUG_MSG
-		printf("SendTxData Success!\n");
+		SYS_LOG("SendTxData Success!\n");
+#endif // #ifdef DEBUG_MSG
 	} else if (nextTxIn > 0) {
-		printf("SendTxData Early!\n");
+		UTIL_TIMER_StartWithPeriod(&UplinkDispatchTimer, nextTxIn);
+#ifdef DEBUG_MSG
+		SYS_LOG("SendTxData Early!\n");
+#endif // #ifdef DEBUG_MSG
+	} else if ((status == LORAMAC_HANDLER_BUSY_ERROR) || (status == LORAMAC_HANDLER_PAYLOAD_LENGTH_RESTRICTED)) {
+		/* Restricted: MAC commands went out in place of the uplink, which stays queued */
+		UTIL_TIMER_StartWithPeriod(&UplinkDispatchTimer, LORAWAN_UPLINK_RETRY_DELAY);
 	} else {
-		printf("SendTxData Fail!\n");
+		UTIL_TIMER_StartWithPeriod(&UplinkDispatchTimer, LORAWAN_UPLINK_BACKOFF_DELAY);
+#ifdef DEBUG_MSG
+		SYS_LOG("SendTxData Fail %d!\n", status);
 #endif // #ifdef DEBUG_MSG
 	}
+}
+
+/* Fastest ping slot periodicity whose beacons and empty ping slots fit in the class B budget */
+static uint8_t ClassBPingPeriodicity(void) {
+	for (uint8_t periodicity = 0; periodicity < LORAWAN_DEFAULT_PING_SLOT_PERIODICITY; periodicity++) {
+		uint32_t current = (LORAWAN_CLASSB_BEACON_CHARGE / 128000U) +
+		                   (LORAWAN_CLASSB_PING_SLOT_CHARGE / (1000U << periodicity));
+		if (current <= LORAWAN_CLASSB_CURRENT_BUDGET) {
+			return periodicity;
+		}
+	}
+	return LORAWAN_DEFAULT_PING_SLOT_PERIODICITY;
+}
+
+static void ApplyScene(void) {
+	decode_packet(PendingScene, SCENE_SIZE);
 	system_update();
 }
 
-/* USER CODE END PrFD */
+/*
+ * [class], 0: A, 1: B, 2: C
+ */
+static void OnClassRxData(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params) {
+	if (payload[0] <= CLASS_C) {
+		LmHandlerRequestClass((DeviceClass_t)payload[0]);
+#ifdef DEBUG_MSG
+		SYS_LOG("CLASS_%c!\n", "ABC"[payload[0]]);
+#endif  // #ifdef DEBUG_MSG
+	}
+}
 
-static void OnRxData(LmHandlerAppData_t *appData, LmHandlerRxParams_t *params)
-{
-  /* USER CODE BEGIN OnRxData_1 */
-	if ((appData != NULL) && (params != NULL)) {
-		switch (appData->Port) {
-			case LORAWAN_SWITCH_CLASS_PORT: {
-				if (appData->BufferSize == 1) {
-					switch (appData->Buffer[0]) {
-						case 0: {
-							LmHandlerRequestClass(CLASS_A);
+/*
+ * LED state, see decode_packet. Any downlink refreshes the sensors and the LEDs.
+ */
+static void OnUserRxData(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params) {
+	decode_packet(payload, size);
+	system_update();
+}
+
+/*
+ * Multicast: [step][scene], the node applies the scene after slot * step * LORAWAN_SCENE_STEP_UNIT ms
+ * Unicast:   [group][slot MSB][slot LSB], sets the position of the node in the group
+ */
+static void OnSceneRxData(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params) {
+	if (params->Multicast == 0) {
+		if ((size == 3) && (payload[0] < LORAMAC_MAX_MC_CTX)) {
+			SceneSlot[payload[0]] = (uint16_t)((payload[1] << 8) | payload[2]);
+		}
+		return;
+	}
+	if ((size != (1 + SCENE_SIZE)) || (params->McGroupId >= LORAMAC_MAX_MC_CTX)) {
+		return;
+	}
+
+	uint32_t delay = (uint32_t)SceneSlot[params->McGroupId] * payload[0] * LORAWAN_SCENE_STEP_UNIT;
+
+	/* A newer scene replaces the pending one */
+	UTIL_TIMER_Stop(&SceneTimer);
+	UTIL_MEM_cpy_8(PendingScene, &payload[1], SCENE_SIZE);
+	if (delay == 0) {
+		UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_Scene), CFG_SEQ_Prio_0);
+	} else {
+		UTIL_TIMER_StartWithPeriod(&SceneTimer, delay);
+	}
 #ifdef DEBUG_MSG
-							printf("CLASS_A!\n");
+	SYS_LOG("Scene group %u in %lu ms\n", params->McGroupId, delay);
 #endif  // #ifdef DEBUG_MSG
-						}
-						break;
-						case 1: {
-							LmHandlerRequestClass(CLASS_B);
+}
+
+static void ApplyScheduledAction(const uint8_t *action, uint8_t size) {
+	decode_packet(action, size);
+	system_update();
+}
+
+/*
+ * [GPS time MSB first (4)][scene (7)], repeated. A single 0 byte clears the schedule.
+ */
+static void OnScheduleRxData(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params) {
+	if ((size == 1) && (payload[0] == 0)) {
+		ActionSchedule_Clear();
+		return;
+	}
+	for (uint8_t i = 0; (i + 4 + SCENE_SIZE) <= size; i += 4 + SCENE_SIZE) {
+		const uint8_t *entry = &payload[i];
+		uint32_t gpsTime = ((uint32_t)entry[0] << 24) | ((uint32_t)entry[1] << 16) |
+		                   ((uint32_t)entry[2] << 8) | (uint32_t)entry[3];
+		if (!ActionSchedule_Add(gpsTime, &entry[4], SCENE_SIZE)) {
 #ifdef DEBUG_MSG
-							printf("CLASS_B!\n");
+			SYS_LOG("Schedule full!\n");
 #endif  // #ifdef DEBUG_MSG
-						}
-						break;
-						case 2: {
-							LmHandlerRequestClass(CLASS_C);
+			break;
+		}
+	}
+}
+
+static void ApplyConfig(const RemoteConfig_t *config) {
+	if (config->TxInterval != TxInterval) {
+		TxInterval = config->TxInterval;
+		/* Restarts the period if it runs */
+		UTIL_TIMER_SetPeriod(&SendTxDataTimer, (uint32_t)TxInterval * 1000U);
+	}
+	system_set_auto_threshold((float)config->AutoThreshold * 0.001f);
+	system_set_averaging(config->Averaging);
+	LmHandlerSetAdrEnable(config->AdrEnable != 0);
+	/* Only taken while ADR is off */
+	LmHandlerSetTxDatarate(config->TxDatarate);
+
+	if ((config->SiteLatitude != SiteLatitude) || (config->SiteLongitude != SiteLongitude)) {
+		SiteLatitude = config->SiteLatitude;
+		SiteLongitude = config->SiteLongitude;
+		SunApplied = false;
+		SunRetries = 0;
+		if ((SiteLatitude == 0) && (SiteLongitude == 0)) {
+			/* Back to the solar voltage alone */
+			UTIL_TIMER_Stop(&SunTimer);
+			system_clear_night();
+		} else {
+			UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_SunEvent), CFG_SEQ_Prio_0);
+		}
+	}
+}
+
+/*
+ * Settings, see remote_config.h. The answer goes with the next uplinks.
+ */
+static void OnConfigRxData(const uint8_t *payload, uint8_t size, const LmHandlerRxParams_t *params) {
+	uint8_t answer[UPLINK_QUEUE_MAX_PAYLOAD];
+	uint8_t answerSize = RemoteConfig_Process(payload, size, answer, sizeof(answer));
+
+	if (answerSize > 0) {
+		UplinkQueue_Push(UPLINK_CLASS_TELEMETRY, LORAWAN_CONFIG_PORT, LORAMAC_HANDLER_UNCONFIRMED_MSG,
+		                 answer, answerSize, NULL, LORAWAN_TELEMETRY_LIFETIME);
+		UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_UplinkDispatch), CFG_SEQ_Prio_0);
+	}
 #ifdef DEBUG_MSG
-							printf("CLASS_C!\n");
+	SYS_LOG("Config status %u\n", (answerSize > 0) ? answer[0] : 0);
 #endif  // #ifdef DEBUG_MSG
-						}
-						break;
-						default: {
-							break;
-						}
-					}
+	system_update();
+}
+
+/*
+ * Returns true between civil dusk and dawn, and the time of the next of them.
+ * The twilights of the previous and next UTC days are included, far from the
+ * Greenwich meridian they cross midnight UTC. A polar day or night starts at
+ * midnight UTC.
+ */
+static bool SunState(uint32_t now, uint32_t *next) {
+	uint32_t today = now - (now % SOLAR_DAY_LENGTH);
+	uint32_t last = 0;
+	bool lastValid = false;
+	bool night = false;
+	uint32_t time[2];
+	bool state[2];
+	uint8_t count;
+
+	*next = now + SOLAR_DAY_LENGTH;
+	for (int8_t d = -1; d <= 1; d++) {
+		uint32_t day = today + (uint32_t)((int32_t)d * (int32_t)SOLAR_DAY_LENGTH);
+		switch (SolarPosition_GetTwilight(day, SiteLatitude, SiteLongitude, &time[0], &time[1])) {
+			case SOLAR_DAY_NORMAL:
+				state[0] = false;
+				state[1] = true;
+				count = 2;
+				break;
+			case SOLAR_DAY_POLAR_NIGHT:
+				time[0] = day;
+				state[0] = true;
+				count = 1;
+				break;
+			case SOLAR_DAY_POLAR_DAY:
+			default:
+				time[0] = day;
+				state[0] = false;
+				count = 1;
+				break;
+		}
+		for (uint8_t i = 0; i < count; i++) {
+			if ((int32_t)(now - time[i]) >= 0) {
+				if (!lastValid || ((int32_t)(time[i] - last) > 0)) {
+					last = time[i];
+					night = state[i];
+					lastValid = true;
 				}
+			} else if ((int32_t)(time[i] - *next) < 0) {
+				*next = time[i];
 			}
-			break;
-			case LORAWAN_USER_APP_PORT: {
-				decode_packet(appData->Buffer, appData->BufferSize);
-				system_update();
-			}
-			break;
-			default: {
-			} break;
 		}
 	}
+	return night;
+}
+
+/*
+ * Switches the LEDs at civil dusk and dawn when the site position is known.
+ * The solar voltage confirms the transition, it is forced once the retries
+ * are exhausted so a dirty or shaded panel does not hold the LEDs.
+ */
+static void SunEvent(void) {
+	uint32_t now;
+	uint32_t next;
+	uint32_t delay;
+	bool night;
+
+	UTIL_TIMER_Stop(&SunTimer);
+	if (!ActionSchedule_IsTimeSynced() || ((SiteLatitude == 0) && (SiteLongitude == 0))) {
+		return;
+	}
+
+	now = ActionSchedule_GetGpsTime();
+	night = SunState(now, &next);
+	if (!SunApplied || (night != SunNight)) {
+		bool force = !SunApplied || (SunRetries >= LORAWAN_SUN_CONFIRM_RETRIES);
+		if (!system_set_night(night, force)) {
+			SunRetries++;
+#ifdef DEBUG_MSG
+			SYS_LOG("Sun night %u not confirmed\n", night);
+#endif  // #ifdef DEBUG_MSG
+			UTIL_TIMER_StartWithPeriod(&SunTimer, LORAWAN_SUN_CONFIRM_DELAY);
+			return;
+		}
+		SunNight = night;
+		SunApplied = true;
+		SunRetries = 0;
+	}
+
+	delay = next - now;
+	if (delay > SOLAR_DAY_LENGTH) {
+		delay = SOLAR_DAY_LENGTH;
+	}
+#ifdef DEBUG_MSG
+	SYS_LOG("Sun night %u, next change in %lu s\n", night, delay);
+#endif  // #ifdef DEBUG_MSG
+	UTIL_TIMER_StartWithPeriod(&SunTimer, delay * 1000U);
+}
+
+/* USER CODE END PrFD */
+
+static void OnRxData(LmHandlerAppData_t *appData, LmHandlerRxParams_t *params)
+{
+  /* USER CODE BEGIN OnRxData_1 */
+	/* The ports of the LmHandler packages have no route */
+	DownlinkRouter_Dispatch(appData, params);
   /* USER CODE END OnRxData_1 */
 }
 
@@ -272,11 +778,12 @@ static void OnTxData(LmHandlerTxParams_t *params)
 {
   /* USER CODE BEGIN OnTxData_1 */
 	if ((params != NULL) && (params->IsMcpsConfirm != 0)) {
+		UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_UplinkDispatch), CFG_SEQ_Prio_0);
 		if (params->MsgType == LORAMAC_HANDLER_CONFIRMED_MSG) {
 #ifdef DEBUG_MSG
-			printf("OnTxData confirmed!!\n");
+			SYS_LOG("OnTxData confirmed!!\n");
 		} else {
-			printf("OnTxData unconfirmed!\n");
+			SYS_LOG("OnTxData unconfirmed!\n");
 #endif // #ifdef DEBUG_MSG
 		}
 	}
@@ -290,13 +797,15 @@ static void OnJoinRequest(LmHandlerJoinParams_t *joinParams)
 		if (joinParams->Status == LORAMAC_HANDLER_SUCCESS) {
 			if (joinParams->Mode == ACTIVATION_TYPE_OTAA) {
 #ifdef DEBUG_MSG
-				printf("OnJoinRequest confirmed!!\n");
+				SYS_LOG("OnJoinRequest confirmed!!\n");
 #endif  // #ifdef DEBUG_MSG
 				UTIL_TIMER_Start(&SendTxDataTimer);
+				UTIL_TIMER_Start(&AlarmTimer);
+				UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_UplinkDispatch), CFG_SEQ_Prio_0);
 			}
 		} else {
 #ifdef DEBUG_MSG
-			printf("OnJoinRequest retry\n");
+			SYS_LOG("OnJoinRequest retry\n");
 #endif  // #ifdef DEBUG_MSG
 			UTIL_TIMER_Start(&JoinNetworkTimer);
 		}
@@ -308,6 +817,46 @@ static void OnJoinRequest(LmHandlerJoinParams_t *joinParams)
   /* USER CODE END OnJoinRequest_2 */
 }
 
+static void OnClassChange(DeviceClass_t deviceClass)
+{
+  /* USER CODE BEGIN OnClassChange_1 */
+#ifdef DEBUG_MSG
+	SYS_LOG("Class %c\n", "ABC"[deviceClass]);
+#endif  // #ifdef DEBUG_MSG
+#if (LORAMAC_CLASSC_SNIFF_PREAMBLE > 0)
+	/* The radio duty cycles the class C reception on its own, the MCU may stop in between */
+	UTIL_LPM_SetStopMode((1 << CFG_LPM_APPLI_Id), (deviceClass == CLASS_C) ? UTIL_LPM_ENABLE : UTIL_LPM_DISABLE);
+#endif
+  /* USER CODE END OnClassChange_1 */
+}
+
+static void OnBeaconStatusChange(LmHandlerBeaconParams_t *params)
+{
+  /* USER CODE BEGIN OnBeaconStatusChange_1 */
+#ifdef DEBUG_MSG
+	LmHandlerClassBStats_t stats;
+
+	if ((params != NULL) && (params->State == LORAMAC_HANDLER_BEACON_LOST) &&
+	    (LmHandlerGetClassBStats(&stats) == LORAMAC_HANDLER_SUCCESS)) {
+		SYS_LOG("Beacon lost, back to class A: rx %u missed %u lost %u\n",
+		        stats.BeaconsReceived, stats.BeaconsMissed, stats.BeaconsLost);
+	}
+#endif  // #ifdef DEBUG_MSG
+  /* USER CODE END OnBeaconStatusChange_1 */
+}
+
+static void OnSysTimeUpdate(void)
+{
+  /* USER CODE BEGIN OnSysTimeUpdate_1 */
+	TimeSyncTime = UTIL_TIMER_GetCurrentTime();
+	ActionSchedule_OnTimeSync();
+	UTIL_SEQ_SetTask((1 << CFG_SEQ_Task_SunEvent), CFG_SEQ_Prio_0);
+#ifdef DEBUG_MSG
+	SYS_LOG("Time synchronized, GPS %lu\n", ActionSchedule_GetGpsTime());
+#endif  // #ifdef DEBUG_MSG
+  /* USER CODE END OnSysTimeUpdate_1 */
+}
+
 static void OnMacProcessNotify(void)
 {
   /* USER CODE BEGIN OnMacProcessNotify_1 */
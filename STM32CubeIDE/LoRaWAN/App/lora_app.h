@@ -42,13 +42,59 @@ extern "C" {
 #define APP_TX_DUTYCYCLE                            20000
 #define LORAWAN_USER_APP_PORT                       1
 #define LORAWAN_SWITCH_CLASS_PORT                   3
+/* Group LED scenes: multicast scenes and unicast position of the node in its groups */
+#define LORAWAN_SCENE_PORT                          4
+/* Unit of the per position delay of a group scene in ms */
+#define LORAWAN_SCENE_STEP_UNIT                     10
+/* Scenes applied at a GPS time */
+#define LORAWAN_SCHEDULE_PORT                       5
+/* Flight recorder summary of the previous boot, sent once after a reset */
+#define LORAWAN_DIAG_PORT                           6
+/* Network time resync period, and retry delay while not synchronized, in ms */
+#define LORAWAN_TIME_SYNC_PERIOD                    (6 * 3600 * 1000)
+#define LORAWAN_TIME_SYNC_RETRY                     (10 * 60 * 1000)
+/* Site position in 1e-4 degree, north and east positive. 0, 0 leaves the LED
+ * auto mode on the solar voltage alone. */
+#define LORAWAN_SITE_LATITUDE                       0
+#define LORAWAN_SITE_LONGITUDE                      0
+/* Delay between the checks of a dawn or dusk the solar voltage does not
+ * confirm yet in ms, and number of checks before switching anyway */
+#define LORAWAN_SUN_CONFIRM_DELAY                   (5 * 60 * 1000)
+#define LORAWAN_SUN_CONFIRM_RETRIES                 6
 #define LORAWAN_DEFAULT_CLASS                       CLASS_A
 #define LORAWAN_DEFAULT_CONFIRMED_MSG_STATE         LORAMAC_HANDLER_UNCONFIRMED_MSG
 #define LORAWAN_ADR_STATE                           LORAMAC_HANDLER_ADR_ON
 #define LORAWAN_DEFAULT_DATA_RATE                   DR_0
 #define LORAWAN_DEFAULT_ACTIVATION_TYPE             ACTIVATION_TYPE_OTAA
 #define LORAWAN_APP_DATA_BUFFER_MAX_SIZE            242
+/* Slowest class B ping slot periodicity (ping period 2^n s), used when the budget below affords no faster one */
 #define LORAWAN_DEFAULT_PING_SLOT_PERIODICITY       4
+/* Class B receive budget: average current in uA for beacons and ping slots */
+#define LORAWAN_CLASSB_CURRENT_BUDGET               60
+/* Charge in uA.ms of one beacon window and of one empty ping slot, including the radio wake-up */
+#define LORAWAN_CLASSB_BEACON_CHARGE                800000
+#define LORAWAN_CLASSB_PING_SLOT_CHARGE             300000
+/* US915 sub-bands probed first when joining, bit n for FSB n+1 (0x02: FSB2), 0: none */
+#define LORAWAN_US915_PREFERRED_SUB_BANDS           0x00
+/* Alarms erasure coded across uplinks on LORAWAN_FEC_PORT (see uplink_fec.h),
+ * 0: confirmed alarms on LORAWAN_USER_APP_PORT, each costing a downlink */
+#define LORAWAN_ALARM_FEC                           1
+#define LORAWAN_FEC_PORT                            7
+/* Settings tuned by downlink, see remote_config.h */
+#define LORAWAN_CONFIG_PORT                         8
+/* Defaults of the settings: LED auto mode solar voltage in mV, ADC samples averaged */
+#define LORAWAN_AUTO_THRESHOLD                      400
+#define LORAWAN_SENSOR_AVERAGING                    4
+#define LORAWAN_ALARM_CONFIRMED_MSG_STATE           LORAMAC_HANDLER_CONFIRMED_MSG
+/* Uplink queue lifetimes in ms, 0: never expires */
+#define LORAWAN_ALARM_LIFETIME                      600000
+#define LORAWAN_TELEMETRY_LIFETIME                  (3 * APP_TX_DUTYCYCLE)
+/* Retry delay of the uplink queue while the MAC is busy or restricted */
+#define LORAWAN_UPLINK_RETRY_DELAY                  1000
+/* Retry delay of the uplink queue after an error, or while its uplinks do not fit the datarate */
+#define LORAWAN_UPLINK_BACKOFF_DELAY                APP_TX_DUTYCYCLE
+/* Period in ms of the alarm checks (PGOOD loss, motion) */
+#define LORAWAN_ALARM_POLL_PERIOD                   1000
 /* USER CODE END EC */
 
 /* Exported macro ------------------------------------------------------------*/
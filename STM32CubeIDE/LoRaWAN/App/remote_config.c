@@ -0,0 +1,210 @@
+/**
+  ******************************************************************************
+  * @file    remote_config.c
+  * @brief   Settings tuned by downlink and kept in flash
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+#include "settings_store.h"
+#include "remote_config.h"
+
+/* Private define ------------------------------------------------------------*/
+/**
+  * @brief Largest latitude and longitude in 1e-4 degree
+  */
+#define REMOTE_CONFIG_MAX_LATITUDE                  900000
+#define REMOTE_CONFIG_MAX_LONGITUDE                 1800000
+
+/* Private variables ---------------------------------------------------------*/
+/* Value size of each tag, the query has a variable one */
+static const uint8_t TagSize[REMOTE_CONFIG_TAG_NBR] = { 0, 2, 2, 1, 1, 1, 8 };
+
+static RemoteConfig_t Config;
+static RemoteConfigApply_t Apply = NULL;
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t GetValue(const uint8_t *value, uint8_t size)
+{
+  uint32_t result = 0;
+
+  for (uint8_t i = 0; i < size; i++)
+  {
+    result = (result << 8) | value[i];
+  }
+  return result;
+}
+
+static void PutValue(uint8_t *value, uint32_t data, uint8_t size)
+{
+  for (uint8_t i = size; i > 0; i--)
+  {
+    value[i - 1] = (uint8_t)data;
+    data >>= 8;
+  }
+}
+
+/**
+  * @brief Sets a setting from an entry value
+  * @param config settings
+  * @param tag entry tag, not the query
+  * @param value entry value, of the tag size
+  * @retval false if the value is out of range
+  */
+static bool SetEntry(RemoteConfig_t *config, uint8_t tag, const uint8_t *value)
+{
+  uint32_t data = GetValue(value, (TagSize[tag] > 4) ? 4 : TagSize[tag]);
+
+  switch (tag)
+  {
+    case REMOTE_CONFIG_TAG_TX_INTERVAL:
+      config->TxInterval = (uint16_t)data;
+      return data >= REMOTE_CONFIG_MIN_TX_INTERVAL;
+    case REMOTE_CONFIG_TAG_AUTO_THRESHOLD:
+      config->AutoThreshold = (uint16_t)data;
+      return data <= REMOTE_CONFIG_MAX_THRESHOLD;
+    case REMOTE_CONFIG_TAG_ADR:
+      config->AdrEnable = (uint8_t)data;
+      return data <= 1U;
+    case REMOTE_CONFIG_TAG_DATARATE:
+      config->TxDatarate = (int8_t)data;
+      return data <= REMOTE_CONFIG_MAX_DATARATE;
+    case REMOTE_CONFIG_TAG_AVERAGING:
+      config->Averaging = (uint8_t)data;
+      return (data >= 1U) && (data <= REMOTE_CONFIG_MAX_AVERAGING);
+    case REMOTE_CONFIG_TAG_SITE:
+      config->SiteLatitude = (int32_t)data;
+      config->SiteLongitude = (int32_t)GetValue(&value[4], 4);
+      return (config->SiteLatitude >= -REMOTE_CONFIG_MAX_LATITUDE) &&
+             (config->SiteLatitude <= REMOTE_CONFIG_MAX_LATITUDE) &&
+             (config->SiteLongitude >= -REMOTE_CONFIG_MAX_LONGITUDE) &&
+             (config->SiteLongitude <= REMOTE_CONFIG_MAX_LONGITUDE);
+    default:
+      return false;
+  }
+}
+
+/**
+  * @brief Writes the value of a setting
+  * @param tag entry tag, not the query
+  * @param value entry value, of the tag size
+  */
+static void GetEntry(uint8_t tag, uint8_t *value)
+{
+  switch (tag)
+  {
+    case REMOTE_CONFIG_TAG_TX_INTERVAL:
+      PutValue(value, Config.TxInterval, 2);
+      break;
+    case REMOTE_CONFIG_TAG_AUTO_THRESHOLD:
+      PutValue(value, Config.AutoThreshold, 2);
+      break;
+    case REMOTE_CONFIG_TAG_ADR:
+      value[0] = Config.AdrEnable;
+      break;
+    case REMOTE_CONFIG_TAG_DATARATE:
+      value[0] = (uint8_t)Config.TxDatarate;
+      break;
+    case REMOTE_CONFIG_TAG_AVERAGING:
+      value[0] = Config.Averaging;
+      break;
+    case REMOTE_CONFIG_TAG_SITE:
+      PutValue(value, (uint32_t)Config.SiteLatitude, 4);
+      PutValue(&value[4], (uint32_t)Config.SiteLongitude, 4);
+      break;
+    default:
+      break;
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+void RemoteConfig_Init(const RemoteConfig_t *defaults, RemoteConfigApply_t apply)
+{
+  uint16_t version;
+
+  Config = *defaults;
+  Apply = apply;
+  /* Fields are only appended: an older block leaves the defaults of the new ones */
+  SettingsStore_Load(&Config, sizeof(Config), &version);
+  Apply(&Config);
+}
+
+const RemoteConfig_t *RemoteConfig_Get(void)
+{
+  return &Config;
+}
+
+uint8_t RemoteConfig_Process(const uint8_t *command, uint8_t size, uint8_t *answer, uint8_t maxSize)
+{
+  RemoteConfig_t next = Config;
+  RemoteConfigStatus_t status = REMOTE_CONFIG_OK;
+  const uint8_t *query = NULL;
+  uint8_t querySize = 0;
+  uint8_t answerSize;
+
+  for (uint16_t i = 0; (i < size) && (status == REMOTE_CONFIG_OK);)
+  {
+    uint8_t tag;
+    uint8_t length;
+
+    if ((i + 2U) > size)
+    {
+      status = REMOTE_CONFIG_REJECTED;
+      break;
+    }
+    tag = command[i];
+    length = command[i + 1U];
+    if ((i + 2U + length) > size)
+    {
+      status = REMOTE_CONFIG_REJECTED;
+    }
+    else if (tag == REMOTE_CONFIG_TAG_QUERY)
+    {
+      query = &command[i + 2U];
+      querySize = length;
+    }
+    else if ((tag >= REMOTE_CONFIG_TAG_NBR) || (length != TagSize[tag]) || !SetEntry(&next, tag, &command[i + 2U]))
+    {
+      status = REMOTE_CONFIG_REJECTED;
+    }
+    i += 2U + length;
+  }
+
+  if ((status == REMOTE_CONFIG_OK) && (memcmp(&next, &Config, sizeof(Config)) != 0))
+  {
+    Config = next;
+    Apply(&Config);
+    if (!SettingsStore_Save(&Config, sizeof(Config), REMOTE_CONFIG_VERSION))
+    {
+      status = REMOTE_CONFIG_NOT_STORED;
+    }
+  }
+  if (((status == REMOTE_CONFIG_OK) && (query == NULL)) || (maxSize == 0))
+  {
+    return 0;
+  }
+
+  answer[0] = (uint8_t)status;
+  answerSize = 1;
+  if (query != NULL)
+  {
+    /* An empty query reads all the settings */
+    for (uint8_t i = 0; i < ((querySize == 0) ? (REMOTE_CONFIG_TAG_NBR - 1) : querySize); i++)
+    {
+      uint8_t tag = (querySize == 0) ? (i + 1) : query[i];
+
+      if ((tag == REMOTE_CONFIG_TAG_QUERY) || (tag >= REMOTE_CONFIG_TAG_NBR) ||
+          ((answerSize + 2U + TagSize[tag]) > maxSize))
+      {
+        continue;
+      }
+      answer[answerSize] = tag;
+      answer[answerSize + 1U] = TagSize[tag];
+      GetEntry(tag, &answer[answerSize + 2U]);
+      answerSize += 2U + TagSize[tag];
+    }
+  }
+  return answerSize;
+}
@@ -0,0 +1,126 @@
+/**
+  ******************************************************************************
+  * @file    remote_config.h
+  * @brief   Settings tuned by downlink and kept in flash
+  *
+  *          A command is a list of [tag][length][value] entries, values MSB
+  *          first. A command is applied as a whole: one invalid entry rejects
+  *          it. The QUERY entry lists the tags to read back, all of them when
+  *          empty. The answer is [status] followed by the queried entries, it
+  *          is only sent for a query or a rejected command.
+  ******************************************************************************
+  */
+#ifndef __REMOTE_CONFIG_H__
+#define __REMOTE_CONFIG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Layout version of RemoteConfig_t, fields are only appended
+ */
+#define REMOTE_CONFIG_VERSION                       1
+
+/*!
+ * Shortest telemetry period in s
+ */
+#define REMOTE_CONFIG_MIN_TX_INTERVAL               10
+
+/*!
+ * Highest LED auto mode threshold in mV, the ADC reference
+ */
+#define REMOTE_CONFIG_MAX_THRESHOLD                 3400
+
+/*!
+ * Highest uplink datarate, DR_4 is the last 125 kHz one of US915
+ */
+#define REMOTE_CONFIG_MAX_DATARATE                  4
+
+/*!
+ * Most ADC samples averaged
+ */
+#define REMOTE_CONFIG_MAX_AVERAGING                 4
+
+/*!
+ * Entry tags
+ */
+typedef enum
+{
+  REMOTE_CONFIG_TAG_QUERY,            /*!< Tags to read back */
+  REMOTE_CONFIG_TAG_TX_INTERVAL,      /*!< 2 bytes, telemetry period in s */
+  REMOTE_CONFIG_TAG_AUTO_THRESHOLD,   /*!< 2 bytes, LED auto mode solar voltage in mV */
+  REMOTE_CONFIG_TAG_ADR,              /*!< 1 byte, 0: off, 1: on */
+  REMOTE_CONFIG_TAG_DATARATE,         /*!< 1 byte, datarate while ADR is off */
+  REMOTE_CONFIG_TAG_AVERAGING,        /*!< 1 byte, ADC samples averaged */
+  REMOTE_CONFIG_TAG_SITE,             /*!< 8 bytes, latitude and longitude in 1e-4 degree */
+  REMOTE_CONFIG_TAG_NBR
+} RemoteConfigTag_t;
+
+/*!
+ * Answer status
+ */
+typedef enum
+{
+  REMOTE_CONFIG_OK,
+  REMOTE_CONFIG_REJECTED,     /*!< Malformed command or value out of range */
+  REMOTE_CONFIG_NOT_STORED,   /*!< Applied, but lost at the next reset */
+} RemoteConfigStatus_t;
+
+/* Exported types ------------------------------------------------------------*/
+/*!
+ * Settings
+ */
+typedef struct
+{
+  uint16_t TxInterval;       /*!< Telemetry period in s */
+  uint16_t AutoThreshold;    /*!< LED auto mode solar voltage in mV */
+  uint8_t AdrEnable;         /*!< ADR on */
+  int8_t TxDatarate;         /*!< Datarate while ADR is off */
+  uint8_t Averaging;         /*!< ADC samples averaged */
+  uint8_t Reserved;
+  int32_t SiteLatitude;      /*!< 1e-4 degree, north positive */
+  int32_t SiteLongitude;     /*!< 1e-4 degree, east positive */
+} RemoteConfig_t;
+
+/*!
+ * Applies the settings
+ */
+typedef void (*RemoteConfigApply_t)(const RemoteConfig_t *config);
+
+/* Exported functions ------------------------------------------------------- */
+/**
+  * @brief Loads the stored settings over the defaults and applies them
+  * @param defaults settings used when nothing valid is stored
+  * @param apply called with the settings at init and after each change
+  * @retval none
+  */
+void RemoteConfig_Init(const RemoteConfig_t *defaults, RemoteConfigApply_t apply);
+
+/**
+  * @brief Returns the current settings
+  * @param none
+  * @retval settings
+  */
+const RemoteConfig_t *RemoteConfig_Get(void);
+
+/**
+  * @brief Applies and stores a command
+  * @param command command entries
+  * @param size command size
+  * @param answer answer buffer
+  * @param maxSize answer buffer size, the queried entries which do not fit are left out
+  * @retval answer size, 0 if there is nothing to answer
+  */
+uint8_t RemoteConfig_Process(const uint8_t *command, uint8_t size, uint8_t *answer, uint8_t maxSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REMOTE_CONFIG_H__ */
@@ -0,0 +1,204 @@
+/**
+  ******************************************************************************
+  * @file    solar_position.c
+  * @brief   Fixed-point civil twilight times
+  *
+  *          Low precision solar coordinates (Astronomical Almanac), evaluated
+  *          once per day at the approximate solar noon. Angles are binary
+  *          angles (65536 per turn), sines and cosines are Q15.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "solar_position.h"
+
+/* Private define ------------------------------------------------------------*/
+#define BA_TURN                                     65536
+#define BA_QUARTER                                  16384
+#define Q15_ONE                                     32768
+
+/**
+  * @brief J2000.0 epoch (2000-01-01 12:00) in GPS time
+  */
+#define J2000_GPS_TIME                              630763200
+
+/**
+  * @brief Obliquity of the ecliptic, 23.439 degrees
+  */
+#define OBLIQUITY_BA                                4267
+
+/**
+  * @brief Sine of the civil twilight altitude, -6 degrees
+  */
+#define SIN_CIVIL_TWILIGHT                          (-3425)
+
+/* Private variables ---------------------------------------------------------*/
+/**
+  * @brief Quarter wave sine, 65 points
+  */
+static const uint16_t SinTable[65] =
+{
+  0, 804, 1608, 2411, 3212, 4011, 4808, 5602, 6393, 7180, 7962, 8740, 9512, 10279, 11039, 11793,
+  12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531, 18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595,
+  23170, 23732, 24279, 24812, 25330, 25833, 26320, 26791, 27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+  30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972, 32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758,
+  32768
+};
+
+/**
+  * @brief atan(2^-i) in binary angle, CORDIC steps
+  */
+static const uint16_t AtanTable[16] =
+{
+  8192, 4836, 2555, 1297, 651, 326, 163, 81, 41, 20, 10, 5, 3, 1, 1, 0
+};
+
+/* Private functions ---------------------------------------------------------*/
+static int32_t Sin(int32_t angle)
+{
+  uint32_t a = (uint32_t)angle & (BA_TURN - 1);
+  uint32_t idx = a & (BA_QUARTER - 1);
+  int32_t value;
+
+  if ((a & BA_QUARTER) != 0)
+  {
+    idx = BA_QUARTER - idx;
+  }
+  if (idx == BA_QUARTER)
+  {
+    value = Q15_ONE;
+  }
+  else
+  {
+    value = SinTable[idx >> 8] + ((((int32_t)SinTable[(idx >> 8) + 1] - SinTable[idx >> 8]) * (int32_t)(idx & 0xFF)) >> 8);
+  }
+  return ((a & (2 * BA_QUARTER)) != 0) ? -value : value;
+}
+
+static int32_t Cos(int32_t angle)
+{
+  return Sin(angle + BA_QUARTER);
+}
+
+/**
+  * @brief CORDIC arc tangent
+  * @retval angle of (x, y) in binary angle, -32768..32767
+  */
+static int32_t Atan2(int32_t y, int32_t x)
+{
+  int32_t angle = 0;
+  int32_t xi;
+
+  if ((x == 0) && (y == 0))
+  {
+    return 0;
+  }
+  /* Headroom for the CORDIC gain, multiplied as x and y may be negative */
+  x *= (1 << 14);
+  y *= (1 << 14);
+  if (x < 0)
+  {
+    x = -x;
+    y = -y;
+    angle = BA_TURN / 2;
+  }
+  for (uint8_t i = 0; i < 16; i++)
+  {
+    xi = x;
+    if (y > 0)
+    {
+      x += y >> i;
+      y -= xi >> i;
+      angle += AtanTable[i];
+    }
+    else
+    {
+      x -= y >> i;
+      y += xi >> i;
+      angle -= AtanTable[i];
+    }
+  }
+  return (int16_t)angle;
+}
+
+static uint32_t ISqrt(uint32_t value)
+{
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+
+  while (bit > value)
+  {
+    bit >>= 2;
+  }
+  while (bit != 0)
+  {
+    if (value >= root + bit)
+    {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+/**
+  * @brief Angle in binary angle of a mean longitude or anomaly in 1e-6 degree
+  */
+static int32_t MicroDegreesToBa(int64_t value)
+{
+  value %= 360000000LL;
+  if (value < 0)
+  {
+    value += 360000000LL;
+  }
+  return (int32_t)((value * BA_TURN) / 360000000LL);
+}
+
+/* Exported functions --------------------------------------------------------*/
+SolarDay_t SolarPosition_GetTwilight(uint32_t day, int32_t latitude, int32_t longitude,
+                                     uint32_t *dawn, uint32_t *dusk)
+{
+  /* Longitude in s of solar time, 240 s per degree */
+  int32_t longitudeTime = (longitude * 240) / 10000;
+  int32_t noon = (int32_t)(SOLAR_DAY_LENGTH / 2) - longitudeTime;
+  int64_t t = ((int64_t)day + noon) - J2000_GPS_TIME;
+  int32_t meanAnomaly = MicroDegreesToBa(357529000LL + ((t * 98560028LL) / 8640000LL));
+  int32_t meanLongitude = MicroDegreesToBa(280459000LL + ((t * 98564736LL) / 8640000LL));
+  int32_t eclipticLongitude = meanLongitude + ((34862 * Sin(meanAnomaly)) >> 15) / 100 +
+                              ((364 * Sin(2 * meanAnomaly)) >> 15) / 100;
+  int32_t sinDeclination = (Sin(OBLIQUITY_BA) * Sin(eclipticLongitude)) >> 15;
+  int32_t cosDeclination = (int32_t)ISqrt((uint32_t)(((int64_t)Q15_ONE * Q15_ONE) -
+                                                     ((int64_t)sinDeclination * sinDeclination)));
+  int32_t rightAscension = Atan2((Cos(OBLIQUITY_BA) * Sin(eclipticLongitude)) >> 15, Cos(eclipticLongitude));
+  /* Equation of time, a full turn is a day */
+  int32_t equationOfTime = (int32_t)(((int64_t)(int16_t)(meanLongitude - rightAscension) * SOLAR_DAY_LENGTH) / BA_TURN);
+  int32_t latitudeBa = (int32_t)(((int64_t)latitude * BA_TURN) / 3600000);
+  int32_t numerator = SIN_CIVIL_TWILIGHT - ((Sin(latitudeBa) * sinDeclination) >> 15);
+  int32_t denominator = (Cos(latitudeBa) * cosDeclination) >> 15;
+  int32_t cosHourAngle;
+  int32_t sinHourAngle;
+  int32_t hourAngle;
+
+  if (numerator >= denominator)
+  {
+    return SOLAR_DAY_POLAR_NIGHT;
+  }
+  if (-numerator >= denominator)
+  {
+    return SOLAR_DAY_POLAR_DAY;
+  }
+  cosHourAngle = (int32_t)(((int64_t)numerator * Q15_ONE) / denominator);
+  sinHourAngle = (int32_t)ISqrt((uint32_t)(((int64_t)Q15_ONE * Q15_ONE) - ((int64_t)cosHourAngle * cosHourAngle)));
+  /* 0 to half a turn, sinHourAngle is positive */
+  hourAngle = (int32_t)(((int64_t)(uint16_t)Atan2(sinHourAngle, cosHourAngle) * SOLAR_DAY_LENGTH) / BA_TURN);
+
+  noon -= equationOfTime;
+  *dawn = (uint32_t)((int32_t)day + noon - hourAngle);
+  *dusk = (uint32_t)((int32_t)day + noon + hourAngle);
+  return SOLAR_DAY_NORMAL;
+}
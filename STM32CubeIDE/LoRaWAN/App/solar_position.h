@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file    solar_position.h
+  * @brief   Fixed-point civil twilight times
+  ******************************************************************************
+  */
+#ifndef __SOLAR_POSITION_H__
+#define __SOLAR_POSITION_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Length of a day in s
+ */
+#define SOLAR_DAY_LENGTH                            86400U
+
+/* Exported types ------------------------------------------------------------*/
+/*!
+ * Kind of day at a location
+ */
+typedef enum
+{
+  SOLAR_DAY_NORMAL,         /*!< The sun crosses the civil twilight altitude */
+  SOLAR_DAY_POLAR_NIGHT,    /*!< The sun stays below the civil twilight altitude */
+  SOLAR_DAY_POLAR_DAY,      /*!< The sun stays above the civil twilight altitude */
+} SolarDay_t;
+
+/* Exported functions ------------------------------------------------------- */
+/**
+  * @brief Computes the civil dawn and dusk (sun 6 degrees below the horizon)
+  *        around the local solar noon of a UTC day, within a few minutes.
+  *        Far from the Greenwich meridian they may fall on the previous or
+  *        next UTC day. Integer arithmetic only.
+  * @param day GPS time in s of the start of the UTC day, a multiple of SOLAR_DAY_LENGTH
+  * @param latitude latitude in 1e-4 degree, north positive
+  * @param longitude longitude in 1e-4 degree, east positive
+  * @param dawn GPS time in s of the civil dawn, set for SOLAR_DAY_NORMAL only
+  * @param dusk GPS time in s of the civil dusk, set for SOLAR_DAY_NORMAL only
+  * @retval kind of day
+  */
+SolarDay_t SolarPosition_GetTwilight(uint32_t day, int32_t latitude, int32_t longitude,
+                                     uint32_t *dawn, uint32_t *dusk);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SOLAR_POSITION_H__ */
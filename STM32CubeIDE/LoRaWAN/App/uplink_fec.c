@@ -0,0 +1,142 @@
+/**
+  ******************************************************************************
+  * @file    uplink_fec.c
+  * @brief   Systematic erasure code across application uplinks
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32_mem.h"
+#include "uplink_fec.h"
+
+/* Private define ------------------------------------------------------------*/
+/**
+  * @brief Shard: payload size and payload
+  */
+#define UPLINK_FEC_SHARD_SIZE                       (UPLINK_FEC_MAX_PAYLOAD + 1)
+
+/**
+  * @brief Parity flag of the second header byte
+  */
+#define UPLINK_FEC_PARITY_FLAG                      0x80U
+
+/**
+  * @brief Low byte of the GF(256) polynomial x^8 + x^4 + x^3 + x^2 + 1
+  */
+#define UPLINK_FEC_GF_POLY                          0x1DU
+
+/* Private variables ---------------------------------------------------------*/
+/**
+  * @brief Parity shards of the current window, accumulated as payloads are added
+  */
+static uint8_t Parity[UPLINK_FEC_PARITY_COUNT][UPLINK_FEC_SHARD_SIZE];
+
+/**
+  * @brief Window number, payloads in the window and longest shard
+  */
+static uint8_t Window = 0;
+static uint8_t Count = 0;
+static uint8_t ShardSize = 0;
+
+/* Private functions ---------------------------------------------------------*/
+static uint8_t GfMul(uint8_t a, uint8_t b)
+{
+  uint8_t product = 0;
+
+  while (b != 0)
+  {
+    if ((b & 1U) != 0)
+    {
+      product ^= a;
+    }
+    a = (uint8_t)((a << 1) ^ (((a & 0x80U) != 0) ? UPLINK_FEC_GF_POLY : 0U));
+    b >>= 1;
+  }
+  return product;
+}
+
+/**
+  * @brief Multiplicative inverse, a^254
+  */
+static uint8_t GfInv(uint8_t a)
+{
+  uint8_t result = a;
+
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    a = GfMul(a, a);
+    result = GfMul(result, a);
+  }
+  return GfMul(result, result);
+}
+
+/**
+  * @brief Cauchy coefficient of payload i in parity j: 1 / (x_j + y_i) with
+  *        x_j = UPLINK_FEC_WINDOW_SIZE + j and y_i = i, all distinct
+  */
+static uint8_t Coefficient(uint8_t j, uint8_t i)
+{
+  return GfInv((uint8_t)((UPLINK_FEC_WINDOW_SIZE + j) ^ i));
+}
+
+/* Exported functions --------------------------------------------------------*/
+void UplinkFec_Init(uint8_t window)
+{
+  Window = window;
+  Count = 0;
+  ShardSize = 0;
+  UTIL_MEM_set_8(Parity, 0, sizeof(Parity));
+}
+
+uint8_t UplinkFec_EncodeData(const uint8_t *payload, uint8_t size, uint8_t *frame)
+{
+  if ((size > UPLINK_FEC_MAX_PAYLOAD) || (Count >= UPLINK_FEC_WINDOW_SIZE))
+  {
+    return 0;
+  }
+
+  frame[0] = Window;
+  frame[1] = Count;
+  UTIL_MEM_cpy_8(&frame[UPLINK_FEC_HEADER_SIZE], payload, size);
+
+  /* The shard is the size byte followed by the payload, its zero padding adds nothing */
+  for (uint8_t j = 0; j < UPLINK_FEC_PARITY_COUNT; j++)
+  {
+    uint8_t c = Coefficient(j, Count);
+
+    Parity[j][0] ^= GfMul(c, size);
+    for (uint8_t n = 0; n < size; n++)
+    {
+      Parity[j][n + 1] ^= GfMul(c, payload[n]);
+    }
+  }
+  if ((size + 1) > ShardSize)
+  {
+    ShardSize = size + 1;
+  }
+  Count++;
+  return UPLINK_FEC_HEADER_SIZE + size;
+}
+
+uint8_t UplinkFec_EncodeParity(uint8_t index, uint8_t *frame)
+{
+  if ((Count == 0) || (index >= UPLINK_FEC_PARITY_COUNT))
+  {
+    return 0;
+  }
+
+  frame[0] = Window;
+  frame[1] = UPLINK_FEC_PARITY_FLAG | (uint8_t)(index << 4) | Count;
+  UTIL_MEM_cpy_8(&frame[UPLINK_FEC_HEADER_SIZE], Parity[index], ShardSize);
+  return UPLINK_FEC_HEADER_SIZE + ShardSize;
+}
+
+uint8_t UplinkFec_Count(void)
+{
+  return Count;
+}
+
+void UplinkFec_NextWindow(void)
+{
+  UplinkFec_Init(Window + 1U);
+}
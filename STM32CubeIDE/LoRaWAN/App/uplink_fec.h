@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    uplink_fec.h
+  * @brief   Systematic erasure code across application uplinks
+  *
+  *          The payloads of a window are sent as they are, followed by parity
+  *          frames coded over GF(256) with a Cauchy matrix. Any k of the
+  *          frames of a window of k payloads rebuild the payloads lost on the
+  *          way, without a downlink. tools/fec_decode.py is the reference
+  *          decoder.
+  *
+  *          Data frame:   window u8, index u8, payload
+  *          Parity frame: window u8, 0x80 | parity index << 4 | k, coded shard
+  *
+  *          A shard is the payload size u8 then the payload, zero padded to
+  *          the longest shard of the window.
+  ******************************************************************************
+  */
+#ifndef __UPLINK_FEC_H__
+#define __UPLINK_FEC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "uplink_queue.h"
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Payloads per window, at most 15
+ */
+#define UPLINK_FEC_WINDOW_SIZE                      4
+
+/*!
+ * Parity frames per window, at most 8
+ */
+#define UPLINK_FEC_PARITY_COUNT                     2
+
+/*!
+ * Frame header size
+ */
+#define UPLINK_FEC_HEADER_SIZE                      2
+
+/*!
+ * Maximum payload size, the parity frames carry it with its size
+ */
+#define UPLINK_FEC_MAX_PAYLOAD                      (UPLINK_QUEUE_MAX_PAYLOAD - UPLINK_FEC_HEADER_SIZE - 1)
+
+/* Exported functions ------------------------------------------------------- */
+/**
+  * @brief Starts the first window
+  * @param window first window number, random so that the decoder does not
+  *        mix the windows sent before and after a reset
+  * @retval none
+  */
+void UplinkFec_Init(uint8_t window);
+
+/**
+  * @brief Adds a payload to the current window and encodes its data frame
+  * @param payload payload
+  * @param size payload size, at most UPLINK_FEC_MAX_PAYLOAD
+  * @param frame frame buffer of UPLINK_QUEUE_MAX_PAYLOAD bytes
+  * @retval frame size, 0 if the payload is too large or the window is full
+  */
+uint8_t UplinkFec_EncodeData(const uint8_t *payload, uint8_t size, uint8_t *frame);
+
+/**
+  * @brief Encodes a parity frame of the current window
+  * @param index parity index, below UPLINK_FEC_PARITY_COUNT
+  * @param frame frame buffer of UPLINK_QUEUE_MAX_PAYLOAD bytes
+  * @retval frame size, 0 if the window is empty
+  */
+uint8_t UplinkFec_EncodeParity(uint8_t index, uint8_t *frame);
+
+/**
+  * @brief Returns the number of payloads in the current window
+  * @param none
+  * @retval number of payloads, UPLINK_FEC_WINDOW_SIZE once full
+  */
+uint8_t UplinkFec_Count(void);
+
+/**
+  * @brief Closes the current window, once its parity frames are encoded
+  * @param none
+  * @retval none
+  */
+void UplinkFec_NextWindow(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UPLINK_FEC_H__ */
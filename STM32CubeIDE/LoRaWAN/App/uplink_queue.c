@@ -0,0 +1,201 @@
+/**
+  ******************************************************************************
+  * @file    uplink_queue.c
+  * @brief   Bounded priority queue of application uplinks
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "stm32_mem.h"
+#include "uplink_queue.h"
+
+/* Private variables ---------------------------------------------------------*/
+/**
+  * @brief Queue slots
+  */
+static UplinkMsg_t Slots[UPLINK_QUEUE_SIZE];
+
+/**
+  * @brief Slot in use flags
+  */
+static bool SlotUsed[UPLINK_QUEUE_SIZE];
+
+/**
+  * @brief Enqueue counter, orders the uplinks of a class
+  */
+static uint32_t Sequence = 0;
+
+/* Private functions ---------------------------------------------------------*/
+static bool IsExpired(const UplinkMsg_t *msg, UTIL_TIMER_Time_t now)
+{
+  return (msg->Deadline != 0) && ((int32_t)(now - msg->Deadline) >= 0);
+}
+
+/**
+  * @brief Returns true if a should leave the queue before b
+  */
+static bool IsBefore(const UplinkMsg_t *a, const UplinkMsg_t *b)
+{
+  if (a->Class != b->Class)
+  {
+    return a->Class < b->Class;
+  }
+  return (int32_t)(a->Sequence - b->Sequence) < 0;
+}
+
+static void DropExpired(void)
+{
+  UTIL_TIMER_Time_t now = UTIL_TIMER_GetCurrentTime();
+
+  for (uint8_t i = 0; i < UPLINK_QUEUE_SIZE; i++)
+  {
+    if ((SlotUsed[i] == true) && (IsExpired(&Slots[i], now) == true))
+    {
+      SlotUsed[i] = false;
+    }
+  }
+}
+
+/**
+  * @brief Finds the slot for a new uplink of the given class
+  * @retval slot index, UPLINK_QUEUE_SIZE if none
+  */
+static uint8_t FindSlot(UplinkClass_t cls, uint8_t port)
+{
+  uint8_t victim = UPLINK_QUEUE_SIZE;
+
+  if (cls == UPLINK_CLASS_TELEMETRY)
+  {
+    for (uint8_t i = 0; i < UPLINK_QUEUE_SIZE; i++)
+    {
+      if ((SlotUsed[i] == true) && (Slots[i].Class == UPLINK_CLASS_TELEMETRY) && (Slots[i].Port == port))
+      {
+        /* Superseded snapshot */
+        return i;
+      }
+    }
+  }
+
+  for (uint8_t i = 0; i < UPLINK_QUEUE_SIZE; i++)
+  {
+    if (SlotUsed[i] == false)
+    {
+      return i;
+    }
+    /* Queue full: oldest uplink of the lowest class, never one above the new uplink */
+    if (Slots[i].Class < cls)
+    {
+      continue;
+    }
+    if ((victim == UPLINK_QUEUE_SIZE) || (Slots[i].Class > Slots[victim].Class) ||
+        ((Slots[i].Class == Slots[victim].Class) && ((int32_t)(Slots[i].Sequence - Slots[victim].Sequence) < 0)))
+    {
+      victim = i;
+    }
+  }
+  return victim;
+}
+
+/* Exported functions --------------------------------------------------------*/
+void UplinkQueue_Init(void)
+{
+  UTIL_MEM_set_8(SlotUsed, 0, sizeof(SlotUsed));
+  Sequence = 0;
+}
+
+bool UplinkQueue_Push(UplinkClass_t cls, uint8_t port, LmHandlerMsgTypes_t msgType, const uint8_t *payload,
+                      uint8_t size, UplinkEncoder_t encode, UTIL_TIMER_Time_t lifetime)
+{
+  UplinkMsg_t *msg;
+  uint8_t slot;
+
+  if ((cls >= UPLINK_CLASS_NBR) || (size > UPLINK_QUEUE_MAX_PAYLOAD) || ((payload == NULL) && (size > 0)))
+  {
+    return false;
+  }
+
+  DropExpired();
+  slot = FindSlot(cls, port);
+  if (slot == UPLINK_QUEUE_SIZE)
+  {
+    return false;
+  }
+
+  msg = &Slots[slot];
+  msg->Class = cls;
+  msg->Port = port;
+  msg->MsgType = msgType;
+  msg->Deadline = 0;
+  if (lifetime != 0)
+  {
+    msg->Deadline = UTIL_TIMER_GetCurrentTime() + lifetime;
+    if (msg->Deadline == 0)
+    {
+      msg->Deadline = 1;
+    }
+  }
+  msg->Sequence = Sequence++;
+  msg->Encode = encode;
+  msg->Size = size;
+  if (size > 0)
+  {
+    UTIL_MEM_cpy_8(msg->Payload, payload, size);
+  }
+  SlotUsed[slot] = true;
+  return true;
+}
+
+UplinkMsg_t *UplinkQueue_Peek(uint8_t maxSize, UplinkMsg_t **heldBack)
+{
+  UplinkMsg_t *next = NULL;
+  UplinkMsg_t *held = NULL;
+
+  DropExpired();
+  for (uint8_t i = 0; i < UPLINK_QUEUE_SIZE; i++)
+  {
+    if (SlotUsed[i] == false)
+    {
+      continue;
+    }
+    if ((Slots[i].Size > maxSize) && (Slots[i].Encode == NULL))
+    {
+      if ((held == NULL) || (IsBefore(&Slots[i], held) == true))
+      {
+        held = &Slots[i];
+      }
+      continue;
+    }
+    if ((next == NULL) || (IsBefore(&Slots[i], next) == true))
+    {
+      next = &Slots[i];
+    }
+  }
+  if (heldBack != NULL)
+  {
+    *heldBack = held;
+  }
+  return next;
+}
+
+void UplinkQueue_Remove(UplinkMsg_t *msg)
+{
+  if ((msg >= &Slots[0]) && (msg < &Slots[UPLINK_QUEUE_SIZE]))
+  {
+    SlotUsed[msg - &Slots[0]] = false;
+  }
+}
+
+uint8_t UplinkQueue_Count(void)
+{
+  uint8_t count = 0;
+
+  for (uint8_t i = 0; i < UPLINK_QUEUE_SIZE; i++)
+  {
+    if (SlotUsed[i] == true)
+    {
+      count++;
+    }
+  }
+  return count;
+}
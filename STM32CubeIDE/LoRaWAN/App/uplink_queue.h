@@ -0,0 +1,118 @@
+/**
+  ******************************************************************************
+  * @file    uplink_queue.h
+  * @brief   Bounded priority queue of application uplinks
+  ******************************************************************************
+  */
+#ifndef __UPLINK_QUEUE_H__
+#define __UPLINK_QUEUE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32_timer.h"
+#include "LmHandlerTypes.h"
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Number of uplinks the queue holds
+ */
+#define UPLINK_QUEUE_SIZE                           8
+
+/*!
+ * Maximum size of a queued payload, larger payloads need an encoder
+ */
+#define UPLINK_QUEUE_MAX_PAYLOAD                    16
+
+/* Exported types ------------------------------------------------------------*/
+/*!
+ * Message classes, in order of priority
+ */
+typedef enum
+{
+  UPLINK_CLASS_ALARM,        /*!< Events, never coalesced */
+  UPLINK_CLASS_TELEMETRY,    /*!< Periodic state, a new one supersedes the queued one of the same port */
+  UPLINK_CLASS_DIAGNOSTICS,  /*!< Sent when nothing else is pending */
+  UPLINK_CLASS_NBR
+} UplinkClass_t;
+
+/*!
+ * Encodes a payload of at most maxSize bytes into buffer.
+ * Returns the encoded size, 0 if nothing useful fits.
+ */
+typedef uint8_t (*UplinkEncoder_t)(uint8_t *buffer, uint8_t maxSize);
+
+/*!
+ * Queued uplink
+ */
+typedef struct
+{
+  UplinkClass_t Class;             /*!< Message class */
+  uint8_t Port;                    /*!< Application port */
+  LmHandlerMsgTypes_t MsgType;     /*!< Confirmed or unconfirmed */
+  UTIL_TIMER_Time_t Deadline;      /*!< Time after which the uplink is dropped, 0: never */
+  uint32_t Sequence;               /*!< Enqueue order */
+  UplinkEncoder_t Encode;          /*!< Re-encodes the payload when it does not fit, may be NULL */
+  uint8_t Size;                    /*!< Payload size */
+  uint8_t Payload[UPLINK_QUEUE_MAX_PAYLOAD]; /*!< Payload snapshot */
+} UplinkMsg_t;
+
+/* Exported functions ------------------------------------------------------- */
+/**
+  * @brief Empties the queue
+  * @param none
+  * @retval none
+  */
+void UplinkQueue_Init(void);
+
+/**
+  * @brief Queues an uplink. A telemetry uplink replaces the queued telemetry
+  *        of the same port. When the queue is full, the oldest uplink of the
+  *        lowest class not above the new one is dropped.
+  * @param cls message class
+  * @param port application port
+  * @param msgType confirmed or unconfirmed
+  * @param payload payload snapshot, copied
+  * @param size payload size, at most UPLINK_QUEUE_MAX_PAYLOAD
+  * @param encode re-encodes the payload at dispatch time if it does not fit, may be NULL
+  * @param lifetime time in ms after which the uplink is dropped, 0: never
+  * @retval true if queued, false if the queue only holds uplinks of higher classes
+  */
+bool UplinkQueue_Push(UplinkClass_t cls, uint8_t port, LmHandlerMsgTypes_t msgType, const uint8_t *payload,
+                      uint8_t size, UplinkEncoder_t encode, UTIL_TIMER_Time_t lifetime);
+
+/**
+  * @brief Drops the expired uplinks and returns the next one to send: the
+  *        oldest of the highest class which fits into maxSize or can be
+  *        re-encoded. The uplink stays queued until UplinkQueue_Remove.
+  *        Uplinks larger than maxSize without an encoder stay queued until
+  *        they fit or expire, the first of them is reported in heldBack.
+  * @param maxSize payload size available at the current datarate
+  * @param heldBack set to the next uplink which does not fit, NULL if none
+  * @retval next uplink, NULL if none
+  */
+UplinkMsg_t *UplinkQueue_Peek(uint8_t maxSize, UplinkMsg_t **heldBack);
+
+/**
+  * @brief Removes an uplink returned by UplinkQueue_Peek
+  * @param msg uplink to remove
+  * @retval none
+  */
+void UplinkQueue_Remove(UplinkMsg_t *msg);
+
+/**
+  * @brief Returns the number of queued uplinks
+  * @param none
+  * @retval number of uplinks, including expired ones not yet dropped
+  */
+uint8_t UplinkQueue_Count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UPLINK_QUEUE_H__ */
@@ -52,17 +52,39 @@ extern "C" {
 #define REGION_US915
 /*#define REGION_RU864*/
 
+/* Single region build: when exactly one region is listed above, set to 1 to
+   replace the runtime region dispatch of Region.c by direct calls into that
+   region. The MAC then refuses any other ACTIVE_REGION at initialization. */
+#ifndef LORAMAC_SINGLE_REGION
+#define LORAMAC_SINGLE_REGION   1
+#endif /* LORAMAC_SINGLE_REGION */
+
 #define HYBRID_ENABLED          0
 
+/* Data distribution: remote multicast setup and fragmented data block
+   transport, the firmware update over the air, see boot.h */
+#define LORAWAN_DATA_DISTRIB_MGT        1
+
 /* USER CODE BEGIN KEY_LOG_ENABLED */
 #define KEY_LOG_ENABLED         0
 /* USER CODE END KEY_LOG_ENABLED */
 
+/* Device side TX power control: steps the TX power below the one set by the
+   application or by LinkADRReq while the link margin allows it.
+   LORAMAC_TXPOWER_CTRL_WITH_ADR set to 0 limits it to ADR off. */
+#define LORAMAC_TXPOWER_CTRL_ENABLED    1
+#define LORAMAC_TXPOWER_CTRL_WITH_ADR   1
+
+/* Class C RX sniff: the continuous class C reception is replaced by a radio
+   duty cycle which catches the downlinks sent with a preamble of at least
+   LORAMAC_CLASSC_SNIFF_PREAMBLE symbols. Only for a network server configured
+   to send such preambles to these devices. 0: continuous reception */
+#define LORAMAC_CLASSC_SNIFF_PREAMBLE   0
+
 /* Class B ------------------------------------*/
-#define LORAMAC_CLASSB_ENABLED  0
+#define LORAMAC_CLASSB_ENABLED  1
 
-#if ( LORAMAC_CLASSB_ENABLED == 1 )
-/* CLASS B LSE crystall calibration*/
+/* LSE crystal calibration, used by class B and by the RX window clock error model */
 /**
   * \brief Temperature coefficient of the clock source
   */
@@ -82,7 +104,11 @@ extern "C" {
   * \brief Turnover temperature deviation of the clock source
   */
 #define RTC_TEMP_DEV_TURNOVER                           ( 5.0 )
-#endif /* LORAMAC_CLASSB_ENABLED == 1 */
+
+/**
+  * \brief Frequency tolerance of the clock source at the turnover temperature (in ppm)
+  */
+#define RTC_FREQ_TOLERANCE                              ( 20.0 )
 
 /* USER CODE BEGIN EC */
 
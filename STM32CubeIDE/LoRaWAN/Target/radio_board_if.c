@@ -45,7 +45,26 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN PV */
-
+/**
+  * @brief TX path efficiency table of the board, from the optimal PA settings
+  *        of the datasheet and the typical supply current measured at both
+  *        ends of each path. The power given to SetTxParams must stay within
+  *        -17..+14 dBm for the LP PA and -9..+22 dBm for the HP PA.
+  */
+static const RBI_TxPathTable_t TxPathTable[] =
+{
+  /* MinPower, MaxPower, PA, paDutyCycle, hpMax, MaxTxParam, SMPS drive, MinCurrent, MaxCurrent */
+  { -17,  0, RBI_PA_LP, 0x01, 0x00,  3, RBI_SMPS_DRV_20,    5500,   8000 },
+  {   1, 10, RBI_PA_LP, 0x01, 0x00, 13, RBI_SMPS_DRV_40,    8400,  14400 },
+  {  11, 14, RBI_PA_LP, 0x04, 0x00, 14, RBI_SMPS_DRV_60,   15600,  20700 },
+  {  15, 15, RBI_PA_LP, 0x06, 0x00, 14, RBI_SMPS_DRV_60,   23000,  23000 },
+  {  -9, 14, RBI_PA_HP, 0x02, 0x02, 22, RBI_SMPS_DRV_40,   30000,  66000 },
+  {  15, 17, RBI_PA_HP, 0x02, 0x03, 22, RBI_SMPS_DRV_40,   70000,  80000 },
+  {  18, 20, RBI_PA_HP, 0x03, 0x05, 22, RBI_SMPS_DRV_40,   86000, 100000 },
+  {  21, 22, RBI_PA_HP, 0x04, 0x07, 22, RBI_SMPS_DRV_40,  108000, 118000 },
+};
+
+#define TX_PATH_TABLE_SIZE    (sizeof(TxPathTable) / sizeof(TxPathTable[0]))
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -269,7 +288,86 @@ int32_t RBI_IsDCDC(void)
 }
 
 /* USER CODE BEGIN EF */
+void RBI_GetTxPath(int8_t power, RBI_TxPath_t *path)
+{
+  const RBI_TxPathTable_t *best = NULL;
+  const RBI_TxPathTable_t *entry;
+  int32_t txConfig = RBI_GetTxConfig();
+  int8_t minPower = INT8_MAX;
+  int8_t maxPower = INT8_MIN;
+  uint32_t current = 0;
+  uint32_t bestCurrent = UINT32_MAX;
+
+  /* Range of the fitted PAs */
+  for (uint32_t i = 0; i < TX_PATH_TABLE_SIZE; i++)
+  {
+    entry = &TxPathTable[i];
+    if (((entry->PaSelect == RBI_PA_LP) && (txConfig == RBI_CONF_RFO_HP)) ||
+        ((entry->PaSelect == RBI_PA_HP) && (txConfig == RBI_CONF_RFO_LP)))
+    {
+      continue;
+    }
+    if (entry->MinPower < minPower)
+    {
+      minPower = entry->MinPower;
+    }
+    if (entry->MaxPower > maxPower)
+    {
+      maxPower = entry->MaxPower;
+    }
+  }
+  if (power < minPower)
+  {
+    power = minPower;
+  }
+  else if (power > maxPower)
+  {
+    power = maxPower;
+  }
 
+  for (uint32_t i = 0; i < TX_PATH_TABLE_SIZE; i++)
+  {
+    entry = &TxPathTable[i];
+    if (((entry->PaSelect == RBI_PA_LP) && (txConfig == RBI_CONF_RFO_HP)) ||
+        ((entry->PaSelect == RBI_PA_HP) && (txConfig == RBI_CONF_RFO_LP)) ||
+        (power < entry->MinPower) || (power > entry->MaxPower))
+    {
+      continue;
+    }
+    current = entry->MinCurrent;
+    if (entry->MaxPower > entry->MinPower)
+    {
+      current += (entry->MaxCurrent - entry->MinCurrent) * (uint32_t)(power - entry->MinPower) /
+                 (uint32_t)(entry->MaxPower - entry->MinPower);
+    }
+    if (current < bestCurrent)
+    {
+      best = entry;
+      bestCurrent = current;
+    }
+  }
+
+  /* The table covers every power of its range without holes */
+  path->PaSelect = best->PaSelect;
+  path->PaDutyCycle = best->PaDutyCycle;
+  path->HpMax = best->HpMax;
+  path->TxParam = best->MaxTxParam - (best->MaxPower - power);
+  path->SmpsDrive = best->SmpsDrive;
+  path->Current = bestCurrent;
+}
+
+uint32_t RBI_GetTxCurrent(int8_t power)
+{
+  RBI_TxPath_t path;
+
+  RBI_GetTxPath(power, &path);
+  return path.Current;
+}
+
+uint32_t RBI_GetSupplyVoltage(void)
+{
+  return RF_SUPPLY_VOLTAGE;
+}
 /* USER CODE END EF */
 
 /* Private Functions Definition -----------------------------------------------*/
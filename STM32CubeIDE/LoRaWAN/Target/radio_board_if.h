@@ -70,6 +70,9 @@ extern "C" {
  * 1: DCDC supported
  */
 #define IS_DCDC_SUPPORTED                   0U
+
+/* Radio supply voltage used for the TX energy estimation (in mV) */
+#define RF_SUPPLY_VOLTAGE                   3300U
 /* USER CODE END Exported Parameters */
 #endif  /* USE_BSP_DRIVER  */
 
@@ -99,6 +102,15 @@ extern "C" {
 #endif  /* USE_BSP_DRIVER  */
 
 /* USER CODE BEGIN Exported_Defines */
+/* Power amplifiers of a TX path */
+#define RBI_PA_LP                           0U
+#define RBI_PA_HP                           1U
+
+/* SMPS drive capability of a TX path */
+#define RBI_SMPS_DRV_20                     0U
+#define RBI_SMPS_DRV_40                     1U
+#define RBI_SMPS_DRV_60                     2U
+#define RBI_SMPS_DRV_100                    3U
 
 /* USER CODE END Exported_Defines */
 
@@ -128,6 +140,37 @@ typedef enum
 #endif  /* USE_BSP_DRIVER */
 
 /* USER CODE BEGIN ET */
+/**
+  * @brief TX path operating point of the efficiency table. The path covers the
+  *        output powers from MinPower to MaxPower by backing off the power
+  *        given to the radio from MaxTxParam. The current in between is
+  *        interpolated from the two measured ends.
+  */
+typedef struct
+{
+  int8_t MinPower;          /*!< Lowest output power in dBm */
+  int8_t MaxPower;          /*!< Highest output power in dBm */
+  uint8_t PaSelect;         /*!< RBI_PA_LP or RBI_PA_HP */
+  uint8_t PaDutyCycle;      /*!< paDutyCycle of SetPaConfig */
+  uint8_t HpMax;            /*!< hpMax of SetPaConfig, 0 for the LP PA */
+  int8_t MaxTxParam;        /*!< Power of SetTxParams giving MaxPower */
+  uint8_t SmpsDrive;        /*!< RBI_SMPS_DRV_20 to RBI_SMPS_DRV_100 */
+  uint32_t MinCurrent;      /*!< Supply current at MinPower in uA */
+  uint32_t MaxCurrent;      /*!< Supply current at MaxPower in uA */
+} RBI_TxPathTable_t;
+
+/**
+  * @brief TX path settings for a requested output power
+  */
+typedef struct
+{
+  uint8_t PaSelect;         /*!< RBI_PA_LP or RBI_PA_HP */
+  uint8_t PaDutyCycle;      /*!< paDutyCycle of SetPaConfig */
+  uint8_t HpMax;            /*!< hpMax of SetPaConfig */
+  int8_t TxParam;           /*!< Power of SetTxParams */
+  uint8_t SmpsDrive;        /*!< RBI_SMPS_DRV_20 to RBI_SMPS_DRV_100 */
+  uint32_t Current;         /*!< Typical supply current in uA */
+} RBI_TxPath_t;
 
 /* USER CODE END ET */
 
@@ -200,7 +243,26 @@ int32_t RBI_IsTCXO(void);
 int32_t RBI_IsDCDC(void);
 
 /* USER CODE BEGIN EFP */
+/**
+  * @brief  Select the most current efficient TX path for an output power
+  * @note   Only the PAs fitted according to RBI_GetTxConfig are considered.
+  *         A power out of the board range is clamped to it.
+  * @param  power: requested output power in dBm
+  * @param  path: selected TX path settings
+  */
+void RBI_GetTxPath(int8_t power, RBI_TxPath_t *path);
+/**
+  * @brief  Get the supply current drawn by the radio in TX
+  * @param  power: output power in dBm
+  * @return typical supply current in uA
+  */
+uint32_t RBI_GetTxCurrent(int8_t power);
 
+/**
+  * @brief  Get the radio supply voltage
+  * @return supply voltage in mV
+  */
+uint32_t RBI_GetSupplyVoltage(void);
 /* USER CODE END EFP */
 
 #ifdef __cplusplus
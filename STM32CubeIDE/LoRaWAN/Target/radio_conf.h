@@ -62,6 +62,8 @@ extern SUBGHZ_HandleTypeDef hsubghz;
   * @brief drive value used anytime radio is in TX low power mode
   *        TX low power mode is the worst case because the PA sinks from SMPS
   *        while in high power mode, current is sunk directly from the battery
+  * @note  only used by SUBGRF_SetTxParams, SUBGRF_SetRfTxPower takes the drive
+  *        from the TX path table of radio_board_if.c
   */
 #define SMPS_DRIVE_SETTING_MAX      SMPS_DRV_60
 
@@ -82,6 +84,22 @@ extern SUBGHZ_HandleTypeDef hsubghz;
 #define TCXO_CTRL_VOLTAGE           TCXO_CTRL_1_7V
 
 /* USER CODE BEGIN EC */
+/**
+  * @brief Measure the radio wake-up time instead of using RBI_GetWakeUpTime
+  *        0: disabled, the board constant is used
+  *        1: enabled, a percentile of the measured wake-to-ready time is used
+  */
+#define RADIO_WAKEUP_CALIBRATION_ENABLED        1
+
+/**
+  * @brief Percentile of the measured wake-up times used by the MAC
+  */
+#define RADIO_WAKEUP_CALIBRATION_PERCENTILE     95
+
+/**
+  * @brief Safety margin added to the measured wake-up time, in ms
+  */
+#define RADIO_WAKEUP_CALIBRATION_MARGIN         1U
 
 /* USER CODE END EC */
 
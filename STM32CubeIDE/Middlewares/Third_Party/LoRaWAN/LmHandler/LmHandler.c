@@ -49,6 +49,7 @@
 #include "NvmCtxMgmt.h"
 #include "lora_info.h"
 #include "LmhpCompliance.h"
+#include "LmhpRemoteMcastSetup.h"
 #include "LoRaMacTest.h"
 #if (!defined (LORAWAN_DATA_DISTRIB_MGT) || (LORAWAN_DATA_DISTRIB_MGT == 0))
 #else /* LORAWAN_DATA_DISTRIB_MGT == 1 */
@@ -116,22 +117,23 @@ static void MlmeConfirm(MlmeConfirm_t *mlmeConfirm);
  */
 static void MlmeIndication(MlmeIndication_t *mlmeIndication);
 
+#if ( LORAMAC_CLASSB_ENABLED == 1 )
 /*!
- * \brief   Requests network server time update
+ * \brief   Starts the beacon search
  *
  * \retval  status Returns \ref LORAMAC_HANDLER_SUCCESS if request has been
  *                 processed else \ref LORAMAC_HANDLER_ERROR
  */
-static LmHandlerErrorStatus_t LmHandlerDeviceTimeReq(void);
+static LmHandlerErrorStatus_t LmHandlerBeaconReq(void);
 
-#if ( LORAMAC_CLASSB_ENABLED == 1 )
 /*!
- * \brief   Starts the beacon search
+ * \brief   Requests the network time needed by the beacon acquisition and
+ *          sends it at once on an empty uplink
  *
  * \retval  status Returns \ref LORAMAC_HANDLER_SUCCESS if request has been
  *                 processed else \ref LORAMAC_HANDLER_ERROR
  */
-static LmHandlerErrorStatus_t LmHandlerBeaconReq(void);
+static LmHandlerErrorStatus_t LmHandlerClassBTimeReq(void);
 
 /*!
  * \brief   Informs the server on the ping-slot periodicity to use
@@ -252,7 +254,8 @@ static LmHandlerRxParams_t RxParams =
   .Rssi = 0,
   .Snr = 0,
   .DownlinkCounter = 0,
-  .RxSlot = -1
+  .RxSlot = -1,
+  .McGroupId = 0xFF
 };
 
 #if ( LORAMAC_CLASSB_ENABLED == 1 )
@@ -285,11 +288,36 @@ static uint8_t AppDataBuffer[LORAWAN_APP_DATA_BUFFER_MAX_SIZE];
  */
 static LmHandlerAppData_t AppData = { 0, 0, AppDataBuffer };
 
+/*!
+ * Payload area reserved in the MAC frame buffer by LmHandlerTxReserve
+ */
+static uint8_t *TxReservedBuffer = NULL;
+
 #if ( LORAMAC_CLASSB_ENABLED == 1 )
 /*!
  * Indicates if a switch to Class B operation is pending or not.
  */
 static bool IsClassBSwitchPending = false;
+
+/*!
+ * Class B timing statistics
+ */
+static LmHandlerClassBStats_t ClassBStats;
+
+/*!
+ * Start of the pending switch to class B
+ */
+static TimerTime_t ClassBSwitchStart = 0;
+
+/*!
+ * Start of the pending beacon acquisition
+ */
+static TimerTime_t BeaconAcquisitionStart = 0;
+
+/*!
+ * Time of the last received beacon
+ */
+static TimerTime_t LastBeaconRxTime = 0;
 #endif /* LORAMAC_CLASSB_ENABLED == 1 */
 
 static bool CtxRestoreDone = false;
@@ -332,6 +360,7 @@ LmHandlerErrorStatus_t LmHandlerConfigure(LmHandlerParams_t *handlerParams)
 
 #if ( LORAMAC_CLASSB_ENABLED == 1 )
   IsClassBSwitchPending = false;
+  UTIL_MEM_set_8(&ClassBStats, 0, sizeof(ClassBStats));
 #endif /* LORAMAC_CLASSB_ENABLED == 1 */
 
   loraInfo = LoraInfo_GetPtr();
@@ -578,6 +607,7 @@ LmHandlerErrorStatus_t LmHandlerSend(LmHandlerAppData_t *appData, LmHandlerMsgTy
   LmHandlerErrorStatus_t lmhStatus = LORAMAC_HANDLER_ERROR;
   McpsReq_t mcpsReq;
   LoRaMacTxInfo_t txInfo;
+  bool isPayloadDropped = false;
 
   if (LoRaMacIsBusy() == true)
   {
@@ -601,6 +631,7 @@ LmHandlerErrorStatus_t LmHandlerSend(LmHandlerAppData_t *appData, LmHandlerMsgTy
   if (LoRaMacQueryTxPossible(appData->BufferSize, &txInfo) != LORAMAC_STATUS_OK)
   {
     /* Send empty frame in order to flush MAC commands */
+    isPayloadDropped = (appData->BufferSize > 0);
     TxParams.MsgType = LORAMAC_HANDLER_UNCONFIRMED_MSG;
     mcpsReq.Type = MCPS_UNCONFIRMED;
     mcpsReq.Req.Unconfirmed.fBuffer = NULL;
@@ -635,7 +666,7 @@ LmHandlerErrorStatus_t LmHandlerSend(LmHandlerAppData_t *appData, LmHandlerMsgTy
   switch(status)
   {
   case LORAMAC_STATUS_OK:
-    lmhStatus = LORAMAC_HANDLER_SUCCESS;
+    lmhStatus = (isPayloadDropped == true) ? LORAMAC_HANDLER_PAYLOAD_LENGTH_RESTRICTED : LORAMAC_HANDLER_SUCCESS;
     break;
   case LORAMAC_STATUS_BUSY:
   case LORAMAC_STATUS_BUSY_UPLINK_COLLISION:
@@ -668,6 +699,59 @@ LmHandlerErrorStatus_t LmHandlerSend(LmHandlerAppData_t *appData, LmHandlerMsgTy
   return lmhStatus;
 }
 
+LmHandlerErrorStatus_t LmHandlerTxReserve(uint8_t **buffer, uint8_t *maxSize)
+{
+  LoRaMacTxInfo_t txInfo;
+  uint8_t size;
+
+  if ((buffer == NULL) || (maxSize == NULL))
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+
+  switch (LoRaMacReserveTxPayload(&TxReservedBuffer, &size))
+  {
+  case LORAMAC_STATUS_OK:
+    break;
+  case LORAMAC_STATUS_BUSY:
+    return LORAMAC_HANDLER_BUSY_ERROR;
+  default:
+    return LORAMAC_HANDLER_ERROR;
+  }
+
+  if (LoRaMacQueryTxPossible(0, &txInfo) == LORAMAC_STATUS_OK)
+  {
+    size = MIN(size, txInfo.MaxPossibleApplicationDataSize);
+  }
+  else
+  {
+    /* Pending MAC commands leave no room, they are flushed first by an empty frame, see LmHandlerSend */
+    size = 0;
+  }
+
+  *buffer = TxReservedBuffer;
+  *maxSize = size;
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+LmHandlerErrorStatus_t LmHandlerTxCommit(uint8_t port, uint8_t size, LmHandlerMsgTypes_t isTxConfirmed,
+                                         TimerTime_t *nextTxIn, bool allowDelayedTx)
+{
+  LmHandlerAppData_t appData;
+
+  if (TxReservedBuffer == NULL)
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+
+  appData.Port = port;
+  appData.BufferSize = size;
+  appData.Buffer = TxReservedBuffer;
+  TxReservedBuffer = NULL;
+
+  return LmHandlerSend(&appData, isTxConfirmed, nextTxIn, allowDelayedTx);
+}
+
 LmHandlerErrorStatus_t LmHandlerRequestClass(DeviceClass_t newClass)
 {
   MibRequestConfirm_t mibReq;
@@ -718,8 +802,9 @@ LmHandlerErrorStatus_t LmHandlerRequestClass(DeviceClass_t newClass)
         else
         {
           /* Beacon must first be acquired */
-          errorStatus = LmHandlerDeviceTimeReq();
+          errorStatus = LmHandlerClassBTimeReq();
           IsClassBSwitchPending = true;
+          ClassBSwitchStart = TimerGetCurrentTime();
         }
 #else /* LORAMAC_CLASSB_ENABLED == 0 */
         errorStatus = LORAMAC_HANDLER_ERROR;
@@ -764,6 +849,11 @@ LmHandlerErrorStatus_t LmHandlerPackageRegister(uint8_t id, void *params)
       package = LmphCompliancePackageFactory();
       break;
     }
+    case PACKAGE_ID_REMOTE_MCAST_SETUP:
+    {
+      package = LmhpRemoteMcastSetupPackageFactory();
+      break;
+    }
     default:
 #if (!defined (LORAWAN_DATA_DISTRIB_MGT) || (LORAWAN_DATA_DISTRIB_MGT == 0))
 #else /*LORAWAN_DATA_DISTRIB_MGT == 1*/
@@ -1290,8 +1380,22 @@ int32_t LmHandlerGetBeaconState(BeaconState_t *beaconState)
 #endif /* LORAMAC_CLASSB_ENABLED */
 }
 
-/* Private  functions ---------------------------------------------------------*/
-static LmHandlerErrorStatus_t LmHandlerDeviceTimeReq(void)
+int32_t LmHandlerGetClassBStats(LmHandlerClassBStats_t *stats)
+{
+#if ( LORAMAC_CLASSB_ENABLED == 1 )
+  if (stats == NULL)
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+
+  UTIL_MEM_cpy_8(stats, &ClassBStats, sizeof(ClassBStats));
+  return LORAMAC_HANDLER_SUCCESS;
+#else /* LORAMAC_CLASSB_ENABLED == 0 */
+  return LORAMAC_HANDLER_ERROR;
+#endif /* LORAMAC_CLASSB_ENABLED */
+}
+
+LmHandlerErrorStatus_t LmHandlerDeviceTimeReq(void)
 {
   LoRaMacStatus_t status;
   MlmeReq_t mlmeReq;
@@ -1310,6 +1414,7 @@ static LmHandlerErrorStatus_t LmHandlerDeviceTimeReq(void)
   }
 }
 
+/* Private  functions ---------------------------------------------------------*/
 #if ( LORAMAC_CLASSB_ENABLED == 1 )
 static LmHandlerErrorStatus_t LmHandlerBeaconReq(void)
 {
@@ -1322,6 +1427,9 @@ static LmHandlerErrorStatus_t LmHandlerBeaconReq(void)
 
   if (status == LORAMAC_STATUS_OK)
   {
+    BeaconAcquisitionStart = TimerGetCurrentTime();
+    BeaconParams.State = LORAMAC_HANDLER_BEACON_ACQUIRING;
+    DisplayBeaconUpdate(&BeaconParams);
     return LORAMAC_HANDLER_SUCCESS;
   }
   else
@@ -1330,6 +1438,24 @@ static LmHandlerErrorStatus_t LmHandlerBeaconReq(void)
   }
 }
 
+static LmHandlerErrorStatus_t LmHandlerClassBTimeReq(void)
+{
+  LmHandlerAppData_t appData =
+  {
+    .Buffer = NULL,
+    .BufferSize = 0,
+    .Port = 0
+  };
+
+  if (LmHandlerDeviceTimeReq() != LORAMAC_HANDLER_SUCCESS)
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+  /* When the MAC cannot send now, the request waits for the next uplink */
+  LmHandlerSend(&appData, LORAMAC_HANDLER_UNCONFIRMED_MSG, NULL, false);
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
 static LmHandlerErrorStatus_t LmHandlerPingSlotReq(uint8_t periodicity)
 {
   LoRaMacStatus_t status;
@@ -1387,6 +1513,13 @@ static void McpsIndication(McpsIndication_t *mcpsIndication)
     return;
   }
 
+#if ( LORAMAC_CLASSB_ENABLED == 1 )
+  if (mcpsIndication->RxSlot == RX_SLOT_WIN_CLASS_B_PING_SLOT)
+  {
+    ClassBStats.PingSlotDownlinks++;
+  }
+#endif /* LORAMAC_CLASSB_ENABLED == 1 */
+
   if (mcpsIndication->BufferSize > 0)
   {
     RxParams.Datarate = mcpsIndication->RxDatarate;
@@ -1394,6 +1527,8 @@ static void McpsIndication(McpsIndication_t *mcpsIndication)
     RxParams.Snr = mcpsIndication->Snr;
     RxParams.DownlinkCounter = mcpsIndication->DownLinkCounter;
     RxParams.RxSlot = mcpsIndication->RxSlot;
+    RxParams.Multicast = mcpsIndication->Multicast;
+    RxParams.McGroupId = (mcpsIndication->Multicast != 0) ? LoRaMacMcChannelGetGroupId(mcpsIndication->DevAddress) : 0xFF;
 
     appData.Port = mcpsIndication->Port;
     appData.BufferSize = mcpsIndication->BufferSize;
@@ -1462,6 +1597,10 @@ static void MlmeConfirm(MlmeConfirm_t *mlmeConfirm)
     break;
     case MLME_DEVICE_TIME:
     {
+      if ((mlmeConfirm->Status == LORAMAC_EVENT_INFO_STATUS_OK) && (LmHandlerCallbacks.OnSysTimeUpdate != NULL))
+      {
+        LmHandlerCallbacks.OnSysTimeUpdate();
+      }
 #if ( LORAMAC_CLASSB_ENABLED == 1 )
       if (IsClassBSwitchPending == true)
       {
@@ -1476,13 +1615,17 @@ static void MlmeConfirm(MlmeConfirm_t *mlmeConfirm)
       if (mlmeConfirm->Status == LORAMAC_EVENT_INFO_STATUS_OK)
       {
         /* Beacon has been acquired */
+        ClassBStats.Acquisitions++;
+        ClassBStats.AcquisitionTime = TimerGetElapsedTime(BeaconAcquisitionStart);
+        LastBeaconRxTime = TimerGetCurrentTime();
         /* Request server for ping slot */
         LmHandlerPingSlotReq(LmHandlerParams.PingPeriodicity);
       }
       else
       {
         /* Beacon not acquired */
-        /* Request Device Time again. */
+        ClassBStats.AcquisitionFailures++;
+        /* Request Device Time again, it goes with the next uplink to bound the retries */
         LmHandlerDeviceTimeReq();
       }
     }
@@ -1501,6 +1644,9 @@ static void MlmeConfirm(MlmeConfirm_t *mlmeConfirm)
         DisplayClassUpdate(CLASS_B);
 
         IsClassBSwitchPending = false;
+        ClassBStats.SwitchTime = TimerGetElapsedTime(ClassBSwitchStart);
+        MW_LOG(TS_ON, VLEVEL_M, "Class B: switch %u ms, beacon acquisition %u ms\r\n",
+               (unsigned int)ClassBStats.SwitchTime, (unsigned int)ClassBStats.AcquisitionTime);
       }
       else
       {
@@ -1538,13 +1684,19 @@ static void MlmeIndication(MlmeIndication_t *mlmeIndication)
       DisplayClassUpdate(CLASS_A);
       DisplayBeaconUpdate(&BeaconParams);
 
-      LmHandlerDeviceTimeReq();
+      /* Beacon-less operation is over: acquire again, class B is restored once the ping slot is answered */
+      ClassBStats.BeaconsLost++;
+      IsClassBSwitchPending = true;
+      ClassBSwitchStart = TimerGetCurrentTime();
+      LmHandlerClassBTimeReq();
     }
     break;
     case MLME_BEACON:
     {
       if (mlmeIndication->Status == LORAMAC_EVENT_INFO_STATUS_BEACON_LOCKED)
       {
+        ClassBStats.BeaconsReceived++;
+        LastBeaconRxTime = TimerGetCurrentTime();
         BeaconParams.State = LORAMAC_HANDLER_BEACON_RX;
         BeaconParams.Info = mlmeIndication->BeaconInfo;
 
@@ -1552,6 +1704,14 @@ static void MlmeIndication(MlmeIndication_t *mlmeIndication)
       }
       else
       {
+        /* Beacon-less operation, the MAC widens the windows until the beacon-less period ends */
+        uint32_t beaconLessTime = TimerGetElapsedTime(LastBeaconRxTime);
+
+        ClassBStats.BeaconsMissed++;
+        if (beaconLessTime > ClassBStats.MaxBeaconLessTime)
+        {
+          ClassBStats.MaxBeaconLessTime = beaconLessTime;
+        }
         BeaconParams.State = LORAMAC_HANDLER_BEACON_NRX;
         BeaconParams.Info = mlmeIndication->BeaconInfo;
 
@@ -1621,6 +1781,10 @@ static void LmHandlerPackagesNotify(PackageNotifyTypes_t notifyType, void *param
 static void DisplayClassUpdate(DeviceClass_t deviceClass)
 {
   MW_LOG(TS_OFF, VLEVEL_M, "Switch to Class %c done\r\n", "ABC"[deviceClass]);
+  if (LmHandlerCallbacks.OnClassChange != NULL)
+  {
+    LmHandlerCallbacks.OnClassChange(deviceClass);
+  }
 }
 
 #if ( LORAMAC_CLASSB_ENABLED == 1 )
@@ -1640,5 +1804,9 @@ static void DisplayBeaconUpdate(LmHandlerBeaconParams_t *params)
            params->Info.Frequency, params->Info.Datarate,
            params->Info.Rssi, params->Info.Snr);
   }
+  if (LmHandlerCallbacks.OnBeaconStatusChange != NULL)
+  {
+    LmHandlerCallbacks.OnBeaconStatusChange(params);
+  }
 }
 #endif /* LORAMAC_CLASSB_ENABLED == 1 */
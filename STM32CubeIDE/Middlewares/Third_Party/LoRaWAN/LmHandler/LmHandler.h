@@ -84,6 +84,8 @@ typedef struct LmHandlerRxParams_s
   int8_t Snr;
   uint32_t DownlinkCounter;
   int8_t RxSlot;
+  uint8_t Multicast;      /* 1 if the downlink was received on a multicast group */
+  uint8_t McGroupId;      /* Multicast group of the downlink, 0xFF for unicast */
 } LmHandlerRxParams_t;
 
 /*!
@@ -96,6 +98,22 @@ typedef struct LmHandlerBeaconParams_s
   BeaconInfo_t Info;
 } LmHandlerBeaconParams_t;
 
+/*!
+ * \brief Class B timing statistics
+ */
+typedef struct LmHandlerClassBStats_s
+{
+  uint32_t SwitchTime;            /*!< Duration of the last switch to class B in ms, from the request to the PingSlotInfoAns */
+  uint32_t AcquisitionTime;       /*!< Duration of the last successful beacon acquisition in ms */
+  uint32_t MaxBeaconLessTime;     /*!< Longest time without beacon while in class B in ms */
+  uint16_t Acquisitions;          /*!< Successful beacon acquisitions */
+  uint16_t AcquisitionFailures;   /*!< Failed beacon acquisitions */
+  uint16_t BeaconsReceived;       /*!< Beacons received */
+  uint16_t BeaconsMissed;         /*!< Beacons missed while tracking */
+  uint16_t BeaconsLost;           /*!< Fallbacks to class A after the beacon-less period */
+  uint16_t PingSlotDownlinks;     /*!< Downlinks received in unicast ping slots */
+} LmHandlerClassBStats_t;
+
 /*!
  * \brief LoRaMac handler parameters
  */
@@ -172,6 +190,23 @@ typedef struct LmHandlerCallbacks_s
    * \param [in] params notification parameters
    */
   void (*OnRxData)(LmHandlerAppData_t *appData, LmHandlerRxParams_t *params);
+  /*!
+   * \brief Confirms the LoRaWAN device class change, may be NULL
+   *
+   * \param [in] deviceClass new end-device class
+   */
+  void (*OnClassChange)(DeviceClass_t deviceClass);
+  /*!
+   * \brief Notifies the upper layer of the class B beacon status, may be NULL
+   *
+   * \param [in] params notification parameters
+   */
+  void (*OnBeaconStatusChange)(LmHandlerBeaconParams_t *params);
+  /*!
+   * \brief Notifies the upper layer that the system time has been set by a
+   *        DeviceTimeAns, may be NULL
+   */
+  void (*OnSysTimeUpdate)(void);
 } LmHandlerCallbacks_t;
 
 /* External variables --------------------------------------------------------*/
@@ -210,11 +245,43 @@ void LmHandlerProcess(void);
  * \param [in] allowDelayedTx when set to true, the frame will be delayed
  *
  * \retval status Returns \ref LORAMAC_HANDLER_SUCCESS if request has been
- *                processed else \ref LORAMAC_HANDLER_ERROR
+ *                processed, \ref LORAMAC_HANDLER_PAYLOAD_LENGTH_RESTRICTED if
+ *                an empty frame was sent instead to flush the MAC commands
+ *                else \ref LORAMAC_HANDLER_ERROR
  */
 LmHandlerErrorStatus_t LmHandlerSend(LmHandlerAppData_t *appData, LmHandlerMsgTypes_t isTxConfirmed,
                                      TimerTime_t *nextTxIn, bool allowDelayedTx);
 
+/*!
+ * \brief Reserves the application payload area of the next uplink directly
+ *        in the MAC frame buffer, see \ref LmHandlerTxCommit
+ *
+ * \param [out] buffer Payload area to be written by the application
+ * \param [out] maxSize Maximum payload size at the current datarate, 0 if
+ *                     the pending MAC commands have to be flushed first
+ *
+ * \retval status Returns \ref LORAMAC_HANDLER_SUCCESS if the area has been
+ *                reserved, \ref LORAMAC_HANDLER_BUSY_ERROR while a frame is
+ *                being sent else \ref LORAMAC_HANDLER_ERROR
+ */
+LmHandlerErrorStatus_t LmHandlerTxReserve(uint8_t **buffer, uint8_t *maxSize);
+
+/*!
+ * \brief Sends the payload written into the area given by
+ *        \ref LmHandlerTxReserve, without copying it
+ *
+ * \param [in] port Application port
+ * \param [in] size Size of the payload written
+ * \param [in] isTxConfirmed Indicates if the uplink requires an acknowledgement
+ * \param [out] nextTxIn Time before next uplink window available
+ * \param [in] allowDelayedTx when set to true, the frame will be delayed
+ *
+ * \retval status Same as \ref LmHandlerSend, \ref LORAMAC_HANDLER_ERROR if
+ *                nothing was reserved
+ */
+LmHandlerErrorStatus_t LmHandlerTxCommit(uint8_t port, uint8_t size, LmHandlerMsgTypes_t isTxConfirmed,
+                                         TimerTime_t *nextTxIn, bool allowDelayedTx);
+
 /*!
  * \brief   Check whether the Device is joined to the network
  *
@@ -592,6 +659,24 @@ int32_t LmHandlerSetPingPeriodicity(uint8_t pingPeriodicity);
  */
 int32_t LmHandlerGetBeaconState(BeaconState_t *beaconState);
 
+/*!
+ * \brief Gets the class B timing statistics
+ *
+ * \param [out] stats class B statistics since the handler configuration
+ *
+ * \retval -1 LORAMAC_HANDLER_ERROR
+ *          0 LORAMAC_HANDLER_SUCCESS
+ */
+int32_t LmHandlerGetClassBStats(LmHandlerClassBStats_t *stats);
+
+/*!
+ * \brief Requests network server time update, sent with the next uplink
+ *
+ * \retval status Returns \ref LORAMAC_HANDLER_SUCCESS if request has been
+ *                processed else \ref LORAMAC_HANDLER_ERROR
+ */
+LmHandlerErrorStatus_t LmHandlerDeviceTimeReq(void);
+
 #ifdef __cplusplus
 }
 #endif
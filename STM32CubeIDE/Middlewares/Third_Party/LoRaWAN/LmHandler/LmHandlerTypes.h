@@ -70,6 +70,7 @@ typedef enum
   LORAMAC_HANDLER_COMPLIANCE_RUNNING = -4,
   LORAMAC_HANDLER_CRYPTO_ERROR = -5,
   LORAMAC_HANDLER_DUTYCYCLE_RESTRICTED = -6,
+  LORAMAC_HANDLER_PAYLOAD_LENGTH_RESTRICTED = -7,
   LORAMAC_HANDLER_SUCCESS = 0
 } LmHandlerErrorStatus_t;
 
@@ -0,0 +1,367 @@
+/**
+  ******************************************************************************
+  * @file    FragDecoder.c
+  * @brief   Erasure decoder of the LoRa-Alliance fragmented data block
+  *          transport (TS004 v1.0.0)
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include "utilities.h"
+#include "FragDecoder.h"
+
+/* Private define ------------------------------------------------------------*/
+#define FRAG_NB_WORDS                               ( FRAG_MAX_NB / 32 )
+#define FRAG_SIZE_WORDS                             ( FRAG_MAX_SIZE / 4 )
+
+/*!
+ * No lost fragment in a row
+ */
+#define FRAG_NO_BIT                                 0xFFFF
+
+/* Private typedef -----------------------------------------------------------*/
+/*!
+ * Decoder state
+ */
+typedef struct FragDecoder_s
+{
+  FragDecoderCallbacks_t *Callbacks;
+  uint16_t FragNb;
+  uint8_t FragSize;
+  int32_t Result;           /*!< FRAG_SESSION_xxx */
+  bool IsCoding;            /*!< Lost fragments known, coded fragments processed */
+  uint16_t NbUncodedRx;
+  uint16_t NbMissing;
+  uint16_t NbRows;          /*!< Independent rows of the window */
+  FragDecoderStatus_t Status;
+} FragDecoder_t;
+
+/*!
+ * Bitmaps and row window, see FRAG_DECODER_RAM_SIZE
+ */
+typedef struct FragDecoderRam_s
+{
+  uint32_t Received[FRAG_NB_WORDS];
+  uint32_t Line[FRAG_NB_WORDS];
+  uint16_t Missing[FRAG_MAX_MISSING];             /*!< Lost fragment indexes, ascending */
+  uint32_t Rows[FRAG_MAX_MISSING][FRAG_ROW_WORDS];  /*!< Row whose lowest lost fragment is the index */
+  uint32_t RowData[FRAG_MAX_MISSING][FRAG_SIZE_WORDS];
+  uint32_t Pivots[FRAG_ROW_WORDS];                 /*!< Rows in use */
+  uint32_t Data[FRAG_SIZE_WORDS];                  /*!< Incoming row */
+  uint32_t Read[FRAG_SIZE_WORDS];
+} FragDecoderRam_t;
+
+/* Private variables ---------------------------------------------------------*/
+static FragDecoder_t FragDecoder =
+{
+  .Callbacks = NULL,
+  .Result = FRAG_SESSION_NOT_STARTED,
+};
+
+/*!
+ * Not cleared by the startup code, kept apart so that the linker bounds it
+ */
+static FragDecoderRam_t FragDecoderRam __attribute__((section(".frag_decoder")));
+
+/* Private functions ---------------------------------------------------------*/
+static bool IsPowerOfTwo(uint32_t x)
+{
+  return (x != 0) && ((x & (x - 1)) == 0);
+}
+
+/*!
+ * Pseudo-random sequence of TS004
+ */
+static uint32_t FragPrbs23(uint32_t value)
+{
+  uint32_t b0 = value & 0x01;
+  uint32_t b1 = (value & 0x20) >> 5;
+
+  return (value >> 1) + ((b0 ^ b1) << 22);
+}
+
+/*!
+ * Computes the line of the parity matrix of TS004 of a coded fragment
+ *
+ * \param [IN]  n    Line, the fragment counter minus the number of fragments
+ * \param [IN]  m    Number of uncoded fragments
+ * \param [OUT] line Bitmap of the uncoded fragments of the line
+ */
+static void GetParityLine(uint32_t n, uint32_t m, uint32_t *line)
+{
+  uint32_t mTemp = IsPowerOfTwo(m) ? 1 : 0;
+  uint32_t x = 1 + (1001 * n);
+
+  memset1((uint8_t *)line, 0, ((m + 31) / 32) * 4);
+  for (uint32_t nbCoeff = 0; nbCoeff < (m >> 1); nbCoeff++)
+  {
+    uint32_t r = 1 << 16;
+
+    while (r >= m)
+    {
+      x = FragPrbs23(x);
+      r = x % (m + mTemp);
+    }
+    line[r >> 5] |= 1UL << (r & 31);
+  }
+}
+
+static bool IsReceived(uint16_t index)
+{
+  return (FragDecoderRam.Received[index >> 5] & (1UL << (index & 31))) != 0;
+}
+
+static uint16_t LowestBit(const uint32_t *row)
+{
+  for (uint16_t w = 0; w < FRAG_ROW_WORDS; w++)
+  {
+    if (row[w] != 0)
+    {
+      return (w * 32) + __CLZ(__RBIT(row[w]));
+    }
+  }
+  return FRAG_NO_BIT;
+}
+
+static void XorData(uint32_t *dst, const uint32_t *src)
+{
+  for (uint16_t i = 0; i < ((FragDecoder.FragSize + 3) / 4); i++)
+  {
+    dst[i] ^= src[i];
+  }
+}
+
+/*!
+ * Lists the lost fragments, once the first coded fragment is received
+ */
+static int32_t StartCoding(void)
+{
+  FragDecoder.NbMissing = 0;
+  for (uint16_t i = 0; i < FragDecoder.FragNb; i++)
+  {
+    if (IsReceived(i) == false)
+    {
+      if (FragDecoder.NbMissing == FRAG_MAX_MISSING)
+      {
+        FragDecoder.Status.MatrixError = 1;
+        return FRAG_SESSION_FAILED;
+      }
+      FragDecoderRam.Missing[FragDecoder.NbMissing++] = i;
+    }
+  }
+  memset1((uint8_t *)FragDecoderRam.Pivots, 0, sizeof(FragDecoderRam.Pivots));
+  FragDecoder.NbRows = 0;
+  FragDecoder.IsCoding = true;
+  return (FragDecoder.NbMissing == 0) ? FRAG_SESSION_FINISHED : FRAG_SESSION_ONGOING;
+}
+
+/*!
+ * Builds the row of a fragment over the lost fragments, its data reduced by
+ * the received ones
+ */
+static int32_t BuildRow(uint16_t fragCounter, uint32_t *row)
+{
+  uint16_t k = 0;
+
+  memset1((uint8_t *)row, 0, FRAG_ROW_WORDS * 4);
+  if (fragCounter <= FragDecoder.FragNb)
+  {
+    /* Uncoded fragment received after the first coded one */
+    while ((k < FragDecoder.NbMissing) && (FragDecoderRam.Missing[k] != (fragCounter - 1)))
+    {
+      k++;
+    }
+    if (k < FragDecoder.NbMissing)
+    {
+      row[k >> 5] |= 1UL << (k & 31);
+    }
+    return 0;
+  }
+
+  GetParityLine(fragCounter - FragDecoder.FragNb, FragDecoder.FragNb, FragDecoderRam.Line);
+  for (uint16_t w = 0; w < ((FragDecoder.FragNb + 31) / 32); w++)
+  {
+    uint32_t bits = FragDecoderRam.Line[w];
+
+    while (bits != 0)
+    {
+      uint16_t index = (w * 32) + __CLZ(__RBIT(bits));
+
+      bits &= bits - 1;
+      if (IsReceived(index) == true)
+      {
+        if (FragDecoder.Callbacks->FragDecoderRead((uint32_t)index * FragDecoder.FragSize,
+                                                   (uint8_t *)FragDecoderRam.Read, FragDecoder.FragSize) != 0)
+        {
+          return -1;
+        }
+        XorData(FragDecoderRam.Data, FragDecoderRam.Read);
+        continue;
+      }
+      /* Bits are visited in ascending order, as the lost fragments */
+      while (FragDecoderRam.Missing[k] != index)
+      {
+        k++;
+      }
+      row[k >> 5] |= 1UL << (k & 31);
+    }
+  }
+  return 0;
+}
+
+/*!
+ * Solves the lost fragments by back substitution and writes them
+ */
+static int32_t Solve(void)
+{
+  for (int32_t p = FragDecoder.NbMissing - 1; p >= 0; p--)
+  {
+    uint32_t *row = FragDecoderRam.Rows[p];
+
+    /* Clears the pivot, the other bits are solved rows */
+    row[p >> 5] &= ~(1UL << (p & 31));
+    for (uint16_t q = LowestBit(row); q != FRAG_NO_BIT; q = LowestBit(row))
+    {
+      row[q >> 5] &= ~(1UL << (q & 31));
+      XorData(FragDecoderRam.RowData[p], FragDecoderRam.RowData[q]);
+    }
+    if (FragDecoder.Callbacks->FragDecoderWrite((uint32_t)FragDecoderRam.Missing[p] * FragDecoder.FragSize,
+                                                (uint8_t *)FragDecoderRam.RowData[p], FragDecoder.FragSize) != 0)
+    {
+      return FRAG_SESSION_FAILED;
+    }
+  }
+  return FRAG_SESSION_FINISHED;
+}
+
+/*!
+ * Reduces a row by the window, and adds it if it is independent
+ */
+static int32_t AddRow(uint32_t *row)
+{
+  uint16_t p;
+
+  for (p = LowestBit(row); p != FRAG_NO_BIT; p = LowestBit(row))
+  {
+    if ((FragDecoderRam.Pivots[p >> 5] & (1UL << (p & 31))) == 0)
+    {
+      break;
+    }
+    /* The row of p has no bit below p */
+    for (uint16_t w = 0; w < FRAG_ROW_WORDS; w++)
+    {
+      row[w] ^= FragDecoderRam.Rows[p][w];
+    }
+    XorData(FragDecoderRam.Data, FragDecoderRam.RowData[p]);
+  }
+  if (p == FRAG_NO_BIT)
+  {
+    /* Nothing new */
+    return FRAG_SESSION_ONGOING;
+  }
+
+  memcpy1((uint8_t *)FragDecoderRam.Rows[p], (uint8_t *)row, FRAG_ROW_WORDS * 4);
+  memcpy1((uint8_t *)FragDecoderRam.RowData[p], (uint8_t *)FragDecoderRam.Data, FRAG_MAX_SIZE);
+  FragDecoderRam.Pivots[p >> 5] |= 1UL << (p & 31);
+  FragDecoder.NbRows++;
+  if (FragDecoder.NbRows < FragDecoder.NbMissing)
+  {
+    return FRAG_SESSION_ONGOING;
+  }
+  return Solve();
+}
+
+/* Exported functions ---------------------------------------------------------*/
+int32_t FragDecoderInit(uint16_t fragNb, uint8_t fragSize, FragDecoderCallbacks_t *callbacks)
+{
+  FragDecoder.Result = FRAG_SESSION_NOT_STARTED;
+  if ((fragNb == 0) || (fragNb > FRAG_MAX_NB) || (fragSize == 0) || (fragSize > FRAG_MAX_SIZE) ||
+      (callbacks == NULL) || (callbacks->FragDecoderPrepare(fragNb, fragSize) != 0))
+  {
+    return -1;
+  }
+
+  FragDecoder.Callbacks = callbacks;
+  FragDecoder.FragNb = fragNb;
+  FragDecoder.FragSize = fragSize;
+  FragDecoder.IsCoding = false;
+  FragDecoder.NbUncodedRx = 0;
+  FragDecoder.NbMissing = 0;
+  FragDecoder.NbRows = 0;
+  FragDecoder.Status.FragNbRx = 0;
+  FragDecoder.Status.FragNbLost = 0;
+  FragDecoder.Status.FragNbLastRx = 0;
+  FragDecoder.Status.MatrixError = 0;
+  memset1((uint8_t *)FragDecoderRam.Received, 0, sizeof(FragDecoderRam.Received));
+  FragDecoder.Result = FRAG_SESSION_ONGOING;
+  return 0;
+}
+
+uint32_t FragDecoderGetMaxFileSize(void)
+{
+  return (uint32_t)FRAG_MAX_NB * FRAG_MAX_SIZE;
+}
+
+int32_t FragDecoderProcess(uint16_t fragCounter, uint8_t *rawData)
+{
+  uint32_t row[FRAG_ROW_WORDS];
+
+  if ((FragDecoder.Result != FRAG_SESSION_ONGOING) || (fragCounter == 0))
+  {
+    return FragDecoder.Result;
+  }
+
+  FragDecoder.Status.FragNbRx++;
+  if ((int16_t)(fragCounter - FragDecoder.Status.FragNbLastRx) > 0)
+  {
+    FragDecoder.Status.FragNbLastRx = fragCounter;
+  }
+  if (FragDecoder.Status.FragNbLastRx > FragDecoder.Status.FragNbRx)
+  {
+    FragDecoder.Status.FragNbLost = FragDecoder.Status.FragNbLastRx - FragDecoder.Status.FragNbRx;
+  }
+
+  if ((fragCounter <= FragDecoder.FragNb) && (FragDecoder.IsCoding == false))
+  {
+    if (IsReceived(fragCounter - 1) == false)
+    {
+      if (FragDecoder.Callbacks->FragDecoderWrite((uint32_t)(fragCounter - 1) * FragDecoder.FragSize, rawData,
+                                                  FragDecoder.FragSize) != 0)
+      {
+        FragDecoder.Result = FRAG_SESSION_FAILED;
+        return FragDecoder.Result;
+      }
+      FragDecoderRam.Received[(fragCounter - 1) >> 5] |= 1UL << ((fragCounter - 1) & 31);
+      if (++FragDecoder.NbUncodedRx == FragDecoder.FragNb)
+      {
+        FragDecoder.Result = FRAG_SESSION_FINISHED;
+      }
+    }
+    return FragDecoder.Result;
+  }
+
+  if (FragDecoder.IsCoding == false)
+  {
+    FragDecoder.Result = StartCoding();
+    if (FragDecoder.Result != FRAG_SESSION_ONGOING)
+    {
+      return FragDecoder.Result;
+    }
+  }
+
+  memset1((uint8_t *)FragDecoderRam.Data, 0, sizeof(FragDecoderRam.Data));
+  memcpy1((uint8_t *)FragDecoderRam.Data, rawData, FragDecoder.FragSize);
+  if (BuildRow(fragCounter, row) != 0)
+  {
+    FragDecoder.Result = FRAG_SESSION_FAILED;
+    return FragDecoder.Result;
+  }
+  FragDecoder.Result = AddRow(row);
+  return FragDecoder.Result;
+}
+
+FragDecoderStatus_t FragDecoderGetStatus(void)
+{
+  return FragDecoder.Status;
+}
@@ -0,0 +1,161 @@
+/**
+  ******************************************************************************
+  * @file    FragDecoder.h
+  * @brief   Erasure decoder of the LoRa-Alliance fragmented data block
+  *          transport (TS004 v1.0.0)
+  *
+  *          The uncoded fragments are written to their place in the file as
+  *          they arrive. From the first coded fragment on, the lost fragments
+  *          are the unknowns of a binary system whose rows are the parity
+  *          lines of the LDPC matrix of TS004, reduced by the fragments
+  *          already known. The rows are kept in RAM, in echelon form as they
+  *          arrive, so that the decoder RAM is bounded by the number of lost
+  *          fragments it can recover, not by the file size.
+  *
+  *          RAM, in bytes:
+  *            received and parity line bitmaps   2 * FRAG_MAX_NB / 8
+  *            lost fragment indexes              2 * FRAG_MAX_MISSING
+  *            row window                         FRAG_MAX_MISSING * (FRAG_MAX_MISSING / 8 + FRAG_MAX_SIZE)
+  *            incoming row and read buffers      2 * FRAG_MAX_SIZE
+  *          see FRAG_DECODER_RAM_SIZE.
+  ******************************************************************************
+  */
+#ifndef __FRAG_DECODER_H__
+#define __FRAG_DECODER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+/*!
+ * Maximum number of uncoded fragments of a file, a multiple of 32
+ */
+#ifndef FRAG_MAX_NB
+#define FRAG_MAX_NB                                 1024
+#endif
+
+/*!
+ * Maximum fragment size
+ */
+#ifndef FRAG_MAX_SIZE
+#define FRAG_MAX_SIZE                               232
+#endif
+
+/*!
+ * Maximum number of lost fragments a session recovers, a multiple of 32
+ */
+#ifndef FRAG_MAX_MISSING
+#define FRAG_MAX_MISSING                            64
+#endif
+
+/*!
+ * Words of a row of the window
+ */
+#define FRAG_ROW_WORDS                              ( FRAG_MAX_MISSING / 32 )
+
+/*!
+ * Decoder RAM
+ */
+#define FRAG_DECODER_RAM_SIZE                       ( ( 2 * FRAG_MAX_NB / 8 ) + ( 2 * FRAG_MAX_MISSING ) + \
+                                                      ( FRAG_MAX_MISSING * ( ( 4 * FRAG_ROW_WORDS ) + FRAG_MAX_SIZE ) ) + \
+                                                      ( 2 * FRAG_MAX_SIZE ) )
+
+/*!
+ * Decoding status
+ */
+#define FRAG_SESSION_FINISHED                       ( int32_t )0
+#define FRAG_SESSION_ONGOING                        ( int32_t )-1
+#define FRAG_SESSION_NOT_STARTED                    ( int32_t )-2
+#define FRAG_SESSION_FAILED                         ( int32_t )-3
+
+/* Exported types ------------------------------------------------------------*/
+/*!
+ * File storage, addressed by the offset in the file
+ */
+typedef struct FragDecoderCallbacks_s
+{
+  /*!
+   * Prepares the storage of a file
+   *
+   * \param [IN] fragNb   Number of fragments
+   * \param [IN] fragSize Fragment size
+   * \retval 0 if the file fits, -1 otherwise
+   */
+  int32_t (*FragDecoderPrepare)(uint16_t fragNb, uint8_t fragSize);
+  /*!
+   * Writes a fragment, once per fragment
+   *
+   * \param [IN] addr Offset in the file, a multiple of the fragment size
+   * \param [IN] data Fragment
+   * \param [IN] size Fragment size
+   * \retval 0 if written, -1 otherwise
+   */
+  int32_t (*FragDecoderWrite)(uint32_t addr, uint8_t *data, uint32_t size);
+  /*!
+   * Reads a fragment written before
+   *
+   * \param [IN]  addr Offset in the file, a multiple of the fragment size
+   * \param [OUT] data Fragment
+   * \param [IN]  size Fragment size
+   * \retval 0 if read, -1 otherwise
+   */
+  int32_t (*FragDecoderRead)(uint32_t addr, uint8_t *data, uint32_t size);
+} FragDecoderCallbacks_t;
+
+/*!
+ * Decoder status
+ */
+typedef struct FragDecoderStatus_s
+{
+  uint16_t FragNbRx;        /*!< Fragments received, uncoded and coded */
+  uint16_t FragNbLost;      /*!< Fragments lost on the way */
+  uint16_t FragNbLastRx;    /*!< Counter of the last fragment received */
+  uint8_t MatrixError;      /*!< 1 when more fragments are lost than FRAG_MAX_MISSING */
+} FragDecoderStatus_t;
+
+/* Exported functions ------------------------------------------------------- */
+/*!
+ * Starts the decoding of a file
+ *
+ * \param [IN] fragNb    Number of uncoded fragments
+ * \param [IN] fragSize  Fragment size
+ * \param [IN] callbacks File storage
+ * \retval 0 if the file can be decoded, -1 otherwise
+ */
+int32_t FragDecoderInit(uint16_t fragNb, uint8_t fragSize, FragDecoderCallbacks_t *callbacks);
+
+/*!
+ * Returns the largest file the decoder handles
+ *
+ * \retval File size
+ */
+uint32_t FragDecoderGetMaxFileSize(void);
+
+/*!
+ * Processes a fragment
+ *
+ * \param [IN] fragCounter Fragment counter, from 1, coded fragments above
+ *                         the number of uncoded fragments
+ * \param [IN] rawData     Fragment, of the fragment size
+ * \retval FRAG_SESSION_ONGOING, FRAG_SESSION_FINISHED once the file is
+ *         complete, FRAG_SESSION_FAILED when it cannot be, or
+ *         FRAG_SESSION_NOT_STARTED
+ */
+int32_t FragDecoderProcess(uint16_t fragCounter, uint8_t *rawData);
+
+/*!
+ * Returns the decoder status
+ *
+ * \retval Decoder status
+ */
+FragDecoderStatus_t FragDecoderGetStatus(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRAG_DECODER_H__ */
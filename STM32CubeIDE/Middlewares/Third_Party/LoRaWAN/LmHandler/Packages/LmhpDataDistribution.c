@@ -0,0 +1,38 @@
+/**
+  ******************************************************************************
+  * @file    LmhpDataDistribution.c
+  * @brief   LoRa-Alliance data distribution packages: remote multicast setup
+  *          and fragmented data block transport
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "LmhpDataDistribution.h"
+#include "frag_decoder_if.h"
+
+/* Exported functions ---------------------------------------------------------*/
+LmHandlerErrorStatus_t LmhpDataDistributionInit(void)
+{
+  if (LmHandlerPackageRegister(PACKAGE_ID_REMOTE_MCAST_SETUP, NULL) != LORAMAC_HANDLER_SUCCESS)
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+  if (LmHandlerPackageRegister(PACKAGE_ID_FRAGMENTATION, &FRAG_DECODER_IF_FragmentationParams) != LORAMAC_HANDLER_SUCCESS)
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+LmHandlerErrorStatus_t LmhpDataDistributionPackageRegister(uint8_t id, LmhPackage_t **package)
+{
+  switch (id)
+  {
+    case PACKAGE_ID_FRAGMENTATION:
+    {
+      *package = LmhpFragmentationPackageFactory();
+      return LORAMAC_HANDLER_SUCCESS;
+    }
+    default:
+      return LORAMAC_HANDLER_ERROR;
+  }
+}
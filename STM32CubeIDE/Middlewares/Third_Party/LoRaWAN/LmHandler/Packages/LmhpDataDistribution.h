@@ -0,0 +1,48 @@
+/**
+  ******************************************************************************
+  * @file    LmhpDataDistribution.h
+  * @brief   Header for the LoRa-Alliance data distribution packages: remote
+  *          multicast setup and fragmented data block transport
+  ******************************************************************************
+  */
+#ifndef __LMHP_DATA_DISTRIBUTION_H__
+#define __LMHP_DATA_DISTRIBUTION_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "LmHandler.h"
+#include "LmhpRemoteMcastSetup.h"
+#include "LmhpFragmentation.h"
+
+/* Exported defines ----------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Exported types ------------------------------------------------------------*/
+/* External variables --------------------------------------------------------*/
+/* Exported macros -----------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+/*!
+ * Registers the data distribution packages
+ *
+ * \retval status LORAMAC_HANDLER_SUCCESS, LORAMAC_HANDLER_ERROR if a package
+ *                failed to register
+ */
+LmHandlerErrorStatus_t LmhpDataDistributionInit(void);
+
+/*!
+ * Returns the data distribution package of an identifier
+ *
+ * \param [in]  id      Package identifier
+ * \param [out] package Package, unchanged if the identifier is not a data
+ *                      distribution package
+ * \retval status LORAMAC_HANDLER_SUCCESS, LORAMAC_HANDLER_ERROR if unknown
+ */
+LmHandlerErrorStatus_t LmhpDataDistributionPackageRegister(uint8_t id, LmhPackage_t **package);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LMHP_DATA_DISTRIBUTION_H__ */
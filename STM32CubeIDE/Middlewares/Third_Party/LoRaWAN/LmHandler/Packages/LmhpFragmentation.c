@@ -0,0 +1,468 @@
+/**
+  ******************************************************************************
+  * @file    LmhpFragmentation.c
+  * @brief   LoRa-Alliance fragmented data block transport package
+  *          (TS004 v1.0.0)
+  *
+  *          One session at a time, with the LDPC fragmentation matrix of
+  *          TS004. The fragments are received in unicast or on the multicast
+  *          groups of the session, and handed to the decoder which stores
+  *          the file through the package parameters.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "utilities.h"
+#include "LmHandler.h"
+#include "LmhpFragmentation.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/*!
+ * Package commands
+ */
+typedef enum LmhpFragmentationCmd_e
+{
+  FRAGMENTATION_PKG_VERSION_REQ                 = 0x00,
+  FRAGMENTATION_FRAG_SESSION_STATUS_REQ         = 0x01,
+  FRAGMENTATION_FRAG_SESSION_SETUP_REQ          = 0x02,
+  FRAGMENTATION_FRAG_SESSION_DELETE_REQ         = 0x03,
+  FRAGMENTATION_DATA_FRAGMENT                   = 0x08,
+} LmhpFragmentationCmd_t;
+
+/*!
+ * Fragmentation session
+ */
+typedef struct FragSessionData_s
+{
+  bool IsDefined;
+  bool IsDone;
+  uint8_t McGroupBitMask;
+  uint16_t FragNb;
+  uint8_t FragSize;
+  uint8_t BlockAckDelay;
+  uint8_t Padding;
+  uint32_t Descriptor;
+} FragSessionData_t;
+
+/*!
+ * Package current context
+ */
+typedef struct LmhpFragmentationState_s
+{
+  bool Initialized;
+  bool IsRunning;
+  uint8_t DataBufferMaxSize;
+  uint8_t *DataBuffer;
+  uint8_t AnsSize;
+} LmhpFragmentationState_t;
+
+/* Private define ------------------------------------------------------------*/
+/*!
+ * Fragmented data block transport package port number
+ */
+#define FRAGMENTATION_PORT                          201
+
+#define FRAGMENTATION_ID                            3
+#define FRAGMENTATION_VERSION                       1
+
+/*!
+ * Sessions handled, a single decoder
+ */
+#define FRAGMENTATION_MAX_SESSIONS                  1
+
+/*!
+ * Size of the answer buffer
+ */
+#define FRAGMENTATION_ANS_MAX_SIZE                  16
+
+/*!
+ * Delay before retrying an answer while the MAC is busy in ms
+ */
+#define FRAGMENTATION_ANS_RETRY_DELAY               1000
+
+/*!
+ * FragSessionSetupAns status bits
+ */
+#define FRAGMENTATION_SETUP_ENCODING_UNSUPPORTED    0x01
+#define FRAGMENTATION_SETUP_NOT_ENOUGH_MEMORY       0x02
+#define FRAGMENTATION_SETUP_INDEX_UNSUPPORTED       0x04
+
+/* Private macro -------------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+/*!
+ * Initializes the package with provided parameters
+ *
+ * \param [in] params            Pointer to the package parameters
+ * \param [in] dataBuffer        Pointer to main application buffer
+ * \param [in] dataBufferMaxSize Application buffer maximum size
+ */
+static void LmhpFragmentationInit(void *params, uint8_t *dataBuffer, uint8_t dataBufferMaxSize);
+
+/*!
+ * Returns the current package initialization status.
+ *
+ * \retval status Package initialization status
+ *                [true: Initialized, false: Not initialized]
+ */
+static bool LmhpFragmentationIsInitialized(void);
+
+/*!
+ * Returns the package operation status.
+ *
+ * \retval status Package operation status
+ *                [true: Running, false: Not running]
+ */
+static bool LmhpFragmentationIsRunning(void);
+
+/*!
+ * Sends the pending answers
+ */
+static void LmhpFragmentationProcess(void);
+
+/*!
+ * Processes the MCPS Indication
+ *
+ * \param [in] mcpsIndication     MCPS indication primitive data
+ */
+static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication);
+
+/*!
+ * Sends the delayed answers, or retries them
+ */
+static void OnAnsTimerEvent(void *context);
+
+/* Private variables ---------------------------------------------------------*/
+static LmhpFragmentationState_t LmhpFragmentationState =
+{
+  .Initialized = false,
+  .IsRunning = false,
+  .AnsSize = 0,
+};
+
+/*!
+ * Package parameters
+ */
+static LmhpFragmentationParams_t *LmhpFragmentationParams;
+
+static FragSessionData_t FragSessionData[FRAGMENTATION_MAX_SESSIONS];
+
+/*!
+ * Answers to the last requests
+ */
+static uint8_t AnsBuffer[FRAGMENTATION_ANS_MAX_SIZE];
+
+/*!
+ * Timer of the delayed answers and of the retries while the MAC is busy
+ */
+static TimerEvent_t AnsTimer;
+
+static LmhPackage_t LmhpFragmentationPackage =
+{
+  .Port =                       FRAGMENTATION_PORT,
+  .Init =                       LmhpFragmentationInit,
+  .IsInitialized =              LmhpFragmentationIsInitialized,
+  .IsRunning =                  LmhpFragmentationIsRunning,
+  .Process =                    LmhpFragmentationProcess,
+  .OnMcpsConfirmProcess =       NULL,                           /* Not used in this package */
+  .OnMcpsIndicationProcess =    LmhpFragmentationOnMcpsIndication,
+  .OnMlmeConfirmProcess =       NULL,                           /* Not used in this package */
+  .OnJoinRequest =              NULL,                           /* To be initialized by LmHandler */
+  .OnSendRequest =              NULL,                           /* To be initialized by LmHandler */
+  .OnDeviceTimeRequest =        NULL,                           /* To be initialized by LmHandler */
+};
+
+/* Exported functions ---------------------------------------------------------*/
+LmhPackage_t *LmhpFragmentationPackageFactory(void)
+{
+  return &LmhpFragmentationPackage;
+}
+
+/* Private  functions ---------------------------------------------------------*/
+static void LmhpFragmentationInit(void *params, uint8_t *dataBuffer, uint8_t dataBufferMaxSize)
+{
+  if ((params != NULL) && (dataBuffer != NULL))
+  {
+    LmhpFragmentationParams = (LmhpFragmentationParams_t *)params;
+    LmhpFragmentationState.DataBuffer = dataBuffer;
+    LmhpFragmentationState.DataBufferMaxSize = dataBufferMaxSize;
+    LmhpFragmentationState.Initialized = true;
+    LmhpFragmentationState.IsRunning = false;
+    LmhpFragmentationState.AnsSize = 0;
+    for (uint8_t i = 0; i < FRAGMENTATION_MAX_SESSIONS; i++)
+    {
+      FragSessionData[i].IsDefined = false;
+    }
+    TimerInit(&AnsTimer, OnAnsTimerEvent);
+  }
+  else
+  {
+    LmhpFragmentationParams = NULL;
+    LmhpFragmentationState.Initialized = false;
+  }
+}
+
+static bool LmhpFragmentationIsInitialized(void)
+{
+  return LmhpFragmentationState.Initialized;
+}
+
+static bool LmhpFragmentationIsRunning(void)
+{
+  if (LmhpFragmentationState.Initialized == false)
+  {
+    return false;
+  }
+
+  return LmhpFragmentationState.IsRunning;
+}
+
+static void LmhpFragmentationProcess(void)
+{
+  if (LmhpFragmentationState.IsRunning == false)
+  {
+    return;
+  }
+
+  LmHandlerAppData_t appData =
+  {
+    .Buffer = AnsBuffer,
+    .BufferSize = LmhpFragmentationState.AnsSize,
+    .Port = FRAGMENTATION_PORT
+  };
+  TimerTime_t nextTxIn = 0;
+
+  if (LmhpFragmentationPackage.OnSendRequest(&appData, LORAMAC_HANDLER_UNCONFIRMED_MSG, &nextTxIn,
+                                             true) == LORAMAC_HANDLER_SUCCESS)
+  {
+    LmhpFragmentationState.AnsSize = 0;
+    LmhpFragmentationState.IsRunning = false;
+  }
+  else
+  {
+    TimerSetValue(&AnsTimer, (nextTxIn > 0) ? nextTxIn : FRAGMENTATION_ANS_RETRY_DELAY);
+    TimerStart(&AnsTimer);
+  }
+}
+
+static void OnAnsTimerEvent(void *context)
+{
+  LmhpFragmentationState.IsRunning = true;
+  LmhpFragmentationProcess();
+}
+
+/*!
+ * Answers FragSessionStatusReq after a random delay, so that the devices of
+ * a multicast group do not answer at once
+ */
+static void StartStatusAnsDelay(uint8_t blockAckDelay)
+{
+  uint32_t maxDelay = 1UL << (blockAckDelay + 4);
+
+  TimerStop(&AnsTimer);
+  TimerSetValue(&AnsTimer, (uint32_t)randr(0, (int32_t)(maxDelay * 1000)) + 1);
+  TimerStart(&AnsTimer);
+}
+
+/*!
+ * Handles DataFragment
+ */
+static void ProcessDataFragment(const uint8_t *buffer, uint8_t size, uint8_t mcGroupId)
+{
+  FragSessionData_t *session;
+  FragDecoderStatus_t status;
+  uint16_t fragCounter;
+  uint8_t index;
+  int32_t result;
+
+  if (size < 2)
+  {
+    return;
+  }
+  fragCounter = (uint16_t)(buffer[0] | (buffer[1] << 8));
+  index = (uint8_t)(fragCounter >> 14);
+  fragCounter &= 0x3FFF;
+  if (index >= FRAGMENTATION_MAX_SESSIONS)
+  {
+    return;
+  }
+  session = &FragSessionData[index];
+  if ((session->IsDefined == false) || (session->IsDone == true) || ((size - 2) < session->FragSize) ||
+      ((mcGroupId != 0xFF) && ((mcGroupId >= 4) || ((session->McGroupBitMask & (1 << mcGroupId)) == 0))))
+  {
+    return;
+  }
+
+  result = FragDecoderProcess(fragCounter, (uint8_t *)&buffer[2]);
+  status = FragDecoderGetStatus();
+  if (LmhpFragmentationParams->OnProgress != NULL)
+  {
+    LmhpFragmentationParams->OnProgress(fragCounter, session->FragNb, session->FragSize, status.FragNbLost);
+  }
+  if ((result == FRAG_SESSION_FINISHED) || (result == FRAG_SESSION_FAILED))
+  {
+    session->IsDone = true;
+    if (LmhpFragmentationParams->OnDone != NULL)
+    {
+      LmhpFragmentationParams->OnDone(result, ((uint32_t)session->FragNb * session->FragSize) - session->Padding);
+    }
+  }
+}
+
+static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication)
+{
+  uint8_t cmdIndex = 0;
+  uint8_t mcGroupId = 0xFF;
+  uint8_t *ans;
+  uint8_t index;
+
+  if ((LmhpFragmentationState.Initialized == false) || (mcpsIndication->Port != FRAGMENTATION_PORT))
+  {
+    return;
+  }
+  if (mcpsIndication->Multicast != 0)
+  {
+    mcGroupId = LoRaMacMcChannelGetGroupId(mcpsIndication->DevAddress);
+  }
+
+  while (cmdIndex < mcpsIndication->BufferSize)
+  {
+    const uint8_t *req = &mcpsIndication->Buffer[cmdIndex + 1];
+    uint8_t reqSize = mcpsIndication->BufferSize - cmdIndex - 1;
+
+    /* Largest answer: FragSessionStatusAns */
+    if ((LmhpFragmentationState.AnsSize + 5) > FRAGMENTATION_ANS_MAX_SIZE)
+    {
+      break;
+    }
+    ans = &AnsBuffer[LmhpFragmentationState.AnsSize];
+
+    switch (mcpsIndication->Buffer[cmdIndex++])
+    {
+      case FRAGMENTATION_PKG_VERSION_REQ:
+      {
+        if (mcGroupId != 0xFF)
+        {
+          /* Not answered to a multicast request */
+          break;
+        }
+        ans[0] = FRAGMENTATION_PKG_VERSION_REQ;
+        ans[1] = FRAGMENTATION_ID;
+        ans[2] = FRAGMENTATION_VERSION;
+        LmhpFragmentationState.AnsSize += 3;
+        LmhpFragmentationState.IsRunning = true;
+        break;
+      }
+      case FRAGMENTATION_FRAG_SESSION_STATUS_REQ:
+      {
+        FragDecoderStatus_t status;
+        bool participants;
+
+        if (reqSize < 1)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
+        participants = (req[0] & 0x01) != 0;
+        index = (req[0] >> 1) & 0x03;
+        cmdIndex += 1;
+        if ((index >= FRAGMENTATION_MAX_SESSIONS) || (FragSessionData[index].IsDefined == false))
+        {
+          break;
+        }
+        status = FragDecoderGetStatus();
+        if ((participants == false) && (FragSessionData[index].IsDone == true) && (status.MatrixError == 0))
+        {
+          /* Only the devices missing fragments answer */
+          break;
+        }
+        ans[0] = FRAGMENTATION_FRAG_SESSION_STATUS_REQ;
+        ans[1] = (uint8_t)status.FragNbRx;
+        ans[2] = (uint8_t)((index << 6) | ((status.FragNbRx >> 8) & 0x3F));
+        ans[3] = (status.FragNbLost > 0xFF) ? 0xFF : (uint8_t)status.FragNbLost;
+        ans[4] = status.MatrixError;
+        LmhpFragmentationState.AnsSize += 5;
+        StartStatusAnsDelay(FragSessionData[index].BlockAckDelay);
+        break;
+      }
+      case FRAGMENTATION_FRAG_SESSION_SETUP_REQ:
+      {
+        uint8_t status = 0;
+
+        if (reqSize < 10)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
+        index = (req[0] >> 4) & 0x03;
+        if (index >= FRAGMENTATION_MAX_SESSIONS)
+        {
+          status |= FRAGMENTATION_SETUP_INDEX_UNSUPPORTED;
+        }
+        if (((req[4] >> 3) & 0x07) != 0)
+        {
+          status |= FRAGMENTATION_SETUP_ENCODING_UNSUPPORTED;
+        }
+        if (status == 0)
+        {
+          FragSessionData_t *session = &FragSessionData[index];
+
+          session->McGroupBitMask = req[0] & 0x0F;
+          session->FragNb = (uint16_t)(req[1] | (req[2] << 8));
+          session->FragSize = req[3];
+          session->BlockAckDelay = req[4] & 0x07;
+          session->Padding = req[5];
+          session->Descriptor = (uint32_t)req[6] | ((uint32_t)req[7] << 8) | ((uint32_t)req[8] << 16) |
+                                ((uint32_t)req[9] << 24);
+          session->IsDone = false;
+          session->IsDefined = (FragDecoderInit(session->FragNb, session->FragSize,
+                                                &LmhpFragmentationParams->DecoderCallbacks) == 0);
+          if (session->IsDefined == false)
+          {
+            status |= FRAGMENTATION_SETUP_NOT_ENOUGH_MEMORY;
+          }
+        }
+        ans[0] = FRAGMENTATION_FRAG_SESSION_SETUP_REQ;
+        ans[1] = (uint8_t)(index << 6) | status;
+        LmhpFragmentationState.AnsSize += 2;
+        LmhpFragmentationState.IsRunning = true;
+        cmdIndex += 10;
+        break;
+      }
+      case FRAGMENTATION_FRAG_SESSION_DELETE_REQ:
+      {
+        if (reqSize < 1)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
+        index = req[0] & 0x03;
+        ans[0] = FRAGMENTATION_FRAG_SESSION_DELETE_REQ;
+        ans[1] = index;
+        if ((index < FRAGMENTATION_MAX_SESSIONS) && (FragSessionData[index].IsDefined == true))
+        {
+          FragSessionData[index].IsDefined = false;
+        }
+        else
+        {
+          ans[1] |= 0x04;
+        }
+        LmhpFragmentationState.AnsSize += 2;
+        LmhpFragmentationState.IsRunning = true;
+        cmdIndex += 1;
+        break;
+      }
+      case FRAGMENTATION_DATA_FRAGMENT:
+      {
+        /* The fragment is the rest of the frame */
+        ProcessDataFragment(req, reqSize, mcGroupId);
+        cmdIndex = mcpsIndication->BufferSize;
+        break;
+      }
+      default:
+      {
+        /* Unknown command, the rest of the frame cannot be parsed */
+        cmdIndex = mcpsIndication->BufferSize;
+        break;
+      }
+    }
+  }
+}
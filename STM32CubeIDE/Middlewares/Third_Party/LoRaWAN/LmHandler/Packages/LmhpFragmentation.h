@@ -0,0 +1,66 @@
+/**
+  ******************************************************************************
+  * @file    LmhpFragmentation.h
+  * @brief   Header for the LoRa-Alliance fragmented data block transport
+  *          package (TS004 v1.0.0)
+  ******************************************************************************
+  */
+#ifndef __LMHP_FRAGMENTATION_H__
+#define __LMHP_FRAGMENTATION_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "LmhPackage.h"
+#include "FragDecoder.h"
+
+/* Exported defines ----------------------------------------------------------*/
+/*!
+  * Fragmented data block transport package identifier.
+  *
+  * \remark This value must be unique amongst the packages
+  */
+#define PACKAGE_ID_FRAGMENTATION                    3
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported types ------------------------------------------------------------*/
+/*!
+  * Fragmented data block transport package parameters
+  */
+typedef struct LmhpFragmentationParams_s
+{
+  /*!
+    * Storage of the file
+    */
+  FragDecoderCallbacks_t DecoderCallbacks;
+  /*!
+    * Notifies the reception of a fragment, may be NULL
+    *
+    * \param [in] fragCounter Fragment counter
+    * \param [in] fragNb      Number of uncoded fragments
+    * \param [in] fragSize    Fragment size
+    * \param [in] fragNbLost  Fragments lost so far
+    */
+  void (*OnProgress)(uint16_t fragCounter, uint16_t fragNb, uint8_t fragSize, uint16_t fragNbLost);
+  /*!
+    * Notifies the end of the session
+    *
+    * \param [in] status FRAG_SESSION_FINISHED once the file is stored,
+    *                    FRAG_SESSION_FAILED when it cannot be rebuilt
+    * \param [in] size   File size, without the padding
+    */
+  void (*OnDone)(int32_t status, uint32_t size);
+} LmhpFragmentationParams_t;
+
+/* External variables --------------------------------------------------------*/
+/* Exported macros -----------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+LmhPackage_t *LmhpFragmentationPackageFactory(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LMHP_FRAGMENTATION_H__ */
@@ -0,0 +1,689 @@
+/**
+  ******************************************************************************
+  * @file    LmhpRemoteMcastSetup.c
+  * @brief   LoRa-Alliance remote multicast setup package (TS005 v1.0.0)
+  *
+  *          The multicast keys are sent encrypted with the McKEKey derived
+  *          from the McRootKey at join, the session keys are derived by the
+  *          MAC. Session times are GPS seconds compared to the system time,
+  *          which is kept in sync by DeviceTimeReq.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "utilities.h"
+#include "LmHandler.h"
+#include "LmhpRemoteMcastSetup.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/*!
+ * Package commands
+ */
+typedef enum LmhpRemoteMcastSetupCmd_e
+{
+  REMOTE_MCAST_SETUP_PKG_VERSION_REQ            = 0x00,
+  REMOTE_MCAST_SETUP_MC_GROUP_STATUS_REQ        = 0x01,
+  REMOTE_MCAST_SETUP_MC_GROUP_SETUP_REQ         = 0x02,
+  REMOTE_MCAST_SETUP_MC_GROUP_DELETE_REQ        = 0x03,
+  REMOTE_MCAST_SETUP_MC_GROUP_CLASS_C_SESSION_REQ = 0x04,
+  REMOTE_MCAST_SETUP_MC_GROUP_CLASS_B_SESSION_REQ = 0x05,
+} LmhpRemoteMcastSetupCmd_t;
+
+/*!
+ * Multicast session state
+ */
+typedef enum SessionState_e
+{
+  SESSION_STOPPED,
+  SESSION_PENDING,
+  SESSION_ACTIVE,
+} SessionState_t;
+
+/*!
+ * Multicast group data
+ */
+typedef struct McGroupData_s
+{
+  bool IsDefined;
+  uint32_t Address;
+  uint8_t McKeyE[16];
+  uint32_t FCountMin;
+  uint32_t FCountMax;
+  DeviceClass_t Class;
+  McRxParams_t RxParams;
+  SessionState_t SessionState;
+  uint32_t SessionTime;                 /* GPS seconds */
+  uint32_t SessionTimeout;              /* seconds */
+  TimerEvent_t SessionTimer;
+} McGroupData_t;
+
+/*!
+ * Package current context
+ */
+typedef struct LmhpRemoteMcastSetupState_s
+{
+  bool Initialized;
+  bool IsRunning;
+  uint8_t DataBufferMaxSize;
+  uint8_t *DataBuffer;
+  uint8_t AnsSize;
+  uint8_t NbActiveSessions;
+  DeviceClass_t ClassBeforeSession;
+  DeviceClass_t SessionClass;           /* Class to switch to, retried while refused */
+  bool IsClassReentry;                  /* Class C is left and re-entered */
+} LmhpRemoteMcastSetupState_t;
+
+/* Private define ------------------------------------------------------------*/
+/*!
+ * Remote multicast setup package port number
+ */
+#define REMOTE_MCAST_SETUP_PORT                     200
+
+#define REMOTE_MCAST_SETUP_ID                       2
+#define REMOTE_MCAST_SETUP_VERSION                  1
+
+/*!
+ * Size of the answer buffer
+ */
+#define REMOTE_MCAST_SETUP_ANS_MAX_SIZE             32
+
+/*!
+ * Longest timer delay, the session timer is re-armed for what remains
+ */
+#define REMOTE_MCAST_SETUP_MAX_TIMER_S              ( 24 * 3600 )
+
+/*!
+ * Delay before retrying an answer while the MAC is busy in ms
+ */
+#define REMOTE_MCAST_SETUP_ANS_RETRY_DELAY          1000
+
+/*!
+ * Delay before retrying a class switch refused by the MAC in ms, e.g. while
+ * it is busy or class B has no beacon yet
+ */
+#define REMOTE_MCAST_SETUP_CLASS_RETRY_DELAY        1000
+
+/* Private macro -------------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+/*!
+ * Initializes the package with provided parameters
+ *
+ * \param [in] params            Pointer to the package parameters, may be NULL
+ * \param [in] dataBuffer        Pointer to main application buffer
+ * \param [in] dataBufferMaxSize Application buffer maximum size
+ */
+static void LmhpRemoteMcastSetupInit(void *params, uint8_t *dataBuffer, uint8_t dataBufferMaxSize);
+
+/*!
+ * Returns the current package initialization status.
+ *
+ * \retval status Package initialization status
+ *                [true: Initialized, false: Not initialized]
+ */
+static bool LmhpRemoteMcastSetupIsInitialized(void);
+
+/*!
+ * Returns the package operation status.
+ *
+ * \retval status Package operation status
+ *                [true: Running, false: Not running]
+ */
+static bool LmhpRemoteMcastSetupIsRunning(void);
+
+/*!
+ * Sends the pending answers
+ */
+static void LmhpRemoteMcastSetupProcess(void);
+
+/*!
+ * Processes the MCPS Indication
+ *
+ * \param [in] mcpsIndication     MCPS indication primitive data
+ */
+static void LmhpRemoteMcastSetupOnMcpsIndication(McpsIndication_t *mcpsIndication);
+
+/*!
+ * Starts or stops a multicast session
+ */
+static void OnSessionTimerEvent(void *context);
+
+/*!
+ * Retries the pending answers
+ */
+static void OnAnsRetryTimerEvent(void *context);
+
+/*!
+ * Retries the pending class switch
+ */
+static void OnClassRetryTimerEvent(void *context);
+
+/* Private variables ---------------------------------------------------------*/
+static LmhpRemoteMcastSetupState_t LmhpRemoteMcastSetupState =
+{
+  .Initialized = false,
+  .IsRunning = false,
+  .AnsSize = 0,
+  .NbActiveSessions = 0,
+};
+
+/*!
+ * Package parameters
+ */
+static LmhpRemoteMcastSetupParams_t *LmhpRemoteMcastSetupParams;
+
+static McGroupData_t McGroupData[LORAMAC_MAX_MC_CTX];
+
+/*!
+ * Answers to the last requests
+ */
+static uint8_t AnsBuffer[REMOTE_MCAST_SETUP_ANS_MAX_SIZE];
+
+/*!
+ * Timer to retry the answers while the MAC is busy
+ */
+static TimerEvent_t AnsRetryTimer;
+
+/*!
+ * Timer to retry the class switch of a session start or end
+ */
+static TimerEvent_t ClassRetryTimer;
+
+static LmhPackage_t LmhpRemoteMcastSetupPackage =
+{
+  .Port =                       REMOTE_MCAST_SETUP_PORT,
+  .Init =                       LmhpRemoteMcastSetupInit,
+  .IsInitialized =              LmhpRemoteMcastSetupIsInitialized,
+  .IsRunning =                  LmhpRemoteMcastSetupIsRunning,
+  .Process =                    LmhpRemoteMcastSetupProcess,
+  .OnMcpsConfirmProcess =       NULL,                           /* Not used in this package */
+  .OnMcpsIndicationProcess =    LmhpRemoteMcastSetupOnMcpsIndication,
+  .OnMlmeConfirmProcess =       NULL,                           /* Not used in this package */
+  .OnJoinRequest =              NULL,                           /* To be initialized by LmHandler */
+  .OnSendRequest =              NULL,                           /* To be initialized by LmHandler */
+  .OnDeviceTimeRequest =        NULL,                           /* To be initialized by LmHandler */
+};
+
+/* Exported functions ---------------------------------------------------------*/
+LmhPackage_t *LmhpRemoteMcastSetupPackageFactory(void)
+{
+  return &LmhpRemoteMcastSetupPackage;
+}
+
+/* Private  functions ---------------------------------------------------------*/
+static void LmhpRemoteMcastSetupInit(void *params, uint8_t *dataBuffer, uint8_t dataBufferMaxSize)
+{
+  if (dataBuffer != NULL)
+  {
+    LmhpRemoteMcastSetupParams = (LmhpRemoteMcastSetupParams_t *)params;
+    LmhpRemoteMcastSetupState.DataBuffer = dataBuffer;
+    LmhpRemoteMcastSetupState.DataBufferMaxSize = dataBufferMaxSize;
+    LmhpRemoteMcastSetupState.Initialized = true;
+    LmhpRemoteMcastSetupState.IsRunning = false;
+    LmhpRemoteMcastSetupState.AnsSize = 0;
+    LmhpRemoteMcastSetupState.NbActiveSessions = 0;
+    for (uint8_t id = 0; id < LORAMAC_MAX_MC_CTX; id++)
+    {
+      McGroupData[id].IsDefined = false;
+      McGroupData[id].SessionState = SESSION_STOPPED;
+      UTIL_TIMER_Create(&McGroupData[id].SessionTimer, TIMERTIME_T_MAX, UTIL_TIMER_ONESHOT, OnSessionTimerEvent,
+                        &McGroupData[id]);
+    }
+    TimerInit(&AnsRetryTimer, OnAnsRetryTimerEvent);
+    TimerInit(&ClassRetryTimer, OnClassRetryTimerEvent);
+  }
+  else
+  {
+    LmhpRemoteMcastSetupParams = NULL;
+    LmhpRemoteMcastSetupState.Initialized = false;
+  }
+}
+
+static bool LmhpRemoteMcastSetupIsInitialized(void)
+{
+  return LmhpRemoteMcastSetupState.Initialized;
+}
+
+static bool LmhpRemoteMcastSetupIsRunning(void)
+{
+  if (LmhpRemoteMcastSetupState.Initialized == false)
+  {
+    return false;
+  }
+
+  return LmhpRemoteMcastSetupState.IsRunning;
+}
+
+static void LmhpRemoteMcastSetupProcess(void)
+{
+  if (LmhpRemoteMcastSetupState.IsRunning == false)
+  {
+    return;
+  }
+
+  LmHandlerAppData_t appData =
+  {
+    .Buffer = AnsBuffer,
+    .BufferSize = LmhpRemoteMcastSetupState.AnsSize,
+    .Port = REMOTE_MCAST_SETUP_PORT
+  };
+  TimerTime_t nextTxIn = 0;
+
+  if (LmhpRemoteMcastSetupPackage.OnSendRequest(&appData, LORAMAC_HANDLER_UNCONFIRMED_MSG, &nextTxIn,
+                                                true) == LORAMAC_HANDLER_SUCCESS)
+  {
+    LmhpRemoteMcastSetupState.AnsSize = 0;
+    LmhpRemoteMcastSetupState.IsRunning = false;
+  }
+  else
+  {
+    TimerSetValue(&AnsRetryTimer, (nextTxIn > 0) ? nextTxIn : REMOTE_MCAST_SETUP_ANS_RETRY_DELAY);
+    TimerStart(&AnsRetryTimer);
+  }
+}
+
+static void OnAnsRetryTimerEvent(void *context)
+{
+  LmhpRemoteMcastSetupProcess();
+}
+
+/*!
+ * Returns the current GPS time in seconds
+ */
+static uint32_t GetGpsTime(void)
+{
+  SysTime_t sysTime = SysTimeGet();
+
+  return sysTime.Seconds - UNIX_GPS_EPOCH_OFFSET;
+}
+
+/*!
+ * Arms the session timer for what remains until the given GPS time
+ */
+static void StartSessionTimer(McGroupData_t *group, uint32_t gpsTime)
+{
+  int32_t remaining = (int32_t)(gpsTime - GetGpsTime());
+
+  if (remaining < 0)
+  {
+    remaining = 0;
+  }
+  else if (remaining > REMOTE_MCAST_SETUP_MAX_TIMER_S)
+  {
+    remaining = REMOTE_MCAST_SETUP_MAX_TIMER_S;
+  }
+  TimerStop(&group->SessionTimer);
+  TimerSetValue(&group->SessionTimer, ((uint32_t)remaining * 1000) + 1);
+  TimerStart(&group->SessionTimer);
+}
+
+/*!
+ * Requests the session class, through class A when another class is running.
+ * Retried after REMOTE_MCAST_SETUP_CLASS_RETRY_DELAY while the MAC refuses.
+ */
+static void ApplySessionClass(void)
+{
+  DeviceClass_t newClass = LmhpRemoteMcastSetupState.SessionClass;
+  DeviceClass_t currentClass;
+
+  LmHandlerGetCurrentClass(&currentClass);
+  if ((currentClass != CLASS_A) && ((currentClass != newClass) || LmhpRemoteMcastSetupState.IsClassReentry))
+  {
+    if (LmHandlerRequestClass(CLASS_A) != LORAMAC_HANDLER_SUCCESS)
+    {
+      TimerSetValue(&ClassRetryTimer, REMOTE_MCAST_SETUP_CLASS_RETRY_DELAY);
+      TimerStart(&ClassRetryTimer);
+      return;
+    }
+  }
+  LmhpRemoteMcastSetupState.IsClassReentry = false;
+  if (LmHandlerRequestClass(newClass) != LORAMAC_HANDLER_SUCCESS)
+  {
+    TimerSetValue(&ClassRetryTimer, REMOTE_MCAST_SETUP_CLASS_RETRY_DELAY);
+    TimerStart(&ClassRetryTimer);
+  }
+}
+
+/*!
+ * Switches to a class, the latest request wins over a pending retry
+ */
+static void SwitchClass(DeviceClass_t newClass)
+{
+  TimerStop(&ClassRetryTimer);
+  LmhpRemoteMcastSetupState.SessionClass = newClass;
+  /* Class C is re-entered to listen on the multicast channel */
+  LmhpRemoteMcastSetupState.IsClassReentry = (newClass == CLASS_C);
+  ApplySessionClass();
+}
+
+static void OnClassRetryTimerEvent(void *context)
+{
+  ApplySessionClass();
+}
+
+static void OnSessionTimerEvent(void *context)
+{
+  McGroupData_t *group = (McGroupData_t *)context;
+  uint8_t id = (uint8_t)(group - &McGroupData[0]);
+  uint32_t now = GetGpsTime();
+
+  switch (group->SessionState)
+  {
+    case SESSION_PENDING:
+    {
+      if ((int32_t)(group->SessionTime - now) > 0)
+      {
+        StartSessionTimer(group, group->SessionTime);
+        break;
+      }
+      if (LmhpRemoteMcastSetupState.NbActiveSessions == 0)
+      {
+        LmHandlerGetCurrentClass(&LmhpRemoteMcastSetupState.ClassBeforeSession);
+      }
+      LmhpRemoteMcastSetupState.NbActiveSessions++;
+      group->SessionState = SESSION_ACTIVE;
+      SwitchClass(group->Class);
+      StartSessionTimer(group, group->SessionTime + group->SessionTimeout);
+      if ((LmhpRemoteMcastSetupParams != NULL) && (LmhpRemoteMcastSetupParams->OnSessionChange != NULL))
+      {
+        LmhpRemoteMcastSetupParams->OnSessionChange(id, true);
+      }
+      break;
+    }
+    case SESSION_ACTIVE:
+    {
+      if ((int32_t)(group->SessionTime + group->SessionTimeout - now) > 0)
+      {
+        StartSessionTimer(group, group->SessionTime + group->SessionTimeout);
+        break;
+      }
+      group->SessionState = SESSION_STOPPED;
+      LmhpRemoteMcastSetupState.NbActiveSessions--;
+      if (LmhpRemoteMcastSetupState.NbActiveSessions == 0)
+      {
+        SwitchClass(LmhpRemoteMcastSetupState.ClassBeforeSession);
+      }
+      if ((LmhpRemoteMcastSetupParams != NULL) && (LmhpRemoteMcastSetupParams->OnSessionChange != NULL))
+      {
+        LmhpRemoteMcastSetupParams->OnSessionChange(id, false);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/*!
+ * Stops the session of a group without restoring the class when others run
+ */
+static void StopSession(McGroupData_t *group)
+{
+  TimerStop(&group->SessionTimer);
+  if (group->SessionState == SESSION_ACTIVE)
+  {
+    group->SessionTimeout = 0;
+    group->SessionTime = GetGpsTime();
+    OnSessionTimerEvent(group);
+  }
+  group->SessionState = SESSION_STOPPED;
+}
+
+/*!
+ * Sets up the MAC multicast channel of a group
+ */
+static LoRaMacStatus_t SetupChannel(uint8_t id)
+{
+  McChannelParams_t channel =
+  {
+    .IsRemotelySetup = true,
+    .Class = McGroupData[id].Class,
+    .IsEnabled = true,
+    .GroupID = (AddressIdentifier_t)id,
+    .Address = McGroupData[id].Address,
+    .McKeys.McKeyE = McGroupData[id].McKeyE,
+    .FCountMin = McGroupData[id].FCountMin,
+    .FCountMax = McGroupData[id].FCountMax,
+    .RxParams = McGroupData[id].RxParams
+  };
+
+  return LoRaMacMcChannelSetup(&channel);
+}
+
+static uint32_t GetUint32(const uint8_t *buffer)
+{
+  return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+/*!
+ * Handles McClassCSessionReq and McClassBSessionReq
+ *
+ * \retval Number of bytes of the request, 0 if too short
+ */
+static uint8_t ProcessSessionReq(const uint8_t *buffer, uint8_t size, DeviceClass_t sessionClass, uint8_t *ans)
+{
+  McRxParams_t rxParams;
+  uint8_t status;
+  uint8_t id;
+  uint32_t timeToStart;
+  uint32_t sessionTime;
+  uint8_t timeout;
+
+  if (size < 10)
+  {
+    return 0;
+  }
+  id = buffer[0] & 0x03;
+  sessionTime = GetUint32(&buffer[1]);
+  timeout = buffer[5] & 0x0F;
+  if (sessionClass == CLASS_B)
+  {
+    rxParams.ClassB.Periodicity = (buffer[5] >> 4) & 0x07;
+    rxParams.ClassB.Frequency = ((uint32_t)buffer[6] | ((uint32_t)buffer[7] << 8) | ((uint32_t)buffer[8] << 16)) * 100;
+    rxParams.ClassB.Datarate = (int8_t)buffer[9];
+  }
+  else
+  {
+    rxParams.ClassC.Frequency = ((uint32_t)buffer[6] | ((uint32_t)buffer[7] << 8) | ((uint32_t)buffer[8] << 16)) * 100;
+    rxParams.ClassC.Datarate = (int8_t)buffer[9];
+  }
+
+  ans[0] = (sessionClass == CLASS_B) ? REMOTE_MCAST_SETUP_MC_GROUP_CLASS_B_SESSION_REQ :
+           REMOTE_MCAST_SETUP_MC_GROUP_CLASS_C_SESSION_REQ;
+  ans[1] = 0x10 | id;
+  ans[2] = 0;
+  if ((id < LORAMAC_MAX_MC_CTX) && (McGroupData[id].IsDefined == true))
+  {
+    StopSession(&McGroupData[id]);
+    McGroupData[id].Class = sessionClass;
+    if (SetupChannel(id) == LORAMAC_STATUS_OK)
+    {
+      /* Applies the parameters if they are valid for the region */
+      LoRaMacMcChannelSetupRxParams((AddressIdentifier_t)id, &rxParams, &status);
+      ans[1] = status;
+    }
+  }
+
+  if (ans[1] == id)
+  {
+    McGroupData[id].RxParams = rxParams;
+    if (sessionClass == CLASS_B)
+    {
+      /* The ping slots of the group follow the new periodicity */
+      SetupChannel(id);
+    }
+    McGroupData[id].SessionTime = sessionTime;
+    McGroupData[id].SessionTimeout = 1UL << timeout;
+    McGroupData[id].SessionState = SESSION_PENDING;
+    timeToStart = sessionTime - GetGpsTime();
+    if ((int32_t)timeToStart < 0)
+    {
+      timeToStart = 0;
+    }
+    else if (timeToStart > 0xFFFFFF)
+    {
+      timeToStart = 0xFFFFFF;
+    }
+    StartSessionTimer(&McGroupData[id], sessionTime);
+    ans[2] = (uint8_t)timeToStart;
+    ans[3] = (uint8_t)(timeToStart >> 8);
+    ans[4] = (uint8_t)(timeToStart >> 16);
+    LmhpRemoteMcastSetupState.AnsSize += 5;
+  }
+  else
+  {
+    LmhpRemoteMcastSetupState.AnsSize += 2;
+  }
+  return 10;
+}
+
+static void LmhpRemoteMcastSetupOnMcpsIndication(McpsIndication_t *mcpsIndication)
+{
+  uint8_t cmdIndex = 0;
+  uint8_t *ans;
+  uint8_t id;
+
+  if ((LmhpRemoteMcastSetupState.Initialized == false) || (mcpsIndication->Port != REMOTE_MCAST_SETUP_PORT) ||
+      (mcpsIndication->Multicast != 0))
+  {
+    return;
+  }
+
+  while (cmdIndex < mcpsIndication->BufferSize)
+  {
+    const uint8_t *req = &mcpsIndication->Buffer[cmdIndex + 1];
+    uint8_t reqSize = mcpsIndication->BufferSize - cmdIndex - 1;
+
+    /* Largest answer: McGroupStatusAns of every group */
+    if ((LmhpRemoteMcastSetupState.AnsSize + 2 + (5 * LORAMAC_MAX_MC_CTX)) > REMOTE_MCAST_SETUP_ANS_MAX_SIZE)
+    {
+      break;
+    }
+    ans = &AnsBuffer[LmhpRemoteMcastSetupState.AnsSize];
+
+    switch (mcpsIndication->Buffer[cmdIndex++])
+    {
+      case REMOTE_MCAST_SETUP_PKG_VERSION_REQ:
+      {
+        ans[0] = REMOTE_MCAST_SETUP_PKG_VERSION_REQ;
+        ans[1] = REMOTE_MCAST_SETUP_ID;
+        ans[2] = REMOTE_MCAST_SETUP_VERSION;
+        LmhpRemoteMcastSetupState.AnsSize += 3;
+        break;
+      }
+      case REMOTE_MCAST_SETUP_MC_GROUP_STATUS_REQ:
+      {
+        uint8_t nbGroups = 0;
+        uint8_t ansMask = 0;
+        uint8_t index = 2;
+
+        if (reqSize < 1)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
+        for (id = 0; id < LORAMAC_MAX_MC_CTX; id++)
+        {
+          if (McGroupData[id].IsDefined == false)
+          {
+            continue;
+          }
+          nbGroups++;
+          if ((req[0] & (1 << id)) != 0)
+          {
+            ansMask |= 1 << id;
+            ans[index++] = id;
+            ans[index++] = (uint8_t)McGroupData[id].Address;
+            ans[index++] = (uint8_t)(McGroupData[id].Address >> 8);
+            ans[index++] = (uint8_t)(McGroupData[id].Address >> 16);
+            ans[index++] = (uint8_t)(McGroupData[id].Address >> 24);
+          }
+        }
+        ans[0] = REMOTE_MCAST_SETUP_MC_GROUP_STATUS_REQ;
+        ans[1] = (nbGroups << 4) | ansMask;
+        LmhpRemoteMcastSetupState.AnsSize += index;
+        cmdIndex += 1;
+        break;
+      }
+      case REMOTE_MCAST_SETUP_MC_GROUP_SETUP_REQ:
+      {
+        if (reqSize < 29)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
+        id = req[0] & 0x03;
+        ans[0] = REMOTE_MCAST_SETUP_MC_GROUP_SETUP_REQ;
+        ans[1] = id;
+        if (id < LORAMAC_MAX_MC_CTX)
+        {
+          StopSession(&McGroupData[id]);
+          McGroupData[id].Address = GetUint32(&req[1]);
+          memcpy1(McGroupData[id].McKeyE, &req[5], 16);
+          McGroupData[id].FCountMin = GetUint32(&req[21]);
+          McGroupData[id].FCountMax = GetUint32(&req[25]);
+          /* Class and reception parameters come with the session request */
+          McGroupData[id].Class = CLASS_C;
+          memset1((uint8_t *)&McGroupData[id].RxParams, 0, sizeof(McRxParams_t));
+          McGroupData[id].IsDefined = (SetupChannel(id) == LORAMAC_STATUS_OK);
+        }
+        if ((id >= LORAMAC_MAX_MC_CTX) || (McGroupData[id].IsDefined == false))
+        {
+          ans[1] |= 0x04;
+        }
+        LmhpRemoteMcastSetupState.AnsSize += 2;
+        cmdIndex += 29;
+        break;
+      }
+      case REMOTE_MCAST_SETUP_MC_GROUP_DELETE_REQ:
+      {
+        if (reqSize < 1)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
+        id = req[0] & 0x03;
+        ans[0] = REMOTE_MCAST_SETUP_MC_GROUP_DELETE_REQ;
+        ans[1] = id;
+        if ((id < LORAMAC_MAX_MC_CTX) && (McGroupData[id].IsDefined == true))
+        {
+          StopSession(&McGroupData[id]);
+          LoRaMacMcChannelDelete((AddressIdentifier_t)id);
+          McGroupData[id].IsDefined = false;
+        }
+        else
+        {
+          ans[1] |= 0x04;
+        }
+        LmhpRemoteMcastSetupState.AnsSize += 2;
+        cmdIndex += 1;
+        break;
+      }
+      case REMOTE_MCAST_SETUP_MC_GROUP_CLASS_C_SESSION_REQ:
+      case REMOTE_MCAST_SETUP_MC_GROUP_CLASS_B_SESSION_REQ:
+      {
+        DeviceClass_t sessionClass = (mcpsIndication->Buffer[cmdIndex - 1] == REMOTE_MCAST_SETUP_MC_GROUP_CLASS_B_SESSION_REQ) ?
+                                     CLASS_B : CLASS_C;
+        uint8_t reqLen = ProcessSessionReq(req, reqSize, sessionClass, ans);
+
+        if (reqLen == 0)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
+        cmdIndex += reqLen;
+        break;
+      }
+      default:
+      {
+        /* Unknown command, the rest of the frame cannot be parsed */
+        cmdIndex = mcpsIndication->BufferSize;
+        break;
+      }
+    }
+  }
+
+  if (LmhpRemoteMcastSetupState.AnsSize > 0)
+  {
+    /* Sent by the package process once the MAC is idle */
+    LmhpRemoteMcastSetupState.IsRunning = true;
+  }
+}
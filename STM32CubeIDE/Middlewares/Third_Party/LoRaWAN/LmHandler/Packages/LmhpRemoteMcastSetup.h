@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * @file    LmhpRemoteMcastSetup.h
+  * @brief   Header for the LoRa-Alliance remote multicast setup package
+  *          (TS005 v1.0.0)
+  ******************************************************************************
+  */
+#ifndef __LMHP_REMOTE_MCAST_SETUP_H__
+#define __LMHP_REMOTE_MCAST_SETUP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "LmhPackage.h"
+
+/* Exported defines ----------------------------------------------------------*/
+/*!
+  * Remote multicast setup package identifier.
+  *
+  * \remark This value must be unique amongst the packages
+  */
+#define PACKAGE_ID_REMOTE_MCAST_SETUP               2
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported types ------------------------------------------------------------*/
+/*!
+  * Remote multicast setup package parameters, may be NULL
+  */
+typedef struct LmhpRemoteMcastSetupParams_s
+{
+  /*!
+    * Notifies the start and the end of a multicast session
+    *
+    * \param [in] groupId  Multicast group
+    * \param [in] isActive true at the start of the session, false at its end
+    */
+  void (*OnSessionChange)(uint8_t groupId, bool isActive);
+} LmhpRemoteMcastSetupParams_t;
+
+/* External variables --------------------------------------------------------*/
+/* Exported macros -----------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+LmhPackage_t *LmhpRemoteMcastSetupPackageFactory(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LMHP_REMOTE_MCAST_SETUP_H__ */
@@ -52,12 +52,17 @@
 #include "LoRaMacHeaderTypes.h"
 #include "LoRaMacMessageTypes.h"
 #include "LoRaMacParser.h"
+#include "LoRaMacFrameView.h"
 #include "LoRaMacCommands.h"
 #include "LoRaMacAdr.h"
 #include "LoRaMacSerializer.h"
+#include "LoRaMacAirtime.h"
+#include "LoRaMacClockError.h"
+#include "LoRaMacTxPowerCtrl.h"
 
 #include "LoRaMac.h"
 #include "mw_log_conf.h"
+#include "flight_recorder.h"
 
 /* Private macro -------------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -73,6 +78,15 @@
  */
 #define LORAMAC_PHY_MAXPAYLOAD                      255
 
+/*!
+ * Room kept in front of the application payload of an uplink for the largest
+ * frame header ( MHDR, FHDR with FOpts and FPort ). The header is serialized
+ * right in front of the payload, so that the payload is never moved.
+ */
+#define LORAMAC_TX_HEADROOM                         ( LORAMAC_MHDR_FIELD_SIZE + LORAMAC_FHDR_DEV_ADDR_FIELD_SIZE + \
+                                                      LORAMAC_FHDR_F_CTRL_FIELD_SIZE + LORAMAC_FHDR_F_CNT_FIELD_SIZE + \
+                                                      LORAMAC_FHDR_F_OPTS_MAX_FIELD_SIZE + LORAMAC_F_PORT_FIELD_SIZE )
+
 /*!
  * Maximum MAC commands buffer size
  */
@@ -225,23 +239,24 @@ typedef struct sLoRaMacCtx
     */
     uint16_t PktBufferLen;
     /*
-    * Buffer containing the data to be sent or received.
+    * Offset of the packet in PktBuffer
     */
-    uint8_t PktBuffer[LORAMAC_PHY_MAXPAYLOAD];
+    uint16_t PktBufferOffset;
+    /*
+    * Buffer containing the data to be sent. The application payload of data
+    * frames is located at LORAMAC_TX_HEADROOM.
+    */
+    uint8_t PktBuffer[LORAMAC_TX_HEADROOM + LORAMAC_PHY_MAXPAYLOAD];
     /*!
     * Current processed transmit message
     */
     LoRaMacMessage_t TxMsg;
-    /*!
-    * Buffer containing the data received by the application.
-    */
-    uint8_t AppData[LORAMAC_PHY_MAXPAYLOAD];
     /*
     * Size of buffer containing the application data.
     */
     uint8_t AppDataSize;
     /*
-    * Buffer containing the upper layer data.
+    * Buffer containing the upper layer data, while the radio keeps receiving.
     */
     uint8_t RxPayload[LORAMAC_PHY_MAXPAYLOAD];
     SysTime_t LastTxSysTime;
@@ -432,6 +447,16 @@ static void OnRadioTxDone( void );
  */
 static void PrepareRxDoneAbort( void );
 
+/*!
+ * \brief Returns the buffer handed to the upper layers with a received payload
+ *
+ * \param [IN] buffer Payload, in the radio buffer
+ * \param [IN] size Size of the payload
+ *
+ * \retval Payload buffer which stays valid until the indication is handled
+ */
+static uint8_t* RxIndicationBuffer( uint8_t* buffer, uint8_t size );
+
 /*!
  * \brief Function to be executed on Radio Rx Done event
  */
@@ -572,6 +597,12 @@ static LoRaMacStatus_t SendReJoinReq( JoinReqIdentifier_t joinReqType );
  */
 static LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t* fCtrl, uint8_t fPort, void* fBuffer, uint16_t fBufferSize );
 
+/*
+ * \brief Places the data frame in PktBuffer so that its FRMPayload ends up
+ *        at LORAMAC_TX_HEADROOM once serialized
+ */
+static void PlaceDataFrame( void );
+
 /*
  * \brief Schedules the frame according to the duty cycle
  *
@@ -814,6 +845,7 @@ static void LoRaMacHandleIndicationEvents( void );
 /* Private  functions ---------------------------------------------------------*/
 static void OnRadioTxDone( void )
 {
+    FlightRecorder_Record( FLIGHT_EVENT_TX_DONE, 0 );
     TxDoneParams.CurTime = TimerGetCurrentTime( );
     MacCtx.LastTxSysTime = SysTimeGet( );
 
@@ -828,6 +860,7 @@ static void OnRadioTxDone( void )
 
 static void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
 {
+    FlightRecorder_Record( FLIGHT_EVENT_RX_DONE, size );
     RxDoneParams.LastRxDone = TimerGetCurrentTime( );
     RxDoneParams.Payload = payload;
     RxDoneParams.Size = size;
@@ -845,6 +878,7 @@ static void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t
 
 static void OnRadioTxTimeout( void )
 {
+    FlightRecorder_Record( FLIGHT_EVENT_TX_TIMEOUT, 0 );
     LoRaMacRadioEvents.Events.TxTimeout = 1;
 
     if( ( MacCtx.MacCallbacks != NULL ) && ( MacCtx.MacCallbacks->MacProcessNotify != NULL ) )
@@ -856,6 +890,7 @@ static void OnRadioTxTimeout( void )
 
 static void OnRadioRxError( void )
 {
+    FlightRecorder_Record( FLIGHT_EVENT_RX_ERROR, 0 );
     LoRaMacRadioEvents.Events.RxError = 1;
 
     if( ( MacCtx.MacCallbacks != NULL ) && ( MacCtx.MacCallbacks->MacProcessNotify != NULL ) )
@@ -866,6 +901,7 @@ static void OnRadioRxError( void )
 
 static void OnRadioRxTimeout( void )
 {
+    FlightRecorder_Record( FLIGHT_EVENT_RX_TIMEOUT, 0 );
     LoRaMacRadioEvents.Events.RxTimeout = 1;
 
     if( ( MacCtx.MacCallbacks != NULL ) && ( MacCtx.MacCallbacks->MacProcessNotify != NULL ) )
@@ -948,6 +984,55 @@ static void PrepareRxDoneAbort( void )
     UpdateRxSlotIdleState( );
 }
 
+static uint8_t* RxIndicationBuffer( uint8_t* buffer, uint8_t size )
+{
+    // In class A the radio is idle until the indication is handled. In class B
+    // and C, including multicast sessions, it receives again right away and the
+    // next frame overwrites the radio buffer.
+    if( MacCtx.NvmCtx->DeviceClass == CLASS_A )
+    {
+        return buffer;
+    }
+    memcpy1( MacCtx.RxPayload, buffer, size );
+    return MacCtx.RxPayload;
+}
+
+/*!
+ * \brief Feeds the clock error model with the arrival time of a class A
+ *        downlink relative to the end of the uplink.
+ *
+ * \param [IN] size Size of the received PHY payload
+ */
+static void ObserveRxArrival( uint16_t size )
+{
+    uint32_t rxDelay;
+    TimerTime_t timeOnAir;
+
+    switch( MacCtx.RxSlot )
+    {
+        case RX_SLOT_WIN_1:
+            rxDelay = ( MacCtx.NvmCtx->NetworkActivation == ACTIVATION_TYPE_NONE ) ?
+                      MacCtx.NvmCtx->MacParams.JoinAcceptDelay1 : MacCtx.NvmCtx->MacParams.ReceiveDelay1;
+            break;
+        case RX_SLOT_WIN_2:
+            rxDelay = ( MacCtx.NvmCtx->NetworkActivation == ACTIVATION_TYPE_NONE ) ?
+                      MacCtx.NvmCtx->MacParams.JoinAcceptDelay2 : MacCtx.NvmCtx->MacParams.ReceiveDelay2;
+            break;
+        default:
+            return;
+    }
+
+    // Downlinks are sent without payload CRC
+    timeOnAir = LoRaMacAirtimeGetPhyTimeOnAir( MacCtx.McpsIndication.RxDatarate, size, false );
+    if( timeOnAir == 0 )
+    {
+        return;
+    }
+
+    LoRaMacClockErrorRxObservation( ( int32_t )( RxDoneParams.LastRxDone - TxDoneParams.CurTime ) -
+                                    ( int32_t )( rxDelay + timeOnAir ) );
+}
+
 static void ProcessRadioRxDone( void )
 {
     LoRaMacHeader_t macHdr;
@@ -1040,10 +1125,10 @@ static void ProcessRadioRxDone( void )
 
             if( LORAMAC_CRYPTO_SUCCESS == macCryptoStatus )
             {
+                ObserveRxArrival( size );
+
                 // Network ID
-                MacCtx.NvmCtx->NetID = ( uint32_t ) macMsgJoinAccept.NetID[0];
-                MacCtx.NvmCtx->NetID |= ( ( uint32_t ) macMsgJoinAccept.NetID[1] << 8 );
-                MacCtx.NvmCtx->NetID |= ( ( uint32_t ) macMsgJoinAccept.NetID[2] << 16 );
+                MacCtx.NvmCtx->NetID = LoRaMacFrameViewGetUint24( macMsgJoinAccept.NetID );
 
                 // Device Address
                 MacCtx.NvmCtx->DevAddr = macMsgJoinAccept.DevAddr;
@@ -1070,8 +1155,11 @@ static void ProcessRadioRxDone( void )
                 applyCFList.Size = size - 17;
 
                 RegionApplyCFList( MacCtx.NvmCtx->Region, &applyCFList );
+                RegionOnJoinAccept( MacCtx.NvmCtx->Region );
+                EventRegionNvmCtxChanged( );
 
                 MacCtx.NvmCtx->NetworkActivation = ACTIVATION_TYPE_OTAA;
+                FlightRecorder_Record( FLIGHT_EVENT_JOIN_ACCEPT, 0 );
 
                 // MLME handling
                 if( LoRaMacConfirmQueueIsCmdActive( MLME_JOIN ) == true )
@@ -1111,10 +1199,9 @@ static void ProcessRadioRxDone( void )
                 PrepareRxDoneAbort( );
                 return;
             }
+            // Parsed and decrypted in place, see RxIndicationBuffer for the indication
             macMsgData.Buffer = payload;
             macMsgData.BufSize = size;
-            macMsgData.FRMPayload = MacCtx.RxPayload;
-            macMsgData.FRMPayloadSize = LORAMAC_PHY_MAXPAYLOAD;
 
             if( LORAMAC_PARSER_SUCCESS != LoRaMacParserData( &macMsgData ) )
             {
@@ -1214,6 +1301,7 @@ static void ProcessRadioRxDone( void )
             }
 
             // Frame is valid
+            ObserveRxArrival( size );
             MacCtx.McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_OK;
             MacCtx.McpsIndication.Multicast = multicast;
             MacCtx.McpsIndication.FramePending = macMsgData.FHDR.FCtrl.Bits.FPending;
@@ -1230,6 +1318,7 @@ static void ProcessRadioRxDone( void )
                 ( MacCtx.McpsIndication.RxSlot == RX_SLOT_WIN_2 ) )
             {
                 MacCtx.NvmCtx->AdrAckCounter = 0;
+                LoRaMacTxPowerCtrlDownlink( MacCtx.McpsIndication.RxDatarate, MacCtx.McpsIndication.Snr );
             }
 
             // MCPS Indication and ack requested handling
@@ -1270,7 +1359,7 @@ static void ProcessRadioRxDone( void )
                     // Decode MAC commands in FOpts field
                     ProcessMacCommands( macMsgData.FHDR.FOpts, 0, macMsgData.FHDR.FCtrl.Bits.FOptsLen, snr, MacCtx.McpsIndication.RxSlot );
                     MacCtx.McpsIndication.Port = macMsgData.FPort;
-                    MacCtx.McpsIndication.Buffer = macMsgData.FRMPayload;
+                    MacCtx.McpsIndication.Buffer = RxIndicationBuffer( macMsgData.FRMPayload, macMsgData.FRMPayloadSize );
                     MacCtx.McpsIndication.BufferSize = macMsgData.FRMPayloadSize;
                     MacCtx.McpsIndication.RxData = true;
                     break;
@@ -1311,7 +1400,7 @@ static void ProcessRadioRxDone( void )
 
                     // No MAC commands just application payload
                     MacCtx.McpsIndication.Port = macMsgData.FPort;
-                    MacCtx.McpsIndication.Buffer = macMsgData.FRMPayload;
+                    MacCtx.McpsIndication.Buffer = RxIndicationBuffer( macMsgData.FRMPayload, macMsgData.FRMPayloadSize );
                     MacCtx.McpsIndication.BufferSize = macMsgData.FRMPayloadSize;
                     MacCtx.McpsIndication.RxData = true;
                     break;
@@ -1328,11 +1417,9 @@ static void ProcessRadioRxDone( void )
 
             break;
         case FRAME_TYPE_PROPRIETARY:
-            memcpy1( MacCtx.RxPayload, &payload[pktHeaderLen], size - pktHeaderLen );
-
             MacCtx.McpsIndication.McpsIndication = MCPS_PROPRIETARY;
             MacCtx.McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_OK;
-            MacCtx.McpsIndication.Buffer = MacCtx.RxPayload;
+            MacCtx.McpsIndication.Buffer = RxIndicationBuffer( &payload[pktHeaderLen], size - pktHeaderLen );
             MacCtx.McpsIndication.BufferSize = size - pktHeaderLen;
 
             MacCtx.MacFlags.Bits.McpsInd = 1;
@@ -1452,6 +1539,12 @@ static void ProcessRadioRxError( void )
 
 static void ProcessRadioRxTimeout( void )
 {
+    // RX2 closes the class A windows, the acknowledgement expected from the
+    // network never came. The RX1 window may be silent because of an RX2 downlink.
+    if( ( MacCtx.RxSlot == RX_SLOT_WIN_2 ) && ( MacCtx.NodeAckRequested == true ) )
+    {
+        LoRaMacClockErrorRxMiss( );
+    }
     HandleRadioRxErrorTimeout( LORAMAC_EVENT_INFO_STATUS_RX1_TIMEOUT, LORAMAC_EVENT_INFO_STATUS_RX2_TIMEOUT );
 }
 
@@ -1592,12 +1685,14 @@ static void LoRaMacHandleMcpsRequest( void )
             ( MacCtx.McpsConfirm.McpsRequest == MCPS_PROPRIETARY ) )
         {
             stopRetransmission = CheckRetransUnconfirmedUplink( );
+            LoRaMacTxPowerCtrlUplinkDone( false, false );
         }
         else if( MacCtx.McpsConfirm.McpsRequest == MCPS_CONFIRMED )
         {
             if( MacCtx.AckTimeoutRetry == true )
             {
                 stopRetransmission = CheckRetransConfirmedUplink( );
+                LoRaMacTxPowerCtrlUplinkDone( true, MacCtx.McpsConfirm.AckReceived );
 
                 if( MacCtx.NvmCtx->Version.Fields.Minor == 0 )
                 {
@@ -1950,12 +2045,15 @@ static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t comm
         {
             case SRV_MAC_LINK_CHECK_ANS:
             {
+                // Also answers the LinkCheckReq of the TX power control
+                LoRaMacTxPowerCtrlLinkCheckAns( payload[macIndex] );
                 if( LoRaMacConfirmQueueIsCmdActive( MLME_LINK_CHECK ) == true )
                 {
                     LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_LINK_CHECK );
-                    MacCtx.MlmeConfirm.DemodMargin = payload[macIndex++];
-                    MacCtx.MlmeConfirm.NbGateways = payload[macIndex++];
+                    MacCtx.MlmeConfirm.DemodMargin = payload[macIndex];
+                    MacCtx.MlmeConfirm.NbGateways = payload[macIndex + 1];
                 }
+                macIndex += 2;
                 break;
             }
             case SRV_MAC_LINK_ADR_REQ:
@@ -1986,6 +2084,10 @@ static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t comm
 
                     if( ( status & 0x07 ) == 0x07 )
                     {
+                        if( linkAdrTxPower != MacCtx.NvmCtx->MacParams.ChannelsTxPower )
+                        {
+                            LoRaMacTxPowerCtrlReset( );
+                        }
                         MacCtx.NvmCtx->MacParams.ChannelsDatarate = linkAdrDatarate;
                         MacCtx.NvmCtx->MacParams.ChannelsTxPower = linkAdrTxPower;
                         MacCtx.NvmCtx->MacParams.ChannelsNbTrans = linkAdrNbRep;
@@ -2152,6 +2254,8 @@ static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t comm
                     SysTime_t gpsEpochTime = { 0 };
                     SysTime_t sysTime = { 0 };
                     SysTime_t sysTimeCurrent = { 0 };
+                    SysTime_t sysTimeCorrection = { 0 };
+                    int32_t correction = INT32_MAX;
 
                     gpsEpochTime.Seconds = ( uint32_t )payload[macIndex++];
                     gpsEpochTime.Seconds |= ( uint32_t )payload[macIndex++] << 8;
@@ -2172,6 +2276,15 @@ static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t comm
                     sysTimeCurrent = SysTimeGet( );
                     sysTime = SysTimeAdd( sysTimeCurrent, SysTimeSub( sysTime, MacCtx.LastTxSysTime ) );
 
+                    // Let the clock error model calibrate the LSE frequency offset
+                    sysTimeCorrection = SysTimeSub( sysTime, sysTimeCurrent );
+                    if( ( ( int32_t )sysTimeCorrection.Seconds > -( INT32_MAX / 1000 ) ) &&
+                        ( ( int32_t )sysTimeCorrection.Seconds < ( INT32_MAX / 1000 ) ) )
+                    {
+                        correction = ( ( int32_t )sysTimeCorrection.Seconds * 1000 ) + sysTimeCorrection.SubSeconds;
+                    }
+                    LoRaMacClockErrorDeviceTimeAns( correction );
+
                     // Apply the new system time.
                     SysTimeSet( sysTime );
                     LoRaMacClassBDeviceTimeAns( );
@@ -2400,6 +2513,21 @@ static LoRaMacStatus_t CheckForClassBCollision( void )
 
 static void ComputeRxWindowParameters( void )
 {
+    uint32_t rxDelay1 = MacCtx.NvmCtx->MacParams.ReceiveDelay1;
+    uint32_t rxDelay2 = MacCtx.NvmCtx->MacParams.ReceiveDelay2;
+
+    if( MacCtx.NvmCtx->NetworkActivation == ACTIVATION_TYPE_NONE )
+    {
+        rxDelay1 = MacCtx.NvmCtx->MacParams.JoinAcceptDelay1;
+        rxDelay2 = MacCtx.NvmCtx->MacParams.JoinAcceptDelay2;
+    }
+
+    // Feed the clock error model with the current board temperature
+    if( ( MacCtx.MacCallbacks != NULL ) && ( MacCtx.MacCallbacks->GetTemperatureLevel != NULL ) )
+    {
+        LoRaMacClockErrorSetTemperature( ( float )( int16_t )MacCtx.MacCallbacks->GetTemperatureLevel( ) );
+    }
+
     // Compute Rx1 windows parameters
     RegionComputeRxWindowParameters( MacCtx.NvmCtx->Region,
                                      RegionApplyDrOffset( MacCtx.NvmCtx->Region,
@@ -2407,24 +2535,17 @@ static void ComputeRxWindowParameters( void )
                                                           MacCtx.NvmCtx->MacParams.ChannelsDatarate,
                                                           MacCtx.NvmCtx->MacParams.Rx1DrOffset ),
                                      MacCtx.NvmCtx->MacParams.MinRxSymbols,
-                                     MacCtx.NvmCtx->MacParams.SystemMaxRxError,
+                                     LoRaMacClockErrorGetRxError( rxDelay1, MacCtx.NvmCtx->MacParams.SystemMaxRxError ),
                                      &MacCtx.RxWindow1Config );
     // Compute Rx2 windows parameters
     RegionComputeRxWindowParameters( MacCtx.NvmCtx->Region,
                                      MacCtx.NvmCtx->MacParams.Rx2Channel.Datarate,
                                      MacCtx.NvmCtx->MacParams.MinRxSymbols,
-                                     MacCtx.NvmCtx->MacParams.SystemMaxRxError,
+                                     LoRaMacClockErrorGetRxError( rxDelay2, MacCtx.NvmCtx->MacParams.SystemMaxRxError ),
                                      &MacCtx.RxWindow2Config );
 
-    // Default setup, in case the device joined
-    MacCtx.RxWindow1Delay = MacCtx.NvmCtx->MacParams.ReceiveDelay1 + MacCtx.RxWindow1Config.WindowOffset;
-    MacCtx.RxWindow2Delay = MacCtx.NvmCtx->MacParams.ReceiveDelay2 + MacCtx.RxWindow2Config.WindowOffset;
-
-    if( MacCtx.NvmCtx->NetworkActivation == ACTIVATION_TYPE_NONE )
-    {
-        MacCtx.RxWindow1Delay = MacCtx.NvmCtx->MacParams.JoinAcceptDelay1 + MacCtx.RxWindow1Config.WindowOffset;
-        MacCtx.RxWindow2Delay = MacCtx.NvmCtx->MacParams.JoinAcceptDelay2 + MacCtx.RxWindow2Config.WindowOffset;
-    }
+    MacCtx.RxWindow1Delay = rxDelay1 + MacCtx.RxWindow1Config.WindowOffset;
+    MacCtx.RxWindow2Delay = rxDelay2 + MacCtx.RxWindow2Config.WindowOffset;
 }
 
 static LoRaMacStatus_t VerifyTxFrame( void )
@@ -2458,9 +2579,11 @@ static LoRaMacStatus_t SerializeTxFrame( void )
             {
                 return LORAMAC_STATUS_CRYPTO_ERROR;
             }
+            MacCtx.PktBufferOffset = 0;
             MacCtx.PktBufferLen = MacCtx.TxMsg.Message.JoinReq.BufSize;
             break;
         case LORAMAC_MSG_TYPE_DATA:
+            PlaceDataFrame( );
             serializeStatus = LoRaMacSerializerData( &MacCtx.TxMsg.Message.Data );
             if( LORAMAC_SERIALIZER_SUCCESS != serializeStatus )
             {
@@ -2565,6 +2688,7 @@ static LoRaMacStatus_t SecureFrame( uint8_t txDr, uint8_t txCh )
             {
                 return LORAMAC_STATUS_CRYPTO_ERROR;
             }
+            MacCtx.PktBufferOffset = 0;
             MacCtx.PktBufferLen = MacCtx.TxMsg.Message.JoinReq.BufSize;
             break;
         case LORAMAC_MSG_TYPE_DATA:
@@ -2579,6 +2703,7 @@ static LoRaMacStatus_t SecureFrame( uint8_t txDr, uint8_t txCh )
                 fCntUp -= 1;
             }
 
+            PlaceDataFrame( );
             macCryptoStatus = LoRaMacCryptoSecureMessage( fCntUp, txDr, txCh, &MacCtx.TxMsg.Message.Data );
             if( LORAMAC_CRYPTO_SUCCESS != macCryptoStatus )
             {
@@ -2693,6 +2818,7 @@ static void RxWindowSetup( TimerEvent_t* rxTimer, RxConfigParams_t* rxConfig )
 
     if( RegionRxConfig( MacCtx.NvmCtx->Region, rxConfig, ( int8_t* )&MacCtx.McpsIndication.RxDatarate ) == true )
     {
+        FlightRecorder_Record( FLIGHT_EVENT_RX_START, rxConfig->RxSlot );
         Radio.Rx( MacCtx.NvmCtx->MacParams.MaxRxWindow );
         MacCtx.RxSlot = rxConfig->RxSlot;
     }
@@ -2715,7 +2841,11 @@ static void OpenContinuousRxCWindow( void )
     // Thus, there is no need to set the radio in standby mode.
     if( RegionRxConfig( MacCtx.NvmCtx->Region, &MacCtx.RxWindowCConfig, ( int8_t* )&MacCtx.McpsIndication.RxDatarate ) == true )
     {
+#if ( LORAMAC_CLASSC_SNIFF_PREAMBLE > 0 )
+        Radio.RxSniff( LORAMAC_CLASSC_SNIFF_PREAMBLE ); // Duty cycled, restarted after each reception
+#else
         Radio.Rx( 0 ); // Continuous mode
+#endif
         MacCtx.RxSlot = MacCtx.RxWindowCConfig.RxSlot;
     }
 }
@@ -2723,17 +2853,18 @@ static void OpenContinuousRxCWindow( void )
 static LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t* fCtrl, uint8_t fPort, void* fBuffer, uint16_t fBufferSize )
 {
     MacCtx.PktBufferLen = 0;
+    MacCtx.PktBufferOffset = 0;
     MacCtx.NodeAckRequested = false;
     uint32_t fCntUp = 0;
     size_t macCmdsSize = 0;
     uint8_t availableSize = 0;
+    uint8_t* appData = MacCtx.PktBuffer + LORAMAC_TX_HEADROOM;
 
     if( fBuffer == NULL )
     {
         fBufferSize = 0;
     }
 
-    memcpy1( MacCtx.AppData, ( uint8_t* ) fBuffer, fBufferSize );
     MacCtx.AppDataSize = fBufferSize;
     MacCtx.PktBuffer[0] = macHdr->Value;
 
@@ -2743,15 +2874,21 @@ static LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t
             MacCtx.NodeAckRequested = true;
             // Intentional fall through
         case FRAME_TYPE_DATA_UNCONFIRMED_UP:
+            // Payloads written through LoRaMacReserveTxPayload are already in place
+            if( ( uint8_t* )fBuffer != appData )
+            {
+                memcpy1( appData, ( uint8_t* ) fBuffer, fBufferSize );
+            }
+
             MacCtx.TxMsg.Type = LORAMAC_MSG_TYPE_DATA;
-            MacCtx.TxMsg.Message.Data.Buffer = MacCtx.PktBuffer;
-            MacCtx.TxMsg.Message.Data.BufSize = LORAMAC_PHY_MAXPAYLOAD;
             MacCtx.TxMsg.Message.Data.MHDR.Value = macHdr->Value;
             MacCtx.TxMsg.Message.Data.FPort = fPort;
             MacCtx.TxMsg.Message.Data.FHDR.DevAddr = MacCtx.NvmCtx->DevAddr;
             MacCtx.TxMsg.Message.Data.FHDR.FCtrl.Value = fCtrl->Value;
             MacCtx.TxMsg.Message.Data.FRMPayloadSize = MacCtx.AppDataSize;
-            MacCtx.TxMsg.Message.Data.FRMPayload = MacCtx.AppData;
+            MacCtx.TxMsg.Message.Data.FRMPayload = appData;
+            // The FOpts end right in front of the FPort
+            MacCtx.TxMsg.Message.Data.FHDR.FOpts = appData - LORAMAC_F_PORT_FIELD_SIZE;
 
             if( LORAMAC_CRYPTO_SUCCESS != LoRaMacCryptoGetFCntUp( &fCntUp ) )
             {
@@ -2777,6 +2914,8 @@ static LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t
                 // There is application payload available and the MAC commands fit into FOpts field.
                 if( ( MacCtx.AppDataSize > 0 ) && ( macCmdsSize <= LORA_MAC_COMMAND_MAX_FOPTS_LENGTH ) )
                 {
+                    // All of them fit, serialized straight into the frame
+                    MacCtx.TxMsg.Message.Data.FHDR.FOpts -= macCmdsSize;
                     if( LoRaMacCommandsSerializeCmds( LORA_MAC_COMMAND_MAX_FOPTS_LENGTH, &macCmdsSize, MacCtx.TxMsg.Message.Data.FHDR.FOpts ) != LORAMAC_COMMANDS_SUCCESS )
                     {
                         return LORAMAC_STATUS_MAC_COMMAD_ERROR;
@@ -2814,6 +2953,7 @@ static LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t
         case FRAME_TYPE_PROPRIETARY:
             if( ( fBuffer != NULL ) && ( MacCtx.AppDataSize > 0 ) )
             {
+                // memcpy1 copies upwards, a reserved payload may be moved down in place
                 memcpy1( MacCtx.PktBuffer + LORAMAC_MHDR_FIELD_SIZE, ( uint8_t* ) fBuffer, MacCtx.AppDataSize );
                 MacCtx.PktBufferLen = LORAMAC_MHDR_FIELD_SIZE + MacCtx.AppDataSize;
             }
@@ -2825,6 +2965,23 @@ static LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t
     return LORAMAC_STATUS_OK;
 }
 
+static void PlaceDataFrame( void )
+{
+    LoRaMacMessageData_t* macMsg = &MacCtx.TxMsg.Message.Data;
+    uint16_t headerSize = LORAMAC_MHDR_FIELD_SIZE + LORAMAC_FHDR_DEV_ADDR_FIELD_SIZE +
+                          LORAMAC_FHDR_F_CTRL_FIELD_SIZE + LORAMAC_FHDR_F_CNT_FIELD_SIZE +
+                          macMsg->FHDR.FCtrl.Bits.FOptsLen;
+
+    if( macMsg->FRMPayloadSize > 0 )
+    {
+        headerSize += LORAMAC_F_PORT_FIELD_SIZE;
+    }
+
+    MacCtx.PktBufferOffset = LORAMAC_TX_HEADROOM - headerSize;
+    macMsg->Buffer = MacCtx.PktBuffer + MacCtx.PktBufferOffset;
+    macMsg->BufSize = sizeof( MacCtx.PktBuffer ) - MacCtx.PktBufferOffset;
+}
+
 static LoRaMacStatus_t SendFrameOnChannel( uint8_t channel )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_PARAMETER_INVALID;
@@ -2834,6 +2991,10 @@ static LoRaMacStatus_t SendFrameOnChannel( uint8_t channel )
     txConfig.Channel = channel;
     txConfig.Datarate = MacCtx.NvmCtx->MacParams.ChannelsDatarate;
     txConfig.TxPower = MacCtx.NvmCtx->MacParams.ChannelsTxPower;
+    if( MacCtx.NvmCtx->NetworkActivation != ACTIVATION_TYPE_NONE )
+    {
+        txConfig.TxPower = LoRaMacTxPowerCtrlApply( txConfig.TxPower, MacCtx.NvmCtx->AdrCtrlOn );
+    }
     txConfig.MaxEirp = MacCtx.NvmCtx->MacParams.MaxEirp;
     txConfig.AntennaGain = MacCtx.NvmCtx->MacParams.AntennaGain;
     txConfig.PktLen = MacCtx.PktBufferLen;
@@ -2882,8 +3043,13 @@ static LoRaMacStatus_t SendFrameOnChannel( uint8_t channel )
         MacCtx.ChannelsNbTransCounter++;
     }
 
+    LoRaMacAirtimeRecordTx( channel, MacCtx.NvmCtx->MacParams.ChannelsDatarate,
+                            RegionCommonComputeTxPower( txPower, MacCtx.NvmCtx->MacParams.MaxEirp, MacCtx.NvmCtx->MacParams.AntennaGain ),
+                            MacCtx.TxTimeOnAir );
+
     // Send now
-    Radio.Send( MacCtx.PktBuffer, MacCtx.PktBufferLen );
+    FlightRecorder_Record( FLIGHT_EVENT_TX_START, MacCtx.PktBufferLen );
+    Radio.Send( MacCtx.PktBuffer + MacCtx.PktBufferOffset, MacCtx.PktBufferLen );
 
     return LORAMAC_STATUS_OK;
 }
@@ -3266,6 +3432,15 @@ LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t* primitives, LoRaMacC
     // Confirm queue reset
     LoRaMacConfirmQueueInit( primitives, EventConfirmQueueNvmCtxChanged );
 
+    // Airtime accounting reset
+    LoRaMacAirtimeInit( region );
+
+    // RX window clock error model reset
+    LoRaMacClockErrorInit( );
+
+    // TX power control reset
+    LoRaMacTxPowerCtrlInit( region );
+
     // Initialize the module context with zeros
     memset1( ( uint8_t* ) &NvmMacCtx, 0x00, sizeof( LoRaMacNvmCtx_t ) );
     memset1( ( uint8_t* ) &MacCtx, 0x00, sizeof( LoRaMacCtx_t ) );
@@ -3478,6 +3653,24 @@ LoRaMacStatus_t LoRaMacStop( void )
     return LORAMAC_STATUS_BUSY;
 }
 
+LoRaMacStatus_t LoRaMacReserveTxPayload( uint8_t** buffer, uint8_t* size )
+{
+    if( ( buffer == NULL ) || ( size == NULL ) )
+    {
+        return LORAMAC_STATUS_PARAMETER_INVALID;
+    }
+
+    // The buffer holds the frame until the transmission is done
+    if( LoRaMacIsBusy( ) == true )
+    {
+        return LORAMAC_STATUS_BUSY;
+    }
+
+    *buffer = MacCtx.PktBuffer + LORAMAC_TX_HEADROOM;
+    *size = LORAMAC_PHY_MAXPAYLOAD - LORAMAC_MIC_FIELD_SIZE;
+    return LORAMAC_STATUS_OK;
+}
+
 LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t* txInfo )
 {
     CalcNextAdrParams_t adrNext;
@@ -4654,6 +4847,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest )
 
             queueElement.Status = LORAMAC_EVENT_INFO_STATUS_JOIN_FAIL;
 
+            FlightRecorder_Record( FLIGHT_EVENT_JOIN_REQUEST, MacCtx.NvmCtx->MacParams.ChannelsDatarate );
             status = SendReJoinReq( JOIN_REQ );
 
             if( status != LORAMAC_STATUS_OK )
@@ -4858,6 +5052,18 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t* mcpsRequest, bool allowDelayedTx
             }
         }
 
+        if( LoRaMacTxPowerCtrlIsLinkCheckNeeded( ) == true )
+        {
+            LoRaMacTxInfo_t txInfo;
+            uint8_t linkCheckPayload[1];
+
+            // Piggyback a LinkCheckReq only if it does not push the payload out
+            if( LoRaMacQueryTxPossible( fBufferSize + 1, &txInfo ) == LORAMAC_STATUS_OK )
+            {
+                LoRaMacCommandsAddCmd( MOTE_MAC_LINK_CHECK_REQ, linkCheckPayload, 0 );
+            }
+        }
+
         status = Send( &macHdr, fPort, fBuffer, fBufferSize, allowDelayedTx );
         if( status == LORAMAC_STATUS_OK )
         {
@@ -2512,6 +2512,28 @@ bool LoRaMacIsBusy( void );
  */
 void LoRaMacProcess( void );
 
+/*!
+ * \brief   Reserves the application payload area of the next uplink frame.
+ *
+ * \details The application writes its payload directly into the returned
+ *          buffer and passes it as fBuffer of the next \ref LoRaMacMcpsRequest.
+ *          The MAC then encrypts it in place and serializes the frame header
+ *          in front of it, the frame is handed to the radio without any
+ *          further copy. The buffer belongs to the MAC again once the request
+ *          was issued.
+ *
+ * \param   [OUT] buffer - Application payload area.
+ *
+ * \param   [OUT] size - Size of the area. The payload size allowed by the
+ *                       current datarate is given by \ref LoRaMacQueryTxPossible.
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. Possible returns are:
+ *          \ref LORAMAC_STATUS_OK,
+ *          \ref LORAMAC_STATUS_BUSY,
+ *          \ref LORAMAC_STATUS_PARAMETER_INVALID.
+ */
+LoRaMacStatus_t LoRaMacReserveTxPayload( uint8_t** buffer, uint8_t* size );
+
 /*!
  * \brief   Queries the LoRaMAC if it is possible to send the next frame with
  *          a given application data payload size. The LoRaMAC takes scheduled
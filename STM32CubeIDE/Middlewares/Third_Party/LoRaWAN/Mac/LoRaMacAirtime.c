@@ -0,0 +1,246 @@
+/*!
+ * \file      LoRaMacAirtime.c
+ *
+ * \brief     LoRa MAC airtime and TX energy accounting
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "radio.h"
+#include "radio_board_if.h"
+#include "utilities.h"
+#include "LoRaMacHeaderTypes.h"
+#include "Region.h"
+#include "RegionTimeOnAir.h"
+#include "LoRaMacAirtime.h"
+
+/*
+ * Airtime counters of one channel or datarate
+ *
+ * The last hour is approximated with two fixed one hour buckets: the
+ * previous bucket is weighted with the part of it which still lies within
+ * the sliding window.
+ */
+typedef struct sLoRaMacAirtimeCounter
+{
+    /*!
+     * Airtime in ms since initialization
+     */
+    uint32_t Airtime;
+    /*!
+     * Airtime in ms accounted in the current bucket
+     */
+    uint32_t CurrentBucket;
+    /*!
+     * Airtime in ms accounted in the previous bucket
+     */
+    uint32_t PreviousBucket;
+    /*!
+     * Number of frames sent
+     */
+    uint32_t NbFrames;
+    /*!
+     * Estimated TX energy in uJ
+     */
+    uint64_t Energy;
+}LoRaMacAirtimeCounter_t;
+
+/*
+ * Module context
+ */
+typedef struct sLoRaMacAirtimeCtx
+{
+    /*!
+     * Active region
+     */
+    LoRaMacRegion_t Region;
+    /*!
+     * Start time of the current bucket
+     */
+    TimerTime_t BucketStart;
+    /*!
+     * Per channel counters
+     */
+    LoRaMacAirtimeCounter_t Channels[LORAMAC_AIRTIME_MAX_NB_CHANNELS];
+    /*!
+     * Per datarate counters
+     */
+    LoRaMacAirtimeCounter_t Datarates[LORAMAC_AIRTIME_NB_DATARATES];
+    /*!
+     * Device counters
+     */
+    LoRaMacAirtimeCounter_t Total;
+}LoRaMacAirtimeCtx_t;
+
+/*
+ * Module context.
+ */
+static LoRaMacAirtimeCtx_t Ctx;
+
+static void ShiftBucket( LoRaMacAirtimeCounter_t* counter, uint32_t nbBuckets )
+{
+    if( nbBuckets == 1 )
+    {
+        counter->PreviousBucket = counter->CurrentBucket;
+    }
+    else
+    {
+        counter->PreviousBucket = 0;
+    }
+    counter->CurrentBucket = 0;
+}
+
+/*!
+ * Moves the buckets forward if the current one is older than the window.
+ *
+ * \retval Time elapsed since the start of the current bucket
+ */
+static TimerTime_t UpdateBuckets( void )
+{
+    TimerTime_t elapsed = TimerGetElapsedTime( Ctx.BucketStart );
+    uint32_t nbBuckets;
+
+    if( elapsed < LORAMAC_AIRTIME_WINDOW )
+    {
+        return elapsed;
+    }
+
+    nbBuckets = elapsed / LORAMAC_AIRTIME_WINDOW;
+    for( uint8_t i = 0; i < LORAMAC_AIRTIME_MAX_NB_CHANNELS; i++ )
+    {
+        ShiftBucket( &Ctx.Channels[i], nbBuckets );
+    }
+    for( uint8_t i = 0; i < LORAMAC_AIRTIME_NB_DATARATES; i++ )
+    {
+        ShiftBucket( &Ctx.Datarates[i], nbBuckets );
+    }
+    ShiftBucket( &Ctx.Total, nbBuckets );
+
+    Ctx.BucketStart += nbBuckets * LORAMAC_AIRTIME_WINDOW;
+    return elapsed - ( nbBuckets * LORAMAC_AIRTIME_WINDOW );
+}
+
+static void Account( LoRaMacAirtimeCounter_t* counter, TimerTime_t timeOnAir, uint32_t energy )
+{
+    counter->Airtime += timeOnAir;
+    counter->CurrentBucket += timeOnAir;
+    counter->NbFrames++;
+    counter->Energy += energy;
+}
+
+static void GetStats( const LoRaMacAirtimeCounter_t* counter, LoRaMacAirtimeStats_t* stats )
+{
+    TimerTime_t elapsed;
+
+    if( stats == NULL )
+    {
+        return;
+    }
+
+    elapsed = UpdateBuckets( );
+
+    stats->Airtime = counter->Airtime;
+    stats->HourAirtime = counter->CurrentBucket +
+        ( uint32_t )( ( ( uint64_t )counter->PreviousBucket * ( LORAMAC_AIRTIME_WINDOW - elapsed ) ) / LORAMAC_AIRTIME_WINDOW );
+    stats->NbFrames = counter->NbFrames;
+    stats->Energy = counter->Energy;
+}
+
+void LoRaMacAirtimeInit( LoRaMacRegion_t region )
+{
+    memset1( ( uint8_t* ) &Ctx, 0, sizeof( Ctx ) );
+    Ctx.Region = region;
+    Ctx.BucketStart = TimerGetCurrentTime( );
+}
+
+void LoRaMacAirtimeRecordTx( uint8_t channel, int8_t datarate, int8_t txPower, TimerTime_t timeOnAir )
+{
+    uint32_t energy = LoRaMacAirtimeEstimateEnergy( txPower, timeOnAir );
+
+    UpdateBuckets( );
+
+    if( channel < LORAMAC_AIRTIME_MAX_NB_CHANNELS )
+    {
+        Account( &Ctx.Channels[channel], timeOnAir, energy );
+    }
+    if( ( datarate >= 0 ) && ( datarate < LORAMAC_AIRTIME_NB_DATARATES ) )
+    {
+        Account( &Ctx.Datarates[datarate], timeOnAir, energy );
+    }
+    Account( &Ctx.Total, timeOnAir, energy );
+}
+
+void LoRaMacAirtimeGetChannelStats( uint8_t channel, LoRaMacAirtimeStats_t* stats )
+{
+    static const LoRaMacAirtimeCounter_t unknown = { 0 };
+
+    GetStats( ( channel < LORAMAC_AIRTIME_MAX_NB_CHANNELS ) ? &Ctx.Channels[channel] : &unknown, stats );
+}
+
+void LoRaMacAirtimeGetDatarateStats( int8_t datarate, LoRaMacAirtimeStats_t* stats )
+{
+    static const LoRaMacAirtimeCounter_t unknown = { 0 };
+
+    GetStats( ( ( datarate >= 0 ) && ( datarate < LORAMAC_AIRTIME_NB_DATARATES ) ) ? &Ctx.Datarates[datarate] : &unknown, stats );
+}
+
+void LoRaMacAirtimeGetTotalStats( LoRaMacAirtimeStats_t* stats )
+{
+    GetStats( &Ctx.Total, stats );
+}
+
+TimerTime_t LoRaMacAirtimeGetTimeOnAir( int8_t datarate, uint8_t appPayloadSize )
+{
+    return LoRaMacAirtimeGetPhyTimeOnAir( datarate, ( uint16_t )appPayloadSize + LORAMAC_FRAME_PAYLOAD_OVERHEAD_SIZE, true );
+}
+
+TimerTime_t LoRaMacAirtimeGetPhyTimeOnAir( int8_t datarate, uint16_t pktLen, bool crcOn )
+{
+    GetPhyParams_t getPhy;
+    uint32_t phyDr;
+    uint32_t bandwidth;
+
+    switch( Ctx.Region )
+    {
+#if defined( REGION_US915 )
+        case LORAMAC_REGION_US915:
+            return RegionUS915TimeOnAir( datarate, pktLen, crcOn, false );
+#endif
+        default:
+            break;
+    }
+
+    // Regions without table, computed by the radio from the regional datarate
+    if( ( datarate < 0 ) || ( datarate >= LORAMAC_AIRTIME_NB_DATARATES ) )
+    {
+        return 0;
+    }
+    getPhy.Datarate = datarate;
+    getPhy.Attribute = PHY_SF_FROM_DR;
+    phyDr = RegionGetPhyParam( Ctx.Region, &getPhy ).Value;
+    getPhy.Attribute = PHY_BW_FROM_DR;
+    bandwidth = RegionGetPhyParam( Ctx.Region, &getPhy ).Value;
+
+    if( phyDr == 0 )
+    {
+        // RFU datarate
+        return 0;
+    }
+    if( phyDr > 12 )
+    {
+        // FSK, the regional table holds the bitrate in kbps
+        return Radio.TimeOnAir( MODEM_FSK, bandwidth, phyDr * 1000, 0, 5, false, pktLen, crcOn );
+    }
+    return Radio.TimeOnAir( MODEM_LORA, bandwidth, phyDr, 1, 8, false, pktLen, crcOn );
+}
+
+uint32_t LoRaMacAirtimeEstimateEnergy( int8_t txPower, TimerTime_t timeOnAir )
+{
+    uint64_t energy = ( uint64_t )RBI_GetTxCurrent( txPower ) * RBI_GetSupplyVoltage( ) * timeOnAir;
+
+    // uA * mV * ms = 1e-12 J
+    return ( uint32_t )( energy / 1000000U );
+}
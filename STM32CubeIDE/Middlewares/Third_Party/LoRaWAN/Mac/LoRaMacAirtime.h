@@ -0,0 +1,164 @@
+/*!
+ * \file      LoRaMacAirtime.h
+ *
+ * \brief     LoRa MAC airtime and TX energy accounting
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \defgroup  LORAMACAIRTIME LoRa MAC airtime accounting
+ *            Keeps track of the airtime spent per channel and per datarate,
+ *            cumulative and over the last hour, together with an estimate of
+ *            the TX energy derived from the configured output power. The
+ *            application can use the statistics and the time-on-air lookup
+ *            to plan transmissions against an airtime or energy budget
+ *            before handing a frame to the MAC.
+ * \{
+ */
+#ifndef __LORAMAC_AIRTIME_H__
+#define __LORAMAC_AIRTIME_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "timer.h"
+#include "LoRaMac.h"
+
+/*!
+ * Maximum number of channels tracked by the accounting
+ */
+#if defined( REGION_CN470 )
+#define LORAMAC_AIRTIME_MAX_NB_CHANNELS             96
+#else
+#define LORAMAC_AIRTIME_MAX_NB_CHANNELS             72
+#endif
+
+/*!
+ * Number of datarates tracked by the accounting
+ */
+#define LORAMAC_AIRTIME_NB_DATARATES                16
+
+/*!
+ * Length of the sliding accounting window in ms
+ */
+#define LORAMAC_AIRTIME_WINDOW                      3600000U
+
+/*!
+ * Airtime statistics of a channel, a datarate or of the whole device
+ */
+typedef struct sLoRaMacAirtimeStats
+{
+    /*!
+     * Airtime in ms since the accounting was initialized
+     */
+    uint32_t Airtime;
+    /*!
+     * Airtime in ms spent within the last hour
+     */
+    uint32_t HourAirtime;
+    /*!
+     * Number of frames sent
+     */
+    uint32_t NbFrames;
+    /*!
+     * Estimated TX energy in uJ since the accounting was initialized
+     */
+    uint64_t Energy;
+}LoRaMacAirtimeStats_t;
+
+/*!
+ * \brief   Initializes the airtime accounting and clears all statistics.
+ *
+ * \param   [IN] region - Active region, used by \ref LoRaMacAirtimeGetTimeOnAir.
+ */
+void LoRaMacAirtimeInit( LoRaMacRegion_t region );
+
+/*!
+ * \brief   Accounts a transmission. Called by the MAC each time a frame is
+ *          handed to the radio.
+ *
+ * \param   [IN] channel - Channel index.
+ *
+ * \param   [IN] datarate - Regional datarate.
+ *
+ * \param   [IN] txPower - Physical output power in dBm.
+ *
+ * \param   [IN] timeOnAir - Time-on-air of the frame in ms.
+ */
+void LoRaMacAirtimeRecordTx( uint8_t channel, int8_t datarate, int8_t txPower, TimerTime_t timeOnAir );
+
+/*!
+ * \brief   Returns the statistics of a channel.
+ *
+ * \param   [IN] channel - Channel index.
+ *
+ * \param   [OUT] stats - Statistics of the channel, zeroed for unknown channels.
+ */
+void LoRaMacAirtimeGetChannelStats( uint8_t channel, LoRaMacAirtimeStats_t* stats );
+
+/*!
+ * \brief   Returns the statistics of a datarate.
+ *
+ * \param   [IN] datarate - Regional datarate.
+ *
+ * \param   [OUT] stats - Statistics of the datarate, zeroed for unknown datarates.
+ */
+void LoRaMacAirtimeGetDatarateStats( int8_t datarate, LoRaMacAirtimeStats_t* stats );
+
+/*!
+ * \brief   Returns the statistics over all channels and datarates.
+ *
+ * \param   [OUT] stats - Device statistics.
+ */
+void LoRaMacAirtimeGetTotalStats( LoRaMacAirtimeStats_t* stats );
+
+/*!
+ * \brief   Looks up the time-on-air of an uplink, see
+ *          \ref LoRaMacAirtimeGetPhyTimeOnAir.
+ *
+ * \param   [IN] datarate - Regional datarate.
+ *
+ * \param   [IN] appPayloadSize - Size of the application payload in bytes,
+ *                                MAC header, FPort and MIC are added.
+ *
+ * \retval  Time-on-air in ms, 0 for an RFU datarate.
+ */
+TimerTime_t LoRaMacAirtimeGetTimeOnAir( int8_t datarate, uint8_t appPayloadSize );
+
+/*!
+ * \brief   Looks up the time-on-air of a complete PHY payload with explicit
+ *          header from the precomputed tables. Regions without table are
+ *          computed by Radio.TimeOnAir from their datarate definitions.
+ *
+ * \param   [IN] datarate - Regional datarate.
+ *
+ * \param   [IN] pktLen - PHY payload length in bytes.
+ *
+ * \param   [IN] crcOn - Set to true for uplinks, false for downlinks.
+ *
+ * \retval  Time-on-air in ms, 0 for an RFU datarate.
+ */
+TimerTime_t LoRaMacAirtimeGetPhyTimeOnAir( int8_t datarate, uint16_t pktLen, bool crcOn );
+
+/*!
+ * \brief   Estimates the energy the radio draws for a transmission.
+ *
+ * \param   [IN] txPower - Physical output power in dBm.
+ *
+ * \param   [IN] timeOnAir - Time-on-air in ms.
+ *
+ * \retval  Energy in uJ.
+ */
+uint32_t LoRaMacAirtimeEstimateEnergy( int8_t txPower, TimerTime_t timeOnAir );
+
+#ifdef __cplusplus
+}
+#endif
+
+/*! \} defgroup LORAMACAIRTIME */
+
+#endif // __LORAMAC_AIRTIME_H__
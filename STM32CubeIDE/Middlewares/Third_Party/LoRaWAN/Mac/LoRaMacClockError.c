@@ -0,0 +1,248 @@
+/*!
+ * \file      LoRaMacClockError.c
+ *
+ * \brief     LoRa MAC clock error model for the RX window computation
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "timer.h"
+#include "utilities.h"
+#include "lorawan_conf.h"
+#include "LoRaMacClockError.h"
+
+/*
+ * Fixed point scale of the jitter statistics ( 1/16 ms )
+ */
+#define JITTER_SCALE                                16
+
+/*
+ * Weight of a new observation in the moving averages ( 1/8 )
+ */
+#define JITTER_AVG_SHIFT                            3
+
+/*
+ * Multiple of the mean absolute deviation added to the mean jitter
+ */
+#define JITTER_MAD_FACTOR                           4
+
+/*
+ * Residual frequency error assumed once the offset has been calibrated, in ppm
+ */
+#define CALIBRATED_FREQ_TOLERANCE                   2.0f
+
+/*
+ * Module context
+ */
+typedef struct sLoRaMacClockErrorCtx
+{
+    /*!
+     * Last temperature reported by the application
+     */
+    float Temperature;
+    /*!
+     * Temperature at the time of the last DeviceTimeAns
+     */
+    float SyncTemperature;
+    /*!
+     * Calibrated frequency offset at the turnover temperature in ppm
+     */
+    float FreqOffset;
+    /*!
+     * Set to true once FreqOffset holds a measurement
+     */
+    bool FreqOffsetValid;
+    /*!
+     * Set to true once a DeviceTimeAns set the time reference
+     */
+    bool SyncValid;
+    /*!
+     * MCU time of the last DeviceTimeAns
+     */
+    TimerTime_t SyncTime;
+    /*!
+     * Moving average of the downlink arrival offset in 1/16 ms
+     */
+    int32_t JitterMean;
+    /*!
+     * Moving mean absolute deviation of the arrival offset in 1/16 ms
+     */
+    int32_t JitterMad;
+    /*!
+     * Number of downlink observations
+     */
+    uint16_t NbSamples;
+    /*!
+     * Expected downlinks missed since the last observation
+     */
+    uint8_t NbMisses;
+}LoRaMacClockErrorCtx_t;
+
+/*
+ * Module context.
+ */
+static LoRaMacClockErrorCtx_t Ctx;
+
+/*!
+ * Frequency error of the LSE predicted by the temperature model, in ppm
+ */
+static float TemperatureDrift( float temperature )
+{
+    float delta = temperature - ( float )RTC_TEMP_TURNOVER;
+
+    return ( float )RTC_TEMP_COEFFICIENT * delta * delta;
+}
+
+/*!
+ * Worst case deviation of the temperature model, in ppm
+ */
+static float TemperatureDriftDeviation( float temperature )
+{
+    float delta = temperature - ( float )RTC_TEMP_TURNOVER;
+
+    if( delta < 0.0f )
+    {
+        delta = -delta;
+    }
+    delta += ( float )RTC_TEMP_DEV_TURNOVER;
+
+    return ( float )RTC_TEMP_DEV_COEFFICIENT * delta * delta;
+}
+
+void LoRaMacClockErrorInit( void )
+{
+    memset1( ( uint8_t* ) &Ctx, 0, sizeof( Ctx ) );
+    Ctx.Temperature = ( float )RTC_TEMP_TURNOVER;
+}
+
+void LoRaMacClockErrorSetTemperature( float temperature )
+{
+    Ctx.Temperature = temperature;
+}
+
+void LoRaMacClockErrorRxObservation( int32_t offset )
+{
+    int32_t sample = offset * JITTER_SCALE;
+    int32_t deviation;
+
+    if( Ctx.NbSamples == 0 )
+    {
+        Ctx.JitterMean = sample;
+        Ctx.JitterMad = 0;
+    }
+    else
+    {
+        Ctx.JitterMean += ( sample - Ctx.JitterMean ) / ( 1 << JITTER_AVG_SHIFT );
+        deviation = sample - Ctx.JitterMean;
+        if( deviation < 0 )
+        {
+            deviation = -deviation;
+        }
+        Ctx.JitterMad += ( deviation - Ctx.JitterMad ) / ( 1 << JITTER_AVG_SHIFT );
+    }
+
+    if( Ctx.NbSamples < UINT16_MAX )
+    {
+        Ctx.NbSamples++;
+    }
+    Ctx.NbMisses = 0;
+}
+
+void LoRaMacClockErrorRxMiss( void )
+{
+    if( Ctx.NbSamples < LORAMAC_CLOCK_ERROR_MIN_SAMPLES )
+    {
+        // The configured worst case is in use already
+        return;
+    }
+
+    Ctx.NbMisses++;
+    if( Ctx.NbMisses >= LORAMAC_CLOCK_ERROR_MAX_MISSES )
+    {
+        // The learned jitter no longer matches, start over from the worst case
+        Ctx.JitterMean = 0;
+        Ctx.JitterMad = 0;
+        Ctx.NbSamples = 0;
+        Ctx.NbMisses = 0;
+    }
+}
+
+void LoRaMacClockErrorDeviceTimeAns( int32_t correction )
+{
+    TimerTime_t now = TimerGetCurrentTime( );
+    TimerTime_t elapsed = TimerGetElapsedTime( Ctx.SyncTime );
+    float measured;
+    float offset;
+
+    if( ( correction == INT32_MAX ) || ( ( uint32_t )( ( correction < 0 ) ? -correction : correction ) > ( elapsed / 1000 ) ) )
+    {
+        // More than 1000 ppm: the time was set, not corrected. Restart from here.
+        Ctx.SyncValid = false;
+    }
+
+    if( ( Ctx.SyncValid == true ) && ( elapsed >= LORAMAC_CLOCK_ERROR_MIN_SYNC_INTERVAL ) )
+    {
+        // A local clock running slow needs a positive correction
+        measured = -( ( float )correction * 1000000.0f ) / ( float )elapsed;
+        offset = measured - TemperatureDrift( ( Ctx.Temperature + Ctx.SyncTemperature ) * 0.5f );
+
+        if( Ctx.FreqOffsetValid == false )
+        {
+            Ctx.FreqOffset = offset;
+            Ctx.FreqOffsetValid = true;
+        }
+        else
+        {
+            Ctx.FreqOffset += ( offset - Ctx.FreqOffset ) * 0.25f;
+        }
+    }
+    else if( Ctx.SyncValid == true )
+    {
+        // Too close to the previous reference to say anything about the drift
+        return;
+    }
+
+    Ctx.SyncValid = true;
+    Ctx.SyncTime = now;
+    Ctx.SyncTemperature = Ctx.Temperature;
+}
+
+float LoRaMacClockErrorGetDrift( void )
+{
+    return Ctx.FreqOffset + TemperatureDrift( Ctx.Temperature );
+}
+
+uint32_t LoRaMacClockErrorGetRxError( uint32_t rxDelay, uint32_t maxRxError )
+{
+    float ppm;
+    uint32_t jitter;
+    uint32_t drift;
+    uint32_t rxError;
+
+    if( Ctx.NbSamples < LORAMAC_CLOCK_ERROR_MIN_SAMPLES )
+    {
+        // Nothing learned yet, keep the configured worst case
+        return maxRxError;
+    }
+
+    // Drift over the receive delay
+    ppm = LoRaMacClockErrorGetDrift( );
+    if( ppm < 0.0f )
+    {
+        ppm = -ppm;
+    }
+    ppm += TemperatureDriftDeviation( Ctx.Temperature );
+    ppm += ( Ctx.FreqOffsetValid == true ) ? CALIBRATED_FREQ_TOLERANCE : ( float )RTC_FREQ_TOLERANCE;
+    drift = ( uint32_t )( ( ( float )rxDelay * ppm ) / 1000000.0f ) + 1;
+
+    // Learned jitter of the RX path
+    jitter = ( uint32_t )( ( Ctx.JitterMean < 0 ) ? -Ctx.JitterMean : Ctx.JitterMean );
+    jitter += JITTER_MAD_FACTOR * ( uint32_t )Ctx.JitterMad;
+    jitter = DIVC( jitter, JITTER_SCALE );
+
+    // Widened after each missed downlink
+    rxError = MAX( jitter + drift, LORAMAC_CLOCK_ERROR_MIN_RX_ERROR ) << Ctx.NbMisses;
+    return MIN( rxError, maxRxError );
+}
@@ -0,0 +1,113 @@
+/*!
+ * \file      LoRaMacClockError.h
+ *
+ * \brief     LoRa MAC clock error model for the RX window computation
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \defgroup  LORAMACCLOCKERROR LoRa MAC clock error model
+ *            Estimates the timing error of the RX windows instead of using
+ *            the fixed worst case \ref MibParam_t.SystemMaxRxError. The error
+ *            is made of two parts:
+ *            - the drift of the LSE over the receive delay, computed from the
+ *              parabolic temperature model ( RTC_TEMP_* in lorawan_conf.h )
+ *              and a frequency offset calibrated with DeviceTimeAns.
+ *            - the timing jitter of the RX path, learned from the arrival
+ *              time of class A downlinks relative to their expected arrival.
+ *            Each missed downlink doubles the learned error, and after
+ *            \ref LORAMAC_CLOCK_ERROR_MAX_MISSES in a row the jitter is
+ *            learned again from the configured maximum.
+ *            The returned error never exceeds the configured maximum.
+ * \{
+ */
+#ifndef __LORAMAC_CLOCK_ERROR_H__
+#define __LORAMAC_CLOCK_ERROR_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * Number of downlink observations needed before the learned jitter is used
+ */
+#define LORAMAC_CLOCK_ERROR_MIN_SAMPLES             8
+
+/*!
+ * Number of consecutive missed downlinks which clear the learned jitter
+ */
+#define LORAMAC_CLOCK_ERROR_MAX_MISSES              4
+
+/*!
+ * Lower bound of the returned RX error in ms
+ */
+#define LORAMAC_CLOCK_ERROR_MIN_RX_ERROR            2
+
+/*!
+ * Minimum time between two DeviceTimeAns used for the offset calibration in ms
+ */
+#define LORAMAC_CLOCK_ERROR_MIN_SYNC_INTERVAL       3600000U
+
+/*!
+ * \brief   Initializes the model, all learned values are cleared.
+ */
+void LoRaMacClockErrorInit( void );
+
+/*!
+ * \brief   Updates the board temperature used by the drift model.
+ *
+ * \param   [IN] temperature - Temperature in degree Celsius.
+ */
+void LoRaMacClockErrorSetTemperature( float temperature );
+
+/*!
+ * \brief   Feeds the arrival time error of a class A downlink.
+ *
+ * \param   [IN] offset - Measured minus expected RX done time in ms.
+ */
+void LoRaMacClockErrorRxObservation( int32_t offset );
+
+/*!
+ * \brief   Reports a class A downlink which was expected but not received,
+ *          the receive windows timed out.
+ */
+void LoRaMacClockErrorRxMiss( void );
+
+/*!
+ * \brief   Feeds the correction applied by a DeviceTimeAns.
+ *
+ * \param   [IN] correction - Network time minus local time in ms, INT32_MAX
+ *                            if out of range. Corrections above 1000 ppm of
+ *                            the time since the previous one restart the
+ *                            calibration.
+ */
+void LoRaMacClockErrorDeviceTimeAns( int32_t correction );
+
+/*!
+ * \brief   Returns the estimated frequency error of the LSE.
+ *
+ * \retval  Frequency error in ppm at the current temperature.
+ */
+float LoRaMacClockErrorGetDrift( void );
+
+/*!
+ * \brief   Computes the RX error to be used for a receive window.
+ *
+ * \param   [IN] rxDelay - Delay between TX done and the RX window in ms.
+ *
+ * \param   [IN] maxRxError - Configured worst case RX error in ms.
+ *
+ * \retval  RX error in ms.
+ */
+uint32_t LoRaMacClockErrorGetRxError( uint32_t rxDelay, uint32_t maxRxError );
+
+#ifdef __cplusplus
+}
+#endif
+
+/*! \} defgroup LORAMACCLOCKERROR */
+
+#endif // __LORAMAC_CLOCK_ERROR_H__
@@ -44,19 +44,29 @@
  */
 #define CID_FIELD_SIZE 1
 
+/*!
+ * Slot index ending the list
+ */
+#define MAC_COMMAND_NONE 0xFF
+
+/*!
+ * Free slots bitmap when all the slots are free
+ */
+#define MAC_COMMAND_SLOTS_ALL_FREE ( ( 1UL << NUM_OF_MAC_COMMANDS ) - 1 )
+
 /*!
  *  Mac Commands list structure
  */
 typedef struct sMacCommandsList
 {
     /*
-     * First element of MAC command list.
+     * Slot index of the first element of MAC command list.
      */
-    MacCommand_t* First;
+    uint8_t First;
     /*
-     * Last element of MAC command list.
+     * Slot index of the last element of MAC command list.
      */
-    MacCommand_t* Last;
+    uint8_t Last;
 } MacCommandsList_t;
 
 /*!
@@ -68,6 +78,10 @@ typedef struct sLoRaMacCommandsCtx
      * List of MAC command elements
      */
     MacCommandsList_t MacCommandList;
+    /*
+     * Bitmap of the free slots, bit n for slot n
+     */
+    uint32_t FreeSlots;
     /*
      * Buffer to store MAC command elements
      */
@@ -91,23 +105,14 @@ static LoRaMacCommandsCtx_t NvmCtx;
 /* Memory management functions */
 
 /*!
- * \brief Determines if a MAC command slot is free
+ * \brief Returns the slot index of a MAC command
  *
- * \param[IN]     slot           - Slot to check
- * \retval                       - Status of the operation
+ * \param[IN]     slot           - Slot
+ * \retval                       - Slot index
  */
-static bool IsSlotFree( const MacCommand_t* slot )
+static uint8_t GetSlotIndex( const MacCommand_t* slot )
 {
-    uint8_t* mem = ( uint8_t* )slot;
-
-    for( uint16_t size = 0; size < sizeof( MacCommand_t ); size++ )
-    {
-        if( mem[size] != 0x00 )
-        {
-            return false;
-        }
-    }
-    return true;
+    return ( uint8_t )( slot - NvmCtx.MacCommandSlots );
 }
 
 /*!
@@ -117,17 +122,17 @@ static bool IsSlotFree( const MacCommand_t* slot )
  */
 static MacCommand_t* MallocNewMacCommandSlot( void )
 {
-    uint8_t itr = 0;
+    uint8_t itr;
 
-    while( IsSlotFree( ( const MacCommand_t* )&NvmCtx.MacCommandSlots[itr] ) == false )
+    if( NvmCtx.FreeSlots == 0 )
     {
-        itr++;
-        if( itr == NUM_OF_MAC_COMMANDS )
-        {
-            return NULL;
-        }
+        return NULL;
     }
 
+    // Highest free slot
+    itr = 31 - __CLZ( NvmCtx.FreeSlots );
+    NvmCtx.FreeSlots &= ~( 1UL << itr );
+
     return &NvmCtx.MacCommandSlots[itr];
 }
 
@@ -145,7 +150,7 @@ static bool FreeMacCommandSlot( MacCommand_t* slot )
         return false;
     }
 
-    memset1( ( uint8_t* )slot, 0x00, sizeof( MacCommand_t ) );
+    NvmCtx.FreeSlots |= 1UL << GetSlotIndex( slot );
 
     return true;
 }
@@ -165,8 +170,8 @@ static bool LinkedListInit( MacCommandsList_t* list )
         return false;
     }
 
-    list->First = NULL;
-    list->Last = NULL;
+    list->First = MAC_COMMAND_NONE;
+    list->Last = MAC_COMMAND_NONE;
 
     return true;
 }
@@ -185,63 +190,30 @@ static bool LinkedListAdd( MacCommandsList_t* list, MacCommand_t* element )
         return false;
     }
 
+    uint8_t index = GetSlotIndex( element );
+
     // Check if this is the first entry to enter the list.
-    if( list->First == NULL )
+    if( list->First == MAC_COMMAND_NONE )
     {
-        list->First = element;
+        list->First = index;
     }
 
     // Check if the last entry exists and update its next point.
-    if( list->Last )
+    if( list->Last != MAC_COMMAND_NONE )
     {
-        list->Last->Next = element;
+        NvmCtx.MacCommandSlots[list->Last].Next = index;
     }
 
-    // Update the next point of this entry.
-    element->Next = NULL;
+    // Update the links of this entry.
+    element->Prev = list->Last;
+    element->Next = MAC_COMMAND_NONE;
 
     // Update the last entry of the list.
-    list->Last = element;
+    list->Last = index;
 
     return true;
 }
 
-/*!
- * \brief Return the previous element in the list.
- *
- * \param[IN]     list           - List
- * \param[IN]     element        - Element where the previous element shall be searched
- * \retval                       - Status of the operation
- */
-static MacCommand_t* LinkedListGetPrevious( MacCommandsList_t* list, MacCommand_t* element )
-{
-    if( ( list == NULL ) || ( element == NULL ) )
-    {
-        return NULL;
-    }
-
-    MacCommand_t* curElement;
-
-    // Start at the head of the list
-    curElement = list->First;
-
-    // When current element is the first of the list, there's no previous element so we can return NULL immediately.
-    if( element != curElement )
-    {
-        // Loop through all elements until the end is reached or the next of current is the current element.
-        while( ( curElement != NULL ) && ( curElement->Next != element ) )
-        {
-            curElement = curElement->Next;
-        }
-    }
-    else
-    {
-        curElement = NULL;
-    }
-
-    return curElement;
-}
-
 /*!
  * \brief Remove an element from the list
  *
@@ -256,24 +228,26 @@ static bool LinkedListRemove( MacCommandsList_t* list, MacCommand_t* element )
         return false;
     }
 
-    MacCommand_t* PrevElement = LinkedListGetPrevious( list, element );
-
-    if( list->First == element )
+    if( element->Prev == MAC_COMMAND_NONE )
     {
         list->First = element->Next;
     }
-
-    if( list->Last == element )
+    else
     {
-        list->Last = PrevElement;
+        NvmCtx.MacCommandSlots[element->Prev].Next = element->Next;
     }
 
-    if( PrevElement != NULL )
+    if( element->Next == MAC_COMMAND_NONE )
+    {
+        list->Last = element->Prev;
+    }
+    else
     {
-        PrevElement->Next = element->Next;
+        NvmCtx.MacCommandSlots[element->Next].Prev = element->Prev;
     }
 
-    element->Next = NULL;
+    element->Prev = MAC_COMMAND_NONE;
+    element->Next = MAC_COMMAND_NONE;
 
     return true;
 }
@@ -316,6 +290,7 @@ LoRaMacCommandStatus_t LoRaMacCommandsInit( LoRaMacCommandsNvmEvent commandsNvmC
     memset1( ( uint8_t* )&NvmCtx, 0, sizeof( NvmCtx ) );
 
     LinkedListInit( &NvmCtx.MacCommandList );
+    NvmCtx.FreeSlots = MAC_COMMAND_SLOTS_ALL_FREE;
 
     // Assign callback
     CommandsNvmCtxChanged = commandsNvmCtxChanged;
@@ -385,6 +360,13 @@ LoRaMacCommandStatus_t LoRaMacCommandsRemoveCmd( MacCommand_t* macCmd )
         return LORAMAC_COMMANDS_ERROR_NPE;
     }
 
+    // Only allocated slots are in the list
+    if( ( macCmd < NvmCtx.MacCommandSlots ) || ( macCmd >= &NvmCtx.MacCommandSlots[NUM_OF_MAC_COMMANDS] ) ||
+        ( ( NvmCtx.FreeSlots & ( 1UL << GetSlotIndex( macCmd ) ) ) != 0 ) )
+    {
+        return LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND;
+    }
+
     // Remove the Mac command element from MacCommandList
     if( LinkedListRemove( &NvmCtx.MacCommandList, macCmd ) == false )
     {
@@ -406,48 +388,43 @@ LoRaMacCommandStatus_t LoRaMacCommandsRemoveCmd( MacCommand_t* macCmd )
 
 LoRaMacCommandStatus_t LoRaMacCommandsGetCmd( uint8_t cid, MacCommand_t** macCmd )
 {
-    MacCommand_t* curElement;
+    uint8_t curIndex;
 
     // Start at the head of the list
-    curElement = NvmCtx.MacCommandList.First;
+    curIndex = NvmCtx.MacCommandList.First;
 
     // Loop through all elements until we find the element with the given CID
-    while( ( curElement != NULL ) && ( curElement->CID != cid ) )
+    while( ( curIndex != MAC_COMMAND_NONE ) && ( NvmCtx.MacCommandSlots[curIndex].CID != cid ) )
     {
-        curElement = curElement->Next;
+        curIndex = NvmCtx.MacCommandSlots[curIndex].Next;
     }
 
-    // Update the pointer anyway
-    *macCmd = curElement;
-
     // Handle error in case if we reached the end without finding it.
-    if( curElement == NULL )
+    if( curIndex == MAC_COMMAND_NONE )
     {
+        *macCmd = NULL;
         return LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND;
     }
+    *macCmd = &NvmCtx.MacCommandSlots[curIndex];
     return LORAMAC_COMMANDS_SUCCESS;
 }
 
 LoRaMacCommandStatus_t LoRaMacCommandsRemoveNoneStickyCmds( void )
 {
+    uint8_t curIndex;
     MacCommand_t* curElement;
-    MacCommand_t* nexElement;
 
     // Start at the head of the list
-    curElement = NvmCtx.MacCommandList.First;
+    curIndex = NvmCtx.MacCommandList.First;
 
     // Loop through all elements
-    while( curElement != NULL )
+    while( curIndex != MAC_COMMAND_NONE )
     {
+        curElement = &NvmCtx.MacCommandSlots[curIndex];
+        curIndex = curElement->Next;
         if( curElement->IsSticky == false )
         {
-            nexElement = curElement->Next;
             LoRaMacCommandsRemoveCmd( curElement );
-            curElement = nexElement;
-        }
-        else
-        {
-            curElement = curElement->Next;
         }
     }
 
@@ -458,21 +435,21 @@ LoRaMacCommandStatus_t LoRaMacCommandsRemoveNoneStickyCmds( void )
 
 LoRaMacCommandStatus_t LoRaMacCommandsRemoveStickyAnsCmds( void )
 {
+    uint8_t curIndex;
     MacCommand_t* curElement;
-    MacCommand_t* nexElement;
 
     // Start at the head of the list
-    curElement = NvmCtx.MacCommandList.First;
+    curIndex = NvmCtx.MacCommandList.First;
 
     // Loop through all elements
-    while( curElement != NULL )
+    while( curIndex != MAC_COMMAND_NONE )
     {
-        nexElement = curElement->Next;
+        curElement = &NvmCtx.MacCommandSlots[curIndex];
+        curIndex = curElement->Next;
         if( IsSticky( curElement->CID ) == true )
         {
             LoRaMacCommandsRemoveCmd( curElement );
         }
-        curElement = nexElement;
     }
 
     NvmCtxCallback( );
@@ -492,8 +469,8 @@ LoRaMacCommandStatus_t LoRaMacCommandsGetSizeSerializedCmds( size_t* size )
 
 LoRaMacCommandStatus_t LoRaMacCommandsSerializeCmds( size_t availableSize, size_t* effectiveSize, uint8_t* buffer )
 {
-    MacCommand_t* curElement = NvmCtx.MacCommandList.First;
-    MacCommand_t* nextElement;
+    uint8_t curIndex = NvmCtx.MacCommandList.First;
+    MacCommand_t* curElement;
     uint8_t itr = 0;
 
     if( ( buffer == NULL ) || ( effectiveSize == NULL ) )
@@ -502,8 +479,9 @@ LoRaMacCommandStatus_t LoRaMacCommandsSerializeCmds( size_t availableSize, size_
     }
 
     // Loop through all elements which fits into the buffer
-    while( curElement != NULL )
+    while( curIndex != MAC_COMMAND_NONE )
     {
+        curElement = &NvmCtx.MacCommandSlots[curIndex];
         // If the next MAC command still fits into the buffer, add it.
         if( ( availableSize - itr ) >= ( CID_FIELD_SIZE + curElement->PayloadSize ) )
         {
@@ -515,16 +493,16 @@ LoRaMacCommandStatus_t LoRaMacCommandsSerializeCmds( size_t availableSize, size_
         {
             break;
         }
-        curElement = curElement->Next;
+        curIndex = curElement->Next;
     }
 
     // Remove all commands which do not fit into the buffer
-    while( curElement != NULL )
+    while( curIndex != MAC_COMMAND_NONE )
     {
         // Store the next element before removing the current one
-        nextElement = curElement->Next;
+        curElement = &NvmCtx.MacCommandSlots[curIndex];
+        curIndex = curElement->Next;
         LoRaMacCommandsRemoveCmd( curElement );
-        curElement = nextElement;
     }
 
     // Fetch the effective size of the mac commands
@@ -539,21 +517,21 @@ LoRaMacCommandStatus_t LoRaMacCommandsStickyCmdsPending( bool* cmdsPending )
     {
         return LORAMAC_COMMANDS_ERROR_NPE;
     }
-    MacCommand_t* curElement;
-    curElement = NvmCtx.MacCommandList.First;
+    uint8_t curIndex;
+    curIndex = NvmCtx.MacCommandList.First;
 
     *cmdsPending = false;
 
     // Loop through all elements
-    while( curElement != NULL )
+    while( curIndex != MAC_COMMAND_NONE )
     {
-        if( curElement->IsSticky == true )
+        if( NvmCtx.MacCommandSlots[curIndex].IsSticky == true )
         {
             // Found one sticky MAC command
             *cmdsPending = true;
             return LORAMAC_COMMANDS_SUCCESS;
         }
-        curElement = curElement->Next;
+        curIndex = NvmCtx.MacCommandSlots[curIndex].Next;
     }
 
     return LORAMAC_COMMANDS_SUCCESS;
@@ -38,6 +38,7 @@
 #include "secure-element.h"
 
 #include "LoRaMacParser.h"
+#include "LoRaMacFrameView.h"
 #include "LoRaMacSerializer.h"
 #include "LoRaMacCrypto.h"
 
@@ -1276,9 +1277,7 @@ LoRaMacCryptoStatus_t LoRaMacCryptoHandleJoinAccept( JoinReqIdentifier_t joinReq
     // Check if the JoinNonce is greater as the previous one
     uint32_t currentJoinNonce = 0;
 
-    currentJoinNonce = ( uint32_t )macMsg->JoinNonce[0];
-    currentJoinNonce |= ( ( uint32_t )macMsg->JoinNonce[1] << 8 );
-    currentJoinNonce |= ( ( uint32_t )macMsg->JoinNonce[2] << 16 );
+    currentJoinNonce = LoRaMacFrameViewGetUint24( macMsg->JoinNonce );
 
     if( currentJoinNonce > CryptoCtx.NvmCtx->JoinNonce )
     {
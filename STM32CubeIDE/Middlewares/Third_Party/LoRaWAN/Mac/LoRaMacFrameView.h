@@ -0,0 +1,113 @@
+/*!
+ * \file      LoRaMacFrameView.h
+ *
+ * \brief     LoRa MAC layer frame field offsets and accessors
+ *
+ * \remark    The fields are read and written in place in the serialized
+ *            message buffer, without intermediate copies. All multi-byte
+ *            fields are little endian.
+ *
+ * addtogroup LORAMAC
+ * \{
+ *
+ */
+#ifndef __LORAMAC_FRAME_VIEW_H__
+#define __LORAMAC_FRAME_VIEW_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "LoRaMacHeaderTypes.h"
+
+/*! MHDR offset, all frames */
+#define LORAMAC_MHDR_OFFSET                 0
+
+/*! Join-request field offsets */
+#define LORAMAC_JOIN_REQ_JOIN_EUI_OFFSET    ( LORAMAC_MHDR_OFFSET + LORAMAC_MHDR_FIELD_SIZE )
+#define LORAMAC_JOIN_REQ_DEV_EUI_OFFSET     ( LORAMAC_JOIN_REQ_JOIN_EUI_OFFSET + LORAMAC_JOIN_EUI_FIELD_SIZE )
+#define LORAMAC_JOIN_REQ_DEV_NONCE_OFFSET   ( LORAMAC_JOIN_REQ_DEV_EUI_OFFSET + LORAMAC_DEV_EUI_FIELD_SIZE )
+#define LORAMAC_JOIN_REQ_MIC_OFFSET         ( LORAMAC_JOIN_REQ_DEV_NONCE_OFFSET + LORAMAC_DEV_NONCE_FIELD_SIZE )
+
+/*! Join-accept field offsets, the CFList is optional */
+#define LORAMAC_JOIN_ACCEPT_JOIN_NONCE_OFFSET   ( LORAMAC_MHDR_OFFSET + LORAMAC_MHDR_FIELD_SIZE )
+#define LORAMAC_JOIN_ACCEPT_NET_ID_OFFSET       ( LORAMAC_JOIN_ACCEPT_JOIN_NONCE_OFFSET + LORAMAC_JOIN_NONCE_FIELD_SIZE )
+#define LORAMAC_JOIN_ACCEPT_DEV_ADDR_OFFSET     ( LORAMAC_JOIN_ACCEPT_NET_ID_OFFSET + LORAMAC_NET_ID_FIELD_SIZE )
+#define LORAMAC_JOIN_ACCEPT_DL_SETTINGS_OFFSET  ( LORAMAC_JOIN_ACCEPT_DEV_ADDR_OFFSET + LORAMAC_DEV_ADDR_FIELD_SIZE )
+#define LORAMAC_JOIN_ACCEPT_RX_DELAY_OFFSET     ( LORAMAC_JOIN_ACCEPT_DL_SETTINGS_OFFSET + LORAMAC_DL_SETTINGS_FIELD_SIZE )
+#define LORAMAC_JOIN_ACCEPT_CF_LIST_OFFSET      ( LORAMAC_JOIN_ACCEPT_RX_DELAY_OFFSET + LORAMAC_RX_DELAY_FIELD_SIZE )
+
+/*! Data frame field offsets, FPort follows the variable size FOpts */
+#define LORAMAC_DATA_DEV_ADDR_OFFSET        ( LORAMAC_MHDR_OFFSET + LORAMAC_MHDR_FIELD_SIZE )
+#define LORAMAC_DATA_F_CTRL_OFFSET          ( LORAMAC_DATA_DEV_ADDR_OFFSET + LORAMAC_FHDR_DEV_ADDR_FIELD_SIZE )
+#define LORAMAC_DATA_F_CNT_OFFSET           ( LORAMAC_DATA_F_CTRL_OFFSET + LORAMAC_FHDR_F_CTRL_FIELD_SIZE )
+#define LORAMAC_DATA_F_OPTS_OFFSET          ( LORAMAC_DATA_F_CNT_OFFSET + LORAMAC_FHDR_F_CNT_FIELD_SIZE )
+
+/*!
+ * \brief Reads a 16-bit field
+ *
+ * \param [IN] field Field in the message buffer
+ * \retval Field value
+ */
+static inline uint16_t LoRaMacFrameViewGetUint16( const uint8_t* field )
+{
+    return ( uint16_t )( field[0] | ( field[1] << 8 ) );
+}
+
+/*!
+ * \brief Reads a 24-bit field
+ *
+ * \param [IN] field Field in the message buffer
+ * \retval Field value
+ */
+static inline uint32_t LoRaMacFrameViewGetUint24( const uint8_t* field )
+{
+    return ( uint32_t )field[0] | ( ( uint32_t )field[1] << 8 ) | ( ( uint32_t )field[2] << 16 );
+}
+
+/*!
+ * \brief Reads a 32-bit field
+ *
+ * \param [IN] field Field in the message buffer
+ * \retval Field value
+ */
+static inline uint32_t LoRaMacFrameViewGetUint32( const uint8_t* field )
+{
+    return LoRaMacFrameViewGetUint24( field ) | ( ( uint32_t )field[3] << 24 );
+}
+
+/*!
+ * \brief Writes a 16-bit field
+ *
+ * \param [IN] field Field in the message buffer
+ * \param [IN] value Field value
+ */
+static inline void LoRaMacFrameViewSetUint16( uint8_t* field, uint16_t value )
+{
+    field[0] = value & 0xFF;
+    field[1] = ( value >> 8 ) & 0xFF;
+}
+
+/*!
+ * \brief Writes a 32-bit field
+ *
+ * \param [IN] field Field in the message buffer
+ * \param [IN] value Field value
+ */
+static inline void LoRaMacFrameViewSetUint32( uint8_t* field, uint32_t value )
+{
+    field[0] = value & 0xFF;
+    field[1] = ( value >> 8 ) & 0xFF;
+    field[2] = ( value >> 16 ) & 0xFF;
+    field[3] = ( value >> 24 ) & 0xFF;
+}
+
+/*! \} addtogroup LORAMAC */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LORAMAC_FRAME_VIEW_H__
@@ -313,9 +313,10 @@ typedef struct sLoRaMacFrameHeader
      */
     uint16_t FCnt;
     /*!
-     * FOpts field may transport  MAC commands (opt. 0-15 Bytes)
+     * FOpts field may transport  MAC commands (opt. 0-15 Bytes), located in
+     * the serialized message buffer
      */
-    uint8_t FOpts[LORAMAC_FHDR_F_OPTS_MAX_FIELD_SIZE];
+    uint8_t* FOpts;
 }LoRaMacFrameHeader_t;
 
 /*! \} addtogroup LORAMAC */
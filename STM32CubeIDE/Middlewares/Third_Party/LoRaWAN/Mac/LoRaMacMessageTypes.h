@@ -176,13 +176,13 @@ typedef struct sLoRaMacMessageJoinAccept
      */
     LoRaMacHeader_t MHDR;
     /*!
-     *  Server Nonce ( 3 bytes )
+     *  Server Nonce ( 3 bytes ), in the message buffer
      */
-    uint8_t JoinNonce[LORAMAC_JOIN_NONCE_FIELD_SIZE];
+    uint8_t* JoinNonce;
     /*!
-     * Network ID ( 3 bytes )
+     * Network ID ( 3 bytes ), in the message buffer
      */
-    uint8_t NetID[LORAMAC_NET_ID_FIELD_SIZE];
+    uint8_t* NetID;
     /*!
      * Device address
      */
@@ -196,9 +196,9 @@ typedef struct sLoRaMacMessageJoinAccept
      */
     uint8_t RxDelay;
     /*!
-     * List of channel frequencies (opt.)
+     * List of channel frequencies (opt.), in the message buffer, NULL if absent
      */
-    uint8_t CFList[16];
+    uint8_t* CFList;
     /*!
      * Message integrity code (MIC)
      */
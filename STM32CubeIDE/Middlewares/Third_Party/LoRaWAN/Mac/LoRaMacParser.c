@@ -31,7 +31,12 @@
  * \author    Johannes Bruder ( STACKFORCE )
  */
 #include "LoRaMacParser.h"
-#include "utilities.h"
+#include "LoRaMacFrameView.h"
+
+/*
+ * The parsers validate the lengths once, decode the scalar header fields and
+ * point to the byte fields in place: nothing is copied out of the buffer.
+ */
 
 LoRaMacParserStatus_t LoRaMacParserJoinAccept( LoRaMacMessageJoinAccept_t* macMsg )
 {
@@ -40,39 +45,29 @@ LoRaMacParserStatus_t LoRaMacParserJoinAccept( LoRaMacMessageJoinAccept_t* macMs
         return LORAMAC_PARSER_ERROR_NPE;
     }
 
-    uint16_t bufItr = 0;
-
-    macMsg->MHDR.Value = macMsg->Buffer[bufItr++];
-
-    memcpy1( macMsg->JoinNonce, &macMsg->Buffer[bufItr], 3 );
-    bufItr = bufItr + 3;
-
-    memcpy1( macMsg->NetID, &macMsg->Buffer[bufItr], 3 );
-    bufItr = bufItr + 3;
+    uint8_t* buffer = macMsg->Buffer;
+    uint16_t micOffset = macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE;
 
-    macMsg->DevAddr = ( uint32_t ) macMsg->Buffer[bufItr++];
-    macMsg->DevAddr |= ( ( uint32_t ) macMsg->Buffer[bufItr++] << 8 );
-    macMsg->DevAddr |= ( ( uint32_t ) macMsg->Buffer[bufItr++] << 16 );
-    macMsg->DevAddr |= ( ( uint32_t ) macMsg->Buffer[bufItr++] << 24 );
-
-    macMsg->DLSettings.Value = macMsg->Buffer[bufItr++];
-
-    macMsg->RxDelay = macMsg->Buffer[bufItr++];
-
-    if( ( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE - bufItr ) == LORAMAC_CF_LIST_FIELD_SIZE )
+    if( macMsg->BufSize == ( LORAMAC_JOIN_ACCEPT_CF_LIST_OFFSET + LORAMAC_CF_LIST_FIELD_SIZE + LORAMAC_MIC_FIELD_SIZE ) )
+    {
+        macMsg->CFList = &buffer[LORAMAC_JOIN_ACCEPT_CF_LIST_OFFSET];
+    }
+    else if( macMsg->BufSize == ( LORAMAC_JOIN_ACCEPT_CF_LIST_OFFSET + LORAMAC_MIC_FIELD_SIZE ) )
     {
-        memcpy1( macMsg->CFList, &macMsg->Buffer[bufItr], LORAMAC_CF_LIST_FIELD_SIZE );
-        bufItr = bufItr + LORAMAC_CF_LIST_FIELD_SIZE;
+        macMsg->CFList = 0;
     }
-    else if( ( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE - bufItr ) > 0 )
+    else
     {
         return LORAMAC_PARSER_FAIL;
     }
 
-    macMsg->MIC = ( uint32_t ) macMsg->Buffer[bufItr++];
-    macMsg->MIC |= ( ( uint32_t ) macMsg->Buffer[bufItr++] << 8 );
-    macMsg->MIC |= ( ( uint32_t ) macMsg->Buffer[bufItr++] << 16 );
-    macMsg->MIC |= ( ( uint32_t ) macMsg->Buffer[bufItr++] << 24 );
+    macMsg->MHDR.Value = buffer[LORAMAC_MHDR_OFFSET];
+    macMsg->JoinNonce = &buffer[LORAMAC_JOIN_ACCEPT_JOIN_NONCE_OFFSET];
+    macMsg->NetID = &buffer[LORAMAC_JOIN_ACCEPT_NET_ID_OFFSET];
+    macMsg->DevAddr = LoRaMacFrameViewGetUint32( &buffer[LORAMAC_JOIN_ACCEPT_DEV_ADDR_OFFSET] );
+    macMsg->DLSettings.Value = buffer[LORAMAC_JOIN_ACCEPT_DL_SETTINGS_OFFSET];
+    macMsg->RxDelay = buffer[LORAMAC_JOIN_ACCEPT_RX_DELAY_OFFSET];
+    macMsg->MIC = LoRaMacFrameViewGetUint32( &buffer[micOffset] );
 
     return LORAMAC_PARSER_SUCCESS;
 }
@@ -84,47 +79,42 @@ LoRaMacParserStatus_t LoRaMacParserData( LoRaMacMessageData_t* macMsg )
         return LORAMAC_PARSER_ERROR_NPE;
     }
 
-    uint16_t bufItr = 0;
-
-    macMsg->MHDR.Value = macMsg->Buffer[bufItr++];
-
-    macMsg->FHDR.DevAddr = macMsg->Buffer[bufItr++];
-    macMsg->FHDR.DevAddr |= ( ( uint32_t ) macMsg->Buffer[bufItr++] << 8 );
-    macMsg->FHDR.DevAddr |= ( ( uint32_t ) macMsg->Buffer[bufItr++] << 16 );
-    macMsg->FHDR.DevAddr |= ( ( uint32_t ) macMsg->Buffer[bufItr++] << 24 );
-
-    macMsg->FHDR.FCtrl.Value = macMsg->Buffer[bufItr++];
-
-    macMsg->FHDR.FCnt = macMsg->Buffer[bufItr++];
-    macMsg->FHDR.FCnt |= macMsg->Buffer[bufItr++] << 8;
+    uint8_t* buffer = macMsg->Buffer;
+    uint16_t bufItr;
 
-    if( macMsg->FHDR.FCtrl.Bits.FOptsLen <= 15 )
+    if( macMsg->BufSize < ( LORAMAC_DATA_F_OPTS_OFFSET + LORAMAC_MIC_FIELD_SIZE ) )
     {
-        memcpy1( macMsg->FHDR.FOpts, &macMsg->Buffer[bufItr], macMsg->FHDR.FCtrl.Bits.FOptsLen );
-        bufItr = bufItr + macMsg->FHDR.FCtrl.Bits.FOptsLen;
+        return LORAMAC_PARSER_FAIL;
     }
-    else
+
+    macMsg->FHDR.FCtrl.Value = buffer[LORAMAC_DATA_F_CTRL_OFFSET];
+
+    // FOptsLen holds on 4 bits, the FOpts are used in place
+    bufItr = LORAMAC_DATA_F_OPTS_OFFSET + macMsg->FHDR.FCtrl.Bits.FOptsLen;
+    if( ( bufItr + LORAMAC_MIC_FIELD_SIZE ) > macMsg->BufSize )
     {
         return LORAMAC_PARSER_FAIL;
     }
 
+    macMsg->MHDR.Value = buffer[LORAMAC_MHDR_OFFSET];
+    macMsg->FHDR.DevAddr = LoRaMacFrameViewGetUint32( &buffer[LORAMAC_DATA_DEV_ADDR_OFFSET] );
+    macMsg->FHDR.FCnt = LoRaMacFrameViewGetUint16( &buffer[LORAMAC_DATA_F_CNT_OFFSET] );
+    macMsg->FHDR.FOpts = &buffer[LORAMAC_DATA_F_OPTS_OFFSET];
+
     // Initialize anyway with zero.
     macMsg->FPort = 0;
     macMsg->FRMPayloadSize = 0;
+    macMsg->FRMPayload = &buffer[bufItr];
 
-    if( ( macMsg->BufSize - bufItr - LORAMAC_MIC_FIELD_SIZE ) > 0 )
+    if( ( bufItr + LORAMAC_MIC_FIELD_SIZE ) < macMsg->BufSize )
     {
-        macMsg->FPort = macMsg->Buffer[bufItr++];
+        macMsg->FPort = buffer[bufItr++];
 
+        macMsg->FRMPayload = &buffer[bufItr];
         macMsg->FRMPayloadSize = ( macMsg->BufSize - bufItr - LORAMAC_MIC_FIELD_SIZE );
-        memcpy1( macMsg->FRMPayload, &macMsg->Buffer[bufItr], macMsg->FRMPayloadSize );
-        bufItr = bufItr + macMsg->FRMPayloadSize;
     }
 
-    macMsg->MIC = ( uint32_t ) macMsg->Buffer[( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE )];
-    macMsg->MIC |= ( ( uint32_t ) macMsg->Buffer[( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE ) + 1] << 8 );
-    macMsg->MIC |= ( ( uint32_t ) macMsg->Buffer[( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE ) + 2] << 16 );
-    macMsg->MIC |= ( ( uint32_t ) macMsg->Buffer[( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE ) + 3] << 24 );
+    macMsg->MIC = LoRaMacFrameViewGetUint32( &buffer[macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE] );
 
     return LORAMAC_PARSER_SUCCESS;
 }
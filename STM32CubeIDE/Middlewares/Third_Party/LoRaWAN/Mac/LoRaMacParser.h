@@ -71,6 +71,7 @@ typedef enum eLoRaMacParserStatus
 
 /*!
  * Parse a serialized join-accept message and fills the structured object.
+ * JoinNonce, NetID and CFList point into the message buffer.
  *
  * \param[IN/OUT] macMsg       - Join-accept message object
  * \retval                     - Status of the operation
@@ -79,6 +80,8 @@ LoRaMacParserStatus_t LoRaMacParserJoinAccept( LoRaMacMessageJoinAccept_t *macMs
 
 /*!
  * Parse a serialized data message and fills the structured object.
+ * FHDR.FOpts and FRMPayload point into the message buffer, where they are
+ * decrypted in place.
  *
  * \param[IN/OUT] macMsg       - Data message object
  * \retval                     - Status of the operation
@@ -32,6 +32,7 @@
  */
 #include "LoRaMacSerializer.h"
 #include "utilities.h"
+#include "LoRaMacFrameView.h"
 
 LoRaMacSerializerStatus_t LoRaMacSerializerJoinRequest( LoRaMacMessageJoinRequest_t* macMsg )
 {
@@ -40,31 +41,19 @@ LoRaMacSerializerStatus_t LoRaMacSerializerJoinRequest( LoRaMacMessageJoinReques
         return LORAMAC_SERIALIZER_ERROR_NPE;
     }
 
-    uint16_t bufItr = 0;
-
     // Check macMsg->BufSize
     if( macMsg->BufSize < LORAMAC_JOIN_REQ_MSG_SIZE )
     {
         return LORAMAC_SERIALIZER_ERROR_BUF_SIZE;
     }
 
-    macMsg->Buffer[bufItr++] = macMsg->MHDR.Value;
-
-    memcpyr( &macMsg->Buffer[bufItr], macMsg->JoinEUI, LORAMAC_JOIN_EUI_FIELD_SIZE );
-    bufItr += LORAMAC_JOIN_EUI_FIELD_SIZE;
-
-    memcpyr( &macMsg->Buffer[bufItr], macMsg->DevEUI, LORAMAC_DEV_EUI_FIELD_SIZE );
-    bufItr += LORAMAC_DEV_EUI_FIELD_SIZE;
-
-    macMsg->Buffer[bufItr++] = macMsg->DevNonce & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->DevNonce >> 8 ) & 0xFF;
+    macMsg->Buffer[LORAMAC_MHDR_OFFSET] = macMsg->MHDR.Value;
+    memcpyr( &macMsg->Buffer[LORAMAC_JOIN_REQ_JOIN_EUI_OFFSET], macMsg->JoinEUI, LORAMAC_JOIN_EUI_FIELD_SIZE );
+    memcpyr( &macMsg->Buffer[LORAMAC_JOIN_REQ_DEV_EUI_OFFSET], macMsg->DevEUI, LORAMAC_DEV_EUI_FIELD_SIZE );
+    LoRaMacFrameViewSetUint16( &macMsg->Buffer[LORAMAC_JOIN_REQ_DEV_NONCE_OFFSET], macMsg->DevNonce );
+    LoRaMacFrameViewSetUint32( &macMsg->Buffer[LORAMAC_JOIN_REQ_MIC_OFFSET], macMsg->MIC );
 
-    macMsg->Buffer[bufItr++] = macMsg->MIC & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->MIC >> 8 ) & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->MIC >> 16 ) & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->MIC >> 24 ) & 0xFF;
-
-    macMsg->BufSize = bufItr;
+    macMsg->BufSize = LORAMAC_JOIN_REQ_MSG_SIZE;
 
     return LORAMAC_SERIALIZER_SUCCESS;
 }
@@ -161,33 +150,32 @@ LoRaMacSerializerStatus_t LoRaMacSerializerData( LoRaMacMessageData_t* macMsg )
         return LORAMAC_SERIALIZER_ERROR_BUF_SIZE;
     }
 
-    macMsg->Buffer[bufItr++] = macMsg->MHDR.Value;
-
-    macMsg->Buffer[bufItr++] = ( macMsg->FHDR.DevAddr ) & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->FHDR.DevAddr >> 8 ) & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->FHDR.DevAddr >> 16 ) & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->FHDR.DevAddr >> 24 ) & 0xFF;
-
-    macMsg->Buffer[bufItr++] = macMsg->FHDR.FCtrl.Value;
+    macMsg->Buffer[LORAMAC_MHDR_OFFSET] = macMsg->MHDR.Value;
+    LoRaMacFrameViewSetUint32( &macMsg->Buffer[LORAMAC_DATA_DEV_ADDR_OFFSET], macMsg->FHDR.DevAddr );
+    macMsg->Buffer[LORAMAC_DATA_F_CTRL_OFFSET] = macMsg->FHDR.FCtrl.Value;
+    LoRaMacFrameViewSetUint16( &macMsg->Buffer[LORAMAC_DATA_F_CNT_OFFSET], macMsg->FHDR.FCnt );
 
-    macMsg->Buffer[bufItr++] = macMsg->FHDR.FCnt & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->FHDR.FCnt >> 8 ) & 0xFF;
-
-    memcpy1( &macMsg->Buffer[bufItr], macMsg->FHDR.FOpts, macMsg->FHDR.FCtrl.Bits.FOptsLen );
-    bufItr = bufItr + macMsg->FHDR.FCtrl.Bits.FOptsLen;
+    // The FOpts may already be located in the message buffer
+    if( macMsg->FHDR.FOpts != &macMsg->Buffer[LORAMAC_DATA_F_OPTS_OFFSET] )
+    {
+        memcpy1( &macMsg->Buffer[LORAMAC_DATA_F_OPTS_OFFSET], macMsg->FHDR.FOpts, macMsg->FHDR.FCtrl.Bits.FOptsLen );
+    }
+    bufItr = LORAMAC_DATA_F_OPTS_OFFSET + macMsg->FHDR.FCtrl.Bits.FOptsLen;
 
     if( macMsg->FRMPayloadSize > 0 )
     {
         macMsg->Buffer[bufItr++] = macMsg->FPort;
     }
 
-    memcpy1( &macMsg->Buffer[bufItr], macMsg->FRMPayload, macMsg->FRMPayloadSize );
+    // The FRMPayload may already be located in the message buffer
+    if( macMsg->FRMPayload != &macMsg->Buffer[bufItr] )
+    {
+        memcpy1( &macMsg->Buffer[bufItr], macMsg->FRMPayload, macMsg->FRMPayloadSize );
+    }
     bufItr = bufItr + macMsg->FRMPayloadSize;
 
-    macMsg->Buffer[bufItr++] = macMsg->MIC & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->MIC >> 8 ) & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->MIC >> 16 ) & 0xFF;
-    macMsg->Buffer[bufItr++] = ( macMsg->MIC >> 24 ) & 0xFF;
+    LoRaMacFrameViewSetUint32( &macMsg->Buffer[bufItr], macMsg->MIC );
+    bufItr += LORAMAC_MIC_FIELD_SIZE;
 
     macMsg->BufSize = bufItr;
 
@@ -0,0 +1,235 @@
+/*!
+ * \file      LoRaMacTxPowerCtrl.c
+ *
+ * \brief     LoRa MAC device side transmit power control
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "Region.h"
+#include "LoRaMacTxPowerCtrl.h"
+
+#if defined( REGION_US915 )
+#include "RegionUS915.h"
+#endif
+
+/*
+ * Upper bound of the power reduction in TX power indexes
+ */
+#define MAX_OFFSET                                  15
+
+/*
+ * Module context
+ */
+typedef struct sLoRaMacTxPowerCtrlCtx
+{
+    /*!
+     * Active region
+     */
+    LoRaMacRegion_t Region;
+    /*!
+     * Set to true while the controller acts on the TX power
+     */
+    bool Active;
+    /*!
+     * Power reduction in TX power indexes
+     */
+    uint8_t Offset;
+    /*!
+     * TX power index of the last uplink
+     */
+    int8_t LastTxPower;
+    /*!
+     * Consecutive margins good enough to step down
+     */
+    uint8_t NbGoodMargins;
+    /*!
+     * Uplinks since the last downlink
+     */
+    uint16_t SilentUplinks;
+    /*!
+     * Uplinks since the last margin information
+     */
+    uint16_t UplinksSinceMargin;
+    /*!
+     * Set to true when a downlink was received since the last uplink done
+     */
+    bool DownlinkReceived;
+}LoRaMacTxPowerCtrlCtx_t;
+
+/*
+ * Module context.
+ */
+static LoRaMacTxPowerCtrlCtx_t Ctx;
+
+/*!
+ * Spreading factor of a regional datarate, 7 when unknown which gives the
+ * smallest margin estimate
+ */
+static uint8_t GetSpreadingFactor( int8_t datarate )
+{
+    uint8_t sf = 0;
+
+    if( ( datarate < 0 ) || ( datarate > DR_15 ) )
+    {
+        return 7;
+    }
+
+    switch( Ctx.Region )
+    {
+#if defined( REGION_US915 )
+        case LORAMAC_REGION_US915:
+            sf = DataratesUS915[datarate];
+            break;
+#endif
+        default:
+            break;
+    }
+
+    return ( ( sf >= 7 ) && ( sf <= 12 ) ) ? sf : 7;
+}
+
+static void StepUp( uint8_t steps )
+{
+    Ctx.Offset = ( Ctx.Offset > steps ) ? ( Ctx.Offset - steps ) : 0;
+    Ctx.NbGoodMargins = 0;
+}
+
+/*!
+ * Steps the power according to an uplink margin at the power of the last uplink
+ */
+static void ProcessMargin( int16_t margin )
+{
+    Ctx.UplinksSinceMargin = 0;
+
+    if( margin < LORAMAC_TXPOWER_CTRL_TARGET_MARGIN )
+    {
+        StepUp( DIVC( LORAMAC_TXPOWER_CTRL_TARGET_MARGIN - margin, LORAMAC_TXPOWER_CTRL_STEP ) );
+    }
+    else if( margin >= ( LORAMAC_TXPOWER_CTRL_TARGET_MARGIN + ( 2 * LORAMAC_TXPOWER_CTRL_STEP ) ) )
+    {
+        // One step down still leaves a step of hysteresis above the target
+        Ctx.NbGoodMargins++;
+        if( Ctx.NbGoodMargins >= LORAMAC_TXPOWER_CTRL_NB_GOOD_MARGINS )
+        {
+            Ctx.NbGoodMargins = 0;
+            if( Ctx.Offset < MAX_OFFSET )
+            {
+                Ctx.Offset++;
+            }
+        }
+    }
+    else
+    {
+        Ctx.NbGoodMargins = 0;
+    }
+}
+
+void LoRaMacTxPowerCtrlInit( LoRaMacRegion_t region )
+{
+    memset1( ( uint8_t* ) &Ctx, 0, sizeof( Ctx ) );
+    Ctx.Region = region;
+}
+
+void LoRaMacTxPowerCtrlReset( void )
+{
+    Ctx.Offset = 0;
+    Ctx.NbGoodMargins = 0;
+}
+
+int8_t LoRaMacTxPowerCtrlApply( int8_t txPower, bool adrOn )
+{
+    VerifyParams_t verify;
+    int8_t reduced;
+
+#if ( LORAMAC_TXPOWER_CTRL_ENABLED == 1 )
+    Ctx.Active = ( adrOn == false ) || ( LORAMAC_TXPOWER_CTRL_WITH_ADR == 1 );
+#else
+    Ctx.Active = false;
+#endif
+    if( Ctx.Active == false )
+    {
+        Ctx.LastTxPower = txPower;
+        return txPower;
+    }
+
+    // Higher TX power indexes are lower powers, keep the lowest valid one
+    reduced = txPower + Ctx.Offset;
+    verify.TxPower = reduced;
+    while( ( reduced > txPower ) && ( RegionVerify( Ctx.Region, &verify, PHY_TX_POWER ) == false ) )
+    {
+        reduced--;
+        verify.TxPower = reduced;
+    }
+    Ctx.Offset = reduced - txPower;
+    Ctx.LastTxPower = reduced;
+
+    return reduced;
+}
+
+void LoRaMacTxPowerCtrlDownlink( int8_t datarate, int8_t snr )
+{
+    uint8_t sf = GetSpreadingFactor( datarate );
+    // LoRa demodulation floor: -7.5 dB at SF7 down to -20 dB at SF12
+    int16_t margin = snr + 5 + ( ( 5 * ( sf - 6 ) ) / 2 );
+
+    Ctx.DownlinkReceived = true;
+    if( Ctx.Active == false )
+    {
+        return;
+    }
+
+    // The downlink does not see the power reduction of the uplink
+    ProcessMargin( margin - LORAMAC_TXPOWER_CTRL_DL_ASYMMETRY - ( Ctx.LastTxPower * LORAMAC_TXPOWER_CTRL_STEP ) );
+}
+
+void LoRaMacTxPowerCtrlLinkCheckAns( uint8_t margin )
+{
+    if( Ctx.Active == false )
+    {
+        return;
+    }
+    ProcessMargin( margin );
+}
+
+void LoRaMacTxPowerCtrlUplinkDone( bool ackRequested, bool ackReceived )
+{
+    if( Ctx.DownlinkReceived == true )
+    {
+        Ctx.DownlinkReceived = false;
+        Ctx.SilentUplinks = 0;
+    }
+    else if( Ctx.SilentUplinks < UINT16_MAX )
+    {
+        Ctx.SilentUplinks++;
+    }
+    if( Ctx.UplinksSinceMargin < UINT16_MAX )
+    {
+        Ctx.UplinksSinceMargin++;
+    }
+
+    if( ( ackRequested == true ) && ( ackReceived == false ) )
+    {
+        // Missed ack, back up quickly
+        StepUp( 2 );
+    }
+    else if( Ctx.SilentUplinks > LORAMAC_TXPOWER_CTRL_SILENCE_LIMIT )
+    {
+        StepUp( 1 );
+    }
+}
+
+bool LoRaMacTxPowerCtrlIsLinkCheckNeeded( void )
+{
+    if( ( Ctx.Active == false ) || ( LORAMAC_TXPOWER_CTRL_LINK_CHECK_PERIOD == 0 ) ||
+        ( Ctx.UplinksSinceMargin < LORAMAC_TXPOWER_CTRL_LINK_CHECK_PERIOD ) )
+    {
+        return false;
+    }
+    // Restart the period, the answer may never come
+    Ctx.UplinksSinceMargin = 0;
+    return true;
+}
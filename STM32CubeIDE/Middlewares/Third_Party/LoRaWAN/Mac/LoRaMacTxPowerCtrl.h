@@ -0,0 +1,127 @@
+/*!
+ * \file      LoRaMacTxPowerCtrl.h
+ *
+ * \brief     LoRa MAC device side transmit power control
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \defgroup  LORAMACTXPOWERCTRL LoRa MAC transmit power control
+ *            Lowers the TX power below the one set by the application or by
+ *            LinkADRReq while the link margin allows it. The uplink margin is
+ *            taken from LinkCheckAns, or estimated from the SNR of the
+ *            downlinks. The power is stepped down one regional TX power
+ *            index at a time after a few consecutive good margins. It goes
+ *            back up when a margin is short, when a confirmed uplink misses
+ *            its ack, and gradually when the downlinks stop coming. The
+ *            result always stays a valid regional TX power.
+ * \{
+ */
+#ifndef __LORAMAC_TXPOWER_CTRL_H__
+#define __LORAMAC_TXPOWER_CTRL_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "LoRaMac.h"
+
+/*!
+ * Uplink margin the controller aims for in dB
+ */
+#define LORAMAC_TXPOWER_CTRL_TARGET_MARGIN          10
+
+/*!
+ * Assumed excess of the downlink margin over the uplink margin at full
+ * device power in dB, gateways transmit at a higher power
+ */
+#define LORAMAC_TXPOWER_CTRL_DL_ASYMMETRY           10
+
+/*!
+ * Power step of one regional TX power index in dB
+ */
+#define LORAMAC_TXPOWER_CTRL_STEP                   2
+
+/*!
+ * Number of consecutive good margins needed to step the power down
+ */
+#define LORAMAC_TXPOWER_CTRL_NB_GOOD_MARGINS        3
+
+/*!
+ * Number of uplinks without downlink after which the power is stepped up
+ * again at every further uplink
+ */
+#define LORAMAC_TXPOWER_CTRL_SILENCE_LIMIT          16
+
+/*!
+ * Number of uplinks without margin information after which a LinkCheckReq
+ * is piggybacked, 0 to never request one
+ */
+#define LORAMAC_TXPOWER_CTRL_LINK_CHECK_PERIOD      64
+
+/*!
+ * \brief   Initializes the controller at full power.
+ *
+ * \param   [IN] region - Active region.
+ */
+void LoRaMacTxPowerCtrlInit( LoRaMacRegion_t region );
+
+/*!
+ * \brief   Returns to the power set by the application or by LinkADRReq.
+ */
+void LoRaMacTxPowerCtrlReset( void );
+
+/*!
+ * \brief   Computes the TX power of the next uplink.
+ *
+ * \param   [IN] txPower - TX power index set by the application or by LinkADRReq.
+ *
+ * \param   [IN] adrOn - Set to true if ADR is enabled.
+ *
+ * \retval  TX power index to use, never above the given power.
+ */
+int8_t LoRaMacTxPowerCtrlApply( int8_t txPower, bool adrOn );
+
+/*!
+ * \brief   Feeds the SNR of a valid class A downlink.
+ *
+ * \param   [IN] datarate - Downlink datarate.
+ *
+ * \param   [IN] snr - Downlink SNR in dB.
+ */
+void LoRaMacTxPowerCtrlDownlink( int8_t datarate, int8_t snr );
+
+/*!
+ * \brief   Feeds the margin of a LinkCheckAns.
+ *
+ * \param   [IN] margin - Demodulation margin of the last uplink in dB.
+ */
+void LoRaMacTxPowerCtrlLinkCheckAns( uint8_t margin );
+
+/*!
+ * \brief   Feeds the outcome of an uplink, once its RX windows are over.
+ *
+ * \param   [IN] ackRequested - Set to true for a confirmed uplink.
+ *
+ * \param   [IN] ackReceived - Set to true if the ack was received.
+ */
+void LoRaMacTxPowerCtrlUplinkDone( bool ackRequested, bool ackReceived );
+
+/*!
+ * \brief   Tells if a LinkCheckReq should be piggybacked on the next uplink.
+ *          The period restarts each time true is returned.
+ *
+ * \retval  true if the controller lacks margin information.
+ */
+bool LoRaMacTxPowerCtrlIsLinkCheckNeeded( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+/*! \} defgroup LORAMACTXPOWERCTRL */
+
+#endif // __LORAMAC_TXPOWER_CTRL_H__
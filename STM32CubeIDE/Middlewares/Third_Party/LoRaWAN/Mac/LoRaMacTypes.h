@@ -62,7 +62,7 @@ extern "C"
 /*!
  * Maximum number of multicast context
  */
-#define   LORAMAC_MAX_MC_CTX            1
+#define   LORAMAC_MAX_MC_CTX            4
 
 /*!
  * LoRaWAN devices classes definition
@@ -29,7 +29,9 @@
  * \author    Daniel Jaeckle ( STACKFORCE )
  */
 #include "LoRaMac.h"
+#include "Region.h"
 
+#if ( LORAMAC_SINGLE_REGION == 0 )
 // Setup regions
 #ifdef REGION_AS923
 #include "RegionAS923.h"
@@ -457,6 +459,7 @@
 #define US915_GET_NVM_CTX( )                       US915_CASE { return RegionUS915GetNvmCtx( params ); }
 #define US915_VERIFY( )                            US915_CASE { return RegionUS915Verify( verify, phyAttribute ); }
 #define US915_APPLY_CF_LIST( )                     US915_CASE { RegionUS915ApplyCFList( applyCFList ); break; }
+#define US915_ON_JOIN_ACCEPT( )                    US915_CASE { RegionUS915OnJoinAccept( ); break; }
 #define US915_CHAN_MASK_SET( )                     US915_CASE { return RegionUS915ChanMaskSet( chanMaskSet ); }
 #define US915_COMPUTE_RX_WINDOW_PARAMETERS( )      US915_CASE { RegionUS915ComputeRxWindowParameters( datarate, minRxSymbols, rxError, rxConfigParams ); break; }
 #define US915_RX_CONFIG( )                         US915_CASE { return RegionUS915RxConfig( rxConfig, datarate ); }
@@ -481,6 +484,7 @@
 #define US915_GET_NVM_CTX( )
 #define US915_VERIFY( )
 #define US915_APPLY_CF_LIST( )
+#define US915_ON_JOIN_ACCEPT( )
 #define US915_CHAN_MASK_SET( )
 #define US915_COMPUTE_RX_WINDOW_PARAMETERS( )
 #define US915_RX_CONFIG( )
@@ -699,6 +703,18 @@ void RegionApplyCFList( LoRaMacRegion_t region, ApplyCFListParams_t* applyCFList
     }
 }
 
+void RegionOnJoinAccept( LoRaMacRegion_t region )
+{
+    switch( region )
+    {
+        US915_ON_JOIN_ACCEPT( );
+        default:
+        {
+            break;
+        }
+    }
+}
+
 bool RegionChanMaskSet( LoRaMacRegion_t region, ChanMaskSetParams_t* chanMaskSet )
 {
     switch( region )
@@ -1035,6 +1051,8 @@ void RegionRxBeaconSetup( LoRaMacRegion_t region, RxBeaconSetup_t* rxBeaconSetup
     }
 }
 
+#endif /* LORAMAC_SINGLE_REGION == 0 */
+
 Version_t RegionGetVersion( void )
 {
     Version_t version;
@@ -1471,6 +1471,15 @@ bool RegionVerify( LoRaMacRegion_t region, VerifyParams_t* verify, PhyAttribute_
  */
 void RegionApplyCFList( LoRaMacRegion_t region, ApplyCFListParams_t* applyCFList );
 
+/*!
+ * \brief Notifies the region of an accepted join request, once the join
+ *        accept is applied. Only regions which learn from the join outcome
+ *        implement it.
+ *
+ * \param [IN] region LoRaWAN region.
+ */
+void RegionOnJoinAccept( LoRaMacRegion_t region );
+
 /*!
  * \brief Sets a channels mask.
  *
@@ -1719,6 +1728,95 @@ void RegionRxBeaconSetup( LoRaMacRegion_t region, RxBeaconSetup_t* rxBeaconSetup
  */
 Version_t RegionGetVersion( void );
 
+#if ( LORAMAC_SINGLE_REGION == 1 )
+/*
+ * Single region build: the active region is known at compile time, the
+ * dispatch functions above are replaced by direct calls into the regional
+ * implementation. The region argument is still evaluated but otherwise ignored,
+ * RegionIsActive( ) only accepts the compiled region.
+ */
+#if ( defined( REGION_AS923 ) + defined( REGION_AU915 ) + defined( REGION_CN470 ) + \
+      defined( REGION_CN779 ) + defined( REGION_EU433 ) + defined( REGION_EU868 ) + \
+      defined( REGION_KR920 ) + defined( REGION_IN865 ) + defined( REGION_US915 ) + \
+      defined( REGION_RU864 ) ) != 1
+#error "LORAMAC_SINGLE_REGION requires exactly one REGION_xxx to be defined"
+#endif
+
+#if defined( REGION_AS923 )
+#include "RegionAS923.h"
+#define REGION_SINGLE_ID                            LORAMAC_REGION_AS923
+#define REGION_SINGLE( fn )                         RegionAS923##fn
+#elif defined( REGION_AU915 )
+#include "RegionAU915.h"
+#define REGION_SINGLE_ID                            LORAMAC_REGION_AU915
+#define REGION_SINGLE( fn )                         RegionAU915##fn
+#elif defined( REGION_CN470 )
+#include "RegionCN470.h"
+#define REGION_SINGLE_ID                            LORAMAC_REGION_CN470
+#define REGION_SINGLE( fn )                         RegionCN470##fn
+#elif defined( REGION_CN779 )
+#include "RegionCN779.h"
+#define REGION_SINGLE_ID                            LORAMAC_REGION_CN779
+#define REGION_SINGLE( fn )                         RegionCN779##fn
+#elif defined( REGION_EU433 )
+#include "RegionEU433.h"
+#define REGION_SINGLE_ID                            LORAMAC_REGION_EU433
+#define REGION_SINGLE( fn )                         RegionEU433##fn
+#elif defined( REGION_EU868 )
+#include "RegionEU868.h"
+#define REGION_SINGLE_ID                            LORAMAC_REGION_EU868
+#define REGION_SINGLE( fn )                         RegionEU868##fn
+#elif defined( REGION_KR920 )
+#include "RegionKR920.h"
+#define REGION_SINGLE_ID                            LORAMAC_REGION_KR920
+#define REGION_SINGLE( fn )                         RegionKR920##fn
+#elif defined( REGION_IN865 )
+#include "RegionIN865.h"
+#define REGION_SINGLE_ID                            LORAMAC_REGION_IN865
+#define REGION_SINGLE( fn )                         RegionIN865##fn
+#elif defined( REGION_US915 )
+#include "RegionUS915.h"
+#define REGION_SINGLE_ID                            LORAMAC_REGION_US915
+#define REGION_SINGLE( fn )                         RegionUS915##fn
+#elif defined( REGION_RU864 )
+#include "RegionRU864.h"
+#define REGION_SINGLE_ID                            LORAMAC_REGION_RU864
+#define REGION_SINGLE( fn )                         RegionRU864##fn
+#endif
+
+#define RegionIsActive( region )                                                    ( ( region ) == REGION_SINGLE_ID )
+#define RegionGetPhyParam( region, getPhy )                                         ( ( void )( region ), REGION_SINGLE( GetPhyParam )( getPhy ) )
+#define RegionSetBandTxDone( region, txDone )                                       ( ( void )( region ), REGION_SINGLE( SetBandTxDone )( txDone ) )
+#define RegionInitDefaults( region, params )                                        ( ( void )( region ), REGION_SINGLE( InitDefaults )( params ) )
+#define RegionGetNvmCtx( region, params )                                           ( ( void )( region ), REGION_SINGLE( GetNvmCtx )( params ) )
+#define RegionVerify( region, verify, phyAttribute )                                ( ( void )( region ), REGION_SINGLE( Verify )( verify, phyAttribute ) )
+#define RegionApplyCFList( region, applyCFList )                                    ( ( void )( region ), REGION_SINGLE( ApplyCFList )( applyCFList ) )
+#if defined( REGION_US915 )
+#define RegionOnJoinAccept( region )                                                ( ( void )( region ), RegionUS915OnJoinAccept( ) )
+#else
+#define RegionOnJoinAccept( region )                                                ( ( void )( region ) )
+#endif
+#define RegionChanMaskSet( region, chanMaskSet )                                    ( ( void )( region ), REGION_SINGLE( ChanMaskSet )( chanMaskSet ) )
+#define RegionComputeRxWindowParameters( region, datarate, minRxSymbols, rxError, rxConfigParams ) \
+    ( ( void )( region ), REGION_SINGLE( ComputeRxWindowParameters )( datarate, minRxSymbols, rxError, rxConfigParams ) )
+#define RegionRxConfig( region, rxConfig, datarate )                                ( ( void )( region ), REGION_SINGLE( RxConfig )( rxConfig, datarate ) )
+#define RegionTxConfig( region, txConfig, txPower, txTimeOnAir )                    ( ( void )( region ), REGION_SINGLE( TxConfig )( txConfig, txPower, txTimeOnAir ) )
+#define RegionLinkAdrReq( region, linkAdrReq, drOut, txPowOut, nbRepOut, nbBytesParsed ) \
+    ( ( void )( region ), REGION_SINGLE( LinkAdrReq )( linkAdrReq, drOut, txPowOut, nbRepOut, nbBytesParsed ) )
+#define RegionRxParamSetupReq( region, rxParamSetupReq )                            ( ( void )( region ), REGION_SINGLE( RxParamSetupReq )( rxParamSetupReq ) )
+#define RegionNewChannelReq( region, newChannelReq )                                ( ( void )( region ), REGION_SINGLE( NewChannelReq )( newChannelReq ) )
+#define RegionTxParamSetupReq( region, txParamSetupReq )                            ( ( void )( region ), REGION_SINGLE( TxParamSetupReq )( txParamSetupReq ) )
+#define RegionDlChannelReq( region, dlChannelReq )                                  ( ( void )( region ), REGION_SINGLE( DlChannelReq )( dlChannelReq ) )
+#define RegionAlternateDr( region, currentDr, type )                                ( ( void )( region ), REGION_SINGLE( AlternateDr )( currentDr, type ) )
+#define RegionNextChannel( region, nextChanParams, channel, time, aggregatedTimeOff ) \
+    ( ( void )( region ), REGION_SINGLE( NextChannel )( nextChanParams, channel, time, aggregatedTimeOff ) )
+#define RegionChannelAdd( region, channelAdd )                                      ( ( void )( region ), REGION_SINGLE( ChannelAdd )( channelAdd ) )
+#define RegionChannelsRemove( region, channelRemove )                               ( ( void )( region ), REGION_SINGLE( ChannelsRemove )( channelRemove ) )
+#define RegionSetContinuousWave( region, continuousWave )                           ( ( void )( region ), REGION_SINGLE( SetContinuousWave )( continuousWave ) )
+#define RegionApplyDrOffset( region, downlinkDwellTime, dr, drOffset )              ( ( void )( region ), REGION_SINGLE( ApplyDrOffset )( downlinkDwellTime, dr, drOffset ) )
+#define RegionRxBeaconSetup( region, rxBeaconSetup, outDr )                         ( ( void )( region ), REGION_SINGLE( RxBeaconSetup )( rxBeaconSetup, outDr ) )
+#endif /* LORAMAC_SINGLE_REGION == 1 */
+
 /*! \} defgroup REGION */
 
 #ifdef __cplusplus
@@ -0,0 +1,215 @@
+/*!
+ * \file      RegionTimeOnAir.cpp
+ *
+ * \brief     Compile time generation of the regional time-on-air tables
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ */
+#include <stddef.h>
+
+#include "RegionTimeOnAir.h"
+
+#if defined( REGION_US915 )
+#include "RegionUS915.h"
+#endif
+
+namespace {
+
+/*!
+ * Row map value of datarates which have no table row ( RFU or FSK )
+ */
+constexpr uint8_t NoRow = 0xFF;
+
+/*!
+ * LoRaWAN preamble length in symbols
+ */
+constexpr uint16_t LoRaWANPreambleLen = 8;
+
+/*!
+ * LoRaWAN coding rate ( 4/5 )
+ */
+constexpr uint8_t LoRaWANCodingRate = 1;
+
+/*!
+ * Same computation as RadioGetLoRaTimeOnAirNumerator( ) in radio.c, which
+ * has to stay the reference for these tables.
+ */
+constexpr uint32_t LoRaTimeOnAirNumerator( uint32_t bandwidthHz, uint32_t datarate, uint8_t coderate,
+                                           uint16_t preambleLen, bool fixLen, uint16_t payloadLen,
+                                           bool crcOn )
+{
+    int32_t crDenom = coderate + 4;
+    bool lowDatareOptimize = false;
+
+    if( ( datarate == 5 ) || ( datarate == 6 ) )
+    {
+        if( preambleLen < 12 )
+        {
+            preambleLen = 12;
+        }
+    }
+
+    if( ( ( bandwidthHz == 125000 ) && ( ( datarate == 11 ) || ( datarate == 12 ) ) ) ||
+        ( ( bandwidthHz == 250000 ) && ( datarate == 12 ) ) )
+    {
+        lowDatareOptimize = true;
+    }
+
+    int32_t ceilDenominator = 4 * int32_t( datarate );
+    int32_t ceilNumerator = ( int32_t( payloadLen ) << 3 ) +
+                            ( crcOn ? 16 : 0 ) -
+                            ( 4 * int32_t( datarate ) ) +
+                            ( fixLen ? 0 : 20 );
+
+    if( datarate > 6 )
+    {
+        ceilNumerator += 8;
+        if( lowDatareOptimize == true )
+        {
+            ceilDenominator = 4 * ( int32_t( datarate ) - 2 );
+        }
+    }
+
+    if( ceilNumerator < 0 )
+    {
+        ceilNumerator = 0;
+    }
+
+    int32_t intermediate =
+        ( ( ceilNumerator + ceilDenominator - 1 ) / ceilDenominator ) * crDenom + preambleLen + 12;
+
+    if( datarate <= 6 )
+    {
+        intermediate += 2;
+    }
+
+    return uint32_t( ( 4 * intermediate + 1 ) * ( 1 << ( datarate - 2 ) ) );
+}
+
+/*!
+ * Time-on-air in ms, rounded up like RadioTimeOnAir( ) does.
+ */
+constexpr uint16_t LoRaTimeOnAirMs( uint32_t bandwidthHz, uint32_t datarate, bool fixLen,
+                                    uint16_t payloadLen, bool crcOn )
+{
+    uint32_t numerator = 1000U * LoRaTimeOnAirNumerator( bandwidthHz, datarate, LoRaWANCodingRate,
+                                                         LoRaWANPreambleLen, fixLen, payloadLen, crcOn );
+    return uint16_t( ( numerator + bandwidthHz - 1 ) / bandwidthHz );
+}
+
+template<size_t Rows>
+struct TimeOnAirRows
+{
+    uint8_t Map[REGION_TOA_NB_DATARATES];
+    uint32_t Datarate[Rows];
+    uint32_t Bandwidth[Rows];
+};
+
+/*!
+ * Assigns a table row to every LoRa datarate of a region. FSK datarates
+ * ( bandwidth 0 ) and RFU entries ( spreading factor 0 ) get no row.
+ */
+template<size_t Rows>
+constexpr TimeOnAirRows<Rows> MakeRows( const uint8_t ( &datarates )[REGION_TOA_NB_DATARATES],
+                                        const uint32_t ( &bandwidths )[REGION_TOA_NB_DATARATES] )
+{
+    TimeOnAirRows<Rows> rows = { };
+    size_t row = 0;
+
+    for( size_t dr = 0; dr < REGION_TOA_NB_DATARATES; dr++ )
+    {
+        if( ( datarates[dr] < 5 ) || ( datarates[dr] > 12 ) || ( bandwidths[dr] == 0 ) )
+        {
+            rows.Map[dr] = NoRow;
+            continue;
+        }
+        rows.Map[dr] = uint8_t( row );
+        rows.Datarate[row] = datarates[dr];
+        rows.Bandwidth[row] = bandwidths[dr];
+        row++;
+    }
+    return rows;
+}
+
+template<size_t Rows>
+constexpr size_t CountRows( const TimeOnAirRows<Rows> &rows )
+{
+    size_t count = 0;
+    for( size_t dr = 0; dr < REGION_TOA_NB_DATARATES; dr++ )
+    {
+        if( rows.Map[dr] != NoRow )
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+template<size_t Rows>
+struct TimeOnAirTable
+{
+    uint16_t Ms[Rows][REGION_TOA_PKT_LEN_MAX];
+};
+
+template<size_t Rows>
+constexpr TimeOnAirTable<Rows> MakeTable( const TimeOnAirRows<Rows> &rows, bool fixLen, bool crcOn )
+{
+    TimeOnAirTable<Rows> table = { };
+
+    for( size_t row = 0; row < Rows; row++ )
+    {
+        for( size_t len = 0; len < REGION_TOA_PKT_LEN_MAX; len++ )
+        {
+            table.Ms[row][len] = LoRaTimeOnAirMs( rows.Bandwidth[row], rows.Datarate[row], fixLen, uint16_t( len ), crcOn );
+        }
+    }
+    return table;
+}
+
+} // namespace
+
+#if defined( REGION_US915 )
+namespace {
+
+/*!
+ * Number of LoRa datarates defined for US915
+ */
+constexpr size_t US915NbRows = 11;
+
+constexpr auto US915Rows = MakeRows<US915NbRows>( DataratesUS915, BandwidthsUS915 );
+static_assert( CountRows( US915Rows ) == US915NbRows, "US915NbRows does not match DataratesUS915" );
+
+/*
+ * Separate objects per variant so that LTO can drop the tables of variants
+ * which are never looked up.
+ */
+constexpr auto US915ExplicitCrc = MakeTable( US915Rows, false, true );
+constexpr auto US915ExplicitNoCrc = MakeTable( US915Rows, false, false );
+constexpr auto US915ImplicitCrc = MakeTable( US915Rows, true, true );
+constexpr auto US915ImplicitNoCrc = MakeTable( US915Rows, true, false );
+
+// SF10/125 kHz, 23 bytes: 370.7 ms according to the Semtech LoRa calculator
+static_assert( US915ExplicitCrc.Ms[US915Rows.Map[DR_0]][23] == 371, "US915 DR0 time-on-air" );
+
+} // namespace
+
+TimerTime_t RegionUS915TimeOnAir( int8_t datarate, uint16_t pktLen, bool crcOn, bool fixLen )
+{
+    if( ( datarate < 0 ) || ( datarate >= REGION_TOA_NB_DATARATES ) || ( pktLen >= REGION_TOA_PKT_LEN_MAX ) )
+    {
+        return 0;
+    }
+
+    uint8_t row = US915Rows.Map[datarate];
+    if( row == NoRow )
+    {
+        return 0;
+    }
+
+    if( fixLen == false )
+    {
+        return ( crcOn == true ) ? US915ExplicitCrc.Ms[row][pktLen] : US915ExplicitNoCrc.Ms[row][pktLen];
+    }
+    return ( crcOn == true ) ? US915ImplicitCrc.Ms[row][pktLen] : US915ImplicitNoCrc.Ms[row][pktLen];
+}
+#endif /* REGION_US915 */
@@ -0,0 +1,63 @@
+/*!
+ * \file      RegionTimeOnAir.h
+ *
+ * \brief     Precomputed time-on-air tables for the compiled in regions
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \defgroup  REGIONTIMEONAIR Region time-on-air tables
+ *            The tables are generated at compile time from the regional
+ *            datarate definitions and replace the integer divisions done by
+ *            Radio.TimeOnAir on every scheduling decision. One table exists
+ *            per header/CRC variant.
+ * \{
+ */
+#ifndef __REGION_TIME_ON_AIR_H__
+#define __REGION_TIME_ON_AIR_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "timer.h"
+#include "lorawan_conf.h"
+
+/*!
+ * Number of PHY payload lengths covered by the tables ( 0 to 255 bytes )
+ */
+#define REGION_TOA_PKT_LEN_MAX                      256
+
+/*!
+ * Number of datarate entries of the regional tables ( DR_0 to DR_15 )
+ */
+#define REGION_TOA_NB_DATARATES                     16
+
+#if defined( REGION_US915 )
+/*!
+ * \brief Looks up the time-on-air of an US915 LoRa frame with the LoRaWAN
+ *        preamble length of 8 symbols and coding rate 4/5.
+ *
+ * \param [IN] datarate Regional datarate.
+ *
+ * \param [IN] pktLen PHY payload length in bytes.
+ *
+ * \param [IN] crcOn Set to true if the frame carries a payload CRC.
+ *
+ * \param [IN] fixLen Set to true for implicit header frames.
+ *
+ * \retval Time-on-air in ms, 0 for datarates without table entry.
+ */
+TimerTime_t RegionUS915TimeOnAir( int8_t datarate, uint16_t pktLen, bool crcOn, bool fixLen );
+#endif /* REGION_US915 */
+
+#ifdef __cplusplus
+}
+#endif
+
+/*! \} defgroup REGIONTIMEONAIR */
+
+#endif // __REGION_TIME_ON_AIR_H__
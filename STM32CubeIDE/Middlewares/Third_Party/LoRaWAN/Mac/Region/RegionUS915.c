@@ -32,6 +32,7 @@
 
 #include "RegionCommon.h"
 #include "RegionUS915.h"
+#include "RegionTimeOnAir.h"
 
 // Definitions
 #define CHANNELS_MASK_SIZE              6
@@ -39,6 +40,15 @@
 // A mask to select only valid 500KHz channels
 #define CHANNELS_MASK_500KHZ_MASK       0x00FF
 
+// Number of 8 channel sub-bands (FSB), each with one 500KHz channel
+#define NB_SUB_BANDS                    8
+
+// No sub-band recorded
+#define SUB_BAND_NONE                   0xFF
+
+// Weight of a join accept against a join request left unanswered in the sub-band score
+#define SUB_BAND_ACCEPT_WEIGHT          8
+
 /*!
  * Region specific context
  */
@@ -72,6 +82,26 @@ typedef struct sRegionUS915NvmCtx
      * Counter of join trials needed to alternate between DR0 and DR4, see \ref RegionUS915AlternateDr
      */
     uint8_t JoinTrialsCounter;
+    /*!
+     * Number of join requests sent per sub-band
+     */
+    uint16_t JoinRequests[NB_SUB_BANDS];
+    /*!
+     * Number of join accepts received per sub-band
+     */
+    uint16_t JoinAccepts[NB_SUB_BANDS];
+    /*!
+     * Sub-band of the last join request
+     */
+    uint8_t JoinLastSubBand;
+    /*!
+     * Sub-band of the last join request which got a join accept
+     */
+    uint8_t JoinGoodSubBand;
+    /*!
+     * Sub-bands already probed in the current join sweep (bit 0: FSB1, ..., bit 7: FSB8)
+     */
+    uint8_t JoinSubBandsTried;
 }RegionUS915NvmCtx_t;
 
 /*
@@ -79,6 +109,11 @@ typedef struct sRegionUS915NvmCtx
  */
 static RegionUS915NvmCtx_t NvmCtx;
 
+/*
+ * Sub-bands the application expects the network on (bit 0: FSB1, ..., bit 7: FSB8).
+ */
+static uint8_t JoinPreferredSubBands = 0;
+
 // Static functions
 static int8_t GetNextLowerTxDr( int8_t dr, int8_t minDr )
 {
@@ -131,20 +166,79 @@ static LoRaMacStatus_t FindAvailable125kHzChannels( uint8_t* findAvailableChanne
     return LORAMAC_STATUS_OK;
 }
 
+/*!
+ * \brief Returns the remaining 125kHz channels of a sub-band.
+ *
+ * \param [IN] subBand Sub-band index, 0 to 7.
+ *
+ * \retval Channel mask of the sub-band, bit 0 is the first channel.
+ */
+static uint16_t GetSubBandChannelsRemaining( uint8_t subBand )
+{
+    // Two groups per channel mask, for even numbers we need the 8 LSBs and for uneven the 8 MSBs
+    if( ( subBand % 2 ) == 0 )
+    {
+        return ( NvmCtx.ChannelsMaskRemaining[subBand / 2] & 0x00FF );
+    }
+    return ( ( NvmCtx.ChannelsMaskRemaining[subBand / 2] >> 8 ) & 0x00FF );
+}
+
+/*!
+ * \brief Ranks a sub-band for the next join request, lower is tried first.
+ *
+ * \param [IN] subBand Sub-band index, 0 to 7.
+ *
+ * \retval Rank: 0 for the last sub-band which got a join accept, 1 for a sub-band
+ *         preferred by the application, 2 for the others.
+ */
+static uint8_t GetSubBandRank( uint8_t subBand )
+{
+    if( subBand == NvmCtx.JoinGoodSubBand )
+    {
+        return 0;
+    }
+    if( ( JoinPreferredSubBands & ( 1 << subBand ) ) != 0 )
+    {
+        return 1;
+    }
+    return 2;
+}
+
+/*!
+ * \brief Computes the join statistics score of a sub-band. Untried sub-bands
+ *        score 0, sub-bands which never answered a join request score below.
+ *
+ * \param [IN] subBand Sub-band index, 0 to 7.
+ *
+ * \retval Score
+ */
+static int32_t GetSubBandScore( uint8_t subBand )
+{
+    int32_t accepts = NvmCtx.JoinAccepts[subBand];
+    int32_t failures = ( int32_t )NvmCtx.JoinRequests[subBand] - accepts;
+
+    return ( accepts * SUB_BAND_ACCEPT_WEIGHT ) - MAX( failures, 0 );
+}
+
 /*!
  * \brief Computes the next 125kHz channel used for join requests.
  *
+ * \details Every sub-band which has channels left is probed once per sweep
+ *          so that a device still finds a network on any sub-band. Within a
+ *          sweep, the sub-band of the last join accept goes first, then the
+ *          sub-bands preferred by the application, then the others, each
+ *          group ordered by join statistics. Ties keep the default rotation.
+ *
  * \param [OUT] newChannelIndex Index of available channel.
  *
  * \retval Status
  */
 static LoRaMacStatus_t ComputeNext125kHzJoinChannel( uint8_t* newChannelIndex )
 {
-    uint8_t currentChannelsMaskRemainingIndex;
-    uint16_t channelMaskRemaining;
     uint8_t findAvailableChannelsIndex[8] = { 0 };
     uint8_t availableChannels = 0;
-    uint8_t startIndex = NvmCtx.JoinChannelGroupsCurrentIndex;
+    uint8_t candidates = 0;
+    uint8_t subBand = SUB_BAND_NONE;
 
     // Null pointer check
     if( newChannelIndex == NULL )
@@ -152,47 +246,53 @@ static LoRaMacStatus_t ComputeNext125kHzJoinChannel( uint8_t* newChannelIndex )
         return LORAMAC_STATUS_PARAMETER_INVALID;
     }
 
-    do {
-        // Current ChannelMaskRemaining, two groups per channel mask. For example Group 0 and 1 (8 bit) are ChannelMaskRemaining 0 (16 bit), etc.
-        currentChannelsMaskRemainingIndex = (uint8_t) startIndex / 2;
-
-        // For even numbers we need the 8 LSBs and for uneven the 8 MSBs
-        if( ( startIndex % 2 ) == 0 )
-        {
-            channelMaskRemaining = ( NvmCtx.ChannelsMaskRemaining[currentChannelsMaskRemainingIndex] & 0x00FF );
-        }
-        else
+    for( uint8_t i = 0; i < NB_SUB_BANDS; i++ )
+    {
+        if( GetSubBandChannelsRemaining( i ) != 0 )
         {
-            channelMaskRemaining = ( ( NvmCtx.ChannelsMaskRemaining[currentChannelsMaskRemainingIndex] >> 8 ) & 0x00FF );
+            candidates |= ( uint8_t )( 1 << i );
         }
+    }
+    if( candidates == 0 )
+    {
+        return LORAMAC_STATUS_PARAMETER_INVALID;
+    }
 
+    // Start a new sweep once all sub-bands with channels left were probed
+    if( ( candidates & ( uint8_t )~NvmCtx.JoinSubBandsTried ) == 0 )
+    {
+        NvmCtx.JoinSubBandsTried = 0;
+    }
+    candidates &= ( uint8_t )~NvmCtx.JoinSubBandsTried;
 
-        if( FindAvailable125kHzChannels( findAvailableChannelsIndex, channelMaskRemaining, &availableChannels ) == LORAMAC_STATUS_PARAMETER_INVALID )
-        {
-            return LORAMAC_STATUS_PARAMETER_INVALID;
-        }
+    for( uint8_t i = 0; i < NB_SUB_BANDS; i++ )
+    {
+        uint8_t candidate = ( NvmCtx.JoinChannelGroupsCurrentIndex + i ) % NB_SUB_BANDS;
 
-        if ( availableChannels > 0 )
+        if( ( candidates & ( 1 << candidate ) ) == 0 )
         {
-            // Choose randomly a free channel 125kHz
-            *newChannelIndex = ( startIndex * 8 ) + findAvailableChannelsIndex[randr( 0, ( availableChannels - 1 ) )];
+            continue;
         }
-
-        // Increment start index
-        startIndex++;
-        if ( startIndex > 7 )
+        if( ( subBand == SUB_BAND_NONE ) ||
+            ( GetSubBandRank( candidate ) < GetSubBandRank( subBand ) ) ||
+            ( ( GetSubBandRank( candidate ) == GetSubBandRank( subBand ) ) &&
+              ( GetSubBandScore( candidate ) > GetSubBandScore( subBand ) ) ) )
         {
-            startIndex = 0;
+            subBand = candidate;
         }
-    } while( ( availableChannels == 0 ) && ( startIndex != NvmCtx.JoinChannelGroupsCurrentIndex ) );
+    }
 
-    if ( availableChannels > 0 )
+    if( FindAvailable125kHzChannels( findAvailableChannelsIndex, GetSubBandChannelsRemaining( subBand ), &availableChannels ) == LORAMAC_STATUS_PARAMETER_INVALID )
     {
-        NvmCtx.JoinChannelGroupsCurrentIndex = startIndex;
-        return LORAMAC_STATUS_OK;
+        return LORAMAC_STATUS_PARAMETER_INVALID;
     }
 
-    return LORAMAC_STATUS_PARAMETER_INVALID;
+    // Choose randomly a free channel 125kHz
+    *newChannelIndex = ( subBand * 8 ) + findAvailableChannelsIndex[randr( 0, ( availableChannels - 1 ) )];
+
+    NvmCtx.JoinSubBandsTried |= ( uint8_t )( 1 << subBand );
+    NvmCtx.JoinChannelGroupsCurrentIndex = ( subBand + 1 ) % NB_SUB_BANDS;
+    return LORAMAC_STATUS_OK;
 }
 
 static uint32_t GetBandwidth( uint32_t drIndex )
@@ -256,10 +356,8 @@ static bool VerifyRfFreq( uint32_t freq )
 
 static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
 {
-    int8_t phyDr = DataratesUS915[datarate];
-    uint32_t bandwidth = GetBandwidth( datarate );
-
-    return Radio.TimeOnAir( MODEM_LORA, bandwidth, phyDr, 1, 8, false, pktLen, true );
+    // Same parameters as Radio.SetTxConfig in RegionUS915TxConfig: explicit header, CRC on
+    return RegionUS915TimeOnAir( datarate, pktLen, true, false );
 }
 
 PhyParam_t RegionUS915GetPhyParam( GetPhyParams_t* getPhy )
@@ -474,6 +572,16 @@ void RegionUS915SetBandTxDone( SetBandTxDoneParams_t* txDone )
 {
     RegionCommonSetBandTxDone( &NvmCtx.Bands[NvmCtx.Channels[txDone->Channel].Band],
                                txDone->LastTxAirTime, txDone->Joined, txDone->ElapsedTimeSinceStartUp );
+
+    if( txDone->Joined == false )
+    {
+        // Join request sent, the 500KHz channel 64 + n belongs to sub-band n
+        NvmCtx.JoinLastSubBand = ( txDone->Channel < 64 ) ? ( txDone->Channel / 8 ) : ( txDone->Channel - 64 );
+        if( ( NvmCtx.JoinLastSubBand < NB_SUB_BANDS ) && ( NvmCtx.JoinRequests[NvmCtx.JoinLastSubBand] < UINT16_MAX ) )
+        {
+            NvmCtx.JoinRequests[NvmCtx.JoinLastSubBand]++;
+        }
+    }
 }
 
 void RegionUS915InitDefaults( InitDefaultsParams_t* params )
@@ -493,6 +601,13 @@ void RegionUS915InitDefaults( InitDefaultsParams_t* params )
             // Initialize the join trials counter
             NvmCtx.JoinTrialsCounter = 0;
 
+            // Initialize the sub-band join statistics
+            memset1( ( uint8_t* )NvmCtx.JoinRequests, 0, sizeof( NvmCtx.JoinRequests ) );
+            memset1( ( uint8_t* )NvmCtx.JoinAccepts, 0, sizeof( NvmCtx.JoinAccepts ) );
+            NvmCtx.JoinLastSubBand = SUB_BAND_NONE;
+            NvmCtx.JoinGoodSubBand = SUB_BAND_NONE;
+            NvmCtx.JoinSubBandsTried = 0;
+
             // Default bands
             memcpy1( ( uint8_t* )NvmCtx.Bands, ( uint8_t* )bands, sizeof( Band_t ) * US915_MAX_NB_BANDS );
 
@@ -637,6 +752,21 @@ void RegionUS915ApplyCFList( ApplyCFListParams_t* applyCFList )
     }
 }
 
+void RegionUS915OnJoinAccept( void )
+{
+    // Credit the sub-band of the last join request
+    if( NvmCtx.JoinLastSubBand < NB_SUB_BANDS )
+    {
+        if( NvmCtx.JoinAccepts[NvmCtx.JoinLastSubBand] < NvmCtx.JoinRequests[NvmCtx.JoinLastSubBand] )
+        {
+            NvmCtx.JoinAccepts[NvmCtx.JoinLastSubBand]++;
+        }
+        NvmCtx.JoinGoodSubBand = NvmCtx.JoinLastSubBand;
+        NvmCtx.JoinLastSubBand = SUB_BAND_NONE;
+        NvmCtx.JoinSubBandsTried = 0;
+    }
+}
+
 bool RegionUS915ChanMaskSet( ChanMaskSetParams_t* chanMaskSet )
 {
     uint8_t nbChannels = RegionCommonCountChannels( chanMaskSet->ChannelsMaskIn, 0, 4 );
@@ -1065,6 +1195,12 @@ LoRaMacStatus_t RegionUS915NextChannel( NextChanParams_t* nextChanParams, uint8_
                 *channel = newChannelIndex;
             }
             // 500kHz Channels (64 - 71) DR4
+            else if( ( NvmCtx.JoinGoodSubBand < NB_SUB_BANDS ) &&
+                     ( ( NvmCtx.ChannelsMaskRemaining[4] & ( 1 << NvmCtx.JoinGoodSubBand ) ) != 0 ) )
+            {
+                // Use the 500kHz channel of the sub-band which answered last time
+                *channel = 64 + NvmCtx.JoinGoodSubBand;
+            }
             else
             {
                 // Choose the next available channel
@@ -1133,3 +1269,8 @@ void RegionUS915RxBeaconSetup( RxBeaconSetup_t* rxBeaconSetup, uint8_t* outDr )
     // Store downlink datarate
     *outDr = US915_BEACON_CHANNEL_DR;
 }
+
+void RegionUS915SetPreferredSubBands( uint8_t subBandsMask )
+{
+    JoinPreferredSubBands = subBandsMask;
+}
@@ -344,6 +344,12 @@ bool RegionUS915Verify( VerifyParams_t* verify, PhyAttribute_t phyAttribute );
  */
 void RegionUS915ApplyCFList( ApplyCFListParams_t* applyCFList );
 
+/*!
+ * \brief Credits the sub-band of the last join request with the join accept
+ *        and makes it the first one probed by the next join.
+ */
+void RegionUS915OnJoinAccept( void );
+
 /*!
  * \brief Sets a channels mask.
  *
@@ -509,6 +515,17 @@ uint8_t RegionUS915ApplyDrOffset( uint8_t downlinkDwellTime, int8_t dr, int8_t d
  */
 void RegionUS915RxBeaconSetup( RxBeaconSetup_t* rxBeaconSetup, uint8_t* outDr );
 
+/*!
+ * \brief Sets the sub-bands on which the network is expected. Join requests
+ *        probe these sub-bands first within every sweep over the enabled
+ *        channels, right after the sub-band of the last join accept. The
+ *        other sub-bands are still probed, after the preferred ones.
+ *
+ * \param [IN] subBandsMask Bit n set for FSB n + 1 ( channels 8n to 8n + 7
+ *                          and 64 + n ), 0 for no preference.
+ */
+void RegionUS915SetPreferredSubBands( uint8_t subBandsMask );
+
 /*! \} defgroup REGIONUS915 */
 
 #ifdef __cplusplus
@@ -442,6 +442,19 @@ struct Radio_s
      * \return 0 when no parameters error, -1 otherwise
      */
     int32_t (*RadioSetTxGenericConfig)( GenericModems_t modem, TxConfigGeneric_t* config, int8_t power, uint32_t timeout );
+    /*!
+     * \brief Starts the LoRa RX sniff: the radio wakes up periodically on its
+     *        own to look for a preamble and sleeps in between. Only packets
+     *        sent with a preamble of at least preambleLen symbols are caught.
+     *        Falls back to continuous reception when the preamble is too
+     *        short to sleep in between. The reception ends with the first
+     *        packet or error, as a single reception does.
+     *
+     * \remark Must be called after SetRxConfig
+     *
+     * \param [IN] preambleLen  Preamble length of the expected packets in symbols
+     */
+    void    ( *RxSniff )( uint16_t preambleLen );
 };
 
 /*!
@@ -70,6 +70,11 @@ typedef struct
 } FskBandwidth_t;
 
 /* Private define ------------------------------------------------------------*/
+/*!
+ * Preamble symbols the receiver listens for at each wake-up of the RX sniff
+ */
+#define RADIO_SNIFF_RX_SYMBOLS                      4
+
 /* Private macro -------------------------------------------------------------*/
 #define RADIO_BIT_MASK(__n)  (~(1<<__n))
 
@@ -455,6 +460,13 @@ static void RadioRxBoosted( uint32_t timeout );
  */
 static void RadioSetRxDutyCycle( uint32_t rxTime, uint32_t sleepTime );
 
+/*!
+ * \brief Starts the LoRa RX sniff for packets sent with a long preamble
+ *
+ * \param [IN] preambleLen  Preamble length of the expected packets in symbols
+ */
+static void RadioRxSniff( uint16_t preambleLen );
+
 /*!
  * \brief DIO 0 IRQ callback
  */
@@ -560,6 +572,7 @@ const struct Radio_s Radio =
     RadioTxCw,
     RadioSetRxGenericConfig,
     RadioSetTxGenericConfig,
+    RadioRxSniff,
 };
 
 
@@ -1654,6 +1667,47 @@ static void RadioSetRxDutyCycle( uint32_t rxTime, uint32_t sleepTime )
     SUBGRF_SetRxDutyCycle( rxTime, sleepTime );
 }
 
+static void RadioRxSniff( uint16_t preambleLen )
+{
+    uint32_t symbolTime;
+    uint32_t rxTime;
+    int32_t sleepTime;
+
+    if( SubgRf.ModulationParams.PacketType != PACKET_TYPE_LORA )
+    {
+        RadioRx( 0 );
+        return;
+    }
+
+    // Symbol time in us
+    symbolTime = ( ( 1UL << SubgRf.ModulationParams.Params.LoRa.SpreadingFactor ) * 1000000UL ) /
+                 RadioGetLoRaBandwidthInHz( SubgRf.ModulationParams.Params.LoRa.Bandwidth );
+    rxTime = RADIO_SNIFF_RX_SYMBOLS * symbolTime;
+    // A preamble starting just after a wake-up must still be detected at the next
+    // one, which comes after the sleep and the measured wake-up, TCXO included
+    sleepTime = ( int32_t )( preambleLen * symbolTime ) - ( int32_t )( 2 * rxTime ) -
+                ( int32_t )( SUBGRF_GetRadioWakeUpTime( ) * 1000 );
+    if( sleepTime <= 0 )
+    {
+        // Preamble too short to sleep in between, listen continuously
+        RadioRx( 0 );
+        return;
+    }
+
+    // Once a packet or an error ends the reception, the radio is put in standby
+    // and the upper layer restarts the sniff
+    SubgRf.RxContinuous = false;
+    SubgRf.PacketParams.Params.LoRa.PreambleLength = preambleLen;
+    SUBGRF_SetPacketParams( &SubgRf.PacketParams );
+
+    SUBGRF_SetDioIrqParams( IRQ_RADIO_ALL, IRQ_RADIO_ALL, IRQ_RADIO_NONE, IRQ_RADIO_NONE );
+
+    DBG_GPIO_RADIO_RX(SET);
+
+    // Durations in steps of 15.625 us
+    RadioSetRxDutyCycle( ( rxTime << 6 ) / 1000, ( ( uint32_t )sleepTime << 6 ) / 1000 );
+}
+
 static void RadioStartCad( void )
 {
     SUBGRF_SetDioIrqParams( IRQ_CAD_CLEAR | IRQ_CAD_DETECTED, IRQ_CAD_CLEAR | IRQ_CAD_DETECTED, IRQ_RADIO_NONE, IRQ_RADIO_NONE );
@@ -1741,7 +1795,7 @@ static void RadioSetPublicNetwork( bool enable )
 
 static uint32_t RadioGetWakeupTime( void )
 {
-  return SUBGRF_GetRadioWakeUpTime() + RADIO_WAKEUP_TIME;
+  return SUBGRF_GetRadioWakeUpTime();
 }
 
 
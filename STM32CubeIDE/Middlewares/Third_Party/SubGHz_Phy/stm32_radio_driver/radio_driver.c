@@ -35,6 +35,7 @@
 #include "radio_conf.h"
 #include "mw_log_conf.h"
 #include "stm32_lpm.h"
+#include "stm32_timer.h"
 
 /* External variables ---------------------------------------------------------*/
 /*!
@@ -65,6 +66,34 @@ typedef struct
 #define XTAL_FREQ                                   32000000UL
 #endif
 
+#if ( RADIO_WAKEUP_CALIBRATION_ENABLED == 1 )
+/*!
+ * \brief Fixed point scale of the wake-up estimate ( 1/256 timer tick )
+ */
+#define WAKEUP_CALIB_SCALE                          256
+
+/*!
+ * \brief Step of the percentile estimate in 1/256 timer tick. The estimate
+ *        moves up by RADIO_WAKEUP_CALIBRATION_PERCENTILE steps on each longer
+ *        sample and down by ( 100 - RADIO_WAKEUP_CALIBRATION_PERCENTILE )
+ *        steps on each shorter one, so that it settles where that share of
+ *        the samples is shorter. With the 95th percentile a longer sample
+ *        moves it by 0.37 tick, well below the wake-up time of a few ticks.
+ */
+#define WAKEUP_CALIB_STEP                           1
+
+/*!
+ * \brief Samples needed before the estimate replaces the board constant
+ */
+#define WAKEUP_CALIB_MIN_SAMPLES                    16
+
+/*!
+ * \brief Samples longer than this are discarded ( radio woken up long before
+ *        the RX/TX request ), in ms
+ */
+#define WAKEUP_CALIB_MAX_SAMPLE                     50
+#endif /* RADIO_WAKEUP_CALIBRATION_ENABLED == 1 */
+
 /* Private macro -------------------------------------------------------------*/
 
 #define SX_FREQ_TO_CHANNEL( channel, freq )                                  \
@@ -73,8 +102,8 @@ do                                                                           \
   channel = (uint32_t) ((((uint64_t) freq)<<25)/(XTAL_FREQ) );               \
 }while( 0 )
 
-#define SUBGRF_WriteCommand( x, y, z )  HAL_SUBGHZ_ExecSetCmd( &hsubghz, (x), (y), (z) )
-#define SUBGRF_ReadCommand( x, y, z )   HAL_SUBGHZ_ExecGetCmd( &hsubghz, (x), (y), (z) )
+#define SUBGRF_WriteCommand( x, y, z )  ( RadioWakeUpStart( ), HAL_SUBGHZ_ExecSetCmd( &hsubghz, (x), (y), (z) ) )
+#define SUBGRF_ReadCommand( x, y, z )   ( RadioWakeUpStart( ), HAL_SUBGHZ_ExecGetCmd( &hsubghz, (x), (y), (z) ) )
 
 /* Private variables ---------------------------------------------------------*/
 /*!
@@ -102,6 +131,24 @@ volatile uint32_t FrequencyError = 0;
  */
 static bool ImageCalibrated = false;
 
+/*!
+ * \brief SMPS drive of the selected TX path, applied when the switch goes to TX
+ */
+static uint8_t TxSmpsDrive = SMPS_DRIVE_SETTING_MAX;
+
+#if ( RADIO_WAKEUP_CALIBRATION_ENABLED == 1 )
+/*!
+ * \brief Radio wake-up calibration context
+ */
+static struct
+{
+    bool Pending;                                   //!< A wake-up from sleep is being timed
+    uint32_t Start;                                 //!< Timer value of the first access after sleep
+    uint32_t Estimate;                              //!< Percentile estimate in 1/256 timer tick
+    uint16_t NbSamples;                             //!< Number of samples taken
+}WakeUpCalib;
+#endif /* RADIO_WAKEUP_CALIBRATION_ENABLED == 1 */
+
 /* Private function prototypes -----------------------------------------------*/
 
 /*!
@@ -109,6 +156,21 @@ static bool ImageCalibrated = false;
  */
 static void Radio_SMPS_Set( uint8_t level );
 
+/*!
+ * \brief Applies the PA configuration and the TX power
+ */
+static void SUBGRF_SetPaPath( uint8_t paSelect, uint8_t paDutyCycle, uint8_t hpMax, int8_t power, RadioRampTimes_t rampTime );
+
+/*!
+ * \brief Timestamps the first access to the radio after it was put to sleep
+ */
+static void RadioWakeUpStart( void );
+
+/*!
+ * \brief Ends the wake-up timing once the radio reached RX or TX
+ */
+static void RadioWakeUpStop( void );
+
 /*!
  * \brief IRQ Callback radio function
  */
@@ -279,6 +341,9 @@ void SUBGRF_SetSleep( SleepParams_t sleepConfig )
                       ( ( uint8_t )sleepConfig.Fields.WakeUpRTC ) );
     SUBGRF_WriteCommand( RADIO_SET_SLEEP, &value, 1 );
     OperatingMode = MODE_SLEEP;
+#if ( RADIO_WAKEUP_CALIBRATION_ENABLED == 1 )
+    WakeUpCalib.Pending = false;
+#endif /* RADIO_WAKEUP_CALIBRATION_ENABLED == 1 */
 }
 
 void SUBGRF_SetStandby( RadioStandbyModes_t standbyConfig )
@@ -310,6 +375,7 @@ void SUBGRF_SetTx( uint32_t timeout )
     buf[1] = ( uint8_t )( ( timeout >> 8 ) & 0xFF );
     buf[2] = ( uint8_t )( timeout & 0xFF );
     SUBGRF_WriteCommand( RADIO_SET_TX, buf, 3 );
+    RadioWakeUpStop( );
 }
 
 void SUBGRF_SetRx( uint32_t timeout )
@@ -322,6 +388,7 @@ void SUBGRF_SetRx( uint32_t timeout )
     buf[1] = ( uint8_t )( ( timeout >> 8 ) & 0xFF );
     buf[2] = ( uint8_t )( timeout & 0xFF );
     SUBGRF_WriteCommand( RADIO_SET_RX, buf, 3 );
+    RadioWakeUpStop( );
 }
 
 void SUBGRF_SetRxBoosted( uint32_t timeout )
@@ -338,6 +405,7 @@ void SUBGRF_SetRxBoosted( uint32_t timeout )
     buf[1] = ( uint8_t )( ( timeout >> 8 ) & 0xFF );
     buf[2] = ( uint8_t )( timeout & 0xFF );
     SUBGRF_WriteCommand( RADIO_SET_RX, buf, 3 );
+    RadioWakeUpStop( );
 }
 
 void SUBGRF_SetRxDutyCycle( uint32_t rxTime, uint32_t sleepTime )
@@ -550,49 +618,23 @@ RadioPacketTypes_t SUBGRF_GetPacketType( void )
 
 void SUBGRF_SetTxParams( uint8_t paSelect, int8_t power, RadioRampTimes_t rampTime ) 
 {
-    uint8_t buf[2];
-
     if( paSelect == RFO_LP )
     {
+        TxSmpsDrive = SMPS_DRIVE_SETTING_MAX;
         if( power == 15 )
         {
-            SUBGRF_SetPaConfig( 0x06, 0x00, 0x01, 0x01 );
+            SUBGRF_SetPaPath( RFO_LP, 0x06, 0x00, power, rampTime );
         }
         else
         {
-            SUBGRF_SetPaConfig( 0x04, 0x00, 0x01, 0x01 );
+            SUBGRF_SetPaPath( RFO_LP, 0x04, 0x00, power, rampTime );
         }
-        if( power >= 14 )
-        {
-            power = 14;
-        }
-        else if( power < -17 )
-        {
-            power = -17;
-        }
-        SUBGRF_WriteRegister( REG_OCP, 0x18 ); // current max is 80 mA for the whole device
     }
     else // rfo_hp
     {
-        // WORKAROUND - Better Resistance of the SX1262 Tx to Antenna Mismatch, see DS_SX1261-2_V1.2 datasheet chapter 15.2
-        // RegTxClampConfig = @address 0x08D8
-        SUBGRF_WriteRegister( REG_TX_CLAMP, SUBGRF_ReadRegister( REG_TX_CLAMP ) | ( 0x0F << 1 ) );
-        // WORKAROUND END
-
-        SUBGRF_SetPaConfig( 0x04, 0x07, 0x00, 0x01 );
-        if( power > 22 )
-        {
-            power = 22;
-        }
-        else if( power < -9 )
-        {
-            power = -9;
-        }
-        SUBGRF_WriteRegister( REG_OCP, 0x38 ); // current max 160mA for the whole device
+        TxSmpsDrive = SMPS_DRIVE_SETTING_DEFAULT;
+        SUBGRF_SetPaPath( RFO_HP, 0x04, 0x07, power, rampTime );
     }
-    buf[0] = power;
-    buf[1] = ( uint8_t )rampTime;
-    SUBGRF_WriteCommand( RADIO_SET_TXPARAMS, buf, 2 );
 }
 
 void SUBGRF_SetModulationParams( ModulationParams_t *modulationParams )
@@ -859,33 +901,39 @@ void SUBGRF_ClearIrqStatus( uint16_t irq )
 
 void SUBGRF_WriteRegister( uint16_t addr, uint8_t data )
 {
+    RadioWakeUpStart( );
     HAL_SUBGHZ_WriteRegisters( &hsubghz, addr, (uint8_t*)&data, 1 );
 }
 
 uint8_t SUBGRF_ReadRegister( uint16_t addr )
 {
     uint8_t data;
+    RadioWakeUpStart( );
     HAL_SUBGHZ_ReadRegisters( &hsubghz, addr, &data, 1 );
     return data;
 }
 
 void SUBGRF_WriteRegisters( uint16_t address, uint8_t *buffer, uint16_t size )
 {
+    RadioWakeUpStart( );
     HAL_SUBGHZ_WriteRegisters( &hsubghz, address, buffer, size );
 }
 
 void SUBGRF_ReadRegisters( uint16_t address, uint8_t *buffer, uint16_t size )
 {
+    RadioWakeUpStart( );
     HAL_SUBGHZ_ReadRegisters( &hsubghz, address, buffer, size );
 }
 
 void SUBGRF_WriteBuffer( uint8_t offset, uint8_t *buffer, uint8_t size )
 {
+    RadioWakeUpStart( );
     HAL_SUBGHZ_WriteBuffer( &hsubghz, offset, buffer, size );
 }
 
 void SUBGRF_ReadBuffer( uint8_t offset, uint8_t *buffer, uint8_t size )
 {
+    RadioWakeUpStart( );
     HAL_SUBGHZ_ReadBuffer( &hsubghz, offset, buffer, size );
 }
 
@@ -898,12 +946,12 @@ void SUBGRF_SetSwitch( uint8_t paSelect, RFState_t rxtx )
         if (paSelect == RFO_LP)
         {
             state = RBI_SWITCH_RFO_LP;
-            Radio_SMPS_Set(SMPS_DRIVE_SETTING_MAX);
         }
         if (paSelect == RFO_HP)
         {
             state = RBI_SWITCH_RFO_HP;
         }
+        Radio_SMPS_Set(TxSmpsDrive);
     }
     else
     {
@@ -917,46 +965,38 @@ void SUBGRF_SetSwitch( uint8_t paSelect, RFState_t rxtx )
 
 uint8_t SUBGRF_SetRfTxPower( int8_t power ) 
 {
-    uint8_t paSelect= RFO_LP;
+    uint8_t paSelect;
+    RBI_TxPath_t txPath;
 
-    int32_t TxConfig = RBI_GetTxConfig();
+    // Most current efficient PA, PA settings and SMPS drive of the board for this power
+    RBI_GetTxPath( power, &txPath );
+    paSelect = ( txPath.PaSelect == RBI_PA_HP ) ? RFO_HP : RFO_LP;
+    TxSmpsDrive = ( uint8_t )( ( txPath.SmpsDrive << 1 ) & SMPS_DRV_MASK );
 
-    switch (TxConfig)
-    {
-        case RBI_CONF_RFO_LP_HP:
-        {
-            if (power > 15)
-            {
-                paSelect = RFO_HP;
-            }
-            else
-            {
-                paSelect = RFO_LP;
-            }
-            break;
-        }
-        case RBI_CONF_RFO_LP:
-        {
-            paSelect = RFO_LP;
-            break;
-        }
-        case RBI_CONF_RFO_HP:
-        {
-            paSelect = RFO_HP;
-            break;
-        }
-        default:
-            break;
-    }
-
-    SUBGRF_SetTxParams( paSelect, power, RADIO_RAMP_40_US );
+    SUBGRF_SetPaPath( paSelect, txPath.PaDutyCycle, txPath.HpMax, txPath.TxParam, RADIO_RAMP_40_US );
 
     return paSelect;
 }
 
 uint32_t SUBGRF_GetRadioWakeUpTime( void )
 {
-    return ( uint32_t ) RBI_GetWakeUpTime();
+    uint32_t boardWakeUpTime = ( uint32_t ) RBI_GetWakeUpTime() + RADIO_WAKEUP_TIME;
+#if ( RADIO_WAKEUP_CALIBRATION_ENABLED == 1 )
+    uint32_t wakeUpTime;
+
+    if( WakeUpCalib.NbSamples < WAKEUP_CALIB_MIN_SAMPLES )
+    {
+        return boardWakeUpTime;
+    }
+
+    wakeUpTime = UTIL_TimerDriver.Tick2ms( ( WakeUpCalib.Estimate + WAKEUP_CALIB_SCALE - 1 ) / WAKEUP_CALIB_SCALE );
+    wakeUpTime += RADIO_WAKEUP_CALIBRATION_MARGIN;
+
+    // The board constant stays the upper bound
+    return ( wakeUpTime < boardWakeUpTime ) ? wakeUpTime : boardWakeUpTime;
+#else
+    return boardWakeUpTime;
+#endif /* RADIO_WAKEUP_CALIBRATION_ENABLED == 1 */
 }
 
 /* HAL_SUBGHz Callbacks definitions */ 
@@ -1015,6 +1055,101 @@ void HAL_SUBGHZ_HeaderValidCallback(SUBGHZ_HandleTypeDef *hsubghz)
     RadioOnDioIrqCb( IRQ_HEADER_VALID );
 }
 
+static void RadioWakeUpStart( void )
+{
+#if ( RADIO_WAKEUP_CALIBRATION_ENABLED == 1 )
+    if( ( OperatingMode == MODE_SLEEP ) && ( WakeUpCalib.Pending == false ) )
+    {
+        WakeUpCalib.Start = UTIL_TimerDriver.GetTimerValue( );
+        WakeUpCalib.Pending = true;
+    }
+#endif /* RADIO_WAKEUP_CALIBRATION_ENABLED == 1 */
+}
+
+static void RadioWakeUpStop( void )
+{
+#if ( RADIO_WAKEUP_CALIBRATION_ENABLED == 1 )
+    uint32_t sample;
+
+    if( WakeUpCalib.Pending == false )
+    {
+        return;
+    }
+    WakeUpCalib.Pending = false;
+
+    // SetRx/SetTx return once BUSY is released, i.e. once the TCXO is settled
+    // and the PLL is locked
+    sample = UTIL_TimerDriver.GetTimerValue( ) - WakeUpCalib.Start;
+    if( sample > UTIL_TimerDriver.ms2Tick( WAKEUP_CALIB_MAX_SAMPLE ) )
+    {
+        return;
+    }
+    sample *= WAKEUP_CALIB_SCALE;
+
+    if( WakeUpCalib.NbSamples == 0 )
+    {
+        WakeUpCalib.Estimate = sample;
+    }
+    else if( sample > WakeUpCalib.Estimate )
+    {
+        WakeUpCalib.Estimate += WAKEUP_CALIB_STEP * RADIO_WAKEUP_CALIBRATION_PERCENTILE;
+    }
+    else if( WakeUpCalib.Estimate > ( WAKEUP_CALIB_STEP * ( 100 - RADIO_WAKEUP_CALIBRATION_PERCENTILE ) ) )
+    {
+        WakeUpCalib.Estimate -= WAKEUP_CALIB_STEP * ( 100 - RADIO_WAKEUP_CALIBRATION_PERCENTILE );
+    }
+    else
+    {
+        WakeUpCalib.Estimate = 0;
+    }
+
+    if( WakeUpCalib.NbSamples < UINT16_MAX )
+    {
+        WakeUpCalib.NbSamples++;
+    }
+#endif /* RADIO_WAKEUP_CALIBRATION_ENABLED == 1 */
+}
+
+static void SUBGRF_SetPaPath( uint8_t paSelect, uint8_t paDutyCycle, uint8_t hpMax, int8_t power, RadioRampTimes_t rampTime )
+{
+    uint8_t buf[2];
+
+    if( paSelect == RFO_LP )
+    {
+        SUBGRF_SetPaConfig( paDutyCycle, 0x00, 0x01, 0x01 );
+        if( power >= 14 )
+        {
+            power = 14;
+        }
+        else if( power < -17 )
+        {
+            power = -17;
+        }
+        SUBGRF_WriteRegister( REG_OCP, 0x18 ); // current max is 80 mA for the whole device
+    }
+    else // rfo_hp
+    {
+        // WORKAROUND - Better Resistance of the SX1262 Tx to Antenna Mismatch, see DS_SX1261-2_V1.2 datasheet chapter 15.2
+        // RegTxClampConfig = @address 0x08D8
+        SUBGRF_WriteRegister( REG_TX_CLAMP, SUBGRF_ReadRegister( REG_TX_CLAMP ) | ( 0x0F << 1 ) );
+        // WORKAROUND END
+
+        SUBGRF_SetPaConfig( paDutyCycle, hpMax, 0x00, 0x01 );
+        if( power > 22 )
+        {
+            power = 22;
+        }
+        else if( power < -9 )
+        {
+            power = -9;
+        }
+        SUBGRF_WriteRegister( REG_OCP, 0x38 ); // current max 160mA for the whole device
+    }
+    buf[0] = power;
+    buf[1] = ( uint8_t )rampTime;
+    SUBGRF_WriteCommand( RADIO_SET_TXPARAMS, buf, 2 );
+}
+
 static void Radio_SMPS_Set(uint8_t level)
 {
   if ( 1U == RBI_IsDCDC() )
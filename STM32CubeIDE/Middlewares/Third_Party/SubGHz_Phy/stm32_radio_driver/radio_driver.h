@@ -1186,16 +1186,23 @@ uint8_t SUBGRF_ReadRegister( uint16_t address );
 void SUBGRF_SetSwitch (uint8_t paSelect, RFState_t rxtx);
 
 /*!
- * \brief Set the Tx End Device conducted power
- * \param [in]  power           Tx power level [0..15]
+ * \brief Set the Tx End Device conducted power through the most current
+ *        efficient PA, PA settings and SMPS drive of the board TX path table
+ * \param [in]  power           Tx power level in dBm
  * \retval      paSelect        [RFO_LP, RFO_HP]
  */
 uint8_t SUBGRF_SetRfTxPower(  int8_t power );
 
 /*!
  * \brief   Service to get the radio wake-up time.
+ *
+ * \remark  With RADIO_WAKEUP_CALIBRATION_ENABLED, the time from the first
+ *          access after sleep until the radio is in RX or TX is measured on
+ *          every wake-up and a percentile of it, plus a margin, is returned.
+ *          RBI_GetWakeUpTime( ) + RADIO_WAKEUP_TIME is returned until enough
+ *          samples are available and stays the upper bound.
  * \param   none
- * \retval  Value of the radio wake-up time.
+ * \retval  Value of the radio wake-up time in ms.
  */
 uint32_t SUBGRF_GetRadioWakeUpTime( void );
 
@@ -22,39 +22,138 @@
 #include "stm32_mem.h"
    
 /* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief Word access to byte buffers
+  */
+#if defined(__GNUC__)
+typedef uint32_t __attribute__((__may_alias__)) UTIL_MEM_Word_t;
+#else
+typedef uint32_t UTIL_MEM_Word_t;
+#endif /* __GNUC__ */
+
 /* Private defines -----------------------------------------------------------*/
+#define UTIL_MEM_WORD_MASK      3U
+
 /* Private macros ------------------------------------------------------------*/
+#define UTIL_MEM_IS_ALIGNED( __p__ )  ( ( ( uintptr_t )( __p__ ) & UTIL_MEM_WORD_MASK ) == 0U )
+
 /* Private variables ---------------------------------------------------------*/
 /* Global variables ----------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 /* Functions Definition ------------------------------------------------------*/
 
+/* The destination is word aligned first. When the source ends up aligned as
+ * well, 16 bytes are moved per iteration (LDM/STM), otherwise the source is
+ * read with unaligned word loads, which the Cortex-M4 supports. */
 void UTIL_MEM_cpy_8( void *dst, const void *src, uint16_t size )
 {
   uint8_t* dst8= (uint8_t *) dst;
-  uint8_t* src8= (uint8_t *) src;
+  const uint8_t* src8= (const uint8_t *) src;
+  UTIL_MEM_Word_t* dst32;
 
-  while( size-- )
+  while( ( size > 0U ) && !UTIL_MEM_IS_ALIGNED( dst8 ) )
+  {
+    *dst8++ = *src8++;
+    size--;
+  }
+
+  dst32 = (UTIL_MEM_Word_t *) dst8;
+  if( UTIL_MEM_IS_ALIGNED( src8 ) )
+  {
+    const UTIL_MEM_Word_t* src32 = (const UTIL_MEM_Word_t *) src8;
+
+    while( size >= 16U )
+    {
+      uint32_t w0 = src32[0];
+      uint32_t w1 = src32[1];
+      uint32_t w2 = src32[2];
+      uint32_t w3 = src32[3];
+      dst32[0] = w0;
+      dst32[1] = w1;
+      dst32[2] = w2;
+      dst32[3] = w3;
+      src32 += 4;
+      dst32 += 4;
+      size -= 16U;
+    }
+    while( size >= 4U )
     {
-        *dst8++ = *src8++;
+      *dst32++ = *src32++;
+      size -= 4U;
     }
+    src8 = (const uint8_t *) src32;
+  }
+  else
+  {
+    while( size >= 4U )
+    {
+      *dst32++ = __UNALIGNED_UINT32_READ( src8 );
+      src8 += 4;
+      size -= 4U;
+    }
+  }
+  dst8 = (uint8_t *) dst32;
+
+  while( size-- )
+  {
+    *dst8++ = *src8++;
+  }
 }
 
+/* Filled backwards from the end of the destination, once it is word
+ * aligned each source word is byte-reversed with REV. */
 void UTIL_MEM_cpyr_8( void *dst, const void *src, uint16_t size )
 {
-    uint8_t* dst8= (uint8_t *) dst;
-    uint8_t* src8= (uint8_t *) src;
-    
-    dst8 = dst8 + ( size - 1 );
+    uint8_t* dst8= (uint8_t *) dst + size;
+    const uint8_t* src8= (const uint8_t *) src;
+
+    while( ( size > 0U ) && !UTIL_MEM_IS_ALIGNED( dst8 ) )
+    {
+        *--dst8 = *src8++;
+        size--;
+    }
+    while( size >= 4U )
+    {
+        dst8 -= 4;
+        *(UTIL_MEM_Word_t *) dst8 = __REV( __UNALIGNED_UINT32_READ( src8 ) );
+        src8 += 4;
+        size -= 4U;
+    }
     while( size-- )
     {
-        *dst8-- = *src8++;
+        *--dst8 = *src8++;
     }
 }
 
 void UTIL_MEM_set_8( void *dst, uint8_t value, uint16_t size )
 {
   uint8_t* dst8= (uint8_t *) dst;
+  UTIL_MEM_Word_t* dst32;
+  uint32_t value32 = value * 0x01010101U;
+
+  while( ( size > 0U ) && !UTIL_MEM_IS_ALIGNED( dst8 ) )
+  {
+    *dst8++ = value;
+    size--;
+  }
+
+  dst32 = (UTIL_MEM_Word_t *) dst8;
+  while( size >= 16U )
+  {
+    dst32[0] = value32;
+    dst32[1] = value32;
+    dst32[2] = value32;
+    dst32[3] = value32;
+    dst32 += 4;
+    size -= 16U;
+  }
+  while( size >= 4U )
+  {
+    *dst32++ = value32;
+    size -= 4U;
+  }
+  dst8 = (uint8_t *) dst32;
+
   while( size-- )
   {
     *dst8++ = value;
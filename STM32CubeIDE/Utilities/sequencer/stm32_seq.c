@@ -70,6 +70,13 @@ typedef struct
   #define UTIL_SEQ_EXIT_CRITICAL_SECTION_IDLE( )     UTIL_SEQ_EXIT_CRITICAL_SECTION( )
 #endif
 
+/**
+ * @brief macro called with the index of a task before it is executed
+ */
+#ifndef UTIL_SEQ_TASK_ENTRY
+  #define UTIL_SEQ_TASK_ENTRY( __task_idx__ )
+#endif
+
 /**
  * @brief define to represent no task running
  */
@@ -272,6 +279,7 @@ void UTIL_SEQ_Run( UTIL_SEQ_bm_t Mask_bm )
     }
     UTIL_SEQ_EXIT_CRITICAL_SECTION( );
     /** Execute the task */
+    UTIL_SEQ_TASK_ENTRY( CurrentTaskIdx );
     TaskCb[CurrentTaskIdx]( );
   }
 
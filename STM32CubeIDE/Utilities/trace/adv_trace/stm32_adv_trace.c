@@ -42,33 +42,37 @@
 #endif
 
 #if defined(UTIL_ADV_TRACE_OVERRUN)
+#error "UTIL_ADV_TRACE_OVERRUN is not supported by the lock-free FIFO"
+#endif
+
+#if ((UTIL_ADV_TRACE_FIFO_SIZE & (UTIL_ADV_TRACE_FIFO_SIZE - 1U)) != 0U) || (UTIL_ADV_TRACE_FIFO_SIZE > 2048U)
+#error "UTIL_ADV_TRACE_FIFO_SIZE shall be a power of two up to 2048"
+#endif
+
 /**
- *  @brief  List the overrun status.
- *  list of the overrun status used to handle the overrun trace evacuation.
- *
- *  @note only valid if UTIL_ADV_TRACE_OVERRUN has been enabled inside utilities conf
+ *  @brief  FIFO indexes run modulo TRACE_INDEX_MASK + 1, a multiple of the FIFO size
+ *  large enough to tell a full FIFO from an empty one.
  */
-typedef enum {
-  TRACE_OVERRUN_NONE = 0,     /*!<overrun status none.                        */
-  TRACE_OVERRUN_INDICATION,   /*!<overrun status an indication shall be sent. */
-  TRACE_OVERRUN_TRANSFERT,    /*!<overrun status data transfer ongoing.       */
-  TRACE_OVERRUN_EXECUTED,     /*!<overrun status data transfer complete.      */
-} TRACE_OVERRUN_STATUS;
-#endif
+#define TRACE_INDEX_MASK          0xFFFu
+#define TRACE_FIFO_MASK           (UTIL_ADV_TRACE_FIFO_SIZE - 1u)
 
-#if defined(UTIL_ADV_TRACE_UNCHUNK_MODE)
 /**
- *  @brief  List the unchunk status.
- *  list of the unchunk status used to handle the unchunk case.
- *
- *  @note only valid if UTIL_ADV_TRACE_UNCHUNK_MODE has been enabled inside utilities conf
+ *  @brief  fields of the FIFO state word, updated with LDREX/STREX.
+ *  HEAD is the end of the reserved data, COMMIT the end of the data ready to be
+ *  sent, PENDING the number of reservations not finalized yet. COMMIT only
+ *  moves to HEAD when PENDING drops to 0, so a reservation interrupted by
+ *  another one is never sent half written.
  */
-typedef enum {
-  TRACE_UNCHUNK_NONE = 0,     /*!<unchunk status none.                            */
-  TRACE_UNCHUNK_DETECTED,     /*!<unchunk status an unchunk has been detected.    */
-  TRACE_UNCHUNK_TRANSFER      /*!<unchunk status an unchunk transfer is ongoing. */
-} TRACE_UNCHUNK_STATUS;
-#endif
+#define TRACE_STATE_HEAD_POS      0u
+#define TRACE_STATE_COMMIT_POS    12u
+#define TRACE_STATE_PENDING_POS   24u
+#define TRACE_STATE_HEAD(s)       (((s) >> TRACE_STATE_HEAD_POS) & TRACE_INDEX_MASK)
+#define TRACE_STATE_COMMIT(s)     (((s) >> TRACE_STATE_COMMIT_POS) & TRACE_INDEX_MASK)
+#define TRACE_STATE_PENDING(s)    ((s) >> TRACE_STATE_PENDING_POS)
+#define TRACE_STATE(head, commit, pending) \
+  ((((uint32_t)(head) & TRACE_INDEX_MASK) << TRACE_STATE_HEAD_POS) | \
+   (((uint32_t)(commit) & TRACE_INDEX_MASK) << TRACE_STATE_COMMIT_POS) | \
+   ((uint32_t)(pending) << TRACE_STATE_PENDING_POS))
 /**
   * @}
  */
@@ -90,27 +94,25 @@ typedef enum {
  *  @brief  ADV_TRACE_Context.
  *  this structure contains all the data to handle the trace context.
  *
+ *  Producers, in any context, only touch State and the padding; the consumer,
+ *  the DMA transfer chain, owns TraceRdIdx and TraceSentSize while TraceBusy is
+ *  set. No interrupt is ever masked.
+ *
  *  @note some part of the context are depend with the selected switch inside the configuration file
- *  UTIL_ADV_TRACE_UNCHUNK_MODE, UTIL_ADV_TRACE_OVERRUN, UTIL_ADV_TRACE_CONDITIONNAL
+ *  UTIL_ADV_TRACE_CONDITIONNAL
  */
 typedef struct {
-#if defined(UTIL_ADV_TRACE_UNCHUNK_MODE)
-  uint16_t unchunk_enabled;                              /*!<unchunck enable.                           */
-  TRACE_UNCHUNK_STATUS unchunk_status;                   /*!<unchunk transfer status.                  */
-#endif
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-  TRACE_OVERRUN_STATUS OverRunStatus;                    /*!<overrun status.                             */
-  cb_overrun *overrun_func;                               /*!<overrun function                            */
-#endif
 #if defined(UTIL_ADV_TRACE_CONDITIONNAL)
   cb_timestamp *timestamp_func;                           /*!<ptr of function used to insert time stamp. */
   uint8_t CurrentVerboseLevel;                           /*!<verbose level used.                        */
   uint32_t RegionMask;                                   /*!<mask of the enabled region.                */
 #endif
-  uint16_t TraceRdPtr;                                   /*!<read pointer the trace system.             */
-  uint16_t TraceWrPtr;                                   /*!<write pointer the trace system.            */
+  volatile uint32_t State;                               /*!<head, commit and pending reservations.     */
+  volatile uint16_t TraceRdIdx;                          /*!<read index of the trace system.            */
+  volatile uint16_t TracePadIdx;                         /*!<start of the unused end of the FIFO.       */
+  volatile uint8_t TracePadValid;                        /*!<TracePadIdx is ahead of the read index.    */
+  volatile uint8_t TraceBusy;                            /*!<a DMA transfer is ongoing.                 */
   uint16_t TraceSentSize;                                /*!<size of the latest transfer.               */
-  uint16_t TraceLock;                                    /*!<lock counter of the trace system.          */
 } ADV_TRACE_Context;
 
 /**
@@ -130,13 +132,6 @@ typedef struct {
 static ADV_TRACE_Context ADV_TRACE_Ctx;
 static UTIL_ADV_TRACE_MEMLOCATION uint8_t ADV_TRACE_Buffer[UTIL_ADV_TRACE_FIFO_SIZE];
 
-#if defined(UTIL_ADV_TRACE_CONDITIONNAL) && defined(UTIL_ADV_TRACE_UNCHUNK_MODE)
-/**
- * @brief temporary buffer used by UTIL_ADV_TRACE_COND_FSend
- * a temporary buffers variable used to evaluate a formatted string size.
- */
-static uint8_t sztmp[UTIL_ADV_TRACE_TMP_BUF_SIZE];
-#endif
 /**
  * @}
  */
@@ -148,11 +143,9 @@ static uint8_t sztmp[UTIL_ADV_TRACE_TMP_BUF_SIZE];
  */
 static void TRACE_TxCpltCallback(void *Ptr);
 static int16_t TRACE_AllocateBufer(uint16_t Size, uint16_t *Pos);
+static void TRACE_Commit(void);
 static UTIL_ADV_TRACE_Status_t TRACE_Send(void);
-
-static void TRACE_Lock(void);
-static void TRACE_UnLock(void);
-static uint32_t TRACE_IsLocked(void);
+static UTIL_ADV_TRACE_Status_t TRACE_Transfer(void);
 
 /**
   * @}
@@ -169,9 +162,6 @@ UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_Init(void)
   (void)UTIL_ADV_TRACE_MEMSET8(&ADV_TRACE_Ctx, 0x0, sizeof(ADV_TRACE_Context));
   (void)UTIL_ADV_TRACE_MEMSET8(&ADV_TRACE_Buffer, 0x0, sizeof(ADV_TRACE_Buffer));
 
-#if defined(UTIL_ADV_TRACE_UNCHUNK_MODE)
-  UTIL_ADV_TRACE_DEBUG("\nUNCHUNK_MODE\n");
-#endif
   /* Allocate Lock resource */
   UTIL_ADV_TRACE_INIT_CRITICAL_SECTION();
   
@@ -195,14 +185,7 @@ UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_StartRxProcess(void (*UserCallback)(uint8
 UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_COND_FSend(uint32_t VerboseLevel, uint32_t Region, uint32_t TimeStampState, const char *strFormat, ...)
 {
   va_list vaArgs;
-#if defined(UTIL_ADV_TRACE_UNCHUNK_MODE)
-  uint8_t buf[UTIL_ADV_TRACE_TMP_MAX_TIMESTMAP_SIZE];
-  uint16_t timestamp_size = 0u;
-  uint16_t writepos;
-  uint16_t idx;
-#else
   uint8_t buf[UTIL_ADV_TRACE_TMP_BUF_SIZE+UTIL_ADV_TRACE_TMP_MAX_TIMESTMAP_SIZE];
-#endif
   uint16_t buff_size = 0u;
 
   /* check verbose level */
@@ -216,61 +199,6 @@ UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_COND_FSend(uint32_t VerboseLevel, uint32_
     return UTIL_ADV_TRACE_REGIONMASKED;
   }
 
-#if defined(UTIL_ADV_TRACE_UNCHUNK_MODE)
-  if((ADV_TRACE_Ctx.timestamp_func != NULL) && (TimeStampState != 0u))
-  {
-    ADV_TRACE_Ctx.timestamp_func(buf,&timestamp_size);
-  }
-
-  va_start( vaArgs, strFormat);
-  buff_size =(uint16_t)UTIL_ADV_TRACE_VSNPRINTF((char *)sztmp,UTIL_ADV_TRACE_TMP_BUF_SIZE, strFormat, vaArgs);
-
-  TRACE_Lock();
-
-  /* if allocation is ok, write data into the buffer */
-  if (TRACE_AllocateBufer((buff_size+timestamp_size),&writepos) != -1)
-  {
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-    UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-    if(ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_EXECUTED)
-    {
-      /* clear the over run */
-      ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_NONE;
-    }
-    UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-#endif
-
-    /* copy the timestamp */
-    for (idx = 0u; idx < timestamp_size; idx++)
-    {
-      ADV_TRACE_Buffer[writepos] = buf[idx];
-      writepos = writepos + 1u;
-    }
-
-    /* copy the data */
-    (void)UTIL_ADV_TRACE_VSNPRINTF((char *)(&ADV_TRACE_Buffer[writepos]), UTIL_ADV_TRACE_TMP_BUF_SIZE, strFormat, vaArgs);
-    va_end(vaArgs);
-
-    TRACE_UnLock();
-
-    return TRACE_Send();
-  }
-
-  va_end(vaArgs);
-  TRACE_UnLock();
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-  UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-  if((ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_NONE ) && (NULL != ADV_TRACE_Ctx.overrun_func))
-  {
-    UTIL_ADV_TRACE_DEBUG("UTIL_ADV_TRACE_Send:TRACE_OVERRUN_INDICATION");
-    ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_INDICATION;
-  }
-  UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-#endif
-
-  return UTIL_ADV_TRACE_MEM_FULL;
-
-#else
   if((ADV_TRACE_Ctx.timestamp_func != NULL) && (TimeStampState != 0u))
   {
     ADV_TRACE_Ctx.timestamp_func(buf,&buff_size);
@@ -281,7 +209,6 @@ UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_COND_FSend(uint32_t VerboseLevel, uint32_
   va_end(vaArgs);
 
   return UTIL_ADV_TRACE_Send(buf, buff_size);
-#endif
 }
 #endif
 
@@ -300,7 +227,6 @@ UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_FSend(const char *strFormat, ...)
 #if defined(UTIL_ADV_TRACE_CONDITIONNAL)
 UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_COND_ZCSend_Allocation(uint32_t VerboseLevel, uint32_t Region, uint32_t TimeStampState, uint16_t length, uint8_t **pData, uint16_t *FifoSize, uint16_t *WritePos)
 {
-  UTIL_ADV_TRACE_Status_t ret = UTIL_ADV_TRACE_OK;
   uint16_t writepos;
   uint8_t timestamp_ptr[UTIL_ADV_TRACE_TMP_MAX_TIMESTMAP_SIZE];
   uint16_t timestamp_size = 0u;
@@ -321,48 +247,24 @@ UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_COND_ZCSend_Allocation(uint32_t VerboseLe
 	  ADV_TRACE_Ctx.timestamp_func(timestamp_ptr,&timestamp_size);
   }
 
-  TRACE_Lock();
-  
   /* if allocation is ok, write data into the buffer */
-  if (TRACE_AllocateBufer(length+timestamp_size, &writepos) != -1)
+  if (TRACE_AllocateBufer(length+timestamp_size, &writepos) == -1)
   {
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-    UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-    if(ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_EXECUTED)
-    {
-      /* clear the over run */
-	    ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_NONE;
-    }
-    UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-#endif
-    
-    /* fill time stamp information */
-    for(uint16_t index = 0u; index < timestamp_size; index++)
-    {
-      ADV_TRACE_Buffer[writepos] = timestamp_ptr[index];
-      writepos = (uint16_t)((writepos + 1u) % UTIL_ADV_TRACE_FIFO_SIZE);
-    }
-    
-    /*user fill */
-    *pData = ADV_TRACE_Buffer;
-    *FifoSize = (uint16_t)UTIL_ADV_TRACE_FIFO_SIZE;
-    *WritePos = writepos;
+    return UTIL_ADV_TRACE_MEM_FULL;
   }
-  else
+
+  /* fill time stamp information */
+  for(uint16_t index = 0u; index < timestamp_size; index++)
   {
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-    UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-    if((ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_NONE ) && (NULL != ADV_TRACE_Ctx.overrun_func))
-    {
-      UTIL_ADV_TRACE_DEBUG(":TRACE_OVERRUN_INDICATION");
-      ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_INDICATION;
-    }
-    UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-#endif
-    TRACE_UnLock();
-    ret = UTIL_ADV_TRACE_MEM_FULL;
+    ADV_TRACE_Buffer[writepos] = timestamp_ptr[index];
+    writepos++;
   }
-  return ret;
+
+  /*user fill */
+  *pData = ADV_TRACE_Buffer;
+  *FifoSize = (uint16_t)UTIL_ADV_TRACE_FIFO_SIZE;
+  *WritePos = writepos;
+  return UTIL_ADV_TRACE_OK;
 }
 
 UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_COND_ZCSend_Finalize(void)
@@ -373,57 +275,30 @@ UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_COND_ZCSend_Finalize(void)
 
 UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_ZCSend_Allocation(uint16_t Length, uint8_t **pData, uint16_t *FifoSize, uint16_t *WritePos)
 {
-  UTIL_ADV_TRACE_Status_t ret = UTIL_ADV_TRACE_OK;
   uint16_t writepos;
 
-  TRACE_Lock();
-
-  /* if allocation is ok, write data into the buffer */
-  if (TRACE_AllocateBufer(Length,&writepos)  != -1)
-  {
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-	UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-	if(ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_EXECUTED)
-	{
-		/* clear the over run */
-	    ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_NONE;
-	}
-	UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-#endif
-
-	/*user fill */
-	*pData = ADV_TRACE_Buffer;
-	*FifoSize = UTIL_ADV_TRACE_FIFO_SIZE;
-	*WritePos = (uint16_t)writepos;
-  }
-  else
+  /* if allocation is ok, the user writes the data into the buffer */
+  if (TRACE_AllocateBufer(Length,&writepos) == -1)
   {
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-	UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-	if((ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_NONE ) && (NULL != ADV_TRACE_Ctx.overrun_func))
-	{
-		UTIL_ADV_TRACE_DEBUG("UTIL_ADV_TRACE_ZCSend:TRACE_OVERRUN_INDICATION");
-		ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_INDICATION;
-	}
-	UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-#endif
-    TRACE_UnLock();
-    ret = UTIL_ADV_TRACE_MEM_FULL;
+    return UTIL_ADV_TRACE_MEM_FULL;
   }
 
-  return ret;
+  /*user fill, the area does not wrap */
+  *pData = ADV_TRACE_Buffer;
+  *FifoSize = UTIL_ADV_TRACE_FIFO_SIZE;
+  *WritePos = (uint16_t)writepos;
+  return UTIL_ADV_TRACE_OK;
 }
 
 UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_ZCSend_Finalize(void)
 {
-    TRACE_UnLock();
+    TRACE_Commit();
     return TRACE_Send();
 }
 
 #if defined(UTIL_ADV_TRACE_CONDITIONNAL)
 UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_COND_Send(uint32_t VerboseLevel, uint32_t Region, uint32_t TimeStampState, const uint8_t *pData, uint16_t Length)
 {
-  UTIL_ADV_TRACE_Status_t ret;  
   uint16_t writepos;
   uint32_t  idx;
   uint8_t timestamp_ptr[UTIL_ADV_TRACE_TMP_MAX_TIMESTMAP_SIZE];
@@ -445,113 +320,47 @@ UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_COND_Send(uint32_t VerboseLevel, uint32_t
 	  ADV_TRACE_Ctx.timestamp_func(timestamp_ptr,&timestamp_size);
   }
 
-  TRACE_Lock();
-
   /* if allocation is ok, write data into the buffer */
-  if (TRACE_AllocateBufer(Length + timestamp_size, &writepos) != -1)
+  if (TRACE_AllocateBufer(Length + timestamp_size, &writepos) == -1)
   {
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-    UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-    if(ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_EXECUTED)
-    {
-      /* clear the over run */
-	    ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_NONE;
-    }
-    UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-#endif
-    
-    /* fill time stamp information */
-    for( idx = 0; idx < timestamp_size; idx++)
-    {
-      ADV_TRACE_Buffer[writepos] = timestamp_ptr[idx];
-      writepos = (uint16_t)((writepos + 1u) % UTIL_ADV_TRACE_FIFO_SIZE);
-    }
-    
-    for (idx = 0u; idx < Length; idx++)
-    {
-      ADV_TRACE_Buffer[writepos] = pData[idx];
-      writepos = (uint16_t)((writepos + 1u) % UTIL_ADV_TRACE_FIFO_SIZE);
-    }
+    return UTIL_ADV_TRACE_MEM_FULL;
+  }
 
-    TRACE_UnLock();
-    ret = TRACE_Send();
+  /* fill time stamp information */
+  for( idx = 0; idx < timestamp_size; idx++)
+  {
+    ADV_TRACE_Buffer[writepos++] = timestamp_ptr[idx];
   }
-  else
+
+  for (idx = 0u; idx < Length; idx++)
   {
-	TRACE_UnLock();
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-	UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-	if((ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_NONE ) && (NULL != ADV_TRACE_Ctx.overrun_func))
-	{
-		UTIL_ADV_TRACE_DEBUG("UTIL_ADV_TRACE_Send:TRACE_OVERRUN_INDICATION");
-		ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_INDICATION;
-	}
-	UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-#endif
-    ret = UTIL_ADV_TRACE_MEM_FULL;
+    ADV_TRACE_Buffer[writepos++] = pData[idx];
   }
 
-  return ret;
+  TRACE_Commit();
+  return TRACE_Send();
 }
 #endif
 
 UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_Send(const uint8_t *pData, uint16_t Length)
 {
-  UTIL_ADV_TRACE_Status_t ret;  
   uint16_t writepos;
   uint32_t  idx;  
 
-  TRACE_Lock();
-
   /* if allocation is ok, write data into the buffer */
-  if (TRACE_AllocateBufer(Length,&writepos) != -1)
+  if (TRACE_AllocateBufer(Length,&writepos) == -1)
   {
-
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-	UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-    if(ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_EXECUTED)
-    {
-      /* clear the over run */
-	    ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_NONE;
-    }
-    UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-#endif
-    
-    /* initialize the Ptr for Read/Write */
-    for (idx = 0u; idx < Length; idx++)
-    {
-      ADV_TRACE_Buffer[writepos] = pData[idx];
-      writepos = (uint16_t)((writepos + 1u) % UTIL_ADV_TRACE_FIFO_SIZE);
-    }
-    TRACE_UnLock();
-    
-    ret = TRACE_Send();
+    return UTIL_ADV_TRACE_MEM_FULL;
   }
-  else
-  {
-	TRACE_UnLock();
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-	UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-	if((ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_NONE ) && (NULL != ADV_TRACE_Ctx.overrun_func))
-	{
-		UTIL_ADV_TRACE_DEBUG("UTIL_ADV_TRACE_Send:TRACE_OVERRUN_INDICATION");
-		ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_INDICATION;
-	}
-	UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-#endif
 
-    ret = UTIL_ADV_TRACE_MEM_FULL;
+  for (idx = 0u; idx < Length; idx++)
+  {
+    ADV_TRACE_Buffer[writepos++] = pData[idx];
   }
 
-  return ret;
-}
-
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-void UTIL_ADV_TRACE_RegisterOverRunFunction(cb_overrun *cb)
-{
-	ADV_TRACE_Ctx.overrun_func = *cb;
+  TRACE_Commit();
+  return TRACE_Send();
 }
-#endif
 
 #if defined(UTIL_ADV_TRACE_CONDITIONNAL)
 void UTIL_ADV_TRACE_RegisterTimeStampFunction(cb_timestamp *cb)
@@ -602,86 +411,87 @@ __WEAK void UTIL_ADV_TRACE_PostSendHook (void)
  */
 
 /**
-  * @brief send the data of the trace to low layer
+  * @brief  start a transfer if none is ongoing, from any context
   * @retval Status based on @ref UTIL_ADV_TRACE_Status_t
   */
 static UTIL_ADV_TRACE_Status_t TRACE_Send(void)
 {
-  UTIL_ADV_TRACE_Status_t ret = UTIL_ADV_TRACE_OK;  
-  uint8_t *ptr = NULL;
-  
-  UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();  
-  
-  if(TRACE_IsLocked() == 0u)
+  /* Only the context that sets TraceBusy drives the DMA */
+  do
   {
-    TRACE_Lock();
+    if (__LDREXB(&ADV_TRACE_Ctx.TraceBusy) != 0u)
+    {
+      __CLREX();
+      return UTIL_ADV_TRACE_OK;
+    }
+  } while (__STREXB(1u, &ADV_TRACE_Ctx.TraceBusy) != 0u);
 
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-	if(ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_INDICATION )
-	{
-		ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_TRANSFERT;
-	    UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-	    UTIL_ADV_TRACE_PreSendHook();
-
-	    ADV_TRACE_Ctx.overrun_func(&ptr, &ADV_TRACE_Ctx.TraceSentSize);
-	    UTIL_ADV_TRACE_DEBUG("\n--TRACE_Send overrun(%d)--\n", ADV_TRACE_Ctx.TraceSentSize);
-	    return UTIL_TraceDriver.Send(ptr, ADV_TRACE_Ctx.TraceSentSize);
-	}
-#endif
+  UTIL_ADV_TRACE_PreSendHook();
+  return TRACE_Transfer();
+}
+
+/**
+  * @brief  send the committed data from the read index, TraceBusy set.
+  *         Clears TraceBusy when nothing is left.
+  * @retval Status based on @ref UTIL_ADV_TRACE_Status_t
+  */
+static UTIL_ADV_TRACE_Status_t TRACE_Transfer(void)
+{
+  uint16_t rd;
+  uint16_t commit;
+  uint16_t size;
+  uint16_t pad;
 
-    if (ADV_TRACE_Ctx.TraceRdPtr != ADV_TRACE_Ctx.TraceWrPtr)
+  for (;;)
+  {
+    rd = ADV_TRACE_Ctx.TraceRdIdx;
+    commit = (uint16_t)TRACE_STATE_COMMIT(ADV_TRACE_Ctx.State);
+
+    if (rd == commit)
     {
-#ifdef UTIL_ADV_TRACE_UNCHUNK_MODE
-   	  if(TRACE_UNCHUNK_DETECTED == ADV_TRACE_Ctx.unchunk_status)
-   	  {
-        ADV_TRACE_Ctx.TraceSentSize = (uint16_t)(ADV_TRACE_Ctx.unchunk_enabled - ADV_TRACE_Ctx.TraceRdPtr);
-        ADV_TRACE_Ctx.unchunk_status = TRACE_UNCHUNK_TRANSFER;
-        ADV_TRACE_Ctx.unchunk_enabled = 0;
-        
-        UTIL_ADV_TRACE_DEBUG("\nTRACE_TxCpltCallback::unchunk start(%d,%d)\n",ADV_TRACE_Ctx.unchunk_enabled, ADV_TRACE_Ctx.TraceRdPtr);
-        
-        if (0u == ADV_TRACE_Ctx.TraceSentSize)
-        {
-          ADV_TRACE_Ctx.unchunk_status = TRACE_UNCHUNK_NONE;
-          ADV_TRACE_Ctx.TraceRdPtr = 0;
-        }
-   	  }
-      
-   	  if(TRACE_UNCHUNK_NONE == ADV_TRACE_Ctx.unchunk_status)
-   	  {
-#endif
-   	    if (ADV_TRACE_Ctx.TraceWrPtr > ADV_TRACE_Ctx.TraceRdPtr)
-        {
-   	    	ADV_TRACE_Ctx.TraceSentSize = ADV_TRACE_Ctx.TraceWrPtr - ADV_TRACE_Ctx.TraceRdPtr;
-        }
-        else  /* TraceRdPtr > TraceWrPtr */
-        {
-        	ADV_TRACE_Ctx.TraceSentSize = UTIL_ADV_TRACE_FIFO_SIZE - ADV_TRACE_Ctx.TraceRdPtr;
-
-        }
-#ifdef UTIL_ADV_TRACE_UNCHUNK_MODE
+      /* Idle, unless a producer committed after the test */
+      UTIL_ADV_TRACE_PostSendHook();
+      ADV_TRACE_Ctx.TraceBusy = 0u;
+      if (TRACE_STATE_COMMIT(ADV_TRACE_Ctx.State) == rd)
+      {
+        return UTIL_ADV_TRACE_OK;
       }
-#endif
-      ptr = &ADV_TRACE_Buffer[ADV_TRACE_Ctx.TraceRdPtr];
+      return TRACE_Send();
+    }
 
-      UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-      UTIL_ADV_TRACE_PreSendHook(); 
+    /* The end of the FIFO left unused by a reservation that did not fit */
+    if ((ADV_TRACE_Ctx.TracePadValid != 0u) && (ADV_TRACE_Ctx.TracePadIdx == rd))
+    {
+      ADV_TRACE_Ctx.TracePadValid = 0u;
+      ADV_TRACE_Ctx.TraceRdIdx = (uint16_t)((rd + UTIL_ADV_TRACE_FIFO_SIZE - (rd & TRACE_FIFO_MASK)) & TRACE_INDEX_MASK);
+      continue;
+    }
 
-      UTIL_ADV_TRACE_DEBUG("\n--TRACE_Send(%d-%d)--\n",ADV_TRACE_Ctx.TraceRdPtr, ADV_TRACE_Ctx.TraceSentSize);
-      ret = UTIL_TraceDriver.Send(ptr, ADV_TRACE_Ctx.TraceSentSize);
+    size = (uint16_t)((commit - rd) & TRACE_INDEX_MASK);
+    if (size > (UTIL_ADV_TRACE_FIFO_SIZE - (rd & TRACE_FIFO_MASK)))
+    {
+      size = (uint16_t)(UTIL_ADV_TRACE_FIFO_SIZE - (rd & TRACE_FIFO_MASK));
     }
-    else
+    if (ADV_TRACE_Ctx.TracePadValid != 0u)
     {
-      TRACE_UnLock();
-      UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();  
-    }    
-  }
-  else
-  {
-    UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();  
+      pad = (uint16_t)((ADV_TRACE_Ctx.TracePadIdx - rd) & TRACE_INDEX_MASK);
+      if (pad < size)
+      {
+        size = pad;
+      }
+    }
+
+    ADV_TRACE_Ctx.TraceSentSize = size;
+    UTIL_ADV_TRACE_DEBUG("\n--TRACE_Send(%d-%d)--\n", rd, size);
+    if (UTIL_TraceDriver.Send(&ADV_TRACE_Buffer[rd & TRACE_FIFO_MASK], size) != UTIL_ADV_TRACE_OK)
+    {
+      /* Retried by the next trace */
+      UTIL_ADV_TRACE_PostSendHook();
+      ADV_TRACE_Ctx.TraceBusy = 0u;
+      return UTIL_ADV_TRACE_HW_ERROR;
+    }
+    return UTIL_ADV_TRACE_OK;
   }
-  
-  return ret;
 }
 
 /**
@@ -691,195 +501,79 @@ static UTIL_ADV_TRACE_Status_t TRACE_Send(void)
   */
 static void TRACE_TxCpltCallback(void *Ptr)
 { 
-  UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-  
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-  if(ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_TRANSFERT )
-  {
-    ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_EXECUTED;
-    UTIL_ADV_TRACE_DEBUG("\n--TRACE_Send overrun complete--\n");
-    ADV_TRACE_Ctx.TraceSentSize = 0u;
-  }
-#endif
-  
-#if defined(UTIL_ADV_TRACE_UNCHUNK_MODE)
-  if(TRACE_UNCHUNK_TRANSFER == ADV_TRACE_Ctx.unchunk_status)
-  {
-	  ADV_TRACE_Ctx.unchunk_status = TRACE_UNCHUNK_NONE;
-	  ADV_TRACE_Ctx.TraceRdPtr = 0;
-	  UTIL_ADV_TRACE_DEBUG("\nTRACE_TxCpltCallback::unchunk complete\n");
-  }
-  else
-  {
-	  ADV_TRACE_Ctx.TraceRdPtr = (ADV_TRACE_Ctx.TraceRdPtr + ADV_TRACE_Ctx.TraceSentSize) % UTIL_ADV_TRACE_FIFO_SIZE;
-  }
-#else
-  ADV_TRACE_Ctx.TraceRdPtr = (ADV_TRACE_Ctx.TraceRdPtr + ADV_TRACE_Ctx.TraceSentSize) % UTIL_ADV_TRACE_FIFO_SIZE;
-#endif
-  
-#if defined(UTIL_ADV_TRACE_OVERRUN)
-	if(ADV_TRACE_Ctx.OverRunStatus == TRACE_OVERRUN_INDICATION )
-	{
-		uint8_t *ptr = NULL;
-    
-		ADV_TRACE_Ctx.OverRunStatus = TRACE_OVERRUN_TRANSFERT;
-		UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-		ADV_TRACE_Ctx.overrun_func(&ptr, &ADV_TRACE_Ctx.TraceSentSize);
-		UTIL_ADV_TRACE_DEBUG("\n--Driver_Send overrun(%d)--\n", ADV_TRACE_Ctx.TraceSentSize);
-		UTIL_TraceDriver.Send(ptr, ADV_TRACE_Ctx.TraceSentSize);
-    return;
-	}
-#endif
-  
-  if((ADV_TRACE_Ctx.TraceRdPtr != ADV_TRACE_Ctx.TraceWrPtr) && (1u == ADV_TRACE_Ctx.TraceLock))
-  {
-#ifdef UTIL_ADV_TRACE_UNCHUNK_MODE
-    if(TRACE_UNCHUNK_DETECTED == ADV_TRACE_Ctx.unchunk_status)
-    {
-   		ADV_TRACE_Ctx.TraceSentSize = ADV_TRACE_Ctx.unchunk_enabled - ADV_TRACE_Ctx.TraceRdPtr;
-   		ADV_TRACE_Ctx.unchunk_status = TRACE_UNCHUNK_TRANSFER;
-   		ADV_TRACE_Ctx.unchunk_enabled = 0;
-      
-    	UTIL_ADV_TRACE_DEBUG("\nTRACE_TxCpltCallback::unchunk start(%d,%d)\n",ADV_TRACE_Ctx.unchunk_enabled, ADV_TRACE_Ctx.TraceRdPtr);
-      
-    	if (0u == ADV_TRACE_Ctx.TraceSentSize)
-      {
-        ADV_TRACE_Ctx.unchunk_status = TRACE_UNCHUNK_NONE;
-        ADV_TRACE_Ctx.TraceRdPtr = 0;
-      }
-    }
-    
-    if(TRACE_UNCHUNK_NONE == ADV_TRACE_Ctx.unchunk_status)
-    {
-#endif
-      if (ADV_TRACE_Ctx.TraceWrPtr > ADV_TRACE_Ctx.TraceRdPtr)
-      {
-        ADV_TRACE_Ctx.TraceSentSize = ADV_TRACE_Ctx.TraceWrPtr - ADV_TRACE_Ctx.TraceRdPtr;
-      }
-      else  /* TraceRdPtr > TraceWrPtr */
-      {
-        ADV_TRACE_Ctx.TraceSentSize = UTIL_ADV_TRACE_FIFO_SIZE - ADV_TRACE_Ctx.TraceRdPtr;
-      }
-#ifdef UTIL_ADV_TRACE_UNCHUNK_MODE
-    }
-#endif
-    UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION(); 
-    UTIL_ADV_TRACE_DEBUG("\n--TRACE_Send(%d-%d)--\n", ADV_TRACE_Ctx.TraceRdPtr, ADV_TRACE_Ctx.TraceSentSize);
-    UTIL_TraceDriver.Send(&ADV_TRACE_Buffer[ADV_TRACE_Ctx.TraceRdPtr], ADV_TRACE_Ctx.TraceSentSize);
-  }
-  else
-  {
-    UTIL_ADV_TRACE_PostSendHook();      
-    UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION(); 
-    TRACE_UnLock();
-  }
+  ADV_TRACE_Ctx.TraceRdIdx = (uint16_t)((ADV_TRACE_Ctx.TraceRdIdx + ADV_TRACE_Ctx.TraceSentSize) & TRACE_INDEX_MASK);
+  (void)TRACE_Transfer();
 }
 
 /**
-  * @brief  allocate space inside the buffer to push data
+  * @brief  reserve a contiguous area of the FIFO, wait-free for the caller
+  *         unless it is interrupted by another producer.
   * @param  Size to allocate within fifo
   * @param  Pos position within the fifo
   * @retval write position inside the buffer is -1 no space available.
   */
 static int16_t TRACE_AllocateBufer(uint16_t Size, uint16_t *Pos)
 {
-  uint16_t freesize;
-  int16_t ret = -1;
-
-  UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
+  uint32_t state;
+  uint16_t head;
+  uint16_t pad;
 
-  if (ADV_TRACE_Ctx.TraceWrPtr == ADV_TRACE_Ctx.TraceRdPtr)
+  if ((Size == 0u) || (Size > UTIL_ADV_TRACE_FIFO_SIZE))
   {
-#ifdef UTIL_ADV_TRACE_UNCHUNK_MODE
-    freesize = (uint16_t)(UTIL_ADV_TRACE_FIFO_SIZE - ADV_TRACE_Ctx.TraceWrPtr);
-    if((Size >= freesize) && (ADV_TRACE_Ctx.TraceRdPtr > Size))
-    {
-      ADV_TRACE_Ctx.unchunk_status = TRACE_UNCHUNK_DETECTED;
-      ADV_TRACE_Ctx.unchunk_enabled = ADV_TRACE_Ctx.TraceWrPtr;
-      freesize = ADV_TRACE_Ctx.TraceRdPtr;
-      ADV_TRACE_Ctx.TraceWrPtr = 0;
-    }
-#else
-    /* need to add buffer full management*/
-    freesize = (int16_t)UTIL_ADV_TRACE_FIFO_SIZE;
-#endif
+    return -1;
   }
-  else
+
+  do
   {
-#ifdef UTIL_ADV_TRACE_UNCHUNK_MODE
-    if (ADV_TRACE_Ctx.TraceWrPtr > ADV_TRACE_Ctx.TraceRdPtr)
-    {
-      freesize = (uint16_t)(UTIL_ADV_TRACE_FIFO_SIZE - ADV_TRACE_Ctx.TraceWrPtr);
-      if((Size >= freesize) && (ADV_TRACE_Ctx.TraceRdPtr > Size)) 
-      {
-        ADV_TRACE_Ctx.unchunk_status = TRACE_UNCHUNK_DETECTED;
-        ADV_TRACE_Ctx.unchunk_enabled = ADV_TRACE_Ctx.TraceWrPtr;
-        freesize = ADV_TRACE_Ctx.TraceRdPtr;
-        ADV_TRACE_Ctx.TraceWrPtr = 0;
-      }
-    }
-    else
-    {
-      freesize = (uint16_t)(ADV_TRACE_Ctx.TraceRdPtr - ADV_TRACE_Ctx.TraceWrPtr);
-    }
-#else
-    if (ADV_TRACE_Ctx.TraceWrPtr > ADV_TRACE_Ctx.TraceRdPtr)
+    state = __LDREXW(&ADV_TRACE_Ctx.State);
+    head = (uint16_t)TRACE_STATE_HEAD(state);
+
+    /* A reservation never wraps, the end of the FIFO is skipped instead */
+    pad = 0u;
+    if (((head & TRACE_FIFO_MASK) + Size) > UTIL_ADV_TRACE_FIFO_SIZE)
     {
-      freesize = UTIL_ADV_TRACE_FIFO_SIZE - ADV_TRACE_Ctx.TraceWrPtr + ADV_TRACE_Ctx.TraceRdPtr;
+      pad = (uint16_t)(UTIL_ADV_TRACE_FIFO_SIZE - (head & TRACE_FIFO_MASK));
     }
-    else
+    if ((((head - ADV_TRACE_Ctx.TraceRdIdx) & TRACE_INDEX_MASK) + pad + Size) > UTIL_ADV_TRACE_FIFO_SIZE)
     {
-      freesize = ADV_TRACE_Ctx.TraceRdPtr - ADV_TRACE_Ctx.TraceWrPtr;
+      __CLREX();
+      return -1;
     }
-#endif
-  }
-  
-  if (freesize > Size)
+  } while (__STREXW(TRACE_STATE(head + pad + Size, TRACE_STATE_COMMIT(state), TRACE_STATE_PENDING(state) + 1u),
+                    &ADV_TRACE_Ctx.State) != 0u);
+
+  /* Only one padding can be ahead of the read index, the FIFO is too small for
+     another wrap before it is read */
+  if (pad != 0u)
   {
-    *Pos = ADV_TRACE_Ctx.TraceWrPtr;
-    ADV_TRACE_Ctx.TraceWrPtr = (ADV_TRACE_Ctx.TraceWrPtr + Size) % UTIL_ADV_TRACE_FIFO_SIZE;
-    ret = 0;
-    
-#ifdef UTIL_ADV_TRACE_UNCHUNK_MODE
-    UTIL_ADV_TRACE_DEBUG("\n--TRACE_AllocateBufer(%d-%d-%d::%d-%d)--\n",freesize - Size, Size, ADV_TRACE_Ctx.unchunk_enabled, ADV_TRACE_Ctx.TraceRdPtr, ADV_TRACE_Ctx.TraceWrPtr);
-#else
-    UTIL_ADV_TRACE_DEBUG("\n--TRACE_AllocateBufer(%d-%d::%d-%d)--\n",freesize - Size, Size, ADV_TRACE_Ctx.TraceRdPtr, ADV_TRACE_Ctx.TraceWrPtr);
-#endif
+    ADV_TRACE_Ctx.TracePadIdx = head;
+    ADV_TRACE_Ctx.TracePadValid = 1u;
   }
 
-  UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();  
-  return ret;
+  *Pos = (uint16_t)((head + pad) & TRACE_FIFO_MASK);
+  UTIL_ADV_TRACE_DEBUG("\n--TRACE_AllocateBufer(%d-%d::%d-%d)--\n", pad, Size, ADV_TRACE_Ctx.TraceRdIdx, head);
+  return 0;
 }
 
 /**
-  * @brief  Lock the trace buffer.
+  * @brief  finalize the latest reservation of the caller. The data becomes
+  *         visible to the consumer once no reservation is pending.
   * @retval None.
   */
-static void TRACE_Lock(void)
+static void TRACE_Commit(void)
 {
-  UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-  ADV_TRACE_Ctx.TraceLock++;
-  UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-}
-
-/**
-  * @brief  UnLock the trace buffer.
-  * @retval None.
-  */
-static void TRACE_UnLock(void)
-{
-  UTIL_ADV_TRACE_ENTER_CRITICAL_SECTION();
-  ADV_TRACE_Ctx.TraceLock--;
-  UTIL_ADV_TRACE_EXIT_CRITICAL_SECTION();
-}
+  uint32_t state;
+  uint32_t pending;
+  uint32_t commit;
 
-/**
-  * @brief  UnLock the trace buffer.
-  * @retval None.
-  */
-static uint32_t TRACE_IsLocked(void)
-{
-  return (ADV_TRACE_Ctx.TraceLock == 0u? 0u: 1u);
+  /* The data and the padding are written before they are published */
+  __DMB();
+  do
+  {
+    state = __LDREXW(&ADV_TRACE_Ctx.State);
+    pending = TRACE_STATE_PENDING(state) - 1u;
+    commit = (pending == 0u) ? TRACE_STATE_HEAD(state) : TRACE_STATE_COMMIT(state);
+  } while (__STREXW(TRACE_STATE(TRACE_STATE_HEAD(state), commit, pending), &ADV_TRACE_Ctx.State) != 0u);
 }
 
 /**
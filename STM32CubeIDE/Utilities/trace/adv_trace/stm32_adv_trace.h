@@ -133,7 +133,9 @@ UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_FSend(const char *strFormat, ...);
 UTIL_ADV_TRACE_Status_t UTIL_ADV_TRACE_Send(const uint8_t *pdata, uint16_t length);
 
 /**
- * @brief ZCSend_Allocation allocate the memory and return information to write the data
+ * @brief ZCSend_Allocation allocate the memory and return information to write the data.
+ *        The area does not wrap. Safe from any context, nested allocations
+ *        are sent once all of them are finalized.
  * @param Length trase size
  * @param pData  pointer on the fifo
  * @param FifoSize size of the fifo
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Decodes the erasure coded alarm uplinks of a node.
+
+Reads the FRMPayload of the uplinks on the FEC port (LORAWAN_FEC_PORT) of one
+node, one hex string per line in reception order, and prints the alarm
+payloads, rebuilding the lost ones from the parity frames (see uplink_fec.h).
+
+    ./tools/fec_decode.py < port7.txt
+"""
+
+import sys
+
+WINDOW_SIZE = 4
+PARITY_FLAG = 0x80
+# Windows this far behind the last one received are complete or lost
+WINDOW_HORIZON = 16
+
+EXP = [0] * 512
+LOG = [0] * 256
+_x = 1
+for _i in range(255):
+    EXP[_i] = _x
+    LOG[_x] = _i
+    _x <<= 1
+    if _x & 0x100:
+        _x ^= 0x11D
+for _i in range(255, 512):
+    EXP[_i] = EXP[_i - 255]
+
+
+def gf_mul(a, b):
+    if a == 0 or b == 0:
+        return 0
+    return EXP[LOG[a] + LOG[b]]
+
+
+def gf_inv(a):
+    return EXP[255 - LOG[a]]
+
+
+def coefficient(j, i):
+    return gf_inv((WINDOW_SIZE + j) ^ i)
+
+
+def solve(rows, values):
+    """Solves rows * x = values over GF(256), rows square and invertible"""
+    n = len(rows)
+    rows = [list(row) for row in rows]
+    values = [list(value) for value in values]
+    for col in range(n):
+        pivot = next(r for r in range(col, n) if rows[r][col])
+        rows[col], rows[pivot] = rows[pivot], rows[col]
+        values[col], values[pivot] = values[pivot], values[col]
+        inv = gf_inv(rows[col][col])
+        rows[col] = [gf_mul(inv, v) for v in rows[col]]
+        values[col] = [gf_mul(inv, v) for v in values[col]]
+        for r in range(n):
+            factor = rows[r][col]
+            if r == col or factor == 0:
+                continue
+            rows[r] = [a ^ gf_mul(factor, b) for a, b in zip(rows[r], rows[col])]
+            values[r] = [a ^ gf_mul(factor, b) for a, b in zip(values[r], values[col])]
+    return values
+
+
+class Window:
+    def __init__(self):
+        self.data = {}
+        self.parity = {}
+        self.count = None
+        self.recovered = False
+
+    def decode(self):
+        """Returns the lost payloads by index once enough frames are received"""
+        if self.recovered or self.count is None:
+            return {}
+        missing = [i for i in range(self.count) if i not in self.data]
+        if not missing or len(missing) > len(self.parity):
+            return {}
+        size = len(next(iter(self.parity.values())))
+        used = sorted(self.parity)[:len(missing)]
+        values = []
+        for j in used:
+            value = list(self.parity[j])
+            for i, payload in self.data.items():
+                shard = ([len(payload)] + list(payload) + [0] * size)[:size]
+                c = coefficient(j, i)
+                value = [v ^ gf_mul(c, s) for v, s in zip(value, shard)]
+            values.append(value)
+        shards = solve([[coefficient(j, i) for i in missing] for j in used], values)
+        self.recovered = True
+        return {i: bytes(shard[1:1 + shard[0]]) for i, shard in zip(missing, shards)}
+
+
+def main():
+    if len(sys.argv) != 1:
+        sys.stderr.write('usage: %s < frames\n' % sys.argv[0])
+        return 1
+    windows = {}
+    out = sys.stdout
+    for line in sys.stdin:
+        line = line.strip()
+        if not line:
+            continue
+        frame = bytes.fromhex(line)
+        if len(frame) < 2:
+            out.write('<short frame %s>\n' % line)
+            continue
+        number, header = frame[0], frame[1]
+        for old in [w for w in windows if ((number - w) & 0xFF) > WINDOW_HORIZON]:
+            del windows[old]
+        window = windows.setdefault(number, Window())
+        if header & PARITY_FLAG:
+            index, count = (header >> 4) & 0x07, header & 0x0F
+            if window.count not in (None, count):
+                # Same number after a reset
+                window = windows[number] = Window()
+            window.count = count
+            window.parity[index] = frame[2:]
+        else:
+            if window.data.get(header, frame[2:]) != frame[2:]:
+                window = windows[number] = Window()
+            window.data[header] = frame[2:]
+            out.write('window %u payload %u: %s\n' % (number, header, frame[2:].hex()))
+        for index, payload in sorted(window.decode().items()):
+            out.write('window %u payload %u: %s recovered\n' % (number, index, payload.hex()))
+        out.flush()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
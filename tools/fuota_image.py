@@ -0,0 +1,34 @@
+#!/usr/bin/env python3
+"""Builds the file sent by a firmware update over the air.
+
+The file is the header of boot.h followed by the application image, the
+binary of the ELF without the boot stage:
+
+    ./tools/fuota_image.py build/solarpath-firmware-app.bin 0x00010200 > update.bin
+"""
+
+import struct
+import sys
+import zlib
+
+IMAGE_MAGIC = 0x57465053
+APP_MAX_SIZE = 120 * 1024
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write('usage: %s app.bin version > update.bin\n' % sys.argv[0])
+        return 1
+    with open(sys.argv[1], 'rb') as f:
+        image = f.read()
+    if not image or len(image) > APP_MAX_SIZE:
+        sys.stderr.write('%s: %u bytes, 1 to %u expected\n' % (sys.argv[1], len(image), APP_MAX_SIZE))
+        return 1
+    version = int(sys.argv[2], 0)
+    header = struct.pack('<IIII', IMAGE_MAGIC, len(image), zlib.crc32(image) & 0xFFFFFFFF, version)
+    sys.stdout.buffer.write(header + image)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Decodes the tokenized log records of the firmware.
+
+The text sent with printf is passed through, the records are rebuilt from the
+format strings of the .log_fmt section of the ELF (see sys_log.h).
+
+    stty -F /dev/ttyUSB0 115200 raw
+    ./tools/log_decode.py build_debug/solarpath-firmware.elf < /dev/ttyUSB0
+"""
+
+import re
+import struct
+import sys
+
+MARKER = 0x00
+FORMAT_SPEC = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z|j|t)?([diouxXc%])')
+
+
+def read_formats(path):
+    """Returns the format strings by offset in the .log_fmt section"""
+    with open(path, 'rb') as f:
+        elf = f.read()
+    if elf[:4] != b'\x7fELF' or elf[4] != 1 or elf[5] != 1:
+        raise ValueError('%s: not a 32-bit little endian ELF' % path)
+    shoff, = struct.unpack_from('<I', elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x2E)
+    sections = [struct.unpack_from('<IIIIII', elf, shoff + i * shentsize) for i in range(shnum)]
+    names = sections[shstrndx]
+    for name, _, _, addr, offset, size in sections:
+        end = elf.index(b'\0', names[4] + name)
+        if elf[names[4] + name:end] == b'.log_fmt':
+            data = elf[offset:offset + size]
+            break
+    else:
+        raise ValueError('%s: no .log_fmt section' % path)
+
+    # Strings start after a NUL, arrays may be padded with NULs
+    formats = {}
+    pos = 0
+    while pos < len(data):
+        if data[pos] == 0:
+            pos += 1
+            continue
+        end = data.index(b'\0', pos)
+        formats[addr + pos] = data[pos:end].decode('latin-1')
+        pos = end + 1
+    return formats
+
+
+def read_varints(payload):
+    values = []
+    value = 0
+    shift = 0
+    for byte in payload:
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte < 0x80:
+            values.append(value & 0xFFFFFFFF)
+            value = 0
+            shift = 0
+    return values
+
+
+def render(formats, payload):
+    if len(payload) < 2:
+        return '<short record>\n'
+    token = payload[0] | (payload[1] << 8)
+    fmt = formats.get(token)
+    args = read_varints(payload[2:])
+    if fmt is None:
+        return '<unknown id %u %s>\n' % (token, args)
+    values = []
+    for spec in FORMAT_SPEC.finditer(fmt):
+        if spec.group(1) == '%':
+            continue
+        value = args.pop(0) if args else 0
+        if spec.group(1) in 'di' and value >= 0x80000000:
+            value -= 0x100000000
+        values.append(value)
+    try:
+        return fmt % tuple(values)
+    except (TypeError, ValueError, OverflowError):
+        return '<bad record %s: %s>\n' % (fmt.rstrip(), values)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.stderr.write('usage: %s firmware.elf < capture\n' % sys.argv[0])
+        return 1
+    formats = read_formats(sys.argv[1])
+    stream = sys.stdin.buffer
+    out = sys.stdout
+    while True:
+        byte = stream.read(1)
+        if not byte:
+            return 0
+        if byte[0] != MARKER:
+            out.write(byte.decode('latin-1'))
+            continue
+        size = stream.read(1)
+        if not size:
+            return 0
+        payload = stream.read(size[0])
+        out.write(render(formats, payload))
+        out.flush()
+
+
+if __name__ == '__main__':
+    sys.exit(main())
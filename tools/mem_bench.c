@@ -0,0 +1,227 @@
+/**
+  ******************************************************************************
+  * @file    mem_bench.c
+  * @brief   Host check and micro-benchmark of UTIL_MEM_cpy_8, UTIL_MEM_cpyr_8
+  *          and UTIL_MEM_set_8 against the byte loops they replaced
+  *
+  *          Sizes from 4 to 256 bytes, with an aligned, a misaligned source
+  *          and a misaligned destination. Loop vectorization and the
+  *          conversion of loops into libc calls are disabled to stay close to
+  *          the Cortex-M4; for cycle counts on the target, build the firmware
+  *          with -DUTIL_MEM_BENCH=ON, see mem_bench.h.
+  *
+  *              cc -O2 -fno-tree-vectorize -fno-tree-loop-distribute-patterns \
+  *                 -ISTM32CubeIDE/Core/Inc -o mem_bench tools/mem_bench.c
+  *              ./mem_bench
+  ******************************************************************************
+  */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* stm32_mem.c without the target configuration */
+#define __UTILITIES_CONF_H__
+#define __UNALIGNED_UINT32_READ(p)  UnalignedRead(p)
+#define __REV(x)                    __builtin_bswap32(x)
+
+static inline uint32_t UnalignedRead(const void *p)
+{
+  uint32_t word;
+
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+#include "../STM32CubeIDE/Utilities/misc/stm32_mem.c"
+
+#define BENCH_BUFFER_SIZE                           (256U + 8U)
+#define BENCH_BYTES                                 (16UL * 1024UL * 1024UL)
+
+typedef void (*CopyFn_t)(void *dst, const void *src, uint16_t size);
+typedef void (*FillFn_t)(void *dst, uint8_t value, uint16_t size);
+
+/* The byte loops of STM32Cube */
+static void ByteCpy(void *dst, const void *src, uint16_t size)
+{
+  uint8_t *dst8 = (uint8_t *)dst;
+  const uint8_t *src8 = (const uint8_t *)src;
+
+  while (size--)
+  {
+    *dst8++ = *src8++;
+  }
+}
+
+static void ByteCpyr(void *dst, const void *src, uint16_t size)
+{
+  uint8_t *dst8 = (uint8_t *)dst + (size - 1);
+  const uint8_t *src8 = (const uint8_t *)src;
+
+  while (size--)
+  {
+    *dst8-- = *src8++;
+  }
+}
+
+static void ByteSet(void *dst, uint8_t value, uint16_t size)
+{
+  uint8_t *dst8 = (uint8_t *)dst;
+
+  while (size--)
+  {
+    *dst8++ = value;
+  }
+}
+
+/* Read through volatile pointers, so that no call is inlined or folded */
+static CopyFn_t volatile const CopyOld = ByteCpy;
+static CopyFn_t volatile const CopyNew = UTIL_MEM_cpy_8;
+static CopyFn_t volatile const CopyrOld = ByteCpyr;
+static CopyFn_t volatile const CopyrNew = UTIL_MEM_cpyr_8;
+static FillFn_t volatile const FillOld = ByteSet;
+static FillFn_t volatile const FillNew = UTIL_MEM_set_8;
+
+static const uint16_t Sizes[] = { 4, 8, 13, 16, 32, 51, 64, 115, 128, 222, 256 };
+
+/* Destination and source offsets from a word boundary */
+static const struct
+{
+  const char *Name;
+  uint8_t Dst;
+  uint8_t Src;
+} Alignments[] =
+{
+  { "aligned", 0, 0 },
+  { "src+1", 0, 1 },
+  { "dst+3", 3, 0 },
+};
+
+static uint32_t Src[BENCH_BUFFER_SIZE / 4U];
+static uint32_t Dst[BENCH_BUFFER_SIZE / 4U];
+static uint32_t Ref[BENCH_BUFFER_SIZE / 4U];
+
+static double Now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double TimeCopy(CopyFn_t volatile const *fn, uint8_t *dst, const uint8_t *src, uint16_t size)
+{
+  unsigned long calls = BENCH_BYTES / size;
+  double start = Now();
+
+  for (unsigned long i = 0; i < calls; i++)
+  {
+    (*fn)(dst, src, size);
+  }
+  return (Now() - start) / (double)calls;
+}
+
+static double TimeFill(FillFn_t volatile const *fn, uint8_t *dst, uint16_t size)
+{
+  unsigned long calls = BENCH_BYTES / size;
+  double start = Now();
+
+  for (unsigned long i = 0; i < calls; i++)
+  {
+    (*fn)(dst, (uint8_t)i, size);
+  }
+  return (Now() - start) / (double)calls;
+}
+
+/* Runs the old and new routines on the same buffers, 0 if they agree */
+static int Check(void)
+{
+  uint8_t *src = (uint8_t *)Src;
+  uint8_t *dst = (uint8_t *)Dst;
+  uint8_t *ref = (uint8_t *)Ref;
+
+  for (uint32_t i = 0; i < sizeof(Src); i++)
+  {
+    src[i] = (uint8_t)(i * 7U + 1U);
+  }
+  for (uint16_t size = 0; size <= 256U; size++)
+  {
+    for (uint8_t d = 0; d < 4U; d++)
+    {
+      for (uint8_t s = 0; s < 4U; s++)
+      {
+        memset(dst, 0xA5, sizeof(Dst));
+        memset(ref, 0xA5, sizeof(Ref));
+        UTIL_MEM_cpy_8(dst + d, src + s, size);
+        ByteCpy(ref + d, src + s, size);
+        if (memcmp(dst, ref, sizeof(Dst)) != 0)
+        {
+          printf("UTIL_MEM_cpy_8 size %u dst+%u src+%u differs\n", size, d, s);
+          return 1;
+        }
+
+        memset(dst, 0xA5, sizeof(Dst));
+        memset(ref, 0xA5, sizeof(Ref));
+        UTIL_MEM_cpyr_8(dst + d, src + s, size);
+        if (size > 0U)
+        {
+          ByteCpyr(ref + d, src + s, size);
+        }
+        if (memcmp(dst, ref, sizeof(Dst)) != 0)
+        {
+          printf("UTIL_MEM_cpyr_8 size %u dst+%u src+%u differs\n", size, d, s);
+          return 1;
+        }
+      }
+
+      memset(dst, 0xA5, sizeof(Dst));
+      memset(ref, 0xA5, sizeof(Ref));
+      UTIL_MEM_set_8(dst + d, 0x3C, size);
+      ByteSet(ref + d, 0x3C, size);
+      if (memcmp(dst, ref, sizeof(Dst)) != 0)
+      {
+        printf("UTIL_MEM_set_8 size %u dst+%u differs\n", size, d);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int main(void)
+{
+  if (Check() != 0)
+  {
+    return 1;
+  }
+
+  printf("%-6s %5s %-8s %9s %9s %7s\n", "op", "size", "align", "old ns", "new ns", "speedup");
+  for (uint32_t a = 0; a < (sizeof(Alignments) / sizeof(Alignments[0])); a++)
+  {
+    uint8_t *dst = (uint8_t *)Dst + Alignments[a].Dst;
+    const uint8_t *src = (const uint8_t *)Src + Alignments[a].Src;
+
+    for (uint32_t i = 0; i < (sizeof(Sizes) / sizeof(Sizes[0])); i++)
+    {
+      uint16_t size = Sizes[i];
+      double old, new;
+
+      old = TimeCopy(&CopyOld, dst, src, size);
+      new = TimeCopy(&CopyNew, dst, src, size);
+      printf("%-6s %5u %-8s %9.1f %9.1f %6.1fx\n", "cpy", size, Alignments[a].Name, old, new, old / new);
+      old = TimeCopy(&CopyrOld, dst, src, size);
+      new = TimeCopy(&CopyrNew, dst, src, size);
+      printf("%-6s %5u %-8s %9.1f %9.1f %6.1fx\n", "cpyr", size, Alignments[a].Name, old, new, old / new);
+      if (Alignments[a].Src == 0U)
+      {
+        old = TimeFill(&FillOld, dst, size);
+        new = TimeFill(&FillNew, dst, size);
+        printf("%-6s %5u %-8s %9.1f %9.1f %6.1fx\n", "set", size, Alignments[a].Name, old, new, old / new);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Compares the flash and RAM footprint of the two LoRaWAN region modes:
+# the runtime dispatch of Region.c (LORAMAC_SINGLE_REGION=OFF) and the direct
+# calls into the configured region (LORAMAC_SINGLE_REGION=ON, the default).
+#
+#     ./tools/region_size.sh [Debug|Release]
+#
+# The application flash excludes the boot stage and is checked against the
+# ROM region of the linker script. Trees without boot stage or fragmentation
+# decoder RAM, i.e. without the .boot or .frag_decoder sections, count them
+# as 0.
+
+set -e
+
+BUILD_TYPE=${1:-Release}
+PROJECT=solarpath-firmware
+
+cd "$(dirname "$0")/.."
+
+# LENGTH of the ROM region, in K
+APP_SLOT=$(sed -n 's/^[[:space:]]*ROM[[:space:]]*(rx)[[:space:]]*:.*LENGTH[[:space:]]*=[[:space:]]*\([0-9]*\)K.*/\1/p' \
+    STM32CubeIDE/STM32WLE5CCUX_FLASH.ld)
+if [ -z "$APP_SLOT" ]; then
+    echo "ROM region not found in the linker script" >&2
+    exit 1
+fi
+APP_SLOT=$((APP_SLOT * 1024))
+
+build() {
+    mkdir -p build_region_$1
+    cd build_region_$1
+    cmake -G "Ninja" -DCMAKE_TOOLCHAIN_FILE=../arm-gcc-toolchain.cmake -DCMAKE_BUILD_TYPE=$BUILD_TYPE \
+        -DLORAMAC_SINGLE_REGION=$2 .. > /dev/null
+    ninja > /dev/null
+    cd ..
+}
+
+# Prints "flash ram app" of an ELF, in bytes, missing sections count as 0
+footprint() {
+    arm-none-eabi-size -A $1 | awk '
+        BEGIN                                               { boot = 0; flash = 0; ram = 0 }
+        $1 == ".boot"                                       { boot = $2 }
+        $1 ~ /^\.(isr_vector|text|rodata|ARM|preinit_array|init_array|fini_array)/ { flash += $2 }
+        $1 == ".data"                                       { flash += $2; ram += $2 }
+        $1 ~ /^\.(bss|noinit|frag_decoder)/ || $1 == "._user_heap_stack" { ram += $2 }
+        END                                                 { printf "%d %d %d\n", flash + boot, ram, flash }'
+}
+
+build dispatch OFF
+build direct ON
+
+set -- $(footprint build_region_dispatch/$PROJECT.elf) $(footprint build_region_direct/$PROJECT.elf)
+
+printf '%-10s %10s %10s %10s %10s\n' "mode" "flash" "ram" "app" "app free"
+printf '%-10s %10d %10d %10d %10d\n' "dispatch" $1 $2 $3 $((APP_SLOT - $3))
+printf '%-10s %10d %10d %10d %10d\n' "direct" $4 $5 $6 $((APP_SLOT - $6))
+printf '%-10s %+10d %+10d %+10d\n' "delta" $(($4 - $1)) $(($5 - $2)) $(($6 - $3))
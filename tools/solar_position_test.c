@@ -0,0 +1,87 @@
+/**
+  ******************************************************************************
+  * @file    solar_position_test.c
+  * @brief   Host test of SolarPosition_GetTwilight against reference civil
+  *          twilight times, mostly high latitudes in summer
+  *
+  *          The references come from the NOAA solar position equations,
+  *          solved for a -6 degree altitude. They are offsets in s from the
+  *          start of the UTC day, leap seconds aside.
+  *
+  *              cc -O2 -fsanitize=undefined -fno-sanitize-recover \
+  *                 -ISTM32CubeIDE/LoRaWAN/App -o solar_position_test \
+  *                 tools/solar_position_test.c STM32CubeIDE/LoRaWAN/App/solar_position.c
+  *              ./solar_position_test
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "solar_position.h"
+
+/**
+  * @brief Allowed error, in s
+  */
+#define TEST_TOLERANCE                              300
+
+typedef struct
+{
+  const char *Name;
+  uint32_t Day;         /* GPS time of the UTC day */
+  int32_t Latitude;     /* 1e-4 degree */
+  int32_t Longitude;    /* 1e-4 degree */
+  SolarDay_t Kind;
+  int32_t Dawn;         /* s from the start of the day */
+  int32_t Dusk;
+} TestCase_t;
+
+static const TestCase_t Cases[] =
+{
+  /* 2024-06-21 */
+  { "London", 1402963200, 515074, -1278, SOLAR_DAY_NORMAL, 10524, 76166 },
+  { "Aberdeen", 1402963200, 571497, -20943, SOLAR_DAY_NORMAL, 7376, 80256 },
+  { "Stockholm", 1402963200, 593293, 180686, SOLAR_DAY_NORMAL, -57, 78008 },
+  { "Oslo", 1402963200, 599139, 107522, SOLAR_DAY_NORMAL, 574, 80886 },
+  { "Reykjavik", 1402963200, 641466, -219426, SOLAR_DAY_POLAR_DAY, 0, 0 },
+  { "Tromso", 1402963200, 696492, 189553, SOLAR_DAY_POLAR_DAY, 0, 0 },
+  /* 2024-06-01 */
+  { "Helsinki", 1401235200, 601699, 249384, SOLAR_DAY_NORMAL, -1114, 75464 },
+  /* 2024-05-01 */
+  { "Anchorage", 1398556800, 612181, -1499003, SOLAR_DAY_NORMAL, 46267, 111885 },
+  /* 2024-12-21 */
+  { "Ushuaia", 1418774400, -548019, -683030, SOLAR_DAY_NORMAL, 24849, 94145 },
+};
+
+int main(void)
+{
+  int failures = 0;
+
+  for (uint32_t i = 0; i < (sizeof(Cases) / sizeof(Cases[0])); i++)
+  {
+    const TestCase_t *test = &Cases[i];
+    uint32_t dawn = 0;
+    uint32_t dusk = 0;
+    SolarDay_t kind = SolarPosition_GetTwilight(test->Day, test->Latitude, test->Longitude, &dawn, &dusk);
+    int32_t dawnError = (int32_t)(dawn - test->Day) - test->Dawn;
+    int32_t duskError = (int32_t)(dusk - test->Day) - test->Dusk;
+
+    if (kind != test->Kind)
+    {
+      printf("FAIL %-10s kind %d, expected %d\n", test->Name, kind, test->Kind);
+      failures++;
+    }
+    else if ((kind == SOLAR_DAY_NORMAL) && ((abs(dawnError) > TEST_TOLERANCE) || (abs(duskError) > TEST_TOLERANCE)))
+    {
+      printf("FAIL %-10s dawn %+d s, dusk %+d s\n", test->Name, dawnError, duskError);
+      failures++;
+    }
+    else
+    {
+      printf("ok   %-10s dawn %+d s, dusk %+d s\n", test->Name,
+             (kind == SOLAR_DAY_NORMAL) ? dawnError : 0, (kind == SOLAR_DAY_NORMAL) ? duskError : 0);
+    }
+  }
+  return (failures == 0) ? 0 : 1;
+}